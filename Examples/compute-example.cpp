@@ -8,6 +8,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <string>
 
 
 using namespace oglopp;
@@ -29,10 +31,26 @@ int main() {
 	Window window;
 	window.create(800, 800, "HoneyLib OpenGL - Compute", options);
 
+	DataStruct* data = new DataStruct[ELEMENTS];
+
+	// Initialize testVar with random values
+	for (int i=0;i<ELEMENTS;i++) {
+		data[i].testVar = static_cast<float>(static_cast<double>(rand()) / RAND_MAX);
+	}
+
+	// Create a new SSBO object from the data (We could also do this first, then map the buffer, then fill it, if we wanted. That would remove the need for the 'data' array.. but this is a demonstration so it's fine.)
+	SSBO ssbo;
+	ssbo.load(data, sizeof(DataStruct) * ELEMENTS);
+	delete[] data;
+
 	// // Initialize our shader object
-	Compute compute(// Compute
+	// The tuner picks LOCAL_SIZE_X by timing each candidate on this device, and remembers the winner in oglopp-tuning.cache.
+	// The local size is read back from the shader, so dispatchElements() can work out the groups by itself
+	ComputeTuner tuner;
+	std::unique_ptr<Compute> kernel = tuner.tune(std::string(// Compute
 	"#version 460 core\n"\
-	"layout (local_size_x = 1, local_size_y = 1) in;\n"\
+	"layout (local_size_x = LOCAL_SIZE_X) in;\n") +
+	Compute::ELEMENT_INDEX_FUNCTION +
 	"struct DataStruct {\n"\
 		"float testVar;\n"\
 		"float coolVar;\n"\
@@ -43,22 +61,26 @@ int main() {
 	"};\n"\
 	\
 	"void main() {\n"\
-		"uvec3 index = gl_GlobalInvocationID;\n"\
+		"uint index = elementIndex();\n"\
+		"if (index >= elementCount) {\n"\
+			"return;\n"\
+		"}\n"\
 		\
-		"data[index.x].coolVar = data[index.x].testVar * 2.0;\n"\
-	"}\n", ShaderType::RAW);
+		"data[index].coolVar = data[index].testVar * 2.0;\n"\
+	"}\n",
 
-	DataStruct* data = new DataStruct[ELEMENTS];
+	// Tuning runs the real workload. Here that is harmless, since the kernel only writes coolVar from testVar
+	[&](Compute& candidate) {
+		candidate.setSSBO(&ssbo);
+		candidate.dispatchElements(ELEMENTS);
+	});
 
-	// Initialize testVar with random values
-	for (int i=0;i<ELEMENTS;i++) {
-		data[i].testVar = static_cast<float>(static_cast<double>(rand()) / RAND_MAX);
+	if (kernel == nullptr) {
+		return -1;
 	}
 
-	// Create a new SSBO object from the data (We could also do this first, then map the buffer, then fill it, if we wanted. That would remove the need for the 'data' array.. but this is a demonstration so it's fine.)
-	SSBO ssbo;
-	ssbo.load(data, sizeof(DataStruct) * ELEMENTS);
-	delete[] data;
+	Compute& compute = *kernel;
+	std::cout << "Tuned local size: " << compute.getLocalSize().x << std::endl;
 
 	// Tell the compute shader to use the new SSBO object
 	compute.setSSBO(&ssbo);
@@ -67,7 +89,7 @@ int main() {
 	//compute.prepare(data, sizeof(DataStruct) * ELEMENTS);
 
 	// Attempt to run once - this will double testVar and place the product into coolVar
-	compute.dispatch(ELEMENTS);
+	compute.dispatchElements(ELEMENTS);
 
 	// Map the SSBO and read the result (By default, map() will use READONLY mode)
 	DataStruct* result = static_cast<DataStruct*>(ssbo.map());
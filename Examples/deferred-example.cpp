@@ -0,0 +1,222 @@
+// For basic texture stuff
+// https://learnopengl.com/Getting-started/Hello-Triangle
+
+// For 3d
+// http://www.opengl-tutorial.org/beginners-tutorials/tutorial-3-matrices/
+
+#include "oglopp.h"
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define CAMSPEED (0.05)
+
+void handleInput(Window& window) {
+	// When escape is pressed...
+	if (window.keyPressed(GLFW_KEY_ESCAPE)) {
+		// Release the cursor
+		window.cursorCapture();
+
+		// If control is also pressed.. Destroy the window
+		if (window.keyPressed(GLFW_KEY_LEFT_CONTROL)) {
+			window.destroy();
+		}
+	}
+
+	bool eventRecevied = false;
+	{ // Keyboard
+		if (window.keyPressed(GLFW_KEY_W)) {
+			window.getCam().translate(window.getCam().getBack() * -CAMSPEED);
+			eventRecevied = true;
+		}
+		if (window.keyPressed(GLFW_KEY_A)) {
+			window.getCam().translate(window.getCam().getRight() * -CAMSPEED);
+			eventRecevied = true;
+		}
+		if (window.keyPressed(GLFW_KEY_S)) {
+			window.getCam().translate(window.getCam().getBack() * CAMSPEED);
+			eventRecevied = true;
+		}
+		if (window.keyPressed(GLFW_KEY_D)) {
+			window.getCam().translate(window.getCam().getRight() * CAMSPEED);
+			eventRecevied = true;
+		}
+		if (window.keyPressed(GLFW_KEY_LEFT_CONTROL)) {
+			window.getCam().translate(window.getCam().getUp() * -CAMSPEED);
+			eventRecevied = true;
+		}
+		if (window.keyPressed(GLFW_KEY_SPACE)) {
+			window.getCam().translate(window.getCam().getUp() * CAMSPEED);
+			eventRecevied = true;
+		}
+	}
+
+	// The cursor is trapped. So we can do window stuff now
+	if (window.isCursorCaptured()) {
+		// Get the cursor position then set it to the middle of the window... or bottom left idk but it works
+		glm::dvec2 cursor = window.getCursorPos();
+		window.setCursorPos({0.0, 0.0});
+
+		window.getCam().aimBy(cursor.y, cursor.x);
+	}
+
+	if (eventRecevied) {
+		window.cursorCapture();
+		window.setCursorPos({0.0, 0.0});
+	}
+
+	if (window.keyPressed(GLFW_KEY_R)) {
+		window.cursorRelease();
+	}
+}
+
+class InputBuffer {
+public:
+	static Window* windowPtr;
+
+	static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+		InputBuffer::windowPtr->getCam().setFov(InputBuffer::windowPtr->getCam().getFov() - yoffset);
+	}
+};
+
+Window* InputBuffer::windowPtr  = nullptr;
+
+#define LIGHTS (2048)
+
+int main() {
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Deferred Shading");
+	InputBuffer::windowPtr = &window;
+	glfwSetScrollCallback(window.getWindow(), InputBuffer::scrollCallback);
+
+	int width, height;
+	window.getSize(&width, &height);
+
+	// G-buffer, lighting shader and output texture
+	DeferredRenderer deferred(width, height);
+	int gbufferWidth = width, gbufferHeight = height;
+
+	// // Initialize our shader object
+	Shader shader(
+		// Vertex
+		(std::string("#version 430 core\n") +
+		"layout (location = 0) in vec3 aPos;\n"\
+		"layout (location = 1) in vec3 aNormal;\n"\
+		"layout (location = 2) in vec2 aTexCoord;\n" +
+		oglopp::Shader::MODEL_VIEW_PROJECTION_MATRICES +
+		\
+		"out vec3 Normal;\n"\
+		\
+		"void main() {\n"\
+			"gl_Position = projection * view * model * vec4(aPos, 1.0);\n"\
+			"Normal = vec3(rotation * vec4(aNormal, 1.0));\n"\
+		"}\n").c_str(), // End of vertex
+
+		// Fragment. Only writes the surface, the lights are applied later
+		(std::string("#version 430 core\n") +
+		DeferredRenderer::getGBufferInclude() +
+		"uniform vec3 albedo;\n"\
+		\
+		"in vec3 Normal;\n"\
+		\
+		"void main() {\n"\
+			"writeGBuffer(albedo, 0.5, Normal, 32.0);\n"\
+		"}\n").c_str(), // End of fragment
+
+		ShaderType::RAW);
+
+	// A field of pillars on a floor
+	std::vector<Cube> pillars(100);
+	for (size_t i = 0; i < pillars.size(); i++) {
+		pillars[i].scale(glm::vec3(0.5, 3.0, 0.5));
+		pillars[i].setPosition(glm::vec3((i % 10) * 4.0 - 18.0, -1.0, (i / 10) * 4.0 - 18.0));
+	}
+
+	Cube floor;
+	floor.scale(glm::vec3(100.f, 0.5, 100.f));
+	floor.setPosition(glm::vec3(0.f, -2.5f, 0.f));
+
+	// Scatter small coloured lights around the pillars
+	std::vector<ClusteredLights::Light> lights(LIGHTS);
+	std::vector<glm::vec3> origins(LIGHTS);
+	for (int i = 0; i < LIGHTS; i++) {
+		float hue = static_cast<float>(i) / LIGHTS * 6.283f;
+		glm::vec3 color = glm::vec3(sin(hue) * 0.5 + 0.5, sin(hue + 2.094) * 0.5 + 0.5, sin(hue + 4.188) * 0.5 + 0.5);
+
+		origins[i] = glm::vec3((rand() % 4000) / 100.0 - 20.0, -1.5, (rand() % 4000) / 100.0 - 20.0);
+		lights[i].position = glm::vec4(origins[i], 2.0);
+		lights[i].diffuse = glm::vec4(color, 1.0);
+		lights[i].specular = glm::vec4(color, 1.0);
+		lights[i].attenuation = glm::vec4(1.0, 0.7, 1.8, 0.0);
+	}
+
+	// The lights are rewritten every frame, so they live in persistently mapped regions when the driver allows it
+	SSBO lightBuffer;
+	bool persistentLights = lightBuffer.loadPersistent(lights.data(), sizeof(ClusteredLights::Light) * LIGHTS) == 0;
+	if (!persistentLights) {
+		lightBuffer.load(lights.data(), sizeof(ClusteredLights::Light) * LIGHTS);
+	}
+	uint64_t frame = 0;
+
+	window.getCam().setPos(glm::vec3(0.0, 4.0, -24.0)).setAngle(glm::vec3(-10, -90, 0));
+	window.getCam().setFov(65);
+
+	float angle = 0;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		// Process events
+		handleInput(window);
+
+		angle += 0.01;
+
+		// Update the projection and view matrices for all the shapes to be drawn
+		window.getSize(&width, &height);
+		window.getCam().updateProjectionView(width, height);
+
+		// The G-buffer doesn't follow the window, so resize it with the window
+		if (width != gbufferWidth || height != gbufferHeight) {
+			deferred.resize(width, height);
+			gbufferWidth = width;
+			gbufferHeight = height;
+		}
+
+		// Move the lights in small circles, writing them straight into this frame's region if there is one
+		ClusteredLights::Light* target = persistentLights ? static_cast<ClusteredLights::Light*>(lightBuffer.writePtr(frame++)) : lights.data();
+		for (int i = 0; i < LIGHTS; i++) {
+			float phase = angle + i;
+			lights[i].position = glm::vec4(origins[i] + glm::vec3(sin(phase), 0.0, cos(phase)), 2.0);
+			target[i] = lights[i];
+		}
+		if (!persistentLights) {
+			lightBuffer.update(0, lights.data(), sizeof(ClusteredLights::Light) * LIGHTS);
+		}
+
+		// Geometry pass. The cost does not depend on the number of lights
+		deferred.beginGeometryPass();
+
+		shader.use();
+		shader.setVec3("albedo", glm::vec3(0.8));
+		for (Cube& pillar : pillars) {
+			pillar.draw(window, &shader);
+		}
+
+		shader.setVec3("albedo", glm::vec3(0.4));
+		floor.draw(window, &shader);
+
+		deferred.endGeometryPass();
+
+		// Lighting pass. The cost does not depend on the number of triangles
+		deferred.lightingPass(window, lightBuffer, LIGHTS);
+		deferred.present(window);
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
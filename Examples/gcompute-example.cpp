@@ -12,6 +12,7 @@
 #include <cstring>
 #include <glm/ext/scalar_uint_sized.hpp>
 #include <iostream>
+#include <memory>
 #include <cmath>
 
 
@@ -25,7 +26,6 @@ int main() {
 	Window::Settings options;
 	options.visible = true;
 	options.doFaceCulling = false;
-	options.modifyPointSize = true;
 
 	// Create the window
 	Window window;
@@ -47,69 +47,38 @@ int main() {
 		"data[index.x] = vec3(sin(6 * (float(index.x) / gl_NumWorkGroups.x + time)), float(index.x) / gl_NumWorkGroups.x * 2.0 - 1.0, 0.0);\n"\
 	"}\n", ShaderType::RAW);
 
-	Shader shader(
-		// Vertex
-		"#version 460 core\n"\
-		"layout (location = 0) in uint index;\n"\
-		"layout (std430, binding = 0) buffer SSBO {\n"\
+	// Each point is a small screen space quad expanded in the vertex shader, read straight from the compute output.
+	// The positions are already in clip space, so the matrices are identities
+	BillboardRenderer points(BillboardRenderer::SCREEN_SPACE,
+		"layout (std430, binding = 0) readonly buffer SSBO {\n"\
 			"vec3 data[];\n"\
 		"};\n"\
 		\
-		"void main() {\n"\
-			"gl_Position = vec4(data[index], 1.0);\n"\
-		"}",
-
-		//Geometry
-		"#version 460 core\n"\
-		"layout (points) in;\n"\
-		"layout (points, max_vertices = 1) out;\n"\
-		\
-		"void main() {\n"\
-			"gl_Position = gl_in[0].gl_Position;\n"\
-			"gl_PointSize = 1.0;\n"\
-			"EmitVertex();\n"\
-			"EndPrimitive();\n"\
-		"}",
-
-		// Fragment
-		"#version 460 core\n"\
-		\
-		"in vec3 FragPos;\n"\
-		"out vec4 FragColor;\n"\
-		\
-		"void main() {\n"\
-			"FragColor = vec4(1.0, 1.0, 1.0, 1.0);\n"\
-		"}",
-		ShaderType::RAW
-	);
-
-	shader.setDrawType(POINTS);
-
-	// Create a list of vertices with just an ID. the position will be provided in an SSBO calculated by a compute shader
-	Shape verts;
-	for (uint32_t id = 0; id < ELEMENTS; id++) {
-		verts.pushValue(&id, sizeof(id));
-		verts.incrementVerts();
-	}
-	verts.finalizePoints(Shape::UINT32);
+		"Billboard fetchBillboard(uint instance) {\n"\
+			"return Billboard(data[instance], 1.5, vec4(1.0), 0.0);\n"\
+		"}\n");
+	points.setBlendMode(BillboardRenderer::OPAQUE);
 
 
-	glm::vec4* data = new glm::vec4[ELEMENTS];
-	std::memset(data, 0, sizeof(glm::vec4) * ELEMENTS);
-
-	SSBO ssbo;
-	ssbo.load(data, sizeof(glm::vec4) * ELEMENTS);
+	// The shaders declare vec3 data[], which std430 pads to a 16 byte stride, so the CPU side holds vec4s.
+	// TypedSSBO<glm::vec3> would not compile
+	TypedSSBO<glm::vec4> ssbo(ELEMENTS, glm::vec4(0.0));
 
 	// Send the data to the compute shader
 	compute.setSSBO(&ssbo);
-	delete[] data;
 
 	float time = 0;
 
 	std::cout << "Moving " << ELEMENTS << " verticies per frame in compute shader" << std::endl;
 
+	// The first point is read back asynchronously. It arrives a frame or two late, but the loop never waits for it
+	std::shared_ptr<Readback> firstPoint;
+	uint64_t frame = 0;
+	uint64_t requestFrame = 0;
+
 	while (!window.shouldClose()) {
 		time += 0.002;
+		frame++;
 
 		compute.use();
 		compute.setFloat("time", time);
@@ -120,9 +89,20 @@ int main() {
 
 		window.clear();
 
-		//compute.bindSSBO();
-		verts.draw(window, &shader);
-		//compute.unbindSSBO();
+		// dispatch() leaves the barrier to the next use. The renderer issues it when it binds the positions
+		points.draw(glm::mat4(1.0), glm::mat4(1.0), ELEMENTS, &ssbo);
+
+		if (firstPoint != nullptr && firstPoint->ready()) {
+			if (frame % 120 == 0) {
+				std::cout << "First point x = " << firstPoint->as<glm::vec4>()->x << ", read back " << frame - requestFrame << " frame(s) late" << std::endl;
+			}
+			firstPoint = nullptr;
+		}
+
+		if (firstPoint == nullptr) {
+			firstPoint = ssbo.readbackAsync(0, sizeof(glm::vec4));
+			requestFrame = frame;
+		}
 
 		window.bufferSwap();
 		window.pollEvents();
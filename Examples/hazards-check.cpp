@@ -0,0 +1,140 @@
+// Checks that compute dispatches issue exactly the barriers their bindings need, by counting them across repeated dispatches.
+// Returns nonzero if a count or a result is wrong
+
+#include "oglopp.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define ELEMENTS 4096
+
+// Read the first count uints of a buffer back
+std::vector<uint32_t> readBack(SSBO& buffer, size_t count) {
+	std::vector<uint32_t> result(count);
+
+	void* mapped = buffer.map();
+	std::memcpy(result.data(), mapped, count * sizeof(uint32_t));
+	buffer.unmap();
+
+	return result;
+}
+
+bool check(const char* name, uint64_t barriers, uint64_t expectedBarriers, bool correct) {
+	bool passed = barriers == expectedBarriers && correct;
+
+	std::cout << name << ": " << barriers << " barriers (expected " << expectedBarriers << "), "
+		<< (correct ? "matches" : "MISMATCH") << (passed ? "" : " - FAILED") << std::endl;
+
+	return passed;
+}
+
+int main() {
+
+	// Setup some window options to make it invisible
+	Window::Settings options;
+	options.visible = false;
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Hazards check", options);
+
+	bool passed = true;
+
+	// The same read-modify-write kernel dispatched again and again. Each dispatch after the first reads what the one before
+	// it wrote, so it waits once. The first has nothing to wait for
+	{
+		std::vector<uint32_t> zeros(ELEMENTS, 0);
+		SSBO counters;
+		counters.load(zeros.data(), ELEMENTS * sizeof(uint32_t));
+
+		Compute increment((std::string(
+		"#version 450 core\n"\
+		"layout (local_size_x = 64) in;\n") +
+		Compute::ELEMENT_INDEX_FUNCTION +
+		"layout (std430, binding = 0) buffer Counters {\n"\
+			"uint counters[];\n"\
+		"};\n"\
+		\
+		"void main() {\n"\
+			"uint index = elementIndex();\n"\
+			"if (index < elementCount) {\n"\
+				"counters[index] += 1u;\n"\
+			"}\n"\
+		"}\n").c_str(), RAW);
+		increment.setSSBO(&counters);
+
+		uint64_t before = Hazards::getBarrierCount();
+		for (int i=0;i<3;i++) {
+			increment.dispatchElements(ELEMENTS);
+		}
+		uint64_t barriers = Hazards::getBarrierCount() - before;
+
+		passed &= check("Repeated += dispatches", barriers, 2, readBack(counters, ELEMENTS) == std::vector<uint32_t>(ELEMENTS, 3));
+	}
+
+	// A kernel reading a buffer through a read-only binding made before another kernel writes that buffer. The binding is
+	// still in place when the reader dispatches, so the reader must wait for the write
+	{
+		std::vector<uint32_t> zeros(ELEMENTS, 0);
+		SSBO source, copy;
+		source.load(zeros.data(), ELEMENTS * sizeof(uint32_t));
+		copy.load(zeros.data(), ELEMENTS * sizeof(uint32_t));
+
+		Compute writer((std::string(
+		"#version 450 core\n"\
+		"layout (local_size_x = 64) in;\n") +
+		Compute::ELEMENT_INDEX_FUNCTION +
+		"layout (std430, binding = 1) buffer Source {\n"\
+			"uint source[];\n"\
+		"};\n"\
+		\
+		"void main() {\n"\
+			"uint index = elementIndex();\n"\
+			"if (index < elementCount) {\n"\
+				"source[index] = index * 7u;\n"\
+			"}\n"\
+		"}\n").c_str(), RAW);
+
+		Compute reader((std::string(
+		"#version 450 core\n"\
+		"layout (local_size_x = 64) in;\n") +
+		Compute::ELEMENT_INDEX_FUNCTION +
+		"layout (std430, binding = 1) readonly buffer Source {\n"\
+			"uint source[];\n"\
+		"};\n"\
+		"layout (std430, binding = 2) writeonly buffer Copy {\n"\
+			"uint copy[];\n"\
+		"};\n"\
+		\
+		"void main() {\n"\
+			"uint index = elementIndex();\n"\
+			"if (index < elementCount) {\n"\
+				"copy[index] = source[index];\n"\
+			"}\n"\
+		"}\n").c_str(), RAW);
+
+		// Bound for reading first, then written through the same binding point by the writer
+		reader.bindSSBO(1, source, GL_READ_ONLY);
+		reader.bindSSBO(2, copy);
+		writer.bindSSBO(1, source);
+
+		writer.dispatchElements(ELEMENTS);
+
+		uint64_t before = Hazards::getBarrierCount();
+		reader.dispatchElements(ELEMENTS);
+		uint64_t barriers = Hazards::getBarrierCount() - before;
+
+		std::vector<uint32_t> expected(ELEMENTS);
+		for (int i=0;i<ELEMENTS;i++) {
+			expected[i] = i * 7;
+		}
+
+		passed &= check("Write, then read-only binding", barriers, 1, readBack(copy, ELEMENTS) == expected);
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// Compute shaders on textures: blur, downsample and a luminance histogram
+// https://www.khronos.org/opengl/wiki/Image_Load_Store
+
+#include <oglopp.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+
+using namespace oglopp;
+
+int main() {
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Image Kernels Example");
+
+	Texture image("/network/Programming/opengl/Examples/assets/container.jpg");
+
+	int width = 0;
+	int height = 0;
+	image.getSize(&width, &height);
+	std::cout << "Image size: [" << width << ", " << height << "]" << std::endl;
+
+	// Compute kernels store with imageStore, so their targets need a sized internal format
+	Texture blurred(width, height, GL_RGBA8, false);
+	Texture temporary(width, height, GL_RGBA8, false);
+	Texture half((width + 1) / 2, (height + 1) / 2, GL_RGBA8, false);
+
+	std::vector<GLuint> zeros(ImageKernels::HISTOGRAM_BINS, 0);
+	SSBO bins;
+	bins.load(zeros.data(), zeros.size() * sizeof(GLuint));
+
+	ImageKernels kernels;
+
+	// Draw the result to the screen with one fullscreen triangle
+	PostProcessChain present;
+	present.addColorOp("opaque", "color.a = 1.0;");
+
+	float radius = 0.f;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		radius = radius >= ImageKernels::BLUR_MAX_RADIUS ? 0.f : radius + 0.25f;
+
+		kernels.blur(image, blurred, temporary, static_cast<int>(radius));
+		kernels.downsample(blurred, half);
+		kernels.histogram(half, bins);
+
+		// Show the darkest and brightest bins which have any pixels
+		GLuint* counts = static_cast<GLuint*>(bins.map());
+		if (counts != nullptr) {
+			int darkest = -1;
+			int brightest = -1;
+			for (int i = 0; i < ImageKernels::HISTOGRAM_BINS; i++) {
+				if (counts[i] != 0) {
+					brightest = i;
+					if (darkest < 0) {
+						darkest = i;
+					}
+				}
+			}
+			bins.unmap();
+
+			std::cout << "\rBlur radius " << static_cast<int>(radius) << ", luminance bins " << darkest << " to " << brightest << "   " << std::flush;
+		}
+
+		window.clear();
+		present.run(window, half);
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	std::cout << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+// GPU driven drawing: compute shaders decide how much work to dispatch and which cubes to draw,
+// and the CPU never reads anything back
+
+#include "../Headers/oglopp.h"
+#include <iostream>
+#include <cmath>
+#include <string>
+
+
+using namespace oglopp;
+
+#define GRID 64
+#define CUBES (GRID * GRID)
+
+int main() {
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Indirect");
+
+	Cube cube;
+
+	const std::string grid = std::to_string(GRID);
+
+	// One dispatch command, written by the prepare pass and consumed by the cull pass
+	DispatchIndirectBuffer dispatchArgs(1);
+
+	// Up to one draw command per cube. The cull pass appends the visible ones and bumps commandCount
+	DrawElementsIndirectBuffer draws(CUBES);
+
+	// Clears the draw count and sizes the cull dispatch. In a real scene the cube count would also live on the GPU
+	Compute prepare((std::string(
+	"#version 460 core\n"\
+	"layout (local_size_x = 1) in;\n") +
+	DispatchIndirectBuffer::getDeclaration(0) +
+	"layout (std430, binding = 1) buffer DrawCount {\n"\
+		"uint drawCount;\n"\
+	"};\n"\
+	\
+	"uniform int cubeCount;\n"\
+	\
+	"void main() {\n"\
+		"drawCount = 0;\n"\
+		"commandCount = 1;\n"\
+		"commands[0].numGroupsX = (uint(cubeCount) + 63) / 64;\n"\
+		"commands[0].numGroupsY = 1;\n"\
+		"commands[0].numGroupsZ = 1;\n"\
+	"}\n").c_str(), ShaderType::RAW);
+
+	// Appends a draw of one instance for every cube above the wave
+	Compute cull((std::string(
+	"#version 460 core\n"\
+	"layout (local_size_x = 64) in;\n") +
+	DrawElementsIndirectBuffer::getDeclaration(1) +
+	"uniform int cubeCount;\n"\
+	"uniform int elements;\n"\
+	"uniform float time;\n"\
+	\
+	"void main() {\n"\
+		"uint cube = gl_GlobalInvocationID.x;\n"\
+		"if (cube >= uint(cubeCount)) {\n"\
+			"return;\n"\
+		"}\n"\
+		\
+		"vec2 cell = vec2(cube % " + grid + ", cube / " + grid + ");\n"\
+		"if (sin(cell.x * 0.2 + time) * cos(cell.y * 0.2 + time * 0.7) < 0.0) {\n"\
+			"return;\n"\
+		"}\n"\
+		\
+		"uint slot = atomicAdd(commandCount, 1);\n"\
+		"commands[slot].count = uint(elements);\n"\
+		"commands[slot].instanceCount = 1;\n"\
+		"commands[slot].firstIndex = 0;\n"\
+		"commands[slot].baseVertex = 0;\n"\
+		"commands[slot].baseInstance = cube;\n"\
+	"}\n").c_str(), ShaderType::RAW);
+
+	// The binding tables record what each pass writes, so the indirect reads wait for exactly those writes
+	BindingTable prepareBindings;
+	prepareBindings.storage(0, dispatchArgs).storage(1, draws, 0, sizeof(GLuint));
+	prepare.setBindings(&prepareBindings);
+
+	BindingTable cullBindings;
+	cullBindings.storage(1, draws);
+	cull.setBindings(&cullBindings);
+
+	// gl_BaseInstance is the cube index the cull pass stored in the command
+	std::string vertex = std::string(
+		"#version 460 core\n"\
+		"layout (location = 0) in vec3 aPos;\n"\
+		"layout (location = 1) in vec3 aNormal;\n"\
+		\
+		"uniform mat4 model;\n"\
+		"uniform mat4 view;\n"\
+		"uniform mat4 projection;\n"\
+		\
+		"out vec3 Normal;\n"\
+		"out vec3 Color;\n"\
+		\
+		"void main() {\n"\
+			"uint cube = uint(gl_BaseInstance + gl_InstanceID);\n"\
+			"vec2 cell = vec2(cube % ") + grid + ", cube / " + grid + ") - " + grid + ".0 / 2.0;\n"\
+			"vec4 world = model * vec4(aPos, 1.0) + vec4(cell.x * 1.5, 0.0, cell.y * 1.5, 0.0);\n"\
+			"gl_Position = projection * view * world;\n"\
+			"Normal = aNormal;\n"\
+			"Color = vec3(cell / " + grid + ".0 + 0.5, 1.0);\n"\
+		"}\n";
+
+	Shader shader(vertex.c_str(),
+		// Fragment
+		"#version 460 core\n"\
+		"in vec3 Normal;\n"\
+		"in vec3 Color;\n"\
+		\
+		"out vec4 FragColor;\n"\
+		\
+		"void main() {\n"\
+			"float light = max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0) * 0.8 + 0.2;\n"\
+			"FragColor = vec4(Color * light, 1.0);\n"\
+		"}\n", // End of fragment
+
+		ShaderType::RAW);
+
+	float time = 0;
+
+	glEnable(GL_DEPTH_TEST);
+
+	window.getCam().setPos(glm::vec3(0.0, 40.0, -60.0)).setAngle(glm::vec3(-35, 90, 0));
+	window.getCam().setFov(65);
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		// Process events
+		window.handleNoclip();
+
+		time += 0.02;
+
+		// Work generation: no CPU readback between these passes and the draw
+		prepare.use();
+		prepare.setInt("cubeCount", CUBES);
+		prepare.dispatch(static_cast<Compute::group_t>(1));
+
+		cull.use();
+		cull.setInt("cubeCount", CUBES);
+		cull.setInt("elements", cube.getElementCount());
+		cull.setFloat("time", time);
+		cull.dispatchIndirect(dispatchArgs);
+
+		// Update the projection and view matrices for all the shapes to be drawn
+		int width, height;
+		window.getSize(&width, &height);
+		window.getCam().updateProjectionView(width, height);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Draws however many commands the cull pass appended
+		cube.drawIndirect(window, &shader, draws);
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
@@ -86,9 +86,13 @@ Window* InputBuffer::windowPtr  = nullptr;
 int main() {
 
 
+	// Draw the depth of every opaque shape first, so the lighting below runs once per pixel
+	Window::Settings settings;
+	settings.depthPrepass = true;
+
 	// Create the window
 	Window window;
-	window.create(800, 800, "HoneyLib OpenGL - Materials");
+	window.create(800, 800, "HoneyLib OpenGL - Materials", settings);
 	InputBuffer::windowPtr = &window;
 	glfwSetScrollCallback(window.getWindow(), InputBuffer::scrollCallback);
 
@@ -101,6 +105,7 @@ int main() {
 		"layout (location = 2) in vec2 aTexCoord;\n" +
 		oglopp::Shader::MODEL_VIEW_PROJECTION_MATRICES +
 		"uniform vec3 lightPos;\n"\
+		"invariant gl_Position;\n"\
 		\
 		"out vec3 FragPos;\n"\
 		"out vec3 Normal;\n"\
@@ -166,6 +171,12 @@ int main() {
 	floor.scale(glm::vec3(100.f, 0.5, 100.f));
 	floor.setPosition(glm::vec3(0.f, -4.f, 0.f));
 
+	// Keep positions in their own buffer so the depth prepass only fetches positions
+	std::vector<Shape*> opaque = {&coob, &coob2, &coob3, &floor};
+	for (Shape* shape : opaque) {
+		shape->setStreams({1});
+	}
+
 	// Camera cam;
 	float angle = 0;
 
@@ -209,6 +220,9 @@ int main() {
 		shader.setVec3("lightPos", glm::vec3(sin(angle) * 10.0, 3.0, cos(angle) * 10.0));
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Lay down depth, then shade with an EQUAL depth test
+		window.depthPrepass(opaque);
+		shader.use();
 
 		shader.setVec3("material.color.diffuse", glm::vec3(1.0, 0.5, 0.0));
 		coob.draw(window, &shader);
@@ -221,6 +235,8 @@ int main() {
 		shader.setVec3("material.color.diffuse", glm::vec3(0.2, 0.2, 1.0));
 		floor.draw(window, &shader);
 
+		window.endShadingPass();
+
 		// Swap buffers since we always draw on the back buffer isntead of the front buffer
 		// When drawing on the front buffer, aka the actual pixels on the screen, you can get screen tearing and watch the pixels draw
 		// We draw on the back buffer then swap it to the front to update the screen (v-sync?)
@@ -0,0 +1,139 @@
+// A million particle fountain simulated and drawn on the GPU.
+// Run with --benchmark to simulate a fixed number of frames in a hidden window, time them, and check the particle lists.
+// The benchmark shrinks itself on software renderers like llvmpipe, so it can check correctness without a GPU
+
+#include "oglopp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+
+using namespace oglopp;
+
+#define PARTICLES (1 << 20)
+#define SOFTWARE_PARTICLES (1 << 14)
+
+// Emits a fixed number of particles per frame, all living a fixed number of frames, then checks the live count is exact
+int benchmark(Window& window) {
+	std::string renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	bool software = renderer.find("llvmpipe") != std::string::npos || renderer.find("softpipe") != std::string::npos;
+
+	const uint32_t capacity = software ? SOFTWARE_PARTICLES : PARTICLES;
+	const uint32_t lifeFrames = 60;
+	// A frame's burst is emitted before the oldest burst retires, so the pool holds one burst more than stays alive
+	const uint32_t perFrame = capacity / (lifeFrames + 1);
+	const uint32_t frames = software ? 90 : 600;
+	const float dt = 1.0f / 60.0f;
+
+	std::cout << "Benchmarking " << capacity << " particles on " << renderer << std::endl;
+
+	ParticleSystem particles(capacity);
+
+	// Half a frame past a whole number of frames, so rounding never decides which frame a particle dies in
+	ParticleSystem::Emitter emitter;
+	emitter.lifetime = (lifeFrames + 0.5f) * dt;
+	emitter.spread = 1.0;
+
+	window.getCam().setPos(glm::vec3(0.0, 1.0, -6.0)).setAngle(glm::vec3(0, 90, 0));
+	window.getCam().updateProjectionView(800, 800);
+
+	GLuint query;
+	glGenQueries(1, &query);
+	double total = 0;
+
+	for (uint32_t frame = 1; frame <= frames; frame++) {
+		glBeginQuery(GL_TIME_ELAPSED, query);
+
+		particles.emit(emitter, perFrame);
+		particles.update(dt);
+
+		window.clear();
+		particles.draw(window);
+
+		glEndQuery(GL_TIME_ELAPSED);
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		total += elapsed / 1e6;
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	glDeleteQueries(1, &query);
+
+	// Each particle survives lifeFrames updates, so the last lifeFrames bursts are alive
+	uint32_t alive = 0;
+	bool consistent = particles.validate(&alive) == 0;
+	uint32_t expected = perFrame * std::min(frames, lifeFrames);
+
+	std::cout << "Average frame: " << total / frames << "ms" << std::endl;
+	std::cout << "Alive: " << alive << ", expected " << expected << ". Lists " << (consistent ? "consistent" : "INCONSISTENT") << std::endl;
+
+	return consistent && alive == expected ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	bool benchmarkMode = argc > 1 && std::strcmp(argv[1], "--benchmark") == 0;
+
+	Window::Settings options;
+	options.visible = !benchmarkMode;
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Particles", options);
+
+	if (benchmarkMode) {
+		return benchmark(window);
+	}
+
+	ParticleSystem particles(PARTICLES);
+	particles.setDrag(0.2);
+
+	// Enough particles per second to keep the pool about full
+	ParticleSystem::Emitter fountain;
+	fountain.velocity = glm::vec3(0.0, 8.0, 0.0);
+	fountain.spread = 2.0;
+	fountain.lifetime = 2.0;
+	fountain.lifetimeVariance = 0.5;
+	fountain.rate = PARTICLES / 2.5;
+	fountain.startSize = 0.03;
+	fountain.endSize = 0.01;
+	fountain.startColor = glm::vec4(0.3, 0.6, 1.0, 0.6);
+	fountain.endColor = glm::vec4(1.0, 1.0, 1.0, 0.0);
+	size_t fountainIndex = particles.addEmitter(fountain);
+
+	glEnable(GL_DEPTH_TEST);
+
+	window.getCam().setPos(glm::vec3(0.0, 3.0, -12.0)).setAngle(glm::vec3(-5, 90, 0));
+	window.getCam().setFov(65);
+
+	float time = 0;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		// Process events
+		window.handleNoclip();
+
+		time += 1.0f / 60.0f;
+
+		// Sweep the fountain from side to side
+		particles.getEmitter(fountainIndex).velocity = glm::vec3(std::sin(time) * 3.0, 8.0, 0.0);
+		particles.update(1.0f / 60.0f);
+
+		// Update the projection and view matrices for all the shapes to be drawn
+		int width, height;
+		window.getSize(&width, &height);
+		window.getCam().updateProjectionView(width, height);
+
+		window.clear();
+		particles.draw(window);
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+// A plucked string simulated with many small steps per frame. Each substep reads the state the previous one wrote,
+// and the buffers swap roles instead of being copied
+
+#include "oglopp.h"
+#include <iostream>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define ELEMENTS 4096
+#define SUBSTEPS 32
+
+int main() {
+
+	Window::Settings options;
+	options.doFaceCulling = false;
+	options.modifyPointSize = true;
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Ping-pong simulation", options);
+
+	// Each point is (x, height, 0, vertical velocity)
+	Compute simulate((std::string(
+	"#version 460 core\n"\
+	"layout (local_size_x = 64) in;\n") +
+	Compute::ELEMENT_INDEX_FUNCTION +
+	PingPongBuffer::getDeclaration("vec4") +
+	\
+	"uniform float time;\n"\
+	"uniform float dt;\n"\
+	\
+	"void main() {\n"\
+		"uint index = elementIndex();\n"\
+		"if (index >= elementCount) {\n"\
+			"return;\n"\
+		"}\n"\
+		\
+		"vec4 point = current[index];\n"\
+		\
+		// The left end is driven, the right end is fixed
+		"if (index == 0) {\n"\
+			"next[index] = vec4(point.x, sin(time * 4.0) * 0.3, 0.0, 0.0);\n"\
+			"return;\n"\
+		"}\n"\
+		"if (index == elementCount - 1) {\n"\
+			"next[index] = vec4(point.x, 0.0, 0.0, 0.0);\n"\
+			"return;\n"\
+		"}\n"\
+		\
+		"float curvature = current[index - 1].y + current[index + 1].y - 2.0 * point.y;\n"\
+		"point.w = (point.w + curvature * 400000.0 * dt) * 0.9998;\n"\
+		"point.y += point.w * dt;\n"\
+		"next[index] = point;\n"\
+	"}\n").c_str(), ShaderType::RAW);
+
+	Shader shader(
+		// Vertex
+		"#version 460 core\n"\
+		"layout (location = 0) in uint index;\n"\
+		"layout (std430, binding = 2) readonly buffer State {\n"\
+			"vec4 state[];\n"\
+		"};\n"\
+		\
+		"void main() {\n"\
+			"gl_Position = vec4(state[index].xy, 0.0, 1.0);\n"\
+			"gl_PointSize = 2.0;\n"\
+		"}",
+
+		// Fragment
+		"#version 460 core\n"\
+		"out vec4 FragColor;\n"\
+		\
+		"void main() {\n"\
+			"FragColor = vec4(1.0, 1.0, 1.0, 1.0);\n"\
+		"}",
+		ShaderType::RAW
+	);
+
+	shader.setDrawType(POINTS);
+
+	Shape verts;
+	for (uint32_t id = 0; id < ELEMENTS; id++) {
+		verts.pushValue(&id, sizeof(id));
+		verts.incrementVerts();
+	}
+	verts.finalizePoints(Shape::UINT32);
+
+	// The string starts flat and at rest
+	std::vector<glm::vec4> initial(ELEMENTS);
+	for (int i = 0; i < ELEMENTS; i++) {
+		initial[i] = glm::vec4(static_cast<float>(i) / (ELEMENTS - 1) * 1.8f - 0.9f, 0.0, 0.0, 0.0);
+	}
+
+	PingPongBuffer state;
+	state.load(initial.data(), initial.size() * sizeof(glm::vec4));
+
+	const float dt = 0.016f / SUBSTEPS;
+	float time = 0;
+
+	std::cout << "Running " << SUBSTEPS << " substeps of " << ELEMENTS << " points per frame" << std::endl;
+
+	while (!window.shouldClose()) {
+		// One bind, dispatch and swap per substep. The only barriers are the reads of the previous substep's output
+		state.step(simulate, ELEMENTS, SUBSTEPS, [&](Compute& compute, uint32_t) {
+			time += dt;
+			compute.setFloat("time", time);
+			compute.setFloat("dt", dt);
+		});
+
+		window.clear();
+
+		// Draw the latest state
+		state.getRead().sync(GL_SHADER_STORAGE_BARRIER_BIT).bind(2);
+		verts.draw(window, &shader);
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
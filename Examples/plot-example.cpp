@@ -0,0 +1,73 @@
+// Plots ten million samples as a thick line. Up and down zoom, left and right pan.
+// However far out it zooms, only a few points per pixel column are drawn
+
+#include "oglopp.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define SAMPLES 10000000
+
+int main() {
+	// Create the window
+	Window window;
+	window.create(1200, 600, "HoneyLib OpenGL - Line Plot");
+
+	// A slow wave with bursts of noise, so the decimated envelope has something to show
+	std::mt19937 random(1);
+	std::normal_distribution<float> noise(0.0, 1.0);
+
+	std::vector<float> samples(SAMPLES);
+	for (size_t i = 0; i < samples.size(); i++) {
+		double t = i / 1000.0;
+		float burst = std::sin(t * 0.05) > 0.8 ? 0.8f : 0.05f;
+		samples[i] = std::sin(t) + 0.3 * std::sin(t * 0.013) + noise(random) * burst;
+	}
+
+	LinePlot plot;
+	plot.setData(samples, 0.0, 0.001).fitView();
+	plot.setColor(glm::vec4(0.3, 0.8, 1.0, 1.0)).setWidth(2.0);
+
+	double center = SAMPLES * 0.0005;
+	double span = SAMPLES * 0.001;
+	uint64_t frame = 0;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		// Zoom about the center, and pan by a fraction of the view
+		if (window.keyPressed(GLFW_KEY_UP)) {
+			span = std::max(span * 0.97, 0.01);
+		}
+		if (window.keyPressed(GLFW_KEY_DOWN)) {
+			span = std::min(span / 0.97, SAMPLES * 0.001);
+		}
+		if (window.keyPressed(GLFW_KEY_LEFT)) {
+			center -= span * 0.01;
+		}
+		if (window.keyPressed(GLFW_KEY_RIGHT)) {
+			center += span * 0.01;
+		}
+
+		// Fit y to what is in view, read from the pyramid rather than the samples
+		glm::vec2 range = plot.getRange(center - span * 0.5, center + span * 0.5);
+		float margin = std::max((range.y - range.x) * 0.05f, 0.01f);
+		plot.setView(center - span * 0.5, center + span * 0.5, range.x - margin, range.y + margin);
+
+		window.clear();
+		plot.draw();
+
+		if (++frame % 120 == 0) {
+			std::cout << "Level " << plot.getLevel() << " of " << plot.getLevelCount() << ", " << plot.getDrawnPoints() << " points" << std::endl;
+		}
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
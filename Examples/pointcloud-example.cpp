@@ -0,0 +1,98 @@
+// Streams a point cloud from an octree file, drawing only what the camera needs at the screen's density.
+// The first run builds pointcloud.oglpc from a generated terrain scan. Pass a point count to build a bigger one, eg. 200000000
+
+#include "oglopp.h"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+
+
+using namespace oglopp;
+
+#define CLOUD_FILE "pointcloud.oglpc"
+#define DEFAULT_POINTS 20000000
+
+// A rolling terrain sampled at random, coloured by height, like an aerial scan
+int buildCloud(size_t count) {
+	std::cout << "Building " << CLOUD_FILE << " from " << count << " points" << std::endl;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0, 1.0);
+
+	PointCloudBuilder builder;
+	for (size_t i = 0; i < count; i++) {
+		float x = unit(random) * 2000.0 - 1000.0;
+		float z = unit(random) * 2000.0 - 1000.0;
+		float y = std::sin(x * 0.01) * std::cos(z * 0.013) * 40.0 + std::sin(x * 0.11 + z * 0.07) * 3.0;
+
+		float height = (y + 43.0) / 86.0;
+		builder.add(glm::vec3(x, y, z), glm::vec4(0.2 + height * 0.6, 0.5 + height * 0.3, 0.3 - height * 0.2, 1.0));
+	}
+
+	return builder.write(CLOUD_FILE) == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_POINTS;
+
+	if (!std::filesystem::exists(CLOUD_FILE) || argc > 1) {
+		if (buildCloud(count) != 0) {
+			return 1;
+		}
+	}
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Point Cloud");
+
+	PointCloud cloud;
+	if (cloud.open(CLOUD_FILE, 512 << 20) != 0) {
+		return 1;
+	}
+
+	cloud.setPixelSpacing(2.0).setPointSize(2.0);
+
+	std::cout << cloud.getHeader().pointCount << " points in " << cloud.getHeader().nodeCount << " nodes, "
+		<< cloud.getSlotCount() << " fit on the GPU" << std::endl;
+
+	glEnable(GL_DEPTH_TEST);
+
+	window.getCam().setPos(glm::vec3(0.0, 150.0, -1100.0)).setAngle(glm::vec3(-10, 90, 0));
+
+	uint64_t frame = 0;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		// Process events
+		window.handleNoclip();
+
+		// Update the projection and view matrices. The far plane reaches across the whole terrain
+		int width, height;
+		window.getSize(&width, &height);
+		window.getCam().updateProjectionView(width, height, 4000.0);
+
+		cloud.update(window);
+
+		window.clear();
+		cloud.draw(window);
+
+		// The bounds of the cloud, and the axes at the origin drawn over it
+		PointCloud::Header const& bounds = cloud.getHeader();
+		debug::box(bounds.min, bounds.min + glm::vec3(bounds.size), glm::vec4(1.0, 1.0, 0.0, 1.0));
+		debug::axes(glm::mat4(1.0), 100.0, true);
+		debug::flush(window);
+
+		if (++frame % 120 == 0) {
+			std::cout << "Drawing " << cloud.getDrawnPoints() << " points from " << cloud.getSelectedNodes() << " nodes, "
+				<< cloud.getResidentNodes() << " resident, " << cloud.getPendingLoads() << " loading" << std::endl;
+		}
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
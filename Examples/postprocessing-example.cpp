@@ -9,26 +9,14 @@
 #include <ctime>
 #include <iostream>
 #include <cmath>
+#include <string>
 
 using namespace oglopp;
 
-struct ResizeData {
-	FBO* fbo;
-	Texture* tex;
-};
-
-void resizeCallback(int width, int height, void* data) {
-	if (data == nullptr) return; // Data may be null since we set it later on
-
-	// Get the FBO pointer and resize it
-	ResizeData* obj = static_cast<ResizeData*>(data);
-	obj->tex->resizeWithFbo(*obj->fbo, width, height);
-}
-
 int main() {
 	Window::Settings settings;
-	// For post-processing, you will need to use the resizeCallback to update the FBO and texture sizes if you plan on resizing your window. If not, then no need.
-	settings.resizeCallback = resizeCallback;
+	// The render graph reallocates its targets by itself when the window is resized
+	settings.resizable = true;
 
 	// Create the window
 	Window window;
@@ -87,59 +75,100 @@ int main() {
 		ShaderType::RAW);
 
 
-	// Post processing shader example (invert RGB in fragment shader)
-	Shader canvasShader(
-		"#version 330 core\n"\
-		"layout (location = 0) in vec3 aPos;\n"\
-		"layout (location = 1) in vec3 aColor;\n"\
-		"layout (location = 2) in vec2 aTexCoord;\n"\
-		\
-		"out vec4 vertexColor;\n"\
-		"out vec2 texCoord;\n"\
-		\
-		"void main() {\n"\
-			"gl_Position = vec4(-2*aPos.x, 2*aPos.y, 0.0, 1.0);\n"\
-			"vertexColor = vec4(aColor, 1.0);\n"\
-			"texCoord = aTexCoord;\n"\
-		"}\n",
+	// Camera cam;
+	float angle = 0;
 
-		// Fragment shader
-		"#version 330 core\n"\
-		"out vec4 FragColor;\n"\
-		"in vec4 vertexColor;\n"\
-		"in vec2 texCoord;\n"\
-		\
-		"uniform sampler2D texture0;\n"\
-		\
-		"void main() {\n"\
-			"vec4 texCol = texture(texture0, vec2(-texCoord.x, texCoord.y));\n"\
-			"FragColor = vec4(vec3(1.0 - texCol.r, 1.0 - texCol.g, 1.0 - texCol.b) * texCol.a, texCol.a);\n"\
-			"//FragColor.a = 1.0;\n"\
-		"}\n",
 
-		ShaderType::RAW);
+	/// POST-PROCESSING - DECLARE THE RENDER GRAPH
+
+	// The scene is drawn into a 4x MSAA framebuffer, then resolved into the graph's scene texture
+	FBO::Description msaaDesc;
+	msaaDesc.colors = {{GL_RGBA8, false, false}};
+	msaaDesc.hasDepth = true;
+	msaaDesc.depth = {GL_DEPTH24_STENCIL8, false, false};
+	msaaDesc.samples = 4;
+	FBO msaa(width, height, msaaDesc);
+
+	// Blur at half resolution, once per chain so the graph has something to alias (see below)
+	auto addBlur = [](PostProcessChain& chain) {
+		for (int axis = 0; axis < 2; axis++) {
+			chain.addEffect(std::string("blur ") + (axis == 0 ? "x" : "y"),
+				"color = vec4(0.0);\n"\
+				"for (int i = -4; i <= 4; i++) {\n"\
+					"color += texture(source, uv + direction * texelSize * float(i));\n"\
+				"}\n"\
+				"color /= 9.0;\n",
+				0.5f,
+				[axis](Shader& shader) {
+					shader.setVec2("direction", axis == 0 ? glm::vec2(1.0, 0.0) : glm::vec2(0.0, 1.0));
+				},
+				"uniform vec2 direction;");
+		}
+	};
+
+	PostProcessChain firstBlur;
+	addBlur(firstBlur);
+
+	// The invert color op is fused into the second blur's last pass, so this chain draws two fullscreen triangles instead of three
+	PostProcessChain secondBlur;
+	addBlur(secondBlur);
+	secondBlur.addColorOp("invert", "color.rgb = (1.0 - color.rgb) * color.a;");
+
+	PostProcessChain vignette;
+	vignette.addColorOp("vignette", "color.rgb *= 1.0 - vignetteStrength * dot(uv - 0.5, uv - 0.5);",
+		[](Shader& shader) {
+			shader.setFloat("vignetteStrength", 1.5f);
+		},
+		"uniform float vignetteStrength;");
+
+	std::cout << "Post-processing passes: " << firstBlur.getPassCount() + secondBlur.getPassCount() + vignette.getPassCount() << std::endl;
+
+	RenderGraph graph;
+	RenderGraph::TextureDesc colorDesc = {GL_RGBA8, 1.f, 0, 0, false};
+
+	RenderGraph::Handle sceneColor = graph.createTexture("scene", colorDesc);
+	RenderGraph::Handle blurred = graph.createTexture("blurred", colorDesc);
+	RenderGraph::Handle inverted = graph.createTexture("inverted", colorDesc);
+	RenderGraph::Handle unused = graph.createTexture("unused", colorDesc);
+
+	graph.addPass("scene", [&](RenderGraph::Context& ctx) {
+		if (msaa.getWidth() != static_cast<unsigned int>(ctx.width) || msaa.getHeight() != static_cast<unsigned int>(ctx.height)) {
+			msaa.resize(ctx.width, ctx.height);
+		}
+
+		msaa.bind(true);
+		window.clear();
+		rect.draw(window, &ourShader);
+		tri.draw(window, &ourShader);
+		coob.draw(window, &ourShader);
+		coob2.draw(window, &ourShader);
 
-	// Camera cam;
-	float angle = 0;
+		msaa.resolve(ctx.framebuffer);
+	}).write(sceneColor);
 
+	// Nothing reads this pass's output, so the graph culls it and never allocates its texture
+	graph.addPass("unused", [&](RenderGraph::Context& ctx) {
+		window.clear();
+	}).read(sceneColor).write(unused);
 
-	/// POST-PROCESSING - CREATE FRAME/RENDERBUFFER, MAP TO TEXTURE
+	// Each chain keeps its own ping-pong targets for its inner passes, and its last pass draws into the graph's target
+	graph.addPass("first blur", [&](RenderGraph::Context& ctx) {
+		firstBlur.run(window, ctx.texture(sceneColor), ctx.framebuffer);
+	}).read(sceneColor).write(blurred);
 
-	// Create the fbo, pass it to the window to update its size on a callback
-	FBO fbo(width, height);
-	// Create the FBO texture
-	Texture fboTex(fbo, width, height);
+	// The scene texture is not read after the first blur, so "inverted" is given the same GL texture
+	graph.addPass("second blur + invert", [&](RenderGraph::Context& ctx) {
+		secondBlur.run(window, ctx.texture(blurred), ctx.framebuffer);
+	}).read(blurred).write(inverted);
 
-	// Copy some pointers into a structure that we can give to window, who will give it to our resizeCallback when the window is resized.
-	ResizeData resizeData;
-	resizeData.fbo = &fbo;
-	resizeData.tex = &fboTex;
-	window.setCallbackDataPtr(&resizeData);
+	graph.addPass("vignette", [&](RenderGraph::Context& ctx) {
+		vignette.run(window, ctx.texture(inverted));
+	}).read(inverted).write(graph.getBackbuffer());
 
-	// Create the canvas we will draw the FBO texture to
-	Rectangle canvas;
-	canvas.pushTexture(&fboTex);
-	// Done FBO
+	graph.compile(window);
+	graph.print();
+	std::cout << "Transient textures: 3, GL textures: " << graph.getPhysicalTextureCount() << std::endl;
+	// Done render graph
 
 
 
@@ -178,22 +207,8 @@ int main() {
 		coob.setAngle(glm::dvec3(angle));
 		coob2.setPosition(glm::vec3(sin(angle), cos(angle), 0.0));
 
-		//Rendering
-		fbo.bind(); // Enables depthTest, sets glViewport size (MAKE SURE THE FBO AND TEXTURE ARE ADDED TO THE RESIZE CALLBACK)
-		window.clear(); // Clear the (now bound) renderbuffer
-		// Draw our points as normal, but now they will draw onto the render buffer (since we did fbo.bind())
-		rect.draw(window, &ourShader);
-		tri.draw(window, &ourShader);
-		coob.draw(window, &ourShader);
-		coob2.draw(window, &ourShader);
-
-		// Unbind the renderbuffer, then clear the real display buffer so we can re-draw our canvas.
-		FBO::unbind();
-		window.clear(GL_DEPTH_BUFFER_BIT); // Don't clear the depth
-
-		// Draw a canvas painted with the renderbuffer, so we can apply a post-processing shader (vertex, geometry, fragment, or compute!).
-		// This also does not need to be a simple rectangle.
-		canvas.draw(window, &canvasShader);
+		//Rendering. Every pass declared above runs in order, into targets the graph allocated
+		graph.execute(window);
 
 		// Swap buffers since we always draw on the back buffer isntead of the front buffer
 		// When drawing on the front buffer, aka the actual pixels on the screen, you can get screen tearing and watch the pixels draw
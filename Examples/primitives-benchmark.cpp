@@ -0,0 +1,144 @@
+// Runs each GPU primitive over a million random values, checks it against the CPU reference, and times both
+
+#include "oglopp.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define ELEMENTS (1 << 20)
+#define BINS 1024
+
+// Time some GPU work with a timer query, in milliseconds
+double timeGPU(std::function<void()> const& work) {
+	GLuint query;
+	glGenQueries(1, &query);
+
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	work();
+	glEndQuery(GL_TIME_ELAPSED);
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+	glDeleteQueries(1, &query);
+
+	return elapsed / 1e6;
+}
+
+// Time some CPU work, in milliseconds
+double timeCPU(std::function<void()> const& work) {
+	auto start = std::chrono::steady_clock::now();
+	work();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Read the first count uints of a buffer back
+std::vector<uint32_t> readBack(SSBO& buffer, size_t count) {
+	std::vector<uint32_t> result(count);
+
+	void* mapped = buffer.map();
+	std::memcpy(result.data(), mapped, count * sizeof(uint32_t));
+	buffer.unmap();
+
+	return result;
+}
+
+// Print a result, and return whether it matched
+bool report(const char* name, double gpu, double cpu, bool correct) {
+	std::cout << name << ": GPU " << gpu << "ms, CPU " << cpu << "ms, " << (correct ? "matches" : "MISMATCH") << std::endl;
+	return correct;
+}
+
+int main() {
+
+	// Setup some window options to make it invisible
+	Window::Settings options;
+	options.visible = false;
+
+	// Create the window
+	Window window;
+	window.create(800, 800, "HoneyLib OpenGL - Compute primitives", options);
+
+	std::vector<uint32_t> values(ELEMENTS);
+	std::vector<uint32_t> small(ELEMENTS);
+	std::vector<uint32_t> flags(ELEMENTS);
+	std::vector<uint32_t> payloads(ELEMENTS);
+
+	for (int i=0;i<ELEMENTS;i++) {
+		values[i] = (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand());
+		small[i] = rand() % BINS;
+		flags[i] = rand() % 2;
+		payloads[i] = i;
+	}
+
+	SSBO valueBuffer, smallBuffer, flagBuffer, payloadBuffer, outputBuffer, resultBuffer, warmupBuffer;
+	valueBuffer.load(values.data(), ELEMENTS * sizeof(uint32_t));
+	smallBuffer.load(small.data(), ELEMENTS * sizeof(uint32_t));
+	flagBuffer.load(flags.data(), ELEMENTS * sizeof(uint32_t));
+	payloadBuffer.load(payloads.data(), ELEMENTS * sizeof(uint32_t));
+	outputBuffer.load(values.data(), ELEMENTS * sizeof(uint32_t));
+	resultBuffer.load(payloads.data(), BINS * sizeof(uint32_t));
+	warmupBuffer.load(payloads.data(), ELEMENTS * sizeof(uint32_t));
+
+	ComputePrimitives primitives;
+
+	// Compile every kernel and size the scratch buffers before timing anything
+	primitives.scan(smallBuffer, outputBuffer, ELEMENTS);
+	primitives.reduce(smallBuffer, ELEMENTS, resultBuffer);
+	primitives.compact(smallBuffer, flagBuffer, outputBuffer, resultBuffer, ELEMENTS);
+	primitives.histogram(smallBuffer, ELEMENTS, resultBuffer, BINS);
+	primitives.sort(outputBuffer, &warmupBuffer, ELEMENTS);
+
+	bool passed = true;
+
+	// Scan. The small values keep the sums from overflowing
+	{
+		std::vector<uint32_t> expected;
+		double gpu = timeGPU([&]() { primitives.scan(smallBuffer, outputBuffer, ELEMENTS); });
+		double cpu = timeCPU([&]() { expected = ComputePrimitives::scanReference(small); });
+		passed &= report("Exclusive scan", gpu, cpu, readBack(outputBuffer, ELEMENTS) == expected);
+	}
+
+	// Reduce
+	{
+		uint32_t expected = 0;
+		double gpu = timeGPU([&]() { primitives.reduce(valueBuffer, ELEMENTS, resultBuffer, ComputePrimitives::MAX); });
+		double cpu = timeCPU([&]() { expected = ComputePrimitives::reduceReference(values, ComputePrimitives::MAX); });
+		passed &= report("Max reduction", gpu, cpu, readBack(resultBuffer, 1)[0] == expected);
+	}
+
+	// Compaction
+	{
+		std::vector<uint32_t> expected;
+		double gpu = timeGPU([&]() { primitives.compact(valueBuffer, flagBuffer, outputBuffer, resultBuffer, ELEMENTS); });
+		double cpu = timeCPU([&]() { expected = ComputePrimitives::compactReference(values, flags); });
+
+		uint32_t kept = readBack(resultBuffer, 1)[0];
+		passed &= report("Stream compaction", gpu, cpu, kept == expected.size() && readBack(outputBuffer, kept) == expected);
+	}
+
+	// Histogram
+	{
+		std::vector<uint32_t> expected;
+		double gpu = timeGPU([&]() { primitives.histogram(smallBuffer, ELEMENTS, resultBuffer, BINS); });
+		double cpu = timeCPU([&]() { expected = ComputePrimitives::histogramReference(small, BINS); });
+		passed &= report("Histogram", gpu, cpu, readBack(resultBuffer, BINS) == expected);
+	}
+
+	// Radix sort, with the original index of each key as its payload
+	{
+		std::vector<uint32_t> expectedKeys = values;
+		std::vector<uint32_t> expectedPayloads = payloads;
+
+		double gpu = timeGPU([&]() { primitives.sort(valueBuffer, &payloadBuffer, ELEMENTS); });
+		double cpu = timeCPU([&]() { ComputePrimitives::sortReference(expectedKeys, &expectedPayloads); });
+		passed &= report("Radix sort", gpu, cpu, readBack(valueBuffer, ELEMENTS) == expectedKeys && readBack(payloadBuffer, ELEMENTS) == expectedPayloads);
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// A hundred thousand bouncing sprites from two textures, drawn by a SpriteBatch in two draws.
+// Run from the repository root so the textures are found
+
+#include "oglopp.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+using namespace oglopp;
+
+#define SPRITES 100000
+
+struct Mover {
+	glm::vec2 position;
+	glm::vec2 velocity;
+	float spin;
+};
+
+int main() {
+	// Create the window
+	Window window;
+	window.create(1200, 800, "HoneyLib OpenGL - Sprites");
+
+	Texture container("Examples/assets/container.jpg");
+	Texture face("Examples/assets/awesomeface.png", oglopp::Texture::PNG);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0, 1.0);
+
+	std::vector<Mover> movers(SPRITES);
+	for (Mover& mover : movers) {
+		mover.position = glm::vec2(unit(random) * 1200.0, unit(random) * 800.0);
+		mover.velocity = glm::vec2(unit(random) - 0.5, unit(random) - 0.5) * 400.0f;
+		mover.spin = (unit(random) - 0.5) * 4.0;
+	}
+
+	SpriteBatch batch;
+	uint64_t frame = 0;
+	float time = 0;
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		int width, height;
+		window.getSize(&width, &height);
+
+		float dt = 1.0f / 60.0f;
+		time += dt;
+
+		auto start = std::chrono::steady_clock::now();
+
+		// Alternate textures, so TEXTURE order has something to group
+		batch.begin();
+		for (size_t i = 0; i < movers.size(); i++) {
+			Mover& mover = movers[i];
+			mover.position += mover.velocity * dt;
+
+			if (mover.position.x < 0 || mover.position.x > width) {
+				mover.velocity.x = -mover.velocity.x;
+			}
+			if (mover.position.y < 0 || mover.position.y > height) {
+				mover.velocity.y = -mover.velocity.y;
+			}
+
+			batch.draw(i % 2 == 0 ? &container : &face, mover.position, glm::vec2(16.0), glm::vec4(1.0), glm::vec4(0.0, 0.0, 1.0, 1.0), mover.spin * time);
+		}
+
+		window.clear();
+		batch.end();
+
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (++frame % 120 == 0) {
+			std::cout << batch.getSpriteCount() << " sprites in " << batch.getDrawCount() << " draws, " << elapsed << "ms on the CPU" << std::endl;
+		}
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
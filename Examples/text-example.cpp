@@ -0,0 +1,62 @@
+// Text at many sizes from one signed distance field atlas, drawn by a TextRenderer in one draw.
+// Pass a TTF file, or DejaVu Sans is looked for where Linux distributions usually install it
+
+#include "oglopp.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+
+
+using namespace oglopp;
+
+int main(int argc, char** argv) {
+	std::string path = argc > 1 ? argv[1] : "/usr/share/fonts/TTF/DejaVuSans.ttf";
+
+	// Create the window
+	Window window;
+	window.create(1200, 800, "HoneyLib OpenGL - Text");
+
+	Font font;
+	if (font.load(path) != 0) {
+		std::cout << "Usage: " << argv[0] << " [font.ttf]" << std::endl;
+		return 1;
+	}
+
+	TextRenderer text;
+	uint64_t frame = 0;
+	float time = 0;
+
+	const char* paragraph = "The atlas is rasterized once, at 48 pixels. Every size here is drawn from it, and these lines "
+		"wrap at a width which breathes in and out, so the layout is redone every frame. AVA Tea WAVE: kerned pairs sit closer.";
+
+	// ----- Render Loop -----
+	while (!window.shouldClose()) {
+		time += 1.0f / 60.0f;
+
+		window.clear();
+
+		text.begin();
+
+		float y = 20.0;
+		for (float size : {10.0f, 14.0f, 20.0f, 32.0f, 56.0f, 96.0f}) {
+			y += text.draw(font, "Signed distance fields", glm::vec2(20.0, y), size, glm::vec4(1.0)).y;
+		}
+
+		float width = 500.0f + std::sin(time) * 200.0f;
+		text.draw(font, paragraph, glm::vec2(20.0, y + 20.0), 24.0, glm::vec4(1.0, 0.8, 0.4, 1.0), width);
+
+		// Scaled far past the rasterized size, the outline stays sharp
+		text.draw(font, "Aa", glm::vec2(750.0, 300.0), 300.0f + std::sin(time * 0.7f) * 120.0f, glm::vec4(0.5, 0.8, 1.0, 1.0));
+
+		text.end();
+
+		if (++frame % 120 == 0) {
+			std::cout << text.getGlyphCount() << " glyphs in " << text.getDrawCount() << " draws" << std::endl;
+		}
+
+		window.bufferSwap();
+		window.pollEvents();
+	}
+
+	return 0;
+}
@@ -11,9 +11,29 @@
 #include "oglopp/more_shapes.h"
 
 #include "oglopp/texture.h"
+#include "oglopp/hazards.h"
 #include "oglopp/ssbo.h"
+#include "oglopp/typedssbo.h"
+#include "oglopp/readback.h"
+#include "oglopp/indirect.h"
 #include "oglopp/shader.h"
 #include "oglopp/compute.h"
+#include "oglopp/tuner.h"
+#include "oglopp/primitives.h"
+#include "oglopp/pingpong.h"
+#include "oglopp/billboard.h"
+#include "oglopp/particles.h"
+#include "oglopp/pointcloud.h"
+#include "oglopp/plot.h"
+#include "oglopp/debugdraw.h"
+#include "oglopp/spritebatch.h"
+#include "oglopp/font.h"
+#include "oglopp/kernels.h"
+#include "oglopp/bindings.h"
+#include "oglopp/clustered.h"
+#include "oglopp/deferred.h"
+#include "oglopp/rendergraph.h"
+#include "oglopp/postprocess.h"
 #include "oglopp/fbo.h"
 
 #include "oglopp/matrix.h"
@@ -0,0 +1,164 @@
+#ifndef OGLOPP_BILLBOARD_H
+#define OGLOPP_BILLBOARD_H
+
+#include <memory>
+#include <string>
+
+#include "defines.h"
+#include "window.h"
+#include "shader.h"
+#include "texture.h"
+#include "indirect.h"
+#include "typedssbo.h"
+
+/*
+ - Billboards are quads expanded in the vertex shader: each instance draws 6 vertices, and gl_VertexID picks the corner.
+   There is no geometry shader and no vertex buffer, only an empty vertex array
+ - The vertex shader gets each instance from a GLSL function, `Billboard fetchBillboard(uint instance)`. The default reads
+   an SSBO of Instance at INSTANCE_BINDING. Other data (particles, compute output) can be drawn in place by passing a fetch
+   function reading it instead, along with any blocks and uniforms it needs
+ - CAMERA_FACING quads lie in the view plane. AXIS_ALIGNED quads turn about a world axis only, eg. trees or beams.
+   SCREEN_SPACE quads are sized in pixels, for markers which stay the same size at any distance
+ - Without a texture, the fragment shader draws a soft disc. With one, the texture is tinted by the instance color
+*/
+
+namespace oglopp {
+	/** @brief Draws camera facing quads from per instance data
+	*/
+	class BillboardRenderer {
+	public:
+		static constexpr GLuint INSTANCE_BINDING = 0;
+
+		enum Mode : uint8_t {
+			CAMERA_FACING,
+			AXIS_ALIGNED,
+			SCREEN_SPACE
+		};
+
+		enum BlendMode : uint8_t {
+			OPAQUE,			// Depth tested and written. Pixels outside the disc or with alpha below 0.5 are discarded
+			ALPHA,			// Depth tested but not written. Draw back to front
+			ADDITIVE		// Depth tested but not written. Any order
+		};
+
+		/** @brief The default per instance data
+		*/
+		struct Instance {
+			glm::vec4 position;		// xyz, w is the size: the half width in world units, or pixels in SCREEN_SPACE
+			glm::vec4 color;
+			glm::vec4 rotation;		// x is the rotation in radians about the view direction or axis, yzw unused
+		};
+
+		// The GLSL struct fetchBillboard() returns. It is declared before the fetch function
+		static constexpr const char* BILLBOARD_STRUCT =
+			"struct Billboard {\n"\
+				"vec3 position;\n"\
+				"float size;\n"\
+				"vec4 color;\n"\
+				"float rotation;\n"\
+			"};\n";
+
+		/** @brief Create a billboard renderer
+		 * @param[in] mode		How the quads are oriented
+		 * @param[in] fetch		GLSL defining `Billboard fetchBillboard(uint instance)` and anything it uses. Empty to read Instance SSBOs
+	 	*/
+		BillboardRenderer(Mode mode = CAMERA_FACING, std::string const& fetch = "");
+		~BillboardRenderer();
+
+		BillboardRenderer(BillboardRenderer const&) = delete;
+		BillboardRenderer& operator=(BillboardRenderer const&) = delete;
+
+		/** @brief Draw some number of billboards with the camera of a window. Call after the camera's projection and view are updated
+		 * @param[in] window		The window
+		 * @param[in] count			The number of billboards
+		 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+		 * @return					A reference to this object
+	 	*/
+		BillboardRenderer& draw(Window& window, uint32_t count, SSBO* instances = nullptr);
+
+		/** @brief Draw some number of billboards with explicit matrices
+		 * @param[in] view			The view matrix
+		 * @param[in] projection	The projection matrix
+		 * @param[in] count			The number of billboards
+		 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+		 * @return					A reference to this object
+	 	*/
+		BillboardRenderer& draw(glm::mat4 const& view, glm::mat4 const& projection, uint32_t count, SSBO* instances = nullptr);
+
+		/** @brief Draw the billboards counted by an indirect command, eg. written by a compute pass. Its count must be 6, and its
+		 *  base instance 0 unless the driver has GL_ARB_shader_draw_parameters
+		 * @param[in] window		The window
+		 * @param[in] commands		The draw command buffer
+		 * @param[in] index			The command to draw
+		 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+		 * @return					A reference to this object
+	 	*/
+		BillboardRenderer& drawIndirect(Window& window, DrawArraysIndirectBuffer& commands, uint32_t index = 0, SSBO* instances = nullptr);
+
+		/** @brief Set the axis AXIS_ALIGNED billboards turn about
+		 * @param[in] axis	The world space axis
+		 * @return			A reference to this object
+	 	*/
+		BillboardRenderer& setAxis(glm::vec3 const& axis);
+
+		/** @brief Set a texture to draw instead of the soft disc
+		 * @param[in] texture	The texture, or nullptr for the disc. It must outlive its use by this object
+		 * @return				A reference to this object
+	 	*/
+		BillboardRenderer& setTexture(Texture* texture);
+
+		/** @brief Set how billboards blend with what is behind them
+		 * @param[in] mode	The blend mode
+		 * @return			A reference to this object
+	 	*/
+		BillboardRenderer& setBlendMode(BlendMode mode);
+
+		/** @brief Get the shader, eg. to set uniforms the fetch function uses. Call use() first
+		 * @return A reference to the shader
+	 	*/
+		Shader& getShader();
+
+		/** @brief Get the mode
+		 * @return How the quads are oriented
+	 	*/
+		Mode getMode() const;
+
+		/** @brief Get the GLSL of the Instance block and the default fetch function
+		 * @param[in] binding	The storage block binding
+		 * @return				The source
+	 	*/
+		static std::string getInstanceFetch(GLuint binding = INSTANCE_BINDING);
+
+	private:
+		Mode mode;
+		BlendMode blendMode = ALPHA;
+		glm::vec3 axis = glm::vec3(0.0, 1.0, 0.0);
+		Texture* texture = nullptr;
+
+		std::unique_ptr<Shader> shader;
+		GLuint vao = 0;
+
+		// Restored after the draw
+		GLboolean blendWas = GL_FALSE;
+		GLint blendFuncWas[4] = {GL_ONE, GL_ZERO, GL_ONE, GL_ZERO};	// Source and destination, RGB then alpha
+		GLboolean depthWriteWas = GL_TRUE;
+
+		/** @brief Set the uniforms and state shared by every draw
+		 * @param[in] view			The view matrix
+		 * @param[in] projection	The projection matrix
+		 * @param[in] instances		The Instance data, or nullptr
+	 	*/
+		void begin(glm::mat4 const& view, glm::mat4 const& projection, SSBO* instances);
+
+		/** @brief Restore the state begin() changed
+	 	*/
+		void end();
+	};
+
+	OGLOPP_STD430_STRUCT(BillboardRenderer::Instance, 16);
+	OGLOPP_STD430_MEMBER(BillboardRenderer::Instance, position);
+	OGLOPP_STD430_MEMBER(BillboardRenderer::Instance, color);
+	OGLOPP_STD430_MEMBER(BillboardRenderer::Instance, rotation);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef OGLOPP_BINDINGS_H
+#define OGLOPP_BINDINGS_H
+
+#include <vector>
+
+#include "defines.h"
+#include "ssbo.h"
+#include "texture.h"
+
+/*
+ - A binding table lists every buffer and texture a program uses, with the binding point or unit each goes to
+ - bind() binds consecutive binding points of the same kind with one glBindBuffersRange/glBindTextures/glBindImageTextures call
+   when GL 4.4 (or ARB_multi_bind) is available, and one call per binding otherwise
+ - Compute::setBindings() checks the table against the program's reflected interface, and binds it before each dispatch
+ - bind() first issues whichever barriers its resources need after earlier shader writes (see hazards.h)
+*/
+
+namespace oglopp {
+	/** @brief The buffers, images and textures used by a program
+	*/
+	class BindingTable {
+	public:
+		enum Kind : uint8_t {
+			STORAGE_BUFFER,		// GL_SHADER_STORAGE_BUFFER, `buffer` blocks
+			UNIFORM_BUFFER,		// GL_UNIFORM_BUFFER, `uniform` blocks
+			ATOMIC_COUNTER,		// GL_ATOMIC_COUNTER_BUFFER, `atomic_uint`
+			IMAGE,				// Image units, `image2D`
+			SAMPLER				// Texture units, `sampler2D`
+		};
+
+		/** @brief One resource and where it is bound
+		*/
+		struct Entry {
+			Kind kind;
+			GLuint binding;		// The binding point, image unit or texture unit
+			SSBO* buffer;		// Set for the buffer kinds
+			Texture* texture;	// Set for IMAGE and SAMPLER
+			GLintptr offset;	// Buffer range start in bytes
+			GLsizeiptr size;	// Buffer range size in bytes. 0 for the rest of the buffer
+			GLenum access;		// Image or storage buffer access
+			GLint level;		// Image mipmap level
+		};
+
+		BindingTable() = default;
+
+		/** @brief Bind a buffer (or part of it) to a shader storage block
+		 * @param[in] binding	The binding point
+		 * @param[in] buffer	The buffer
+		 * @param[in] offset	The start of the range in bytes. Must respect GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+		 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+		 * @param[in] access	GL_READ_ONLY if the program never writes the block, so later uses need not wait for it
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& storage(GLuint binding, SSBO& buffer, GLintptr offset = 0, GLsizeiptr size = 0, GLenum access = GL_READ_WRITE);
+
+		/** @brief Bind a buffer (or part of it) to a uniform block
+		 * @param[in] binding	The binding point
+		 * @param[in] buffer	The buffer
+		 * @param[in] offset	The start of the range in bytes. Must respect GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& uniform(GLuint binding, SSBO& buffer, GLintptr offset = 0, GLsizeiptr size = 0);
+
+		/** @brief Bind a buffer (or part of it) as atomic counters
+		 * @param[in] binding	The binding point
+		 * @param[in] buffer	The buffer
+		 * @param[in] offset	The start of the range in bytes. Must be a multiple of 4
+		 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& atomicCounter(GLuint binding, SSBO& buffer, GLintptr offset = 0, GLsizeiptr size = 0);
+
+		/** @brief Bind a texture to an image unit for imageLoad/imageStore
+		 * @param[in] unit		The image unit
+		 * @param[in] texture	The texture. It must have been created with an internal format (render target constructor)
+		 * @param[in] access	GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+		 * @param[in] level		The mipmap level
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& image(GLuint unit, Texture& texture, GLenum access = GL_READ_WRITE, GLint level = 0);
+
+		/** @brief Bind a texture to a texture unit for sampling
+		 * @param[in] unit		The texture unit
+		 * @param[in] texture	The texture
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& sampler(GLuint unit, Texture& texture);
+
+		/** @brief Remove the resource of a kind at a binding point
+		 * @param[in] kind		The kind of binding
+		 * @param[in] binding	The binding point or unit
+		 * @return				A reference to this table
+	 	*/
+		BindingTable& remove(Kind kind, GLuint binding);
+
+		/** @brief Remove every entry
+		 * @return A reference to this table
+	 	*/
+		BindingTable& clear();
+
+		/** @brief Bind every entry, after issuing the barriers earlier shader writes to them need
+		 * @return A reference to this table
+	 	*/
+		BindingTable& bind();
+
+		/** @brief Record that a dispatch or draw wrote every writable buffer and image in the table
+		 * @return A reference to this table
+	 	*/
+		BindingTable& markWritten();
+
+		/** @brief Find the entry of a kind at a binding point
+		 * @param[in] kind		The kind of binding
+		 * @param[in] binding	The binding point or unit
+		 * @return				A pointer to the entry, or nullptr if there is none
+	 	*/
+		Entry const* find(Kind kind, GLuint binding) const;
+
+		/** @brief Get every entry, sorted by kind and binding
+		 * @return The entries
+	 	*/
+		std::vector<Entry> const& getEntries() const;
+
+		/** @brief Check if multi-bind (GL 4.4 or ARB_multi_bind) is available
+		 * @return True if consecutive bindings are bound with one call
+	 	*/
+		static bool hasMultiBind();
+
+	private:
+		std::vector<Entry> entries;
+
+		// Reused by bind() so binding allocates nothing once the table is built
+		std::vector<GLuint> names;
+		std::vector<GLintptr> offsets;
+		std::vector<GLsizeiptr> sizes;
+
+		/** @brief Add an entry, replacing any entry of the same kind and binding
+		 * @param[in] entry	The entry
+		 * @return			A reference to this table
+	 	*/
+		BindingTable& set(Entry const& entry);
+
+		/** @brief Get the buffer target of a buffer kind
+		 * @param[in] kind	The kind
+		 * @return			The GL buffer target
+	 	*/
+		static GLenum getTarget(Kind kind);
+
+		/** @brief Get the barrier bit a kind of binding reads through
+		 * @param[in] kind	The kind
+		 * @return			The glMemoryBarrier bit
+	 	*/
+		static GLbitfield getBarrierBit(Kind kind);
+	};
+}
+
+#endif
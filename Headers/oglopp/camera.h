@@ -83,6 +83,33 @@ namespace oglopp {
 		 * @return	A reference to this Camera object
 		*/
 		Camera& updateProjectionView(int const& width, int const& height, double farPlane = HLGL_RENDER_FAR, Projection projectionType = PERSPECTIVE);
+
+		/** @brief Get the near plane used by the last updateProjectionView()
+		 * @return The near plane distance
+	 	*/
+		double getNear() const;
+
+		/** @brief Get the far plane used by the last updateProjectionView()
+		 * @return The far plane distance
+	 	*/
+		double getFar() const;
+
+		/** @brief Get the aspect ratio (width / height) used by the last updateProjectionView()
+		 * @return The aspect ratio
+	 	*/
+		double getAspect() const;
+
+		/** @brief Get the projection type used by the last updateProjectionView()
+		 * @return PERSPECTIVE or ORTHO
+	 	*/
+		Projection getProjectionType() const;
+
+	private:
+		// Projection parameters of the last updateProjectionView() call
+		double _near = HLGL_RENDER_NEAR;
+		double _far = HLGL_RENDER_FAR;
+		double _aspect = 1.0;
+		Projection _projectionType = PERSPECTIVE;
 	};
 }
 
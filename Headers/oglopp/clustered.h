@@ -0,0 +1,145 @@
+#ifndef OGLOPP_CLUSTERED_H
+#define OGLOPP_CLUSTERED_H
+
+#include <string>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "defines.h"
+#include "ssbo.h"
+#include "compute.h"
+#include "window.h"
+
+/*
+ - Lights live in an SSBO and are binned into view-space froxel clusters by a compute pass every frame
+ - Fragment shaders include getInclude() and only loop over the lights of their own cluster
+ - Depth slices are exponential between the camera near and far planes
+*/
+
+namespace oglopp {
+	/** @brief Clustered forward lighting for many point lights
+	*/
+	class ClusteredLights {
+	public:
+		/** @brief A single point light. Matches the ClusterLight struct in the GLSL include (std430)
+		*/
+		struct Light {
+			glm::vec4 position;		// xyz world position, w radius of influence
+			glm::vec4 diffuse;		// rgb diffuse colour, a unused
+			glm::vec4 specular;		// rgb specular colour, a unused
+			glm::vec4 attenuation;	// x constant, y linear, z quadratic, w unused
+		};
+
+		/** @brief Create the light and cluster buffers and compile the binning compute shader
+		 * @param[in] maxLights				The maximum number of lights that can be uploaded
+		 * @param[in] grid					The number of clusters in x, y (screen tiles) and z (depth slices)
+		 * @param[in] maxLightsPerCluster	The maximum number of lights stored per cluster. Extra lights are dropped
+		 * @param[in] firstBinding			The first of three consecutive SSBO binding points used by the lights and clusters
+	 	*/
+		ClusteredLights(uint32_t maxLights = 1024, glm::uvec3 grid = glm::uvec3(16, 9, 24), uint32_t maxLightsPerCluster = 128, GLuint firstBinding = 1);
+
+		/** @brief Upload the lights
+		 * @param[in] lights	A pointer to the lights
+		 * @param[in] count		The number of lights
+		 * @return				A status code. 0 for success. -1 if lights is nullptr. -2 if count is larger than maxLights
+	 	*/
+		int8_t setLights(Light const* lights, uint32_t count);
+
+		/** @brief Bin the lights into clusters using the window camera. Call after updateProjectionView() and setLights()
+		 * @param[in] window	The window whose camera is used
+		 * @return				A reference to this object
+	 	*/
+		ClusteredLights& update(Window& window);
+
+		/** @brief Bind the light and cluster buffers and set the cluster uniforms on a shader which uses getInclude()
+		 * @param[in] shader	The shader to prepare
+		 * @param[in] window	The window being drawn to. Used for the screen size and camera planes
+		 * @return				A reference to this object
+	 	*/
+		ClusteredLights& apply(Shader& shader, Window& window);
+
+		/** @brief Get the GLSL to include in fragment shaders (after a #version 430 line or newer).
+		 * 	Provides clusterIndex(gl_FragCoord, viewDepth), clusterLightCount(cluster), clusterLight(cluster, i) and clusterPointLight(...)
+		 * @return The GLSL source
+	 	*/
+		std::string getInclude() const;
+
+		/** @brief Get the SSBO holding the lights
+		 * @return A reference to the light SSBO
+	 	*/
+		SSBO& getLightSSBO();
+
+		/** @brief Get the number of uploaded lights
+		 * @return The light count
+	 	*/
+		uint32_t getLightCount() const;
+
+		/** @brief Get the cluster grid dimensions
+		 * @return The number of clusters in x, y and z
+	 	*/
+		glm::uvec3 const& getGrid() const;
+
+		// The GLSL struct matching ClusteredLights::Light
+		static constexpr const char* LIGHT_STRUCT =
+		"struct ClusterLight {"\
+			"vec4 position;"\
+			"vec4 diffuse;"\
+			"vec4 specular;"\
+			"vec4 attenuation;"\
+		"};\n";
+
+		// Blinn-Phong contribution of one ClusterLight, faded to zero at its radius so culling by radius is invisible
+		static constexpr const char* POINT_LIGHT_FUNCTION =
+		"vec3 clusterPointLight(ClusterLight light, vec3 fragPos, vec3 normal, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess) {\n"\
+			"vec3 toLight = light.position.xyz - fragPos;\n"\
+			"float dist = length(toLight);\n"\
+			"vec3 lightDir = toLight / max(dist, 0.0001);\n"\
+			"float diff = max(dot(normal, lightDir), 0.0);\n"\
+			"float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), shininess);\n"\
+			"float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * dist + light.attenuation.z * dist * dist);\n"\
+			"float window = clamp(1.0 - pow(dist / light.position.w, 4.0), 0.0, 1.0);\n"\
+			"attenuation *= window * window;\n"\
+			"return (light.diffuse.rgb * diff * albedo + light.specular.rgb * spec * specularColor) * attenuation;\n"\
+		"}\n";
+
+		// Invocations per work group in the binning shader
+		static constexpr uint32_t GROUP_SIZE = 128;
+
+	private:
+		const uint32_t maxLights;
+		const glm::uvec3 grid;
+		const uint32_t maxPerCluster;
+		const GLuint binding;
+
+		uint32_t lightCount;
+
+		SSBO lights;
+		SSBO clusterCounts;
+		SSBO clusterIndices;
+
+		// The three buffers at consecutive binding points, bound with one call where multi-bind is available
+		BindingTable bindings;
+
+		Compute binner;
+
+		/** @brief Get the binning compute shader source
+		 * @param[in] binding			The first SSBO binding point
+		 * @param[in] maxPerCluster		The maximum lights per cluster
+		 * @return						The GLSL source
+	 	*/
+		static std::string getBinningSource(GLuint binding, uint32_t maxPerCluster);
+
+		/** @brief Get the buffer declarations shared by the compute and fragment shaders
+		 * @param[in] binding			The first SSBO binding point
+		 * @param[in] maxPerCluster		The maximum lights per cluster
+		 * @return						The GLSL source
+	 	*/
+		static std::string getBufferSource(GLuint binding, uint32_t maxPerCluster);
+
+		/** @brief Bind the three buffers to their binding points
+	 	*/
+		void bindBuffers();
+	};
+}
+
+#endif
@@ -4,10 +4,22 @@
 #include "oglopp/glad/gl.h"
 #include "oglopp/shader.h"
 #include "oglopp/ssbo.h"
+#include "oglopp/texture.h"
+#include "oglopp/bindings.h"
+#include "oglopp/indirect.h"
+
+#include <unordered_map>
+#include <vector>
 
 /*
  - Work group Size is defined in c++
- - Local size is defined in glsl with layout()
+ - Local size is defined in glsl with layout(), and read back from the program once it is linked
+ - Device limits are queried once and shared by every Compute object
+ - Textures are bound to image units (image2D, load/store) or texture units (sampler2D, filtered reads).
+   Declare the unit in glsl with layout(binding = N)
+ - A BindingTable set with setBindings() is checked against the program's interface once, then bound before every dispatch
+ - dispatch() issues no barrier of its own. It records what it wrote, and the next use of those resources issues only the
+   barrier it needs (see hazards.h). Independent dispatches can overlap
 */
 
 namespace oglopp {
@@ -17,6 +29,26 @@ namespace oglopp {
 	public:
 		typedef GLint group_t;
 
+		/** @brief Compute limits of the device
+		*/
+		struct Limits {
+			glm::ivec3 maxGroupCount;		// GL_MAX_COMPUTE_WORK_GROUP_COUNT
+			glm::ivec3 maxGroupSize;		// GL_MAX_COMPUTE_WORK_GROUP_SIZE
+			GLint maxGroupInvocations;		// GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS
+			GLint maxSharedMemory;			// GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, in bytes
+		};
+
+		// Declares elementIndex() and elementCount for shaders run with dispatchElements(). Place it after the layout() line:
+		//	uint index = elementIndex();
+		//	if (index >= elementCount) return;
+		static constexpr const char* ELEMENT_INDEX_FUNCTION =
+			"uniform uint elementOffset;\n"\
+			"uniform uint elementCount;\n"\
+			"uint elementIndex() {\n"\
+				"uint groupInvocations = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;\n"\
+				"return elementOffset + gl_WorkGroupID.x * groupInvocations + gl_LocalInvocationIndex;\n"\
+			"}\n";
+
 		/** @brief Compute default constructor
 		 * @param[in] computeShader		The compute shader path or file contents
 		 * @param[in] type				The shader type.  File or raw.
@@ -35,6 +67,58 @@ namespace oglopp {
 	 	*/
 		SSBO* getSSBO();
 
+		/** @brief Bind a texture to an image unit for imageLoad/imageStore. Every dispatch waits for earlier writes to it and,
+		 *  unless read-only, marks it written, until another texture is bound to the unit or unbindImage() is called.
+		 *  It must stay alive until then
+		 * @param[in] unit		The image unit, matching layout(binding = unit) on the image2D
+		 * @param[in] texture	The texture. It must have been created with an internal format (render target constructor)
+		 * @param[in] access	GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+		 * @param[in] level		The mipmap level
+		 * @return				A reference to this compute object
+	 	*/
+		Compute& bindImage(GLuint unit, Texture& texture, GLenum access = GL_READ_WRITE, GLint level = 0);
+
+		/** @brief Bind a texture to a texture unit for sampling with texture()/texelFetch()
+		 * @param[in] unit		The texture unit, matching layout(binding = unit) on the sampler2D
+		 * @param[in] texture	The texture
+		 * @return				A reference to this compute object
+	 	*/
+		Compute& bindSampler(GLuint unit, Texture& texture);
+
+		/** @brief Bind another SSBO at its own binding point, in addition to the one set with setSSBO(). Every dispatch waits for
+		 *  earlier writes to it and, unless read-only, marks it written, until another SSBO is bound to the point or
+		 *  unbindSSBO() is called. It must stay alive until then
+		 * @param[in] binding	The binding point
+		 * @param[in] buffer	The SSBO
+		 * @param[in] access	GL_READ_ONLY if the shader never writes the block, so later uses need not wait for it
+		 * @return				A reference to this compute object
+	 	*/
+		Compute& bindSSBO(GLuint binding, SSBO& buffer, GLenum access = GL_READ_WRITE);
+
+		/** @brief Unbind an image unit bound with bindImage(), so dispatches stop tracking its texture
+		 * @param[in] unit		The image unit
+		 * @return				A reference to this compute object
+	 	*/
+		Compute& unbindImage(GLuint unit);
+
+		/** @brief Unbind a binding point bound with bindSSBO(), so dispatches stop tracking its SSBO
+		 * @param[in] binding	The binding point
+		 * @return				A reference to this compute object
+	 	*/
+		Compute& unbindSSBO(GLuint binding);
+
+		/** @brief Set the binding table bound before every dispatch, and check that it covers every buffer block,
+		 *  atomic counter buffer, image and sampler the program uses. The table is used even if the check fails
+		 * @param[in] table		The binding table, or nullptr to stop using one. It must outlive its use by this object
+		 * @return				A status code. 0 for success. -1 if the program uses a binding the table lacks or a range is too small
+	 	*/
+		int8_t setBindings(BindingTable* table);
+
+		/** @brief Get the binding table set with setBindings()
+		 * @return A pointer to the table, or nullptr
+	 	*/
+		BindingTable* getBindings();
+
 		/** @brief Dispatch some groups with the loaded compute shader
 		 * @param[in] xGroups	The number of groups in the x dimension (not optional)
 		 * @param[in] yGroups	The number of groups in the y dimension (optional - default is 1)
@@ -44,8 +128,30 @@ namespace oglopp {
 		int8_t dispatch(group_t xGroups, group_t yGroups = 1, group_t zGroups = 1);
 		int8_t dispatch(glm::ivec3 groups);
 
-		/** @brief Dispatch a buffer object specifying number of groups with the loaded compute shader
-		 * @param[in] pBufferObject	A GLintptr pointing to some buffer object
+		/** @brief Dispatch enough groups to cover every pixel of an image, using the shader's local size
+		 * @param[in] width		The image width in pixels
+		 * @param[in] height	The image height in pixels
+		 * @return				A status code. 0 for success. -1 for failure.
+	 	*/
+		int8_t dispatchImage(int width, int height);
+
+		/** @brief Run one invocation per element, for shaders using ELEMENT_INDEX_FUNCTION. Counts needing more groups than
+		 *  the device allows are split into several dispatches, each given its first element through elementOffset
+		 * @param[in] count		The number of elements
+		 * @return				A status code. 0 for success. -1 for failure.
+	 	*/
+		int8_t dispatchElements(uint32_t count);
+
+		/** @brief Dispatch the group counts stored in an indirect buffer, eg. written by an earlier dispatch
+		 * @param[in] commands	The buffer of dispatch commands
+		 * @param[in] index		The command to dispatch
+		 * @return				A status code. 0 for success. -1 if the index is out of range
+	 	*/
+		int8_t dispatchIndirect(DispatchIndirectBuffer& commands, uint32_t index = 0);
+
+		/** @brief Dispatch the group counts at some offset of the bound GL_DISPATCH_INDIRECT_BUFFER.
+		 *  The caller binds the buffer. Prefer dispatchIndirect(), which binds it and waits for writes to it
+		 * @param[in] pBufferObject	The offset in bytes of the command in the bound indirect buffer
 		 * @return					A status code. 0 for success. -1 for failure.
 	 	*/
 		int8_t dispatch(GLintptr pBufferObject);
@@ -69,6 +175,22 @@ namespace oglopp {
 	 	*/
 		static const bool groupSizeIsValid(group_t groupSize);
 
+		/** @brief Check if a local size is valid in each dimension and in total
+		 * @param[in] localSize		The local size to check
+		 * @return					True if valid, false otherwise
+	 	*/
+		static const bool groupSizeIsValid(glm::ivec3 localSize);
+
+		/** @brief Get the device's compute limits. Queried on the first call only
+		 * @return	A constant reference to the limits
+	 	*/
+		static Limits const& getLimits();
+
+		/** @brief Get the local size declared by the shader
+		 * @return	The local size
+	 	*/
+		glm::ivec3 getLocalSize() const;
+
 	private:
 		//GLuint ssbo;
 		const GLuint binding;
@@ -76,6 +198,49 @@ namespace oglopp {
 		//size_t bufSize;
 		SSBO* ssbo;
 
+		// Reflected when the program is linked
+		glm::ivec3 localSize = glm::ivec3(1);
+		GLint elementOffsetLocation = -1;
+		GLint elementCountLocation = -1;
+
+		// Images and buffers bound with bindImage() and bindSSBO(), by unit and binding point. GL keeps them bound across
+		// dispatches, so every dispatch reads them, and writes them unless read-only, until they are replaced
+		struct BoundImage {
+			Texture* texture;
+			GLenum access;
+		};
+
+		struct BoundBuffer {
+			SSBO* buffer;
+			GLenum access;
+		};
+
+		std::unordered_map<GLuint, BoundImage> boundImages;
+		std::unordered_map<GLuint, BoundBuffer> boundBuffers;
+
+		BindingTable* bindings = nullptr;
+
+		/** @brief Check a binding table against the resources reflected from the linked program
+		 * @param[in] table		The binding table
+		 * @return				A status code. 0 for success. -1 if anything the program uses is missing or too small
+	 	*/
+		int8_t validateBindings(BindingTable const& table) const;
+
+		/** @brief Get the binding kind of a uniform type
+		 * @param[in] type	The uniform type, eg. GL_SAMPLER_2D
+		 * @param[out] kind	The kind, SAMPLER or IMAGE
+		 * @return			True if the type is a sampler or image
+	 	*/
+		static bool getOpaqueKind(GLenum type, BindingTable::Kind* kind);
+
+		/** @brief Bind the SSBO and binding table, and issue the barriers everything the dispatch uses needs
+	 	*/
+		void prepareResources();
+
+		/** @brief Mark everything the dispatch may have written
+	 	*/
+		void markResourcesWritten();
+
 		/** @brief Load a list of shaders into this shader object
 		 * @param[in] computeShader		The compute shader path or file contents
 		 * @param[in] type				The shader type.  File or raw.
@@ -0,0 +1,125 @@
+#ifndef OGLOPP_DEBUGDRAW_H
+#define OGLOPP_DEBUGDRAW_H
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "defines.h"
+#include "window.h"
+
+/*
+ - Immediate mode debug lines. Call debug::line(), box(), sphere(), frustum() or axes() from anywhere during a frame, then
+   debug::flush() once after the scene is drawn. Nothing needs creating first and nothing is kept past the flush
+ - Calls only append vertices to arrays on the CPU, which keep their capacity between frames, so a steady frame allocates nothing.
+   flush() copies both arrays into a persistently mapped ring of regions (see ssbo.h) and draws them with two glDrawArrays calls:
+   the depth tested lines, then the overlay lines with the depth test off so they show through everything
+ - The vertex shader reads the vertices as shader storage by gl_VertexID, so there is no vertex layout to rebuild
+ - setEnabled(false) makes every call return at once and flush() draw nothing. Building with OGLOPP_NO_DEBUG_DRAW defined
+   replaces every call with an empty inline function, so they cost nothing at all
+ - The GL objects are made by the first flush(), on the thread owning the context. Call shutdown() before destroying the context
+   to release them. Calls are not thread safe
+*/
+
+namespace oglopp {
+	namespace debug {
+#ifndef OGLOPP_NO_DEBUG_DRAW
+		/** @brief Draw a line
+		 * @param[in] from		One end
+		 * @param[in] to		The other end
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+	 	*/
+		void line(glm::vec3 const& from, glm::vec3 const& to, glm::vec4 const& color = glm::vec4(1.0), bool overlay = false);
+
+		/** @brief Draw the edges of an axis aligned box
+		 * @param[in] min		The lowest corner
+		 * @param[in] max		The highest corner
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+	 	*/
+		void box(glm::vec3 const& min, glm::vec3 const& max, glm::vec4 const& color = glm::vec4(1.0), bool overlay = false);
+
+		/** @brief Draw the edges of a transformed box
+		 * @param[in] transform		The transform of a cube from -1 to 1 on each axis, eg. a model matrix
+		 * @param[in] color			The color
+		 * @param[in] overlay		True to draw over everything instead of testing depth
+	 	*/
+		void box(glm::mat4 const& transform, glm::vec4 const& color = glm::vec4(1.0), bool overlay = false);
+
+		/** @brief Draw a sphere as three circles, one about each axis
+		 * @param[in] center	The center
+		 * @param[in] radius	The radius
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+		 * @param[in] segments	The lines per circle
+	 	*/
+		void sphere(glm::vec3 const& center, float radius, glm::vec4 const& color = glm::vec4(1.0), bool overlay = false, uint32_t segments = 24);
+
+		/** @brief Draw the edges of the volume a view and projection see, eg. a shadow or culling camera
+		 * @param[in] viewProjection	The projection matrix times the view matrix
+		 * @param[in] color				The color
+		 * @param[in] overlay			True to draw over everything instead of testing depth
+	 	*/
+		void frustum(glm::mat4 const& viewProjection, glm::vec4 const& color = glm::vec4(1.0), bool overlay = false);
+
+		/** @brief Draw the axes of a transform, x red, y green and z blue
+		 * @param[in] transform		The transform, eg. a model matrix
+		 * @param[in] size			The length of each axis before the transform
+		 * @param[in] overlay		True to draw over everything instead of testing depth
+	 	*/
+		void axes(glm::mat4 const& transform, float size = 1.0, bool overlay = false);
+
+		/** @brief Draw everything added since the last flush with a window's camera, then forget it.
+		 * Call after the camera's projection and view are updated for the frame
+		 * @param[in] window	The window
+	 	*/
+		void flush(Window& window);
+
+		/** @brief Draw everything added since the last flush with explicit matrices, then forget it
+		 * @param[in] view			The view matrix
+		 * @param[in] projection	The projection matrix
+	 	*/
+		void flush(glm::mat4 const& view, glm::mat4 const& projection);
+
+		/** @brief Forget everything added since the last flush without drawing it
+	 	*/
+		void clear();
+
+		/** @brief Turn debug drawing on or off. Off, every call returns at once
+		 * @param[in] enabled	True to draw
+	 	*/
+		void setEnabled(bool enabled);
+
+		/** @brief Check whether debug drawing is on
+		 * @return True if calls are drawn
+	 	*/
+		bool isEnabled();
+
+		/** @brief Get the number of lines added since the last flush
+		 * @return The line count, depth tested and overlay
+	 	*/
+		size_t getLineCount();
+
+		/** @brief Release the GL objects. The next flush() makes them again
+	 	*/
+		void shutdown();
+#else
+		inline void line(glm::vec3 const&, glm::vec3 const&, glm::vec4 const& = glm::vec4(1.0), bool = false) {}
+		inline void box(glm::vec3 const&, glm::vec3 const&, glm::vec4 const& = glm::vec4(1.0), bool = false) {}
+		inline void box(glm::mat4 const&, glm::vec4 const& = glm::vec4(1.0), bool = false) {}
+		inline void sphere(glm::vec3 const&, float, glm::vec4 const& = glm::vec4(1.0), bool = false, uint32_t = 24) {}
+		inline void frustum(glm::mat4 const&, glm::vec4 const& = glm::vec4(1.0), bool = false) {}
+		inline void axes(glm::mat4 const&, float = 1.0, bool = false) {}
+		inline void flush(Window&) {}
+		inline void flush(glm::mat4 const&, glm::mat4 const&) {}
+		inline void clear() {}
+		inline void setEnabled(bool) {}
+		inline bool isEnabled() { return false; }
+		inline size_t getLineCount() { return 0; }
+		inline void shutdown() {}
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef OGLOPP_DEFERRED_H
+#define OGLOPP_DEFERRED_H
+
+#include <string>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "defines.h"
+#include "fbo.h"
+#include "texture.h"
+#include "ssbo.h"
+#include "compute.h"
+#include "window.h"
+
+/*
+ - Geometry pass writes a compact G-buffer:
+	0: albedo.rgb, specular intensity
+	1: octahedral normal.xy, shininess / 256
+	depth: sampleable depth texture. Positions are rebuilt from it
+ - Lighting pass is a tiled compute shader. Each 16x16 tile culls the lights against its depth bounds, then shades its pixels
+ - Lights use the ClusteredLights::Light layout, so the same light SSBO can feed both paths
+*/
+
+namespace oglopp {
+	/** @brief Deferred shading with a packed G-buffer and tiled compute light accumulation
+	*/
+	class DeferredRenderer {
+	public:
+		/** @brief G-buffer and output storage formats. Smaller formats save bandwidth at the cost of precision
+		*/
+		struct Settings {
+			GLenum albedoFormat = GL_RGBA8;			// Albedo and specular intensity
+			GLenum normalFormat = GL_RGB10_A2;		// Octahedral normal and shininess. GL_RGBA16F for more precision
+			GLenum depthFormat = GL_DEPTH24_STENCIL8;
+			GLenum lightFormat = GL_RGBA16F;		// Accumulated light. GL_RGBA16F, GL_RGBA32F, GL_R11F_G11F_B10F or GL_RGBA8
+			GLuint lightBinding = 1;				// SSBO binding point of the lights during the lighting pass
+			glm::vec3 ambient = glm::vec3(0.02);	// Ambient light applied to every pixel
+			glm::vec4 background = glm::vec4(0.0);	// Written where no geometry was drawn
+		};
+
+		/** @brief Create the G-buffer and compile the lighting shader
+		 * @param[in] width		The width of the G-buffer
+		 * @param[in] height	The height of the G-buffer
+		 * @param[in] settings	The storage formats
+	 	*/
+		DeferredRenderer(int width, int height, Settings const& settings);
+		DeferredRenderer(int width, int height);
+
+		/** @brief Bind and clear the G-buffer. Draw opaque geometry with shaders which use getGBufferInclude()
+		 * @return A reference to this object
+	 	*/
+		DeferredRenderer& beginGeometryPass();
+
+		/** @brief Return to the default framebuffer
+		 * @return A reference to this object
+	 	*/
+		DeferredRenderer& endGeometryPass();
+
+		/** @brief Accumulate the lights into the output texture
+		 * @param[in] window		The window whose camera was used for the geometry pass
+		 * @param[in] lights		An SSBO of ClusteredLights::Light
+		 * @param[in] lightCount	The number of lights in the SSBO
+		 * @return					A reference to this object
+	 	*/
+		DeferredRenderer& lightingPass(Window& window, SSBO& lights, uint32_t lightCount);
+
+		/** @brief Copy the lit image to the default framebuffer
+		 * @param[in] window	The window to present to
+		 * @param[in] copyDepth	Also copy the G-buffer depth, so forward passes (transparency, debug) can draw on top
+		 * @return				A reference to this object
+	 	*/
+		DeferredRenderer& present(Window& window, bool copyDepth = true);
+
+		/** @brief Resize every render target
+		 * @param[in] width		The new width
+		 * @param[in] height	The new height
+		 * @return				A reference to this object
+	 	*/
+		DeferredRenderer& resize(int width, int height);
+
+		/** @brief Get the GLSL for geometry pass fragment shaders. Declares the G-buffer outputs and
+		 * 	writeGBuffer(vec3 albedo, float specular, vec3 normal, float shininess)
+		 * @return The GLSL source
+	 	*/
+		static std::string getGBufferInclude();
+
+		Texture& getAlbedo();
+		Texture& getNormal();
+		Texture& getDepth();
+		Texture& getOutput();
+
+		// Octahedral normal packing into two [0, 1] channels
+		static constexpr const char* OCTAHEDRAL_FUNCTIONS =
+		"vec2 octWrap(vec2 v) {\n"\
+			"return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);\n"\
+		"}\n"\
+		"vec2 encodeOctahedral(vec3 n) {\n"\
+			"n /= abs(n.x) + abs(n.y) + abs(n.z);\n"\
+			"n.xy = n.z >= 0.0 ? n.xy : octWrap(n.xy);\n"\
+			"return n.xy * 0.5 + 0.5;\n"\
+		"}\n"\
+		"vec3 decodeOctahedral(vec2 f) {\n"\
+			"f = f * 2.0 - 1.0;\n"\
+			"vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));\n"\
+			"float t = clamp(-n.z, 0.0, 1.0);\n"\
+			"n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);\n"\
+			"return normalize(n);\n"\
+		"}\n";
+
+		// Pixels per side of a lighting tile
+		static constexpr uint32_t TILE_SIZE = 16;
+
+		// Lights kept per tile. Extra lights are dropped
+		static constexpr uint32_t MAX_TILE_LIGHTS = 512;
+
+	private:
+		Settings settings;
+
+		int width;
+		int height;
+
+		FBO gbuffer;	// Albedo, normal and depth textures
+		FBO output;		// Lit color texture only
+
+		Compute lighting;
+
+		/** @brief Get the lighting compute shader source
+		 * @param[in] settings	The formats and light binding
+		 * @return				The GLSL source
+	 	*/
+		static std::string getLightingSource(Settings const& settings);
+	};
+}
+
+#endif
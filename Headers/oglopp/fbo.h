@@ -1,42 +1,128 @@
 #ifndef OGLOPP_FBO_H
 #define OGLOPP_FBO_H
 
+#include <memory>
+#include <vector>
+
 #include "defines.h"
 
+/*
+ - An FBO is either created empty with a depth/stencil renderbuffer (textures are attached by the user),
+   or from a Description, in which case it creates and owns every attachment
+ - bind() and unbind() only change the framebuffer binding. bind(true) also sets the viewport to the FBO, which unbind()
+   doesn't put back, so whoever draws to the window next sets it. Depth testing is left to the window
+ - bind() and resolve() wait for compute image stores to the owned attachments. Textures attached with attachTexture() are the caller's to sync
+*/
+
 namespace oglopp {
+	class Texture;
+
 	class FBO {
 		public:
+			/** @brief Describes one attachment created by the FBO
+			*/
+			struct Attachment {
+				GLenum format;		// The internal format, eg. GL_RGBA8, GL_RGBA16F, GL_R11F_G11F_B10F or GL_DEPTH24_STENCIL8
+				bool sampleable;	// Create a texture which can be sampled. Otherwise a renderbuffer, which is cheaper when never read
+				bool nearest;		// Nearest-neighbour filtering for sampleable attachments
+			};
+
+			/** @brief Describes every attachment of an FBO
+			*/
+			struct Description {
+				std::vector<Attachment> colors;		// Color attachments, in COLOR_ATTACHMENT order. May be empty (depth-only)
+				bool hasDepth;						// Create a depth (and stencil, with a stencil format) attachment
+				Attachment depth;					// The depth attachment, if hasDepth
+				uint8_t samples;					// MSAA sample count. When above 0, every attachment is a multisampled renderbuffer. Use resolve()
+			};
 
 			/**
-			 * @brief Create a new SSBO object. Default constructor
+			 * @brief Create a new FBO with only a depth/stencil renderbuffer. Color textures are attached with attachTexture()
 			 * @param[in] rboWidth	The initial width of the rbo
 			 * @param[in] rboHeight The initial height of the rbo
 	 		*/
 			FBO(unsigned int rboWidth = 800, unsigned int rboHeight = 600);
+
+			/**
+			 * @brief Create a new FBO and every attachment in a description
+			 * @param[in] width			The initial width
+			 * @param[in] height		The initial height
+			 * @param[in] description	The attachments to create
+	 		*/
+			FBO(unsigned int width, unsigned int height, Description const& description);
 			~FBO();
 
-			/** @brief Bind the FBO to some binding number. Default is 0 if not specified
+			/** @brief Bind the FBO for drawing and reading. Does not change any other state unless asked to
+			 * @param[in] setViewport	Also set the viewport to the size of the FBO. unbind() doesn't restore it
 			 * @return	A reference to the FBO object
 		 	*/
-			FBO& bind();
+			FBO& bind(bool setViewport = false);
 
 			/** @brief Unbind the bound FBO
 		 	*/
 			static void unbind();
 
 			/**
-			 * @brief Check if the framebuffer is complete after loading
+			 * @brief Check if this framebuffer is complete
 			 * @return True if complete, false otherwise
 			 */
 			bool isComplete() const;
 
 			/**
-			 * @brief Resize the rbo
+			 * @brief Resize the rbo and every attachment owned by this FBO. Their contents are lost
 			 * @param[in] rboWidth	The initial width of the rbo
 			 * @param[in] rboHeight The initial height of the rbo
 			 */
 			void resize(unsigned int rboWidth, unsigned int rboHeight);
 
+			/**
+			 * @brief Select how many color attachments fragment shader outputs are written to (COLOR_ATTACHMENT0 to count - 1)
+			 * @param[in] count	The number of color attachments
+			 * @return			A reference to the FBO object
+			 */
+			FBO& setDrawBuffers(uint8_t count);
+
+			/**
+			 * @brief Attach a texture which is not owned by this FBO
+			 * @param[in] texture		The texture to attach
+			 * @param[in] attachment	The attachment point, eg. GL_COLOR_ATTACHMENT1 or GL_DEPTH_STENCIL_ATTACHMENT
+			 * @return					A reference to the FBO object
+			 */
+			FBO& attachTexture(Texture& texture, GLenum attachment);
+
+			/**
+			 * @brief Copy (and resolve, for MSAA) the color attachments of this FBO into another FBO with glBlitFramebuffer
+			 * @param[in] target	The FBO to copy to. nullptr for the default framebuffer, which only receives color attachment 0
+			 * @param[in] mask		The buffers to copy. Any of GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT and GL_STENCIL_BUFFER_BIT
+			 * @return				A reference to the FBO object
+			 */
+			FBO& resolve(FBO* target, GLbitfield mask = GL_COLOR_BUFFER_BIT);
+
+			/**
+			 * @brief Get an owned color texture
+			 * @param[in] index	The color attachment index
+			 * @return			A pointer to the texture, or nullptr if the attachment is a renderbuffer or does not exist
+			 */
+			Texture* getColor(uint8_t index = 0);
+
+			/**
+			 * @brief Get the owned depth texture
+			 * @return A pointer to the texture, or nullptr if the depth attachment is a renderbuffer or does not exist
+			 */
+			Texture* getDepth();
+
+			/**
+			 * @brief Get the number of color attachments
+			 * @return The color attachment count
+			 */
+			uint8_t getColorCount() const;
+
+			/**
+			 * @brief Get the attachment point of a depth format
+			 * @param[in] format	The depth format
+			 * @return				GL_DEPTH_STENCIL_ATTACHMENT for depth/stencil formats, GL_DEPTH_ATTACHMENT otherwise
+			 */
+			static GLenum getDepthAttachment(GLenum format);
 
 			unsigned int getFbo() const;
 		 	unsigned int getRbo() const;
@@ -46,10 +132,33 @@ namespace oglopp {
 
 		private:
 			GLuint fbo;
-			GLuint rbo;
+			GLuint rbo = 0;
 
 			int width;
 			int height;
+
+			Description description;
+
+			// One entry per color attachment. Either the texture or the renderbuffer is set
+			std::vector<std::unique_ptr<Texture>> colorTextures;
+			std::vector<GLuint> colorRenderbuffers;
+
+			std::unique_ptr<Texture> depthTexture;
+
+			// Number of color attachments fragment outputs are written to
+			uint8_t drawBufferCount = 0;
+
+			/**
+			 * @brief Allocate the storage of a renderbuffer at the current size
+			 * @param[in] renderbuffer	The renderbuffer
+			 * @param[in] format		The internal format
+			 */
+			void storeRenderbuffer(GLuint renderbuffer, GLenum format);
+
+			/**
+			 * @brief Issue the framebuffer barrier if a shader stored to an owned attachment texture since it was last issued
+			 */
+			void syncAttachments();
 	};
 }
 
@@ -0,0 +1,233 @@
+#ifndef OGLOPP_FONT_H
+#define OGLOPP_FONT_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "defines.h"
+#include "shader.h"
+#include "texture.h"
+#include "typedssbo.h"
+
+/*
+ - Font rasterizes the glyphs of a TTF or OTF file with stb_truetype when it is loaded, as signed distance fields packed onto
+   shelves of one single channel atlas. 0.5 is the outline, and the field fades to 0 and 1 over the padding either side of it,
+   so the same atlas draws sharp text at any size, smaller or larger than it was rasterized at
+ - Kerning between every pair of loaded glyphs is read at load time too, so layout needs nothing but the tables in memory
+ - Layout is shaping free: UTF-8 is decoded to codepoints, each placed after the last by its advance and the pair's kerning.
+   '\n' starts a new line, and with a maximum width lines break at the space before a word which would not fit. Codepoints
+   the font has no glyph for draw as '?'. Scripts which need shaping (Arabic, Indic) won't join correctly
+ - TextRenderer batches glyph quads the way SpriteBatch batches sprites: draw() appends to arrays on the CPU, and end() writes
+   them grouped by font into a persistently mapped ring and draws each font's glyphs with one instanced draw, the quads expanded
+   from gl_VertexID. The fragment shader antialiases the outline over about a pixel with fwidth(), whatever the scale
+ - stb_truetype makes single channel fields. Corners are slightly rounded at large sizes, which multi channel fields would keep
+   sharp
+*/
+
+namespace oglopp {
+	/** @brief A font rasterized into a signed distance field atlas
+	*/
+	class Font {
+	public:
+		/** @brief How the atlas is made
+		*/
+		struct Settings {
+			float pixelHeight = 48.0;		// The size glyphs are rasterized at. Larger keeps detail at large sizes
+			int padding = 6;				// Pixels of distance field around each glyph. Also how far outlines can reach
+			int atlasWidth = 1024;
+			std::vector<std::pair<uint32_t, uint32_t>> ranges = {{32, 126}};	// Inclusive codepoint ranges to load
+		};
+
+		/** @brief One glyph. Sizes are in pixels at the rasterized size, y down from the baseline
+		*/
+		struct Glyph {
+			glm::vec2 offset;		// From the pen on the baseline to the top left of the quad
+			glm::vec2 size;			// The quad, padding included. 0 for glyphs with nothing to draw
+			glm::vec4 region;		// Atlas texture coordinates: left, top, right, bottom
+			float advance;			// How far the pen moves
+		};
+
+		/** @brief A glyph placed by layout()
+		*/
+		struct PlacedGlyph {
+			glm::vec2 position;		// Top left of the quad, relative to the top left of the text
+			glm::vec2 size;
+			Glyph const* glyph;
+		};
+
+		Font() = default;
+
+		Font(Font const&) = delete;
+		Font& operator=(Font const&) = delete;
+
+		/** @brief Load a font file and build the atlas with the default settings
+		 * @param[in] path		The TTF or OTF file
+		 * @return				A status code. 0 on success. -1 if the file can't be read or isn't a font
+	 	*/
+		int8_t load(std::string const& path);
+
+		/** @brief Load a font file and build the atlas
+		 * @param[in] path		The TTF or OTF file
+		 * @param[in] settings	How the atlas is made
+		 * @return				A status code. 0 on success. -1 if the file can't be read or isn't a font
+	 	*/
+		int8_t load(std::string const& path, Settings const& settings);
+
+		/** @brief Load a font from memory and build the atlas
+		 * @param[in] data		The font file
+		 * @param[in] size		The size of the file in bytes
+		 * @param[in] settings	How the atlas is made
+		 * @return				A status code. 0 on success. -1 if the data isn't a font
+	 	*/
+		int8_t loadMem(const uint8_t* data, size_t size, Settings const& settings);
+
+		/** @brief Place the glyphs of some text
+		 * @param[in] text		UTF-8 text
+		 * @param[in] size		The line height in pixels to lay out at
+		 * @param[in] maxWidth	The width lines break at, in pixels. 0 to only break at '\n'
+		 * @param[out] glyphs	Appended with the glyphs to draw, or nullptr to only measure
+		 * @return				The width of the widest line and the height of all the lines
+	 	*/
+		glm::vec2 layout(std::string_view text, float size, float maxWidth = 0.0, std::vector<PlacedGlyph>* glyphs = nullptr) const;
+
+		/** @brief Measure some text without placing it
+		 * @param[in] text		UTF-8 text
+		 * @param[in] size		The line height in pixels
+		 * @param[in] maxWidth	The width lines break at, in pixels. 0 to only break at '\n'
+		 * @return				The width of the widest line and the height of all the lines
+	 	*/
+		glm::vec2 measure(std::string_view text, float size, float maxWidth = 0.0) const;
+
+		/** @brief Get a glyph
+		 * @param[in] codepoint		The codepoint
+		 * @return					The glyph, or nullptr if it wasn't loaded
+	 	*/
+		Glyph const* getGlyph(uint32_t codepoint) const;
+
+		/** @brief Get the kerning between two glyphs
+		 * @param[in] first		The codepoint on the left
+		 * @param[in] second	The codepoint on the right
+		 * @return				The pen adjustment in pixels at the rasterized size. Usually 0 or negative
+	 	*/
+		float getKerning(uint32_t first, uint32_t second) const;
+
+		/** @brief Get the distance from one baseline to the next
+		 * @return The line height in pixels at the rasterized size
+	 	*/
+		float getLineHeight() const;
+
+		/** @brief Get the distance from the top of a line to its baseline
+		 * @return The ascent in pixels at the rasterized size
+	 	*/
+		float getAscent() const;
+
+		/** @brief Get the settings the atlas was made with
+		 * @return A reference to the settings
+	 	*/
+		Settings const& getSettings() const;
+
+		/** @brief Get the atlas
+		 * @return The atlas texture, one red channel of distance, or nullptr before load()
+	 	*/
+		Texture* getAtlas();
+
+		/** @brief Check whether a font has been loaded
+		 * @return True if load() or loadMem() succeeded
+	 	*/
+		bool isLoaded() const;
+
+	private:
+		Settings settings;
+		std::unordered_map<uint32_t, Glyph> glyphs;
+		std::unordered_map<uint64_t, float> kerning;		// Only the pairs which aren't 0, keyed by first << 32 | second
+		float ascent = 0.0;
+		float lineHeight = 0.0;
+
+		std::unique_ptr<Texture> atlas;
+	};
+
+	/** @brief Batches text from any number of fonts into one draw per font
+	*/
+	class TextRenderer {
+	public:
+		static constexpr GLuint GLYPH_BINDING = 0;
+
+		/** @brief One glyph quad as stored on the GPU
+		*/
+		struct Instance {
+			glm::vec4 rect;			// Top left xy, size zw
+			glm::vec4 region;		// Atlas texture coordinates: left, top, right, bottom
+			glm::vec4 color;
+		};
+
+		TextRenderer();
+		~TextRenderer();
+
+		TextRenderer(TextRenderer const&) = delete;
+		TextRenderer& operator=(TextRenderer const&) = delete;
+
+		/** @brief Start a batch in pixels over the current viewport, origin at the top left, y down
+		 * @return A reference to this object
+	 	*/
+		TextRenderer& begin();
+
+		/** @brief Start a batch with a projection. Text is laid out y down, so give one whose y points down too
+		 * @param[in] projection	Transforms text positions to clip space
+		 * @return					A reference to this object
+	 	*/
+		TextRenderer& begin(glm::mat4 const& projection);
+
+		/** @brief Add some text
+		 * @param[in] font		The font. It must live until end()
+		 * @param[in] text		UTF-8 text
+		 * @param[in] position	The top left of the text
+		 * @param[in] size		The line height
+		 * @param[in] color		The color
+		 * @param[in] maxWidth	The width lines break at. 0 to only break at '\n'
+		 * @return				The width of the widest line and the height of all the lines
+	 	*/
+		glm::vec2 draw(Font& font, std::string_view text, glm::vec2 const& position, float size, glm::vec4 const& color = glm::vec4(1.0), float maxWidth = 0.0);
+
+		/** @brief Upload the batch and draw it, one draw per font
+		 * @return A reference to this object
+	 	*/
+		TextRenderer& end();
+
+		/** @brief Get the number of glyphs the last end() drew
+		 * @return The glyph count
+	 	*/
+		size_t getGlyphCount() const;
+
+		/** @brief Get the number of draws the last end() made
+		 * @return The draw count
+	 	*/
+		size_t getDrawCount() const;
+
+	private:
+		glm::mat4 projection = glm::mat4(1.0);
+
+		// The batch being built, one list per font
+		std::vector<Font*> fonts;
+		std::vector<std::vector<Instance>> batches;
+		std::vector<Font::PlacedGlyph> placed;
+
+		TypedSSBO<Instance> ring;
+		uint64_t frame = 0;
+		size_t drawn = 0;
+		size_t draws = 0;
+
+		std::unique_ptr<Shader> shader;
+		GLuint vao = 0;
+	};
+
+	OGLOPP_STD430_STRUCT(TextRenderer::Instance, 16);
+	OGLOPP_STD430_MEMBER(TextRenderer::Instance, rect);
+	OGLOPP_STD430_MEMBER(TextRenderer::Instance, region);
+	OGLOPP_STD430_MEMBER(TextRenderer::Instance, color);
+}
+
+#endif
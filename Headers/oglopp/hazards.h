@@ -0,0 +1,58 @@
+#ifndef OGLOPP_HAZARDS_H
+#define OGLOPP_HAZARDS_H
+
+#include "defines.h"
+
+/*
+ - Shader storage, image and atomic counter writes are incoherent: a later read only sees them after a glMemoryBarrier
+   with the bit for that kind of read
+ - Every incoherent write stamps the written resource with a new epoch. Every barrier bit remembers the epoch it was last issued at
+ - Before a use, only the bits whose last barrier is older than the resource's last write are issued,
+   so dispatches which do not depend on each other are not serialized
+*/
+
+namespace oglopp {
+	/** @brief Tracks incoherent writes and issues the glMemoryBarrier bits the next use of a resource needs
+	*/
+	class Hazards {
+	public:
+		typedef uint64_t epoch_t;
+
+		/** @brief Record an incoherent write to a resource
+		 * @param[in,out] lastWrite	The resource's last write epoch, updated to the new epoch
+	 	*/
+		static void written(epoch_t& lastWrite);
+
+		/** @brief Issue whichever of the barrier bits are needed before a resource is used
+		 * @param[in] lastWrite		The resource's last write epoch
+		 * @param[in] barriers		The barrier bits for the kind of use, eg. GL_TEXTURE_FETCH_BARRIER_BIT
+		 * @return					The bits which were issued
+	 	*/
+		static GLbitfield require(epoch_t lastWrite, GLbitfield barriers);
+
+		/** @brief Issue barrier bits needed since any write. For uses which cannot be tied to a resource, eg. an indirect buffer bound by the caller
+		 * @param[in] barriers	The barrier bits
+		 * @return				The bits which were issued
+	 	*/
+		static GLbitfield requireAll(GLbitfield barriers);
+
+		/** @brief Get the epoch of the latest write
+		 * @return The epoch
+	 	*/
+		static epoch_t getEpoch();
+
+		/** @brief Get the number of glMemoryBarrier calls issued so far
+		 * @return The count
+	 	*/
+		static uint64_t getBarrierCount();
+
+	private:
+		static constexpr int BIT_COUNT = 16;	// GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT to GL_QUERY_BUFFER_BARRIER_BIT
+
+		static epoch_t epoch;
+		static epoch_t issued[BIT_COUNT];	// The epoch each barrier bit was last issued at
+		static uint64_t barrierCount;
+	};
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef OGLOPP_INDIRECT_H
+#define OGLOPP_INDIRECT_H
+
+#include <string>
+
+#include "defines.h"
+#include "ssbo.h"
+
+/*
+ - An indirect buffer is an SSBO holding a command count followed by an array of commands, so a compute shader can
+   bind it as a storage block, append commands with atomicAdd(commandCount, 1), and the GPU consumes them without the
+   CPU ever reading anything back
+ - The layout is std430: `uint commandCount; uint pad[3];` then the commands from byte COMMANDS_OFFSET. Each type
+   provides a GLSL declaration of its block through getDeclaration()
+ - Compute::dispatchIndirect() and Shape::drawIndirect() bind the buffer to the indirect target themselves, after
+   GL_COMMAND_BARRIER_BIT if a shader wrote it (see hazards.h)
+ - Multi-draws use the count in the buffer with glMultiDraw*IndirectCount on GL 4.6 (or ARB_indirect_parameters).
+   Without it every command up to the limit is drawn, so unused commands must keep an instanceCount of 0.
+   reset() and the constructor zero every command for that reason
+*/
+
+namespace oglopp {
+	/** @brief An SSBO of indirect commands, with a count a shader can append to
+	*/
+	class IndirectBuffer : public SSBO {
+	public:
+		// The count lives at the start of the buffer. Commands start 16 bytes in so the block keeps std430 alignment
+		static constexpr GLintptr COMMANDS_OFFSET = 16;
+
+		/** @brief Clear the count and every command to zero
+		 * @return A reference to this buffer
+	 	*/
+		IndirectBuffer& reset();
+
+		/** @brief Set the command count from the CPU. Not needed when a shader appends the commands
+		 * @param[in] count	The number of commands
+		 * @return			A reference to this buffer
+	 	*/
+		IndirectBuffer& setCount(uint32_t count);
+
+		/** @brief Get the number of commands the buffer can hold
+		 * @return The capacity
+	 	*/
+		uint32_t getCapacity() const;
+
+		/** @brief Get the size of one command in bytes
+		 * @return The stride
+	 	*/
+		GLsizei getStride() const;
+
+		/** @brief Get the byte offset of a command, as passed to the indirect GL calls
+		 * @param[in] index	The command index
+		 * @return			The offset in bytes
+	 	*/
+		GLintptr getOffset(uint32_t index) const;
+
+		/** @brief Bind the buffer to an indirect target, after the barrier a shader write to it needs
+		 * @param[in] target	GL_DISPATCH_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER or GL_PARAMETER_BUFFER
+		 * @return				A reference to this buffer
+	 	*/
+		IndirectBuffer& bindIndirect(GLenum target);
+
+		/** @brief Check if the GPU side count can be used by multi-draws (GL 4.6 or ARB_indirect_parameters)
+		 * @return True if glMultiDraw*IndirectCount is available
+	 	*/
+		static bool hasIndirectCount();
+
+	protected:
+		uint32_t capacity = 0;
+		GLsizei stride = 0;
+
+		/** @brief Allocate the count and commands
+		 * @param[in] capacity	The number of commands
+		 * @param[in] stride	The size of one command in bytes
+	 	*/
+		IndirectBuffer(uint32_t capacity, GLsizei stride);
+
+		/** @brief Write one command from the CPU
+		 * @param[in] index		The command index
+		 * @param[in] command	A pointer to the command, stride bytes long
+		 * @return				A status code. 0 for success. -1 if the index is out of range
+	 	*/
+		int8_t setCommand(uint32_t index, void const* command);
+
+		/** @brief Build the GLSL declaration of a command block
+		 * @param[in] commandStruct	The GLSL struct of one command, named Command
+		 * @param[in] binding		The storage block binding
+		 * @param[in] blockName		The block name
+		 * @return					The declaration
+	 	*/
+		static std::string getDeclaration(const char* commandStruct, GLuint binding, std::string const& blockName);
+	};
+
+	/** @brief Indirect compute dispatches, for Compute::dispatchIndirect()
+	*/
+	class DispatchIndirectBuffer : public IndirectBuffer {
+	public:
+		// Matches the layout glDispatchComputeIndirect reads
+		struct Command {
+			GLuint numGroupsX;
+			GLuint numGroupsY;
+			GLuint numGroupsZ;
+		};
+
+		static constexpr const char* COMMAND_STRUCT = "struct Command { uint numGroupsX; uint numGroupsY; uint numGroupsZ; };\n";
+
+		/** @brief Create a buffer of zeroed commands
+		 * @param[in] capacity	The number of commands
+	 	*/
+		DispatchIndirectBuffer(uint32_t capacity = 1);
+
+		/** @brief Write one command from the CPU
+		 * @param[in] index		The command index
+		 * @param[in] command	The command
+		 * @return				A reference to this buffer
+	 	*/
+		DispatchIndirectBuffer& set(uint32_t index, Command const& command);
+
+		/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+		 * @param[in] binding	The storage block binding
+		 * @param[in] blockName	The block name
+		 * @return				The declaration
+	 	*/
+		static std::string getDeclaration(GLuint binding, std::string const& blockName = "DispatchCommands");
+	};
+
+	/** @brief Indirect non-indexed draws, for Shape::drawIndirect() on shapes without indices
+	*/
+	class DrawArraysIndirectBuffer : public IndirectBuffer {
+	public:
+		// Matches the layout glDrawArraysIndirect reads
+		struct Command {
+			GLuint count;
+			GLuint instanceCount;
+			GLuint first;
+			GLuint baseInstance;
+		};
+
+		static constexpr const char* COMMAND_STRUCT = "struct Command { uint count; uint instanceCount; uint first; uint baseInstance; };\n";
+
+		/** @brief Create a buffer of zeroed commands
+		 * @param[in] capacity	The number of commands
+	 	*/
+		DrawArraysIndirectBuffer(uint32_t capacity = 1);
+
+		/** @brief Write one command from the CPU
+		 * @param[in] index		The command index
+		 * @param[in] command	The command
+		 * @return				A reference to this buffer
+	 	*/
+		DrawArraysIndirectBuffer& set(uint32_t index, Command const& command);
+
+		/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+		 * @param[in] binding	The storage block binding
+		 * @param[in] blockName	The block name
+		 * @return				The declaration
+	 	*/
+		static std::string getDeclaration(GLuint binding, std::string const& blockName = "DrawCommands");
+	};
+
+	/** @brief Indirect indexed draws, for Shape::drawIndirect() on shapes with indices
+	*/
+	class DrawElementsIndirectBuffer : public IndirectBuffer {
+	public:
+		// Matches the layout glDrawElementsIndirect reads
+		struct Command {
+			GLuint count;
+			GLuint instanceCount;
+			GLuint firstIndex;
+			GLint baseVertex;
+			GLuint baseInstance;
+		};
+
+		static constexpr const char* COMMAND_STRUCT = "struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n";
+
+		/** @brief Create a buffer of zeroed commands
+		 * @param[in] capacity	The number of commands
+	 	*/
+		DrawElementsIndirectBuffer(uint32_t capacity = 1);
+
+		/** @brief Write one command from the CPU
+		 * @param[in] index		The command index
+		 * @param[in] command	The command
+		 * @return				A reference to this buffer
+	 	*/
+		DrawElementsIndirectBuffer& set(uint32_t index, Command const& command);
+
+		/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+		 * @param[in] binding	The storage block binding
+		 * @param[in] blockName	The block name
+		 * @return				The declaration
+	 	*/
+		static std::string getDeclaration(GLuint binding, std::string const& blockName = "DrawCommands");
+	};
+}
+
+#endif
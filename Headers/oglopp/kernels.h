@@ -0,0 +1,82 @@
+#ifndef OGLOPP_KERNELS_H
+#define OGLOPP_KERNELS_H
+
+#include <memory>
+#include <string>
+
+#include "defines.h"
+#include "compute.h"
+#include "ssbo.h"
+#include "texture.h"
+
+/*
+ - Compute kernels which read a texture through a sampler and write another with imageStore
+ - Targets must be created with a float or normalized internal format (Texture(width, height, format)),
+   since the kernels store through a writeonly image2D
+ - Each shader is compiled the first time its kernel is used
+*/
+
+namespace oglopp {
+	/** @brief A small library of tiled image compute kernels
+	*/
+	class ImageKernels {
+	public:
+		static constexpr int BLUR_TILE = 128;			// Pixels along the blur axis per work group
+		static constexpr int BLUR_MAX_RADIUS = 32;		// Largest radius the shared memory tile has room for
+		static constexpr int DOWNSAMPLE_LOCAL_SIZE = 8;
+		static constexpr int HISTOGRAM_LOCAL_SIZE = 16;
+		static constexpr int HISTOGRAM_BINS = 256;		// Must equal HISTOGRAM_LOCAL_SIZE squared
+
+		ImageKernels() = default;
+
+		/** @brief Separable gaussian blur. Each work group caches a row (or column) segment and its apron in shared memory,
+		 *  so every texel is fetched once per pass instead of once per tap
+		 * @param[in] source		The texture to blur
+		 * @param[in] target		The texture to write the result to. Same size as the source
+		 * @param[in] temporary		Holds the horizontal pass. Same size and format as the target
+		 * @param[in] radius		The number of texels on each side of the center. Clamped to BLUR_MAX_RADIUS
+		 * @param[in] sigma			The gaussian's standard deviation in texels. 0 for radius / 2
+		 * @return					A status code. 0 for success. -1 if the textures are not the same size
+	 	*/
+		int8_t blur(Texture& source, Texture& target, Texture& temporary, int radius = 4, float sigma = 0.f);
+
+		/** @brief Average each 2x2 block of the source into one pixel of the target
+		 * @param[in] source	The texture to downsample
+		 * @param[in] target	The texture to write to. Half the size of the source, rounded up
+		 * @return				A status code. 0 for success. -1 if the target is too small
+	 	*/
+		int8_t downsample(Texture& source, Texture& target);
+
+		/** @brief Count the luminance of every pixel into HISTOGRAM_BINS bins. Each work group counts into shared memory first,
+		 *  so the global buffer only sees one atomic per bin per group
+		 * @param[in] source	The texture to read
+		 * @param[out] bins		Receives HISTOGRAM_BINS uints. It must already hold at least that many. It is cleared first
+		 * @param[in] minimum	The luminance mapped to the first bin
+		 * @param[in] maximum	The luminance mapped to the last bin
+		 * @return				A status code. 0 for success. -1 if the buffer is too small
+	 	*/
+		int8_t histogram(Texture& source, SSBO& bins, float minimum = 0.f, float maximum = 1.f);
+
+	private:
+		std::unique_ptr<Compute> blurKernel;
+		std::unique_ptr<Compute> downsampleKernel;
+		std::unique_ptr<Compute> histogramKernel;
+
+		/** @brief Get the GLSL of the blur kernel
+		 * @return The GLSL source
+	 	*/
+		static std::string getBlurSource();
+
+		/** @brief Get the GLSL of the downsample kernel
+		 * @return The GLSL source
+	 	*/
+		static std::string getDownsampleSource();
+
+		/** @brief Get the GLSL of the histogram kernel
+		 * @return The GLSL source
+	 	*/
+		static std::string getHistogramSource();
+	};
+}
+
+#endif
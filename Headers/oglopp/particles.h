@@ -0,0 +1,220 @@
+#ifndef OGLOPP_PARTICLES_H
+#define OGLOPP_PARTICLES_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "window.h"
+#include "billboard.h"
+#include "compute.h"
+#include "indirect.h"
+#include "primitives.h"
+#include "typedssbo.h"
+
+/*
+ - Particles live in a fixed pool. Free slots are on a dead list, live ones on an alive list, both arrays of pool indices
+   with their lengths in a counter buffer. Emitting pops the dead list and appends to the alive list with atomics, and the update
+   pushes expired particles back onto the dead list. Nothing is ever scanned for free slots
+ - There are two alive lists. The update reads one and appends the survivors to the other, so the list stays compacted, and
+   the roles swap every frame
+ - The CPU never reads a count back. A one invocation pass sizes the update dispatch from the alive count (dispatchIndirect) and
+   another writes the instance count of the draw (glDrawArraysIndirect)
+ - Particles are drawn by a BillboardRenderer, as camera facing quads expanded in the vertex shader straight from the pool
+ - With sorting on, the draw order is the alive list sorted back to front by ComputePrimitives::sort() on 16 bit depth keys,
+   for alpha blending. Additive blending needs no sort
+ - Each emitter emits rate * dt particles per update, carrying the fraction over. emit() adds a burst. Emitting more than the
+   dead list holds drops the rest
+*/
+
+namespace oglopp {
+	/** @brief A pool of GPU simulated particles
+	*/
+	class ParticleSystem {
+	public:
+		static constexpr uint32_t LOCAL_SIZE = 256;
+		static constexpr uint32_t MAX_UPDATE_GROUPS = 65535;		// The update loops over the alive list when it needs more
+
+		/** @brief One particle as stored on the GPU
+		*/
+		struct Particle {
+			glm::vec4 position;		// xyz, w is the age in seconds
+			glm::vec4 velocity;		// xyz, w is the lifetime in seconds
+			glm::vec4 size;			// start size, end size, rotation, angular velocity
+			glm::uvec4 color;		// start and end colors packed with packUnorm4x8, 2 unused
+		};
+
+		/** @brief Where and how particles are emitted
+		*/
+		struct Emitter {
+			glm::vec3 position = glm::vec3(0.0);
+			glm::vec3 velocity = glm::vec3(0.0, 1.0, 0.0);
+			float spread = 0.5;					// Random velocity added on each axis, up to this much either way
+			float rate = 1000.0;				// Particles per second
+			float lifetime = 2.0;				// Seconds
+			float lifetimeVariance = 0.0;		// Random lifetime added, up to this much either way
+			float startSize = 0.05;
+			float endSize = 0.0;
+			float spin = 0.0;					// Random angular velocity, up to this many radians per second either way
+			glm::vec4 startColor = glm::vec4(1.0);
+			glm::vec4 endColor = glm::vec4(1.0, 1.0, 1.0, 0.0);
+			bool enabled = true;
+		};
+
+		/** @brief Create a particle pool. Every particle starts dead
+		 * @param[in] capacity	The most particles alive at once
+	 	*/
+		ParticleSystem(uint32_t capacity);
+
+		ParticleSystem(ParticleSystem const&) = delete;
+		ParticleSystem& operator=(ParticleSystem const&) = delete;
+
+		/** @brief Add an emitter, run by every update()
+		 * @param[in] emitter	The emitter settings
+		 * @return				The emitter index
+	 	*/
+		size_t addEmitter(Emitter const& emitter);
+
+		/** @brief Get an emitter to change its settings
+		 * @param[in] index		The emitter index
+		 * @return				A reference to the emitter
+	 	*/
+		Emitter& getEmitter(size_t index);
+
+		/** @brief Get the number of emitters
+		 * @return The emitter count
+	 	*/
+		size_t getEmitterCount() const;
+
+		/** @brief Emit a burst of particles now. They are simulated from the next update()
+		 * @param[in] emitter	The emitter settings. The rate is ignored
+		 * @param[in] count		The number of particles
+		 * @return				A reference to this object
+	 	*/
+		ParticleSystem& emit(Emitter const& emitter, uint32_t count);
+
+		/** @brief Run the emitters, then age, move and retire every live particle
+		 * @param[in] dt	The time step in seconds
+		 * @return			A reference to this object
+	 	*/
+		ParticleSystem& update(float dt);
+
+		/** @brief Draw the live particles. Call after the camera's projection and view are updated for the frame
+		 * @param[in] window	The window whose camera to draw from
+		 * @return				A reference to this object
+	 	*/
+		ParticleSystem& draw(Window& window);
+
+		/** @brief Set the acceleration applied to every particle
+		 * @param[in] gravity	The acceleration
+		 * @return				A reference to this object
+	 	*/
+		ParticleSystem& setGravity(glm::vec3 const& gravity);
+
+		/** @brief Set the fraction of velocity lost per second
+		 * @param[in] drag	The drag
+		 * @return			A reference to this object
+	 	*/
+		ParticleSystem& setDrag(float drag);
+
+		/** @brief Draw back to front, sorted on the GPU every draw
+		 * @param[in] sorting	True to sort
+		 * @return				A reference to this object
+	 	*/
+		ParticleSystem& setSorting(bool sorting);
+
+		/** @brief Set how particles blend with what is behind them
+		 * @param[in] mode	The blend mode. ALPHA looks right with sorting on
+		 * @return			A reference to this object
+	 	*/
+		ParticleSystem& setBlendMode(BillboardRenderer::BlendMode mode);
+
+		/** @brief Get the pool size
+		 * @return The most particles alive at once
+	 	*/
+		uint32_t getCapacity() const;
+
+		/** @brief Get the particle pool, eg. to draw it some other way
+		 * @return The particles. Dead ones hold stale data
+	 	*/
+		TypedSSBO<Particle>& getParticles();
+
+		/** @brief Get the draw command written by the last update(). Its instance count is the number of live particles
+		 * @return The draw command buffer
+	 	*/
+		DrawArraysIndirectBuffer& getDrawCommand();
+
+		/** @brief Read the lists back and check that every particle is on exactly one of them. This waits for the GPU
+		 * @param[out] alive	The number of live particles, or nullptr
+		 * @return				A status code. 0 if the lists are consistent. -1 otherwise
+	 	*/
+		int8_t validate(uint32_t* alive = nullptr);
+
+	private:
+		// Storage bindings used by the kernels and the draw
+		enum Binding : GLuint {
+			PARTICLES = 0,
+			DEAD_LIST,
+			ALIVE_LISTS,
+			COUNTERS,
+			COMMANDS,
+			SORT_KEYS,
+			SORT_VALUES
+		};
+
+		uint32_t capacity;
+		uint32_t current = 0;			// The alive list holding the live particles
+		uint32_t seed = 0;
+
+		glm::vec3 gravity = glm::vec3(0.0, -9.81, 0.0);
+		float drag = 0.0;
+		bool sorting = false;
+
+		std::vector<Emitter> emitters;
+		std::vector<double> emitCarry;	// The fraction of a particle each emitter owes
+
+		TypedSSBO<Particle> particles;
+		SSBO deadList;
+		SSBO aliveLists;				// Two lists of capacity entries each
+		SSBO counters;
+		DispatchIndirectBuffer dispatchArgs;
+		DrawArraysIndirectBuffer drawCommand;
+
+		SSBO sortKeys;
+		SSBO sortValues;
+		std::unique_ptr<ComputePrimitives> primitives;
+
+		std::unique_ptr<Compute> emitKernel;
+		std::unique_ptr<Compute> prepareKernel;
+		std::unique_ptr<Compute> updateKernel;
+		std::unique_ptr<Compute> finalizeKernel;
+		std::unique_ptr<Compute> sortKeysKernel;
+		std::unique_ptr<BillboardRenderer> renderer;
+
+		/** @brief Bind the pool, lists and counters to a kernel
+		 * @param[in] kernel	The kernel about to be dispatched
+	 	*/
+		void bindPool(Compute& kernel);
+
+		/** @brief Get the GLSL shared by every kernel: the particle struct, the pool, the lists and the counters
+		 * @param[in] localSize		The local size of the kernel
+		 * @return					The source, starting with the #version line
+	 	*/
+		static std::string getKernelHeader(uint32_t localSize);
+
+		/** @brief Get the GLSL of the particle struct and the pool block
+		 * @param[in] qualifier		The block memory qualifier, eg. readonly, or an empty string
+		 * @return					The source
+	 	*/
+		static std::string getPoolDeclaration(std::string const& qualifier);
+	};
+
+	OGLOPP_STD430_STRUCT(ParticleSystem::Particle, 16);
+	OGLOPP_STD430_MEMBER(ParticleSystem::Particle, position);
+	OGLOPP_STD430_MEMBER(ParticleSystem::Particle, velocity);
+	OGLOPP_STD430_MEMBER(ParticleSystem::Particle, size);
+	OGLOPP_STD430_MEMBER(ParticleSystem::Particle, color);
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef OGLOPP_PINGPONG_H
+#define OGLOPP_PINGPONG_H
+
+#include <functional>
+#include <string>
+
+#include "defines.h"
+#include "ssbo.h"
+#include "compute.h"
+
+/*
+ - A PingPongBuffer owns two SSBOs of the same size. One holds the current state and is read, the other receives the next
+   state. Swapping the roles costs nothing, so an iterative simulation never copies its state
+ - bind() attaches the current state to the read binding as read only and the other buffer to the write binding, through
+   Compute::bindSSBO(). The barriers come from the hazard tracking: one GL_SHADER_STORAGE_BARRIER_BIT per substep, for the
+   read of the previous substep's output. Overwriting the buffer read a substep earlier needs none, since dispatches run in order
+ - step() runs any number of substeps with a bind, a dispatch and a swap each, so the binding cost per substep stays two
+   glBindBufferBase calls whatever the step count
+ - After step(), getRead() holds the latest state, eg. for a draw reading it as shader storage
+ - Don't also give the Compute an SSBO with setSSBO() at either binding, since dispatch() binds it over these
+*/
+
+namespace oglopp {
+	/** @brief Two storage buffers holding the current and next state of a simulation
+	*/
+	class PingPongBuffer {
+	public:
+		// Called before each substep's dispatch with the compute program in use, eg. to set a time uniform
+		typedef std::function<void(Compute&, uint32_t)> SubstepFunction;
+
+		/** @brief Create the buffer pair. Nothing is allocated until load()
+		 * @param[in] readBinding	The binding of the current state
+		 * @param[in] writeBinding	The binding of the next state
+	 	*/
+		PingPongBuffer(GLuint readBinding = 0, GLuint writeBinding = 1);
+
+		/** @brief Load the same initial state into both buffers
+		 * @param[in] buffer	A pointer to the initial state
+		 * @param[in] size		The size of the state in bytes
+		 * @return				A status code. 0 for success. -1 for failure
+	 	*/
+		int8_t load(void* buffer, size_t size);
+
+		/** @brief Change the binding points
+		 * @param[in] readBinding	The binding of the current state
+		 * @param[in] writeBinding	The binding of the next state
+		 * @return					A reference to this object
+	 	*/
+		PingPongBuffer& setBindings(GLuint readBinding, GLuint writeBinding);
+
+		/** @brief Bind the current state for reading and the other buffer for writing
+		 * @param[in] compute	The compute program about to be dispatched
+		 * @return				A reference to this object
+	 	*/
+		PingPongBuffer& bind(Compute& compute);
+
+		/** @brief Make the buffer last written the current state
+		 * @return A reference to this object
+	 	*/
+		PingPongBuffer& swap();
+
+		/** @brief Run some number of simulation substeps, each reading the state the previous one wrote.
+		 *  The shader uses Compute::ELEMENT_INDEX_FUNCTION
+		 * @param[in] compute		The compute program
+		 * @param[in] elements		The number of elements to dispatch per substep
+		 * @param[in] substeps		The number of substeps
+		 * @param[in] perSubstep	Called before every dispatch with the substep index, or nullptr
+		 * @return					A status code. 0 for success. -1 if a dispatch failed
+	 	*/
+		int8_t step(Compute& compute, uint32_t elements, uint32_t substeps = 1, SubstepFunction const& perSubstep = nullptr);
+
+		/** @brief Get the buffer holding the current state
+		 * @return The current state
+	 	*/
+		SSBO& getRead();
+
+		/** @brief Get the buffer the next substep writes
+		 * @return The next state
+	 	*/
+		SSBO& getWrite();
+
+		/** @brief Get the number of swaps so far
+		 * @return The step count
+	 	*/
+		uint64_t getStepCount() const;
+
+		/** @brief Get the GLSL declaration of both blocks, as arrays of some type named current and next
+		 * @param[in] type			The element type, eg. vec4 or a struct declared before it
+		 * @param[in] readBinding	The binding of the current state
+		 * @param[in] writeBinding	The binding of the next state
+		 * @return					The GLSL source
+	 	*/
+		static std::string getDeclaration(std::string const& type, GLuint readBinding = 0, GLuint writeBinding = 1);
+
+	private:
+		SSBO buffers[2];
+		uint8_t current = 0;
+
+		GLuint readBinding;
+		GLuint writeBinding;
+
+		uint64_t steps = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef OGLOPP_PLOT_H
+#define OGLOPP_PLOT_H
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "defines.h"
+#include "shader.h"
+#include "typedssbo.h"
+
+/*
+ - setData() copies the samples and builds a min/max pyramid over them. Level k holds the lowest and highest sample of every
+   run of 2^k samples, each level made from the one below, so the whole pyramid is about twice the samples
+ - draw() picks the level with one or two runs per pixel across the current viewport, or the samples themselves once there are
+   fewer than two a pixel, so a zoomed out plot draws about 4 points per pixel column however long the series is
+ - A run is drawn as a vertical stroke from its min to its max, alternating direction so consecutive strokes join without
+   crossing. That covers every pixel the full line would
+ - Only the runs inside the view are written, straight into a persistently mapped ring of regions (see ssbo.h), and only when the
+   view, the data or the viewport width changed. x is stored relative to the left edge of the view, so long time axes keep
+   their precision in floats
+ - Lines are drawn as instanced quads, one per segment, expanded to the line width in pixels in the vertex shader. The fragment
+   shader keeps the pixels within half the width of the segment, which rounds the ends, so segments meet in round joins,
+   antialiased over one pixel. With a translucent color the joins are blended twice
+*/
+
+namespace oglopp {
+	/** @brief Draws a long evenly sampled series as a thick line, decimated to the pixels it covers
+	*/
+	class LinePlot {
+	public:
+		static constexpr GLuint POINT_BINDING = 0;
+
+		LinePlot();
+		~LinePlot();
+
+		LinePlot(LinePlot const&) = delete;
+		LinePlot& operator=(LinePlot const&) = delete;
+
+		/** @brief Replace the series and rebuild the pyramid
+		 * @param[in] samples	The values, evenly spaced along x
+		 * @param[in] start		The x of the first sample
+		 * @param[in] step		The x distance between samples. Must be positive
+		 * @return				A reference to this object
+	 	*/
+		LinePlot& setData(std::span<const float> samples, double start = 0.0, double step = 1.0);
+
+		/** @brief Set the part of the plot which fills the viewport
+		 * @param[in] xMin	The x at the left edge
+		 * @param[in] xMax	The x at the right edge
+		 * @param[in] yMin	The y at the bottom edge
+		 * @param[in] yMax	The y at the top edge
+		 * @return			A reference to this object
+	 	*/
+		LinePlot& setView(double xMin, double xMax, float yMin, float yMax);
+
+		/** @brief Set the view to the whole series, from the lowest to the highest sample
+		 * @return A reference to this object
+	 	*/
+		LinePlot& fitView();
+
+		/** @brief Get the lowest and highest sample between two x values, from the pyramid
+		 * @param[in] xMin	The start of the range
+		 * @param[in] xMax	The end of the range
+		 * @return			The lowest sample in x and the highest in y. Both 0 with no samples in the range
+	 	*/
+		glm::vec2 getRange(double xMin, double xMax) const;
+
+		/** @brief Set the line color
+		 * @param[in] color	The color
+		 * @return			A reference to this object
+	 	*/
+		LinePlot& setColor(glm::vec4 const& color);
+
+		/** @brief Set the line width
+		 * @param[in] pixels	The width in pixels
+		 * @return				A reference to this object
+	 	*/
+		LinePlot& setWidth(float pixels);
+
+		/** @brief Draw the view of the series over the current viewport
+		 * @return A reference to this object
+	 	*/
+		LinePlot& draw();
+
+		/** @brief Get the number of samples
+		 * @return The sample count
+	 	*/
+		size_t getSampleCount() const;
+
+		/** @brief Get the number of pyramid levels, counting the samples as level 0
+		 * @return The level count
+	 	*/
+		uint32_t getLevelCount() const;
+
+		/** @brief Get the level the last draw() used
+		 * @return The level. 0 is the samples themselves
+	 	*/
+		uint32_t getLevel() const;
+
+		/** @brief Get the number of points the last draw() drew
+		 * @return The point count
+	 	*/
+		size_t getDrawnPoints() const;
+
+	private:
+		std::vector<float> samples;
+		std::vector<std::vector<glm::vec2>> levels;		// Level k at k - 1: the min and max of each run of 2^k samples
+		double start = 0.0;
+		double step = 1.0;
+
+		double xMin = 0.0;
+		double xMax = 1.0;
+		float yMin = 0.0;
+		float yMax = 1.0;
+		glm::vec4 color = glm::vec4(1.0);
+		float width = 1.5;
+
+		// The points of the current view, written again when dirty
+		TypedSSBO<glm::vec2> ring;
+		uint64_t frame = 0;
+		bool dirty = true;
+		int viewportWidth = 0;
+		double pointsOrigin = 0.0;		// The x the points are stored relative to
+		uint32_t level = 0;
+		size_t points = 0;
+
+		std::unique_ptr<Shader> shader;
+		GLuint vao = 0;
+
+		/** @brief Write the points of the view for the viewport width into the next region of the ring
+	 	*/
+		void stream();
+	};
+}
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef OGLOPP_POINTCLOUD_H
+#define OGLOPP_POINTCLOUD_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+#include "window.h"
+#include "shader.h"
+#include "typedssbo.h"
+
+/*
+ - PointCloudBuilder partitions points into an octree offline. Each node keeps at most chunkSize points, a random sample of
+   the points inside it, and passes the rest down to its children. A node and all of its ancestors together are the cloud
+   at that node's detail, so finer nodes only add points and nothing is stored twice. The input is shuffled once up front,
+   and partitioning keeps the order, so the first chunkSize points of any node are a uniform sample of it
+ - The file is a Header, the Node table and then every node's points, in that order, all fixed size and little endian so
+   PointCloud can memory map it and read nodes in place
+ - PointCloud picks nodes every update() from the camera: nodes outside the frustum are skipped, and a node is refined into
+   its children while the spacing of its points on screen is larger than setPixelSpacing(). Nodes are visited largest on
+   screen first, up to setPointBudget() points, so the cost follows the screen resolution rather than the size of the data
+ - Wanted nodes are read from the mapped file on a background thread, which is where the page faults land. update() uploads
+   what it has read into a pool of chunkSize slots on the GPU, no more than setUploadsPerFrame() a frame, evicting the least
+   recently drawn nodes once the pool, sized from the memory budget, is full
+ - draw() is one glMultiDrawArrays of the resident selected nodes with the POINTS draw type. The vertex shader reads the pool
+   as shader storage by gl_VertexID, so there is no vertex layout to set up
+ - The builder holds its input in memory, 16 bytes a point. Only the runtime is out of core
+*/
+
+namespace oglopp {
+	/** @brief Streams an octree of points from a memory mapped file and draws the part the camera needs
+	*/
+	class PointCloud {
+	public:
+		static constexpr uint32_t VERSION = 1;
+		static constexpr uint32_t DEFAULT_CHUNK_SIZE = 16384;
+		static constexpr uint32_t NONE = 0xFFFFFFFF;
+		static constexpr GLuint POINT_BINDING = 0;
+		static constexpr size_t DEFAULT_BUDGET = 256 << 20;
+
+		/** @brief One point as stored in the file and on the GPU. GLSL declares it as 4 scalars, since std430 only lets a uint
+		 * fill the end of a vec3 when they are separate members
+		*/
+		struct Point {
+			glm::vec3 position;
+			uint32_t color;			// Packed with packUnorm4x8
+		};
+
+		/** @brief The start of the file
+		*/
+		struct Header {
+			char magic[8];			// "OGLOPPC" and a terminator
+			uint32_t version;
+			uint32_t chunkSize;		// The most points in one node
+			uint32_t nodeCount;
+			uint32_t depth;			// The deepest level
+			uint64_t pointCount;	// Points stored, over every node
+			uint64_t nodesOffset;	// Byte offset of the node table
+			glm::vec3 min;			// The root cube
+			float size;
+		};
+
+		/** @brief One octree node. The root is node 0
+		*/
+		struct Node {
+			glm::vec3 min;			// The node's cube
+			float size;
+			uint64_t offset;		// Byte offset of the points
+			uint32_t count;			// The number of points, at most the chunk size
+			uint32_t parent;		// NONE for the root
+			uint32_t children[8];	// NONE where a child is empty. Index bit 0 is +x, bit 1 +y and bit 2 +z
+			float spacing;			// The average distance between the node's points in world units
+			uint32_t level;
+		};
+
+		PointCloud();
+		~PointCloud();
+
+		PointCloud(PointCloud const&) = delete;
+		PointCloud& operator=(PointCloud const&) = delete;
+
+		/** @brief Map a file written by PointCloudBuilder and start the loader thread
+		 * @param[in] path		The file
+		 * @param[in] budget	The GPU memory for points in bytes. The pool holds this many bytes rounded down to whole chunks
+		 * @return				A status code. 0 on success. -1 if the file can't be mapped or isn't a valid point cloud
+	 	*/
+		int8_t open(std::string const& path, size_t budget = DEFAULT_BUDGET);
+
+		/** @brief Stop the loader, unmap the file and release the pool. open() can be called again after
+	 	*/
+		void close();
+
+		/** @brief Pick the nodes to draw from the camera, queue the missing ones for loading and upload what has been loaded.
+		 * Call after the camera's projection and view are updated for the frame
+		 * @param[in] window	The window whose camera to pick for
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& update(Window& window);
+
+		/** @brief Draw the nodes picked by the last update() which are on the GPU
+		 * @param[in] window	The window whose camera to draw from
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& draw(Window& window);
+
+		/** @brief Set the spacing between points on screen which is fine enough. Nodes are refined until they are this dense
+		 * @param[in] pixels	The spacing in pixels. Smaller draws more points
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& setPixelSpacing(float pixels);
+
+		/** @brief Set the size points are drawn at
+		 * @param[in] pixels	The point size in pixels
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& setPointSize(float pixels);
+
+		/** @brief Set the most points to pick in one update(), whatever the spacing asks for
+		 * @param[in] points	The point budget
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& setPointBudget(uint64_t points);
+
+		/** @brief Set the most nodes uploaded to the GPU in one update(), to bound the time spent copying each frame
+		 * @param[in] nodes		The node count
+		 * @return				A reference to this object
+	 	*/
+		PointCloud& setUploadsPerFrame(uint32_t nodes);
+
+		/** @brief Check whether a file is open
+		 * @return True if open() succeeded and close() hasn't been called since
+	 	*/
+		bool isOpen() const;
+
+		/** @brief Get the header of the open file
+		 * @return A reference to the header
+	 	*/
+		Header const& getHeader() const;
+
+		/** @brief Get a node of the open file
+		 * @param[in] index		The node index
+		 * @return				A reference to the node
+	 	*/
+		Node const& getNode(uint32_t index) const;
+
+		/** @brief Get the number of points the last update() picked and are on the GPU, which draw() draws
+		 * @return The point count
+	 	*/
+		uint64_t getDrawnPoints() const;
+
+		/** @brief Get the number of nodes the last update() picked, loaded or not
+		 * @return The node count
+	 	*/
+		size_t getSelectedNodes() const;
+
+		/** @brief Get the number of nodes on the GPU
+		 * @return The node count
+	 	*/
+		size_t getResidentNodes() const;
+
+		/** @brief Get the number of nodes the pool can hold
+		 * @return The slot count
+	 	*/
+		uint32_t getSlotCount() const;
+
+		/** @brief Get the number of nodes queued or being read by the loader
+		 * @return The node count
+	 	*/
+		size_t getPendingLoads() const;
+
+		/** @brief Get the point pool, eg. to draw it some other way
+		 * @return The pool. Slot i holds chunkSize points from point i * chunkSize
+	 	*/
+		TypedSSBO<Point>& getPool();
+
+	private:
+		enum State : uint8_t {
+			UNLOADED,
+			QUEUED,			// Waiting for or being read by the loader
+			RESIDENT		// In a slot of the pool
+		};
+
+		// A node read by the loader, waiting for update() to upload it
+		struct Loaded {
+			uint32_t node;
+			std::vector<Point> points;
+		};
+
+		// The mapped file
+		void const* mapping = nullptr;
+		size_t mappingSize = 0;
+#if defined(_WIN32) || defined(_WIN64)
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int fileDescriptor = -1;
+#endif
+		Header const* header = nullptr;
+		Node const* nodes = nullptr;
+
+		float pixelSpacing = 2.0;
+		float pointSize = 2.0;
+		uint64_t pointBudget = 8 << 20;
+		uint32_t uploadsPerFrame = 16;
+		uint64_t frame = 0;
+
+		// Main thread state, one entry per node
+		std::vector<State> states;
+		std::vector<uint32_t> slots;
+		std::vector<uint64_t> lastUsed;
+
+		// The pool and what each slot holds
+		TypedSSBO<Point> pool;
+		uint32_t slotCount = 0;
+		std::vector<uint32_t> slotNodes;
+		std::vector<uint32_t> freeSlots;
+
+		// The last selection, in priority order, and the draw ranges of the resident part of it
+		std::vector<uint32_t> selected;
+		std::vector<GLint> firsts;
+		std::vector<GLsizei> counts;
+		uint64_t drawnPoints = 0;
+
+		// Shared with the loader thread
+		mutable std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<uint32_t> requests;
+		std::vector<Loaded> loaded;
+		size_t reading = 0;
+		bool stopping = false;
+		std::thread loader;
+
+		std::unique_ptr<Shader> shader;
+		GLuint vao = 0;
+
+		/** @brief Pick the nodes to draw, largest on screen first
+		 * @param[in] window	The window whose camera to pick for
+	 	*/
+		void select(Window& window);
+
+		/** @brief Replace the loader's queue with the wanted nodes which aren't on the GPU
+	 	*/
+		void request();
+
+		/** @brief Upload loaded nodes into free or evicted slots
+	 	*/
+		void upload();
+
+		/** @brief Find a slot for a node, evicting the least recently used node which wasn't picked this frame
+		 * @return The slot, or NONE if every slot is in use this frame
+	 	*/
+		uint32_t acquireSlot();
+
+		/** @brief The loader thread. Reads requested nodes out of the mapping until close()
+	 	*/
+		void loadLoop();
+
+		/** @brief Unmap the file and close its handles
+	 	*/
+		void unmap();
+	};
+
+	/** @brief Builds the octree file PointCloud streams from
+	*/
+	class PointCloudBuilder {
+	public:
+		static constexpr uint32_t DEFAULT_MAX_DEPTH = 20;
+
+		/** @brief Create a builder
+		 * @param[in] chunkSize		The most points in one node
+		 * @param[in] maxDepth		The deepest level. Points past the chunk size in nodes this deep are dropped, which only happens
+		 *							with many points at nearly the same position
+	 	*/
+		PointCloudBuilder(uint32_t chunkSize = PointCloud::DEFAULT_CHUNK_SIZE, uint32_t maxDepth = DEFAULT_MAX_DEPTH);
+
+		/** @brief Add a point
+		 * @param[in] position	The position
+		 * @param[in] color		The color, each channel from 0 to 1
+		 * @return				A reference to this object
+	 	*/
+		PointCloudBuilder& add(glm::vec3 const& position, glm::vec4 const& color = glm::vec4(1.0));
+
+		/** @brief Add some points
+		 * @param[in] points	The points, colors already packed
+		 * @return				A reference to this object
+	 	*/
+		PointCloudBuilder& add(std::span<const PointCloud::Point> points);
+
+		/** @brief Get the number of points added
+		 * @return The point count
+	 	*/
+		size_t getPointCount() const;
+
+		/** @brief Build the octree and write it to a file. The points added are kept, shuffled
+		 * @param[in] path	The file to write
+		 * @return			A status code. 0 on success. -1 if there are no points or the file can't be written
+	 	*/
+		int8_t write(std::string const& path);
+
+	private:
+		uint32_t chunkSize;
+		uint32_t maxDepth;
+
+		std::vector<PointCloud::Point> points;
+		glm::vec3 min = glm::vec3(0.0);
+		glm::vec3 max = glm::vec3(0.0);
+
+		// The nodes being built, and the first point of each in the partitioned points
+		std::vector<PointCloud::Node> nodes;
+		std::vector<size_t> starts;
+		uint64_t dropped = 0;
+
+		/** @brief Build a node over a range of points, then its children over what it doesn't keep
+		 * @param[in] begin		The first point
+		 * @param[in] end		One past the last point
+		 * @param[in] min		The corner of the node's cube
+		 * @param[in] size		The edge of the node's cube
+		 * @param[in] level		The node's depth
+		 * @param[in] parent	The parent index, or NONE
+		 * @return				The node index
+	 	*/
+		uint32_t build(size_t begin, size_t end, glm::vec3 const& min, float size, uint32_t level, uint32_t parent);
+	};
+
+	// Its GLSL struct is 4 scalars
+	OGLOPP_STD430_STRUCT(PointCloud::Point, 4);
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef OGLOPP_POSTPROCESS_H
+#define OGLOPP_POSTPROCESS_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "fbo.h"
+#include "shader.h"
+#include "texture.h"
+#include "window.h"
+
+/*
+ - Every pass draws one attribute-less triangle covering the screen. There is no vertex buffer, and no diagonal seam
+   where the two triangles of a quad would shade some pixels twice
+ - An effect is a full pass. Its code sets `vec4 color` using `source`, `original`, `uv` and `texelSize`
+ - A color op only changes `color`, so it is pasted into the pass before it instead of getting a pass of its own
+ - Passes ping-pong between two targets per resolution scale. The last pass always draws at the output's resolution
+ - A chain whose shaders fail to build reports it once and draws nothing. It is rebuilt only after the effects change
+*/
+
+namespace oglopp {
+	/** @brief A sequence of fullscreen fragment effects
+	*/
+	class PostProcessChain {
+	public:
+		typedef std::function<void(Shader&)> UniformFunction;
+
+		// Draws a triangle twice the size of the screen from gl_VertexID alone. uv is 0 to 1 over the visible part
+		static constexpr const char* FULLSCREEN_TRIANGLE_VERTEX =
+			"#version 330 core\n"\
+			"out vec2 uv;\n"\
+			"void main() {\n"\
+				"vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"\
+				"uv = p;\n"\
+				"gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"\
+			"}\n";
+
+		/** @brief Create an empty chain
+		 * @param[in] format	The internal format of the intermediate targets
+	 	*/
+		PostProcessChain(GLenum format = GL_RGBA8);
+		~PostProcessChain();
+
+		/** @brief Add an effect which runs in its own pass
+		 * @param[in] name			A name for debugging
+		 * @param[in] code			GLSL which sets `vec4 color`. `color` starts as the source texel at uv
+		 * @param[in] scale			The pass's resolution relative to the output, eg. 0.5 for half resolution. Ignored for the last pass
+		 * @param[in] uniforms		Optionally set the effect's uniforms. The shader is already in use
+		 * @param[in] declarations	GLSL placed before main(), eg. uniforms and functions
+		 * @return					A reference to this object
+	 	*/
+		PostProcessChain& addEffect(std::string const& name, std::string const& code, float scale = 1.f, UniformFunction uniforms = nullptr, std::string const& declarations = "");
+
+		/** @brief Add a per-pixel color operation. It is fused into the pass before it, so it costs no extra pass.
+		 *  Declarations of fused operations share one shader, so their names must not collide
+		 * @param[in] name			A name for debugging
+		 * @param[in] code			GLSL which modifies `vec4 color`. It must not sample `source` at other coordinates
+		 * @param[in] uniforms		Optionally set the operation's uniforms. The shader is already in use
+		 * @param[in] declarations	GLSL placed before main(), eg. uniforms and functions
+		 * @return					A reference to this object
+	 	*/
+		PostProcessChain& addColorOp(std::string const& name, std::string const& code, UniformFunction uniforms = nullptr, std::string const& declarations = "");
+
+		/** @brief Run every pass
+		 * @param[in] window	The window, used for the output size when drawing to the default framebuffer
+		 * @param[in] input		The texture to process
+		 * @param[in] output	The framebuffer to draw the result into, or nullptr for the default framebuffer
+		 * @return				A reference to this object
+	 	*/
+		PostProcessChain& run(Window& window, Texture& input, FBO* output = nullptr);
+
+		/** @brief Remove every effect and color op
+		 * @return A reference to this object
+	 	*/
+		PostProcessChain& clear();
+
+		/** @brief Get the number of fullscreen passes run() draws, after fusing color ops
+		 * @return The pass count
+	 	*/
+		size_t getPassCount();
+
+	private:
+		struct Effect {
+			std::string name;
+			std::string code;
+			std::string declarations;
+			UniformFunction uniforms;
+			float scale;
+			bool colorOp;
+		};
+
+		struct Pass {
+			std::string name;
+			float scale;
+			std::unique_ptr<Shader> shader;
+			std::vector<size_t> effects;	// Indices of the effects fused into this pass, in order
+		};
+
+		struct Target {
+			float scale;
+			std::unique_ptr<FBO> framebuffers[2];
+		};
+
+		GLenum format;
+		GLuint vao = 0;
+
+		std::vector<Effect> effects;
+		std::vector<Pass> passes;
+		std::vector<Target> targets;
+
+		bool dirty = true;
+		bool failed = false;	// A pass shader did not link. run() draws nothing until the effects change
+
+		/** @brief Group the effects into passes and compile a shader for each
+	 	*/
+		void build();
+
+		/** @brief Get a target at a scale which is not the texture being read, sized for the output
+		 * @param[in] scale		The resolution scale
+		 * @param[in] source	The texture the pass reads
+		 * @param[in] width		The output width
+		 * @param[in] height	The output height
+		 * @return				The framebuffer to draw into
+	 	*/
+		FBO& getTarget(float scale, Texture* source, int width, int height);
+	};
+}
+
+#endif
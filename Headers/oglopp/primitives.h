@@ -0,0 +1,461 @@
+#ifndef OGLOPP_PRIMITIVES_H
+#define OGLOPP_PRIMITIVES_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "compute.h"
+#include "ssbo.h"
+
+/*
+ - Data parallel building blocks over SSBOs of 32 bit uints: scan, reduce, compaction, histogram and radix sort
+ - Every kernel runs LOCAL_SIZE invocations per group. Groups past GL_MAX_COMPUTE_WORK_GROUP_COUNT in x wrap into y,
+   so the element count is only limited by memory
+ - scan() is work-efficient (Blelloch): each group scans SCAN_BLOCK elements in shared memory, the group totals are
+   scanned recursively, then added back. compact() and sort() are built on it
+ - sort() is an LSD radix sort, RADIX_BITS per pass. Each group sorts its elements locally with 1-bit splits so the
+   scatter is stable and mostly coalesced
+ - Scratch buffers are kept between calls and only grow
+ - Each primitive has a CPU reference for checking results (see Examples/primitives-benchmark.cpp)
+*/
+
+namespace oglopp {
+	/** @brief GPU scan, reduce, compaction, histogram and sort
+	*/
+	class ComputePrimitives {
+	public:
+		static constexpr uint32_t LOCAL_SIZE = 256;
+		static constexpr uint32_t SCAN_BLOCK = LOCAL_SIZE * 2;		// Elements scanned or reduced per group
+		static constexpr uint32_t HISTOGRAM_ITEMS = 16;				// Elements counted per invocation
+		static constexpr uint32_t HISTOGRAM_SHARED_BINS = 4096;		// More bins count straight into the global buffer
+		static constexpr uint32_t RADIX_BITS = 4;
+		static constexpr uint32_t RADIX_DIGITS = 1 << RADIX_BITS;
+
+		enum ReduceOp : uint8_t {
+			SUM,
+			MIN,
+			MAX
+		};
+
+		ComputePrimitives() = default;
+
+		/** @brief Prefix sum. Output i is the sum of inputs before i (exclusive) or up to and including i (inclusive)
+		 * @param[in] input		The values
+		 * @param[out] output	Receives count values. May be the input
+		 * @param[in] count		The number of values
+		 * @param[in] inclusive	True for an inclusive scan
+		 * @return				A status code. 0 for success. -1 if a buffer is too small
+	 	*/
+		int8_t scan(SSBO& input, SSBO& output, uint32_t count, bool inclusive = false);
+
+		/** @brief Reduce values to one
+		 * @param[in] input		The values
+		 * @param[in] count		The number of values
+		 * @param[out] result	Receives the result as its first uint
+		 * @param[in] op		SUM, MIN or MAX
+		 * @return				A status code. 0 for success. -1 if a buffer is too small
+	 	*/
+		int8_t reduce(SSBO& input, uint32_t count, SSBO& result, ReduceOp op = SUM);
+
+		/** @brief Stream compaction. Copy the values whose flag is 1 to the front of the output, keeping their order
+		 * @param[in] input			The values
+		 * @param[in] flags			One uint per value. 1 keeps the value, 0 drops it
+		 * @param[out] output		Receives the kept values. Must hold count values
+		 * @param[out] outputCount	Receives the number of kept values as its first uint. An IndirectBuffer works here
+		 * @param[in] count			The number of values
+		 * @return					A status code. 0 for success. -1 if a buffer is too small
+	 	*/
+		int8_t compact(SSBO& input, SSBO& flags, SSBO& output, SSBO& outputCount, uint32_t count);
+
+		/** @brief Count how many values fall in each bin. Values are bin indices, and values of binCount or more are ignored
+		 * @param[in] input		The values
+		 * @param[in] count		The number of values
+		 * @param[out] bins		Receives binCount uints. It is cleared first
+		 * @param[in] binCount	The number of bins
+		 * @return				A status code. 0 for success. -1 if a buffer is too small
+	 	*/
+		int8_t histogram(SSBO& input, uint32_t count, SSBO& bins, uint32_t binCount);
+
+		/** @brief Sort 32 bit keys in ascending order, and their payloads with them. The sort is stable
+		 * @param[in,out] keys		The keys
+		 * @param[in,out] values	One uint payload per key, or nullptr
+		 * @param[in] count			The number of keys
+		 * @param[in] keyBits		The number of low key bits which can be set. Fewer bits need fewer passes
+		 * @return					A status code. 0 for success. -1 if a buffer is too small
+	 	*/
+		int8_t sort(SSBO& keys, SSBO* values, uint32_t count, uint32_t keyBits = 32);
+
+		/** @brief CPU reference of scan()
+		 * @param[in] input		The values
+		 * @param[in] inclusive	True for an inclusive scan
+		 * @return				The prefix sums
+	 	*/
+		static std::vector<uint32_t> scanReference(std::vector<uint32_t> const& input, bool inclusive = false);
+
+		/** @brief CPU reference of reduce()
+		 * @param[in] input		The values
+		 * @param[in] op		SUM, MIN or MAX
+		 * @return				The result
+	 	*/
+		static uint32_t reduceReference(std::vector<uint32_t> const& input, ReduceOp op = SUM);
+
+		/** @brief CPU reference of compact()
+		 * @param[in] input		The values
+		 * @param[in] flags		One flag per value, 1 or 0
+		 * @return				The kept values
+	 	*/
+		static std::vector<uint32_t> compactReference(std::vector<uint32_t> const& input, std::vector<uint32_t> const& flags);
+
+		/** @brief CPU reference of histogram()
+		 * @param[in] input		The values
+		 * @param[in] binCount	The number of bins
+		 * @return				The bins
+	 	*/
+		static std::vector<uint32_t> histogramReference(std::vector<uint32_t> const& input, uint32_t binCount);
+
+		/** @brief CPU reference of sort()
+		 * @param[in,out] keys		The keys
+		 * @param[in,out] values	The payloads, or nullptr
+	 	*/
+		static void sortReference(std::vector<uint32_t>& keys, std::vector<uint32_t>* values);
+
+	private:
+		std::unique_ptr<Compute> scanKernel;
+		std::unique_ptr<Compute> addKernel;
+		std::unique_ptr<Compute> reduceKernel;
+		std::unique_ptr<Compute> scatterKernel;
+		std::unique_ptr<Compute> histogramKernel;
+		std::unique_ptr<Compute> radixCountKernel;
+		std::unique_ptr<Compute> radixScatterKernel;
+
+		// Group totals of each level of a scan
+		std::vector<std::unique_ptr<SSBO>> scanSums;
+		std::unique_ptr<SSBO> reducePartials[2];
+		std::unique_ptr<SSBO> compactOffsets;
+		std::unique_ptr<SSBO> sortKeys;
+		std::unique_ptr<SSBO> sortValues;
+		std::unique_ptr<SSBO> sortCounts;
+
+		/** @brief Scan one level, recursing into the group totals
+		 * @param[in] input		The values
+		 * @param[out] output	Receives the prefix sums
+		 * @param[in] count		The number of values
+		 * @param[in] inclusive	True for an inclusive scan
+		 * @param[in] depth		The recursion depth, selecting the scratch buffer of the group totals
+	 	*/
+		void scanLevel(SSBO& input, SSBO& output, uint32_t count, bool inclusive, size_t depth);
+
+		/** @brief Dispatch a number of groups, wrapping those past the device's x limit into y. Kernels skip the extra groups
+		 * @param[in] kernel	The kernel, with a groupCount uniform
+		 * @param[in] groups	The number of groups
+	 	*/
+		static void dispatchGroups(Compute& kernel, uint32_t groups);
+
+		/** @brief Get a scratch buffer of at least some size, growing it if needed
+		 * @param[in,out] buffer	The scratch buffer
+		 * @param[in] size			The size needed in bytes
+		 * @return					The buffer
+	 	*/
+		static SSBO& getScratch(std::unique_ptr<SSBO>& buffer, size_t size);
+
+		/** @brief Get a kernel, compiling it the first time
+		 * @param[in,out] kernel	The kernel
+		 * @param[in] body			The GLSL after the common header
+		 * @return					The kernel
+	 	*/
+		static Compute& getKernel(std::unique_ptr<Compute>& kernel, const char* body);
+
+		static constexpr const char* SCAN_SOURCE =
+			"layout (std430, binding = 0) readonly buffer Input { uint inputData[]; };\n"\
+			"layout (std430, binding = 1) writeonly buffer Output { uint outputData[]; };\n"\
+			"layout (std430, binding = 2) writeonly buffer Sums { uint groupSums[]; };\n"\
+			"uniform int count;\n"\
+			"uniform int inclusive;\n"\
+			"shared uint temp[SCAN_BLOCK];\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint lane = gl_LocalInvocationID.x;\n"\
+				"uint a = group * SCAN_BLOCK + lane;\n"\
+				"uint b = a + LOCAL_SIZE;\n"\
+				"uint valueA = a < uint(count) ? inputData[a] : 0u;\n"\
+				"uint valueB = b < uint(count) ? inputData[b] : 0u;\n"\
+				"temp[lane] = valueA;\n"\
+				"temp[lane + LOCAL_SIZE] = valueB;\n"\
+
+				// Up-sweep: build partial sums in place
+				"uint offset = 1u;\n"\
+				"for (uint d = SCAN_BLOCK >> 1; d > 0u; d >>= 1) {\n"\
+					"barrier();\n"\
+					"if (lane < d) {\n"\
+						"temp[offset * (2u * lane + 2u) - 1u] += temp[offset * (2u * lane + 1u) - 1u];\n"\
+					"}\n"\
+					"offset <<= 1;\n"\
+				"}\n"\
+
+				"barrier();\n"\
+				"if (lane == 0u) {\n"\
+					"groupSums[group] = temp[SCAN_BLOCK - 1u];\n"\
+					"temp[SCAN_BLOCK - 1u] = 0u;\n"\
+				"}\n"\
+
+				// Down-sweep: turn the partial sums into an exclusive scan
+				"for (uint d = 1u; d < SCAN_BLOCK; d <<= 1) {\n"\
+					"offset >>= 1;\n"\
+					"barrier();\n"\
+					"if (lane < d) {\n"\
+						"uint left = offset * (2u * lane + 1u) - 1u;\n"\
+						"uint right = offset * (2u * lane + 2u) - 1u;\n"\
+						"uint carry = temp[left];\n"\
+						"temp[left] = temp[right];\n"\
+						"temp[right] += carry;\n"\
+					"}\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				"if (a < uint(count)) {\n"\
+					"outputData[a] = temp[lane] + (inclusive != 0 ? valueA : 0u);\n"\
+				"}\n"\
+				"if (b < uint(count)) {\n"\
+					"outputData[b] = temp[lane + LOCAL_SIZE] + (inclusive != 0 ? valueB : 0u);\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* ADD_SOURCE =
+			"layout (std430, binding = 1) buffer Output { uint outputData[]; };\n"\
+			"layout (std430, binding = 2) readonly buffer Sums { uint groupSums[]; };\n"\
+			"uniform int count;\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint add = groupSums[group];\n"\
+				"for (uint i = group * SCAN_BLOCK + gl_LocalInvocationID.x; i < min((group + 1u) * SCAN_BLOCK, uint(count)); i += LOCAL_SIZE) {\n"\
+					"outputData[i] += add;\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* REDUCE_SOURCE =
+			"layout (std430, binding = 0) readonly buffer Input { uint inputData[]; };\n"\
+			"layout (std430, binding = 1) writeonly buffer Output { uint outputData[]; };\n"\
+			"uniform int count;\n"\
+			"uniform int op;\n"\
+			"shared uint partial[LOCAL_SIZE];\n"\
+
+			"uint combine(uint a, uint b) {\n"\
+				"return op == 0 ? a + b : (op == 1 ? min(a, b) : max(a, b));\n"\
+			"}\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint identity = op == 1 ? 0xFFFFFFFFu : 0u;\n"\
+				"uint lane = gl_LocalInvocationID.x;\n"\
+				"uint a = group * SCAN_BLOCK + lane;\n"\
+				"uint b = a + LOCAL_SIZE;\n"\
+				"partial[lane] = combine(a < uint(count) ? inputData[a] : identity, b < uint(count) ? inputData[b] : identity);\n"\
+
+				"for (uint stride = LOCAL_SIZE >> 1; stride > 0u; stride >>= 1) {\n"\
+					"barrier();\n"\
+					"if (lane < stride) {\n"\
+						"partial[lane] = combine(partial[lane], partial[lane + stride]);\n"\
+					"}\n"\
+				"}\n"\
+
+				"if (lane == 0u) {\n"\
+					"outputData[group] = partial[0];\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* SCATTER_SOURCE =
+			"layout (std430, binding = 0) readonly buffer Input { uint inputData[]; };\n"\
+			"layout (std430, binding = 1) readonly buffer Flags { uint flags[]; };\n"\
+			"layout (std430, binding = 2) readonly buffer Offsets { uint offsets[]; };\n"\
+			"layout (std430, binding = 3) writeonly buffer Output { uint outputData[]; };\n"\
+			"layout (std430, binding = 4) writeonly buffer OutputCount { uint outputCount; };\n"\
+			"uniform int count;\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint i = group * LOCAL_SIZE + gl_LocalInvocationID.x;\n"\
+				"if (i >= uint(count)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"bool keep = flags[i] == 1u;\n"\
+				"if (keep) {\n"\
+					"outputData[offsets[i]] = inputData[i];\n"\
+				"}\n"\
+				"if (i == uint(count) - 1u) {\n"\
+					"outputCount = offsets[i] + (keep ? 1u : 0u);\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* HISTOGRAM_SOURCE =
+			"layout (std430, binding = 0) readonly buffer Input { uint inputData[]; };\n"\
+			"layout (std430, binding = 1) buffer Bins { uint bins[]; };\n"\
+			"uniform int count;\n"\
+			"uniform int binCount;\n"\
+			"shared uint counts[HISTOGRAM_SHARED_BINS];\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint lane = gl_LocalInvocationID.x;\n"\
+				"bool privatized = uint(binCount) <= HISTOGRAM_SHARED_BINS;\n"\
+				"if (privatized) {\n"\
+					"for (uint i = lane; i < uint(binCount); i += LOCAL_SIZE) {\n"\
+						"counts[i] = 0u;\n"\
+					"}\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				// Consecutive invocations read consecutive values
+				"uint first = group * LOCAL_SIZE * HISTOGRAM_ITEMS + lane;\n"\
+				"for (uint k = 0u; k < HISTOGRAM_ITEMS; k++) {\n"\
+					"uint i = first + k * LOCAL_SIZE;\n"\
+					"if (i < uint(count)) {\n"\
+						"uint value = inputData[i];\n"\
+						"if (value < uint(binCount)) {\n"\
+							"if (privatized) {\n"\
+								"atomicAdd(counts[value], 1u);\n"\
+							"} else {\n"\
+								"atomicAdd(bins[value], 1u);\n"\
+							"}\n"\
+						"}\n"\
+					"}\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				"if (privatized) {\n"\
+					"for (uint i = lane; i < uint(binCount); i += LOCAL_SIZE) {\n"\
+						"if (counts[i] != 0u) {\n"\
+							"atomicAdd(bins[i], counts[i]);\n"\
+						"}\n"\
+					"}\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* RADIX_COUNT_SOURCE =
+			"layout (std430, binding = 0) readonly buffer Keys { uint keys[]; };\n"\
+			"layout (std430, binding = 1) writeonly buffer Counts { uint digitCounts[]; };\n"\
+			"uniform int count;\n"\
+			"uniform int shift;\n"\
+			"shared uint counts[RADIX_DIGITS];\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint lane = gl_LocalInvocationID.x;\n"\
+				"if (lane < RADIX_DIGITS) {\n"\
+					"counts[lane] = 0u;\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				"uint i = group * LOCAL_SIZE + lane;\n"\
+				"if (i < uint(count)) {\n"\
+					"atomicAdd(counts[(keys[i] >> shift) & (RADIX_DIGITS - 1u)], 1u);\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				// Digit major, so one scan gives every group its offset for every digit
+				"if (lane < RADIX_DIGITS) {\n"\
+					"digitCounts[lane * uint(groupCount) + group] = counts[lane];\n"\
+				"}\n"\
+			"}\n";
+
+		static constexpr const char* RADIX_SCATTER_SOURCE =
+			"layout (std430, binding = 0) readonly buffer KeysIn { uint keysIn[]; };\n"\
+			"layout (std430, binding = 1) readonly buffer ValuesIn { uint valuesIn[]; };\n"\
+			"layout (std430, binding = 2) readonly buffer Offsets { uint digitOffsets[]; };\n"\
+			"layout (std430, binding = 3) writeonly buffer KeysOut { uint keysOut[]; };\n"\
+			"layout (std430, binding = 4) writeonly buffer ValuesOut { uint valuesOut[]; };\n"\
+			"uniform int count;\n"\
+			"uniform int shift;\n"\
+			"uniform int hasValues;\n"\
+			"shared uint sortedKeys[LOCAL_SIZE];\n"\
+			"shared uint sortedValues[LOCAL_SIZE];\n"\
+			"shared uint zeros[LOCAL_SIZE];\n"\
+			"shared uint digitStart[RADIX_DIGITS];\n"\
+
+			"void main() {\n"\
+				"uint group = groupIndex();\n"\
+				"if (group >= uint(groupCount)) {\n"\
+					"return;\n"\
+				"}\n"\
+
+				"uint lane = gl_LocalInvocationID.x;\n"\
+				"uint i = group * LOCAL_SIZE + lane;\n"\
+				"uint valid = min(uint(count) - group * LOCAL_SIZE, LOCAL_SIZE);\n"\
+
+				// Missing elements hold the largest digit. They start last and stay last, since every split is stable
+				"uint key = i < uint(count) ? keysIn[i] : 0xFFFFFFFFu;\n"\
+				"uint value = (i < uint(count) && hasValues != 0) ? valuesIn[i] : 0u;\n"\
+
+				// Sort the group by the digit with one stable split per bit
+				"for (uint bit = 0u; bit < RADIX_BITS; bit++) {\n"\
+					"uint isZero = ((key >> (uint(shift) + bit)) & 1u) == 0u ? 1u : 0u;\n"\
+					"zeros[lane] = isZero;\n"\
+					"barrier();\n"\
+
+					// Inclusive Hillis-Steele scan of the zero flags
+					"for (uint offset = 1u; offset < LOCAL_SIZE; offset <<= 1) {\n"\
+						"uint add = lane >= offset ? zeros[lane - offset] : 0u;\n"\
+						"barrier();\n"\
+						"zeros[lane] += add;\n"\
+						"barrier();\n"\
+					"}\n"\
+
+					"uint zerosBefore = zeros[lane] - isZero;\n"\
+					"uint totalZeros = zeros[LOCAL_SIZE - 1u];\n"\
+					"uint target = isZero == 1u ? zerosBefore : totalZeros + lane - zerosBefore;\n"\
+					"sortedKeys[target] = key;\n"\
+					"sortedValues[target] = value;\n"\
+					"barrier();\n"\
+
+					"key = sortedKeys[lane];\n"\
+					"value = sortedValues[lane];\n"\
+					"barrier();\n"\
+				"}\n"\
+
+				// Where each digit's run starts in the sorted group
+				"uint digit = (key >> shift) & (RADIX_DIGITS - 1u);\n"\
+				"if (lane == 0u || ((sortedKeys[lane - 1u] >> shift) & (RADIX_DIGITS - 1u)) != digit) {\n"\
+					"digitStart[digit] = lane;\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				"if (lane < valid) {\n"\
+					"uint target = digitOffsets[digit * uint(groupCount) + group] + lane - digitStart[digit];\n"\
+					"keysOut[target] = key;\n"\
+					"if (hasValues != 0) {\n"\
+						"valuesOut[target] = value;\n"\
+					"}\n"\
+				"}\n"\
+			"}\n";
+	};
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef OGLOPP_READBACK_H
+#define OGLOPP_READBACK_H
+
+#include <memory>
+#include <vector>
+
+#include "defines.h"
+#include "ssbo.h"
+
+/*
+ - Mapping a buffer the GPU is still writing stalls the CPU until every command touching it has finished.
+   A readback instead copies the range into a staging buffer with glCopyBufferSubData and places a fence after it,
+   so the CPU can carry on and pick the data up a frame or two later
+ - A ReadbackRing owns a few staging buffers used in turn, so readbacks from consecutive frames are in flight together.
+   A request only waits if the ring wraps around onto a copy which has still not finished. Use more slots for more latency
+ - Staging buffers are persistently mapped when GL 4.4 (or ARB_buffer_storage) is available, and mapped once the fence
+   has signalled otherwise. Either way the data is copied into the handle, freeing the slot for the next request
+ - SSBO::readbackAsync() uses a ring shared by the whole program unless it is given one
+*/
+
+namespace oglopp {
+	class ReadbackRing;
+
+	/** @brief A pending copy of some buffer data back to the CPU
+	*/
+	class Readback {
+	public:
+		~Readback();
+
+		/** @brief Check if the copy has finished, without waiting. Once it has, data() is available
+		 * @return True if the data is ready
+	 	*/
+		bool ready();
+
+		/** @brief Wait for the copy to finish
+		 * @param[in] timeout	The longest wait in nanoseconds
+		 * @return				True if the data is ready
+	 	*/
+		bool wait(GLuint64 timeout = GL_TIMEOUT_IGNORED);
+
+		/** @brief Get the data
+		 * @return A pointer to the copied bytes, or nullptr if the copy has not finished
+	 	*/
+		const void* data() const;
+
+		/** @brief Get the data as an array of some type
+		 * @return A pointer to the copied values, or nullptr if the copy has not finished
+	 	*/
+		template <typename T>
+		const T* as() const {
+			return static_cast<const T*>(this->data());
+		}
+
+		/** @brief Get the number of bytes read back
+		 * @return The size in bytes
+	 	*/
+		size_t getSize() const;
+
+	private:
+		friend class ReadbackRing;
+
+		ReadbackRing* ring;
+		size_t slot;
+		size_t size;
+		GLsync fence;
+
+		bool resolved = false;
+		std::vector<uint8_t> bytes;
+
+		/** @brief Create a pending readback. Only ReadbackRing::request() does this
+		 * @param[in] ring	The ring owning the staging buffer
+		 * @param[in] slot	The staging buffer index
+		 * @param[in] size	The number of bytes copied
+		 * @param[in] fence	The fence after the copy
+	 	*/
+		Readback(ReadbackRing* ring, size_t slot, size_t size, GLsync fence);
+
+		/** @brief Copy the data out of the staging buffer and free it. The fence must have signalled
+	 	*/
+		void resolve();
+	};
+
+	/** @brief Staging buffers for pipelined readbacks
+	*/
+	class ReadbackRing {
+	public:
+		/** @brief Create a ring of staging buffers. They are allocated by the first request using them
+		 * @param[in] slots		The number of readbacks which can be in flight at once
+	 	*/
+		ReadbackRing(size_t slots = 3);
+
+		/** @brief Wait for every pending readback and delete the staging buffers
+	 	*/
+		~ReadbackRing();
+
+		ReadbackRing(ReadbackRing const&) = delete;
+		ReadbackRing& operator=(ReadbackRing const&) = delete;
+
+		/** @brief Start copying a range of a buffer back to the CPU
+		 * @param[in] source	The buffer
+		 * @param[in] offset	The start of the range in bytes
+		 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+		 * @return				The pending readback, or nullptr if the range is out of bounds
+	 	*/
+		std::shared_ptr<Readback> request(SSBO& source, size_t offset = 0, size_t size = 0);
+
+		/** @brief Get the number of staging buffers
+		 * @return The number of slots
+	 	*/
+		size_t getSlotCount() const;
+
+		/** @brief Get the ring SSBO::readbackAsync() uses by default. It is never deleted, since it may outlive the context
+		 * @return The shared ring
+	 	*/
+		static ReadbackRing& getShared();
+
+		/** @brief Check if staging buffers can be persistently mapped (GL 4.4 or ARB_buffer_storage)
+		 * @return True if persistent mapping is available
+	 	*/
+		static bool hasPersistentMapping();
+
+	private:
+		friend class Readback;
+
+		struct Slot {
+			GLuint buffer = 0;
+			size_t capacity = 0;
+			void* mapped = nullptr;					// Set while persistently mapped
+			std::shared_ptr<Readback> pending;		// Kept alive until resolved, even if the caller drops it
+		};
+
+		std::vector<Slot> slots;
+		size_t next = 0;
+
+		/** @brief Make sure a staging buffer can hold some number of bytes, reallocating it if needed
+		 * @param[in,out] slot	The staging buffer
+		 * @param[in] size		The size needed in bytes
+	 	*/
+		static void reserve(Slot& slot, size_t size);
+	};
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef OGLOPP_RENDERGRAPH_H
+#define OGLOPP_RENDERGRAPH_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "fbo.h"
+#include "texture.h"
+#include "ssbo.h"
+#include "window.h"
+
+/*
+ - Passes are declared once, in execution order, with the resources they read and write
+ - compile() culls passes whose results are never used, works out how long each transient texture lives,
+   and lets transient textures with the same format and size share one GL texture when their lifetimes do not overlap
+ - execute() binds each pass's framebuffer, issues glMemoryBarrier only where an image or storage write is read later,
+   and recompiles by itself when the window is resized. The barriers go through Hazards, and image and storage writes are
+   recorded there, so work outside the graph waits for them too (see hazards.h)
+ - A graph which fails to compile prints why once. execute() does nothing until a pass or resource is added
+*/
+
+namespace oglopp {
+	/** @brief Declarative frame graph with transient texture aliasing
+	*/
+	class RenderGraph {
+	public:
+		typedef uint32_t Handle;
+
+		/** @brief How a pass uses a resource
+		*/
+		enum Access : uint8_t {
+			SAMPLED,			// Texture fetches (sampler2D)
+			IMAGE,				// Image load/store (image2D)
+			STORAGE,			// Shader storage buffer reads/writes
+			VERTEX,				// Buffer read as vertex attributes
+			INDIRECT,			// Buffer read as indirect draw/dispatch commands
+			COLOR_ATTACHMENT,	// Rendered to as a color attachment, in the order declared
+			DEPTH_ATTACHMENT	// Rendered to as the depth attachment
+		};
+
+		/** @brief Describes a transient texture owned by the graph
+		*/
+		struct TextureDesc {
+			GLenum format;		// The internal format
+			float scale;		// Size relative to the window. Ignored if width and height are set
+			int width;			// Absolute width, or 0 to follow the window
+			int height;			// Absolute height, or 0 to follow the window
+			bool nearest;		// Nearest-neighbour filtering
+		};
+
+		/** @brief Given to each pass while it executes
+		*/
+		struct Context {
+			RenderGraph& graph;
+			Window& window;
+			FBO* framebuffer;	// The pass's framebuffer, already bound. nullptr if the pass has no attachments or draws to the backbuffer
+			int width;			// Size of the pass's attachments (the window for the backbuffer)
+			int height;
+
+			/** @brief Get the GL texture behind a texture handle for this frame
+			 * @param[in] handle	The texture handle
+			 * @return				A reference to the texture
+		 	*/
+			Texture& texture(Handle handle);
+
+			/** @brief Get the buffer behind a buffer handle
+			 * @param[in] handle	The buffer handle
+			 * @return				A reference to the buffer
+		 	*/
+			SSBO& buffer(Handle handle);
+		};
+
+		typedef std::function<void(Context&)> ExecuteFunction;
+
+		/** @brief A pass and the resources it uses
+		*/
+		class Pass {
+		public:
+			/** @brief Declare a read of a resource
+			 * @param[in] handle	The resource
+			 * @param[in] access	How the resource is read
+			 * @return				A reference to this pass
+		 	*/
+			Pass& read(Handle handle, Access access = SAMPLED);
+
+			/** @brief Declare a write of a resource
+			 * @param[in] handle	The resource
+			 * @param[in] access	How the resource is written
+			 * @return				A reference to this pass
+		 	*/
+			Pass& write(Handle handle, Access access = COLOR_ATTACHMENT);
+
+			/** @brief Keep this pass even if nothing reads what it writes
+			 * @return A reference to this pass
+		 	*/
+			Pass& keep();
+
+		private:
+			friend class RenderGraph;
+
+			struct Use {
+				Handle handle;
+				Access access;
+			};
+
+			RenderGraph* graph;
+			std::string name;
+			ExecuteFunction execute;
+			std::vector<Use> reads;
+			std::vector<Use> writes;
+			bool sideEffects = false;
+			bool culled = false;
+			bool toBackbuffer = false;
+
+			std::unique_ptr<FBO> framebuffer;
+			GLbitfield barriers = 0;	// Required before the pass runs
+		};
+
+		RenderGraph() = default;
+
+		/** @brief Create a transient texture. Its GL texture may be shared with other transient textures
+		 * @param[in] name	A name for debugging
+		 * @param[in] desc	The format and size
+		 * @return			The handle of the new texture
+	 	*/
+		Handle createTexture(std::string const& name, TextureDesc const& desc);
+
+		/** @brief Use a texture owned by the caller. It is never aliased, and passes writing it are never culled
+		 * @param[in] name		A name for debugging
+		 * @param[in] texture	The texture
+		 * @return				The handle of the texture
+	 	*/
+		Handle importTexture(std::string const& name, Texture* texture);
+
+		/** @brief Use a buffer owned by the caller. Passes writing it are never culled
+		 * @param[in] name		A name for debugging
+		 * @param[in] buffer	The buffer
+		 * @return				The handle of the buffer
+	 	*/
+		Handle importBuffer(std::string const& name, SSBO* buffer);
+
+		/** @brief Get the handle of the window's default framebuffer. Write it as a COLOR_ATTACHMENT to draw to the screen
+		 * @return The backbuffer handle
+	 	*/
+		Handle getBackbuffer();
+
+		/** @brief Add a pass. Passes run in the order they are added
+		 * @param[in] name		A name for debugging
+		 * @param[in] execute	The function recording the pass's GL commands
+		 * @return				A reference to the pass, to declare its reads and writes
+	 	*/
+		Pass& addPass(std::string const& name, ExecuteFunction execute);
+
+		/** @brief Cull, compute lifetimes and allocate textures and framebuffers. Called by execute() when needed
+		 * @param[in] window	The window which sizes are relative to
+		 * @return				A status code. 0 for success. -1 if a resource is written as an attachment with the wrong kind
+	 	*/
+		int8_t compile(Window& window);
+
+		/** @brief Run every pass which was not culled
+		 * @param[in] window	The window being drawn to
+		 * @return				A reference to this object
+	 	*/
+		RenderGraph& execute(Window& window);
+
+		/** @brief Remove every pass and resource
+		 * @return A reference to this object
+	 	*/
+		RenderGraph& clear();
+
+		/** @brief Get the number of GL textures allocated for the transient textures
+		 * @return The physical texture count
+	 	*/
+		size_t getPhysicalTextureCount() const;
+
+		/** @brief Get the number of passes which will run
+		 * @return The active pass count
+	 	*/
+		size_t getActivePassCount() const;
+
+		/** @brief Print the passes, culling and texture assignment to stdout
+		 * @return A reference to this object
+	 	*/
+		RenderGraph& print();
+
+	private:
+		enum ResourceType : uint8_t {
+			TRANSIENT_TEXTURE,
+			IMPORTED_TEXTURE,
+			IMPORTED_BUFFER,
+			BACKBUFFER
+		};
+
+		struct Resource {
+			std::string name;
+			ResourceType type;
+			TextureDesc desc;
+			Texture* texture;
+			SSBO* buffer;
+
+			int firstUse;
+			int lastUse;
+			int physical;	// Index into physicalTextures for transient textures
+		};
+
+		struct PhysicalTexture {
+			std::unique_ptr<Texture> texture;
+			GLenum format;
+			int width;
+			int height;
+			bool nearest;
+			int freeAfter;	// The last pass using it, while compiling
+		};
+
+		std::vector<Resource> resources;
+		std::vector<std::unique_ptr<Pass>> passes;
+		std::vector<PhysicalTexture> physicalTextures;
+
+		Handle backbuffer = UINT32_MAX;
+
+		enum CompileState : uint8_t {
+			STALE,		// Changed since the last compile
+			COMPILED,
+			FAILED		// Not retried until the graph changes
+		};
+
+		CompileState compileState = STALE;
+		int compiledWidth = -1;
+		int compiledHeight = -1;
+
+		/** @brief Get the size of a transient texture for a window size
+		 * @param[in] desc		The texture description
+		 * @param[in] width		The window width
+		 * @param[in] height	The window height
+		 * @param[out] outWidth		The texture width
+		 * @param[out] outHeight	The texture height
+	 	*/
+		static void getTextureSize(TextureDesc const& desc, int width, int height, int* outWidth, int* outHeight);
+
+		/** @brief Get the barrier bit making incoherent writes visible to an access
+		 * @param[in] access	The access
+		 * @return				The glMemoryBarrier bit
+	 	*/
+		static GLbitfield getBarrierBit(Access access);
+
+		/** @brief Check if an access writes incoherently (needs a glMemoryBarrier before it is read)
+		 * @param[in] access	The access
+		 * @return				True for image and storage writes
+	 	*/
+		static bool isIncoherent(Access access);
+	};
+}
+
+#endif
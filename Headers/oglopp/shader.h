@@ -50,6 +50,14 @@ namespace oglopp {
 	private:
 		DrawType drawType;
 
+		// True when position (location 0) is the only vertex attribute the program reads
+		bool positionOnly = false;
+
+		/** @brief Check the active attributes of the linked program to see if it only reads the position attribute
+		 * @return True if location 0 is the only active vertex attribute
+	 	*/
+		bool reflectPositionOnly() const;
+
 		/** @brief Load a list of shaders into this shader object
 		 * @param[in] vertexShader		The vertex shader path or file contents. Nullptr for no vertex shader
 		 * @param[in] geoShader			The geometry shader path or file contents. Nullptr for no geometry shader
@@ -101,6 +109,23 @@ namespace oglopp {
 		"uniform mat4 projection;\n"\
 		"uniform mat4 rotation;\n";
 
+		// Position-only shader used by the depth prepass. The main pass vertex shaders must compute gl_Position the same way
+		// (projection * view * model * vec4(aPos, 1.0)) and declare it invariant, otherwise the EQUAL depth test can fail
+		static constexpr const char* DEPTH_PREPASS_VERTEX =
+		"#version 330 core\n"\
+		"layout (location = 0) in vec3 aPos;\n"\
+		"uniform mat4 model;\n"\
+		"uniform mat4 view;\n"\
+		"uniform mat4 projection;\n"\
+		"invariant gl_Position;\n"\
+		"void main() {\n"\
+			"gl_Position = projection * view * model * vec4(aPos, 1.0);\n"\
+		"}\n";
+
+		static constexpr const char* DEPTH_PREPASS_FRAGMENT =
+		"#version 330 core\n"\
+		"void main() {}\n";
+
 		static std::string getTextureUniform(uint8_t textureId);
 
 		/** @brief Create a new shader
@@ -139,6 +164,23 @@ namespace oglopp {
 		 * @return			A reference to this shape object
 	 	*/
 		Shader& setDrawType(DrawType const& type);
+
+		/** @brief Check if this shader only reads the position attribute. Detected automatically when the program is linked.
+		 * 	Shapes with a separate position stream draw with their position-only VAO for these shaders.
+		 * @return True if the shader is position-only
+	 	*/
+		bool isPositionOnly() const;
+
+		/** @brief Check if the program linked. A stage which failed to compile also fails the link
+		 * @return True if the program is usable
+	 	*/
+		bool isLinked() const;
+
+		/** @brief Override the position-only detection
+		 * @param[in] value	True to treat this shader as position-only
+		 * @return			A reference to this shader object
+	 	*/
+		Shader& setPositionOnly(bool value);
 	};
 }
 
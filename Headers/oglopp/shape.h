@@ -12,6 +12,7 @@
 #include "texture.h"
 #include "window.h"
 #include "shader.h"
+#include "indirect.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -28,6 +29,13 @@ namespace oglopp {
 		unsigned int VBO = 0;
 		unsigned int EBO = 0;
 
+		// Position-only VAO, only built when the position attribute lives in its own stream
+		unsigned int depthVAO = 0;
+		// Buffers for every stream after the first. The first stream always uses VBO
+		std::vector<unsigned int> streamVBOs;
+		// Attribute indices which begin a new vertex stream (buffer)
+		std::vector<uint8_t> streamStarts;
+
 		std::vector<uint8_t> vertices;
 		std::vector<unsigned int> indices;
 		std::vector<Texture*> textures;
@@ -44,6 +52,13 @@ namespace oglopp {
 		int16_t size;
 		uint16_t myRegister;
 
+		/** @brief Use the shader, set its MVP and textures, and bind the vertex array, ready for a draw call
+		 * @param[in] window	A reference to the window object
+		 * @param[in] pShader	An optional pointer to the shader object
+		 * @return				The draw type of the shader, or TRIANGLES without one
+		*/
+		DrawType prepareDraw(Window& window, Shader* pShader);
+
 		/** @brief Get the opengl texture register for the n'th texture, where index = n
 		 * @param[in]	index	The index/layer of the texture
 		*/
@@ -69,6 +84,16 @@ namespace oglopp {
 		Shape& updateEBO();
 		Shape& updateVBO();
 
+		/** @brief Upload the vertex streams and set the attribute pointers for every attribute in this->attributes
+		 * @return A reference to this shape object
+		*/
+		Shape& buildVAO();
+
+		/** @brief Delete the vertex array objects and all stream buffers
+		 * @return A reference to this shape object
+		*/
+		Shape& deleteBuffers();
+
 	public:
 		enum DataType : uint16_t {
 			FLOAT 	= GL_FLOAT,
@@ -105,6 +130,28 @@ namespace oglopp {
 			U64VEC4 = GL_UNSIGNED_INT64_VEC4_ARB
 		};
 
+		/** @brief A single vertex attribute within the interleaved vertex list
+		*/
+		struct Attribute {
+			uint8_t index;		// The attribute location in the vertex shader
+			DataType type;		// The attribute data type
+			uint32_t elements;	// Number of components
+			uint32_t bytes;		// Total number of bytes
+			uint32_t offset;	// Offset in bytes from the start of an interleaved vertex
+		};
+
+	protected:
+		std::vector<Attribute> attributes;
+
+		/** @brief Set the attribute pointer for the currently bound array buffer
+		 * @param[in] attribute	The attribute to describe
+		 * @param[in] stride	The stride in bytes of the stream containing the attribute
+		 * @param[in] offset	The offset in bytes of the attribute within the stream
+		*/
+		static void setAttribPointer(Attribute const& attribute, uint32_t stride, uint64_t offset);
+
+	public:
+
 		Shape();
 		~Shape();
 
@@ -200,66 +247,21 @@ namespace oglopp {
 	 	*/
 		template <typename First, typename... Args>
 		Shape& finalizePoints(const int index, First firstParam, Args...args) {
-			// The current stride bytes is the offset
-			const uint64_t OFFSET = this->strideBytes;
+			const DataType TYPE = static_cast<DataType>(firstParam);
 
 			// Calculate the stride elements and stride bytes for THIS SINGLE DATATYPE
-			uint32_t thisStrideElems = Shape::getStrideElems(static_cast<DataType>(firstParam));
-			uint32_t thisStrideBytes = thisStrideElems * Shape::getStrideComponentBytes(static_cast<DataType>(firstParam));
+			uint32_t thisStrideElems = Shape::getStrideElems(TYPE);
+			uint32_t thisStrideBytes = thisStrideElems * Shape::getStrideComponentBytes(TYPE);
 
-			//std::cout << "this bytes is " << thisStrideBytes << std::endl;
+			// The current stride bytes is the offset
+			this->attributes.push_back({static_cast<uint8_t>(index), TYPE, thisStrideElems, thisStrideBytes, this->strideBytes});
 
 			// Accumulate this datatype's stride into the total
 			this->strideElements += thisStrideElems;
 			this->strideBytes += thisStrideBytes;
 
-			// Recurse - accumulate all datatypes before using calculated total
-			this->finalizePoints(index + 1, args...);
-
-			// Now do what I gotta do - we can use the calculated total in this->strideElements and this->strideBytes
-			switch(firstParam) {
-				case FLOAT:
-				case VEC2:
-				case VEC3:
-				case VEC4:
-					glVertexAttribPointer(index, thisStrideElems, Shape::getStructComponentRegister(firstParam), GL_FALSE, this->strideBytes, (void*)OFFSET);
-					break;
-
-				case DVEC4:
-				case DVEC3:
-				case DVEC2:
-				case DOUBLE:
-					glVertexAttribLPointer(index, thisStrideElems, Shape::getStructComponentRegister(firstParam), this->strideBytes, (void*)OFFSET);
-					break;
-
-				case UINT8:
-				case UINT16:
-				case UINT32:
-				case INT8:
-				case INT16:
-				case INT32:
-				case IVEC2:
-				case I64VEC2:
-				case UVEC2:
-				case U64VEC2:
-				case IVEC3:
-				case I64VEC3:
-				case UVEC3:
-				case U64VEC3:
-				case IVEC4:
-				case I64VEC4:
-				case UVEC4:
-				case U64VEC4:
-					glVertexAttribIPointer(index, thisStrideElems, Shape::getStructComponentRegister(firstParam), this->strideBytes, (void*)OFFSET);
-					break;
-
-				default:
-					return *this;
-			}
-
-			glEnableVertexAttribArray(index);
-
-			return *this;
+			// Recurse - accumulate all datatypes. The termination case builds the buffers using the calculated total
+			return this->finalizePoints(index + 1, args...);
 		}
 
 		/** @brief Replacement for updateVAO. Allows dynamically specifying the type of value. Termination case (DOES RECURSE)
@@ -271,16 +273,20 @@ namespace oglopp {
 		Shape& finalizePoints(First firstParam, Args...args) {
 			this->strideElements = 0;
 			this->strideBytes = 0;
+			this->attributes.clear();
 
-			finalizePoints(0, firstParam, args...);
-
-			// Unbind the vertex array
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindVertexArray(0);
-
-			return *this;
+			return finalizePoints(0, firstParam, args...);
 		}
 
+		/** @brief Split the vertex data into multiple streams (buffers). Each value is the attribute index that begins a new stream.
+		 * 	For example, {1} places the position (attribute 0) in its own buffer and everything else in a second buffer.
+		 * 	When the position is alone in the first stream, a position-only VAO is also built and used automatically for position-only shaders (depth prepass, shadow maps).
+		 * 	If the shape was already uploaded, the buffers are rebuilt with the new layout.
+		 * @param[in] firstAttributes	The attribute indices which begin a new stream. Empty for a single interleaved stream
+		 * @return						A reference to this shape object
+	 	*/
+		Shape& setStreams(std::vector<uint8_t> const& firstAttributes);
+
 		/** @brief Convert a shape DataType to a stride element count
 		 * @param[in] dataType	The data type
 		 * @return				The number of associated stride elements/components
@@ -301,6 +307,13 @@ namespace oglopp {
 
 		unsigned int getVAO();
 		unsigned int getVBO();
+		unsigned int getDepthVAO();
+		unsigned int getVertCount();
+
+		/** @brief Get the number of indices (three per triangle), as an indexed draw command's count
+		 * @return The number of indices
+		*/
+		unsigned int getElementCount();
 		std::vector<uint8_t>& getVertices();
 		std::vector<Texture*>& getTextureList();
 
@@ -311,6 +324,17 @@ namespace oglopp {
 		*/
 		Shape& draw(Window& window, Shader* pShader = nullptr);
 
+		/** @brief Draw this shape once per command in an indirect buffer, eg. written by a culling compute shader.
+		 *  Shapes with indices need a DrawElementsIndirectBuffer, shapes without a DrawArraysIndirectBuffer
+		 * @param[in] window	A reference to the window object
+		 * @param[in] pShader	A pointer to the shader object
+		 * @param[in] commands	The draw commands
+		 * @param[in] maxDraws	The most commands drawn. 0 for the buffer's capacity. The count in the buffer is used when
+		 *						GL 4.6 or ARB_indirect_parameters is available, otherwise exactly maxDraws are drawn
+		 * @return 				A reference to this shape
+		*/
+		Shape& drawIndirect(Window& window, Shader* pShader, IndirectBuffer& commands, uint32_t maxDraws = 0);
+
 		/** @brief Get the position of this shape
 		 * @return The position of this shape
 		*/
@@ -0,0 +1,161 @@
+#ifndef OGLOPP_SPRITEBATCH_H
+#define OGLOPP_SPRITEBATCH_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "defines.h"
+#include "shader.h"
+#include "texture.h"
+#include "more_shapes.h"
+#include "typedssbo.h"
+
+/*
+ - Sprites are instances of one Rectangle. Its vertex array is bound once and each sprite's position, size, rotation, texture
+   region and color are read from a storage buffer by the run's first sprite + gl_InstanceID, so a sprite costs 64 bytes and no draw
+ - draw() only appends the sprite and the index of its texture group to arrays on the CPU, which keep their capacity between
+   frames. A group is a Texture, a texture array or no texture. Sprites in one texture array share a group,
+   whatever their layer, so an atlas of many images is one draw
+ - end() writes the sprites, grouped, straight into a persistently mapped ring of regions (see ssbo.h), then draws each group
+   with one glDrawElementsInstanced call
+ - In TEXTURE order the groups are formed with a counting sort, so each texture is drawn once, in the order textures were first
+   used, and sprites of one texture keep their order. Sprites of different textures can end up above one another differently
+   than they were submitted. SUBMISSION order keeps the order exactly and only merges runs of sprites sharing a texture
+ - begin() with no projection maps pixels, origin at the top left of the viewport, y down. The texture region is given from the
+   top left of the image, and shows the right way up in that space. With a projection whose y points up, give a negative height
+*/
+
+namespace oglopp {
+	/** @brief Batches textured quads into a few instanced draws
+	*/
+	class SpriteBatch {
+	public:
+		static constexpr GLuint SPRITE_BINDING = 0;
+
+		enum SortMode : uint8_t {
+			TEXTURE,		// One draw per texture. Order is kept within a texture only
+			SUBMISSION		// Order is kept. One draw per run of sprites sharing a texture
+		};
+
+		/** @brief One sprite as stored on the GPU
+		*/
+		struct Sprite {
+			glm::vec4 rect;			// Center xy, size zw
+			glm::vec4 region;		// The part of the texture from the top left of the image: left, top, right, bottom
+			glm::vec4 color;		// Multiplies the texture
+			glm::vec4 extra;		// x is the rotation in radians about the center, y the texture array layer, zw unused
+		};
+
+		SpriteBatch();
+
+		SpriteBatch(SpriteBatch const&) = delete;
+		SpriteBatch& operator=(SpriteBatch const&) = delete;
+
+		/** @brief Start a batch in pixels over the current viewport, origin at the top left, y down
+		 * @return A reference to this object
+	 	*/
+		SpriteBatch& begin();
+
+		/** @brief Start a batch with a projection
+		 * @param[in] projection	Transforms sprite positions to clip space
+		 * @return					A reference to this object
+	 	*/
+		SpriteBatch& begin(glm::mat4 const& projection);
+
+		/** @brief Add a sprite
+		 * @param[in] texture	The texture, or nullptr for a plain colored quad. It must live until end()
+		 * @param[in] center	The center
+		 * @param[in] size		The width and height
+		 * @param[in] color		The color, multiplied with the texture
+		 * @param[in] region	The part of the texture to show: left, top, right, bottom, from 0 to 1 from the top left
+		 * @param[in] rotation	The rotation in radians about the center
+		 * @return				A reference to this object
+	 	*/
+		SpriteBatch& draw(Texture* texture, glm::vec2 const& center, glm::vec2 const& size, glm::vec4 const& color = glm::vec4(1.0),
+			glm::vec4 const& region = glm::vec4(0.0, 0.0, 1.0, 1.0), float rotation = 0.0);
+
+		/** @brief Add a sprite from a layer of a texture array
+		 * @param[in] textureArray	The GL name of a GL_TEXTURE_2D_ARRAY, its rows uploaded bottom up like Texture does
+		 * @param[in] layer			The layer
+		 * @param[in] center		The center
+		 * @param[in] size			The width and height
+		 * @param[in] color			The color, multiplied with the texture
+		 * @param[in] region		The part of the layer to show: left, top, right, bottom, from 0 to 1 from the top left
+		 * @param[in] rotation		The rotation in radians about the center
+		 * @return					A reference to this object
+	 	*/
+		SpriteBatch& drawLayer(GLuint textureArray, uint32_t layer, glm::vec2 const& center, glm::vec2 const& size, glm::vec4 const& color = glm::vec4(1.0),
+			glm::vec4 const& region = glm::vec4(0.0, 0.0, 1.0, 1.0), float rotation = 0.0);
+
+		/** @brief Upload the batch and draw it, one draw per group
+		 * @return A reference to this object
+	 	*/
+		SpriteBatch& end();
+
+		/** @brief Set how sprites are grouped into draws
+		 * @param[in] mode	The sort mode
+		 * @return			A reference to this object
+	 	*/
+		SpriteBatch& setSortMode(SortMode mode);
+
+		/** @brief Get the number of sprites the last end() drew
+		 * @return The sprite count
+	 	*/
+		size_t getSpriteCount() const;
+
+		/** @brief Get the number of draws the last end() made
+		 * @return The draw count
+	 	*/
+		size_t getDrawCount() const;
+
+	private:
+		// What a group binds
+		struct Group {
+			Texture* texture;
+			GLuint array;			// A texture array instead, when texture is nullptr
+		};
+
+		SortMode sortMode = TEXTURE;
+		glm::mat4 projection = glm::mat4(1.0);
+
+		// The batch being built
+		std::vector<Sprite> sprites;
+		std::vector<uint32_t> spriteGroups;
+		std::vector<Group> groups;
+		std::unordered_map<uint64_t, uint32_t> groupIndices;
+		uint64_t lastKey = ~uint64_t(0);
+		uint32_t lastGroup = 0;
+
+		// Counting sort scratch, one entry per group
+		std::vector<uint32_t> groupStarts;
+
+		TypedSSBO<Sprite> ring;
+		uint64_t frame = 0;
+		size_t drawn = 0;
+		size_t draws = 0;
+
+		Rectangle quad;
+		std::unique_ptr<Shader> shader;
+
+		/** @brief Find or add the group of a texture
+		 * @param[in] texture	The texture, or nullptr
+		 * @param[in] array		The texture array, or 0
+		 * @return				The group index
+	 	*/
+		uint32_t getGroup(Texture* texture, GLuint array);
+
+		/** @brief Bind a group's texture for the next draw
+		 * @param[in] group		The group
+	 	*/
+		void bindGroup(Group const& group);
+	};
+
+	OGLOPP_STD430_STRUCT(SpriteBatch::Sprite, 16);
+	OGLOPP_STD430_MEMBER(SpriteBatch::Sprite, rect);
+	OGLOPP_STD430_MEMBER(SpriteBatch::Sprite, region);
+	OGLOPP_STD430_MEMBER(SpriteBatch::Sprite, color);
+	OGLOPP_STD430_MEMBER(SpriteBatch::Sprite, extra);
+}
+
+#endif
@@ -1,9 +1,30 @@
 #ifndef OGLOPP_SSBO_H
 #define OGLOPP_SSBO_H
 
+#include <memory>
+#include <vector>
+
 #include "defines.h"
+#include "hazards.h"
+
+/*
+ - load() makes a mutable buffer (glBufferData), and update() copies into it with glBufferSubData. The driver copies the data
+   once more on the way, which is fine for buffers written now and then
+ - loadPersistent() makes immutable storage (glBufferStorage) which stays mapped, persistent and coherent, for buffers the CPU rewrites
+   every frame. The storage holds a few regions of the same size, used in turn: writePtr(frame) selects the region for a frame and
+   returns a pointer into it, so the CPU writes straight into memory the GPU reads, with no copy
+ - When writePtr() moves on to another region, a fence is placed after the commands submitted so far, which are the ones reading
+   the old region. Coming back around to a region waits on its fence, so the CPU never overwrites data the GPU is still using.
+   With 3 regions that only happens if the CPU is 2 frames ahead
+ - update() and map(WRITE) on persistent storage write the selected region in place. Commands already submitted may still be
+   reading it, so they wait for the GPU to finish those first. Writing through writePtr() at the start of a frame never stalls
+ - bind(), BindingTable and readbackAsync() use the selected region. getRegionOffset() gives its start for binding it some other way
+*/
 
 namespace oglopp {
+	class Readback;
+	class ReadbackRing;
+
 	class SSBO {
 		public:
 			enum MapMethod : uint16_t {
@@ -15,16 +36,26 @@ namespace oglopp {
 			/** @brief Create a new SSBO object. Default constructor
 	 		*/
 			SSBO() = default;
-			~SSBO() = default;
 
-			/** @brief Copy the data in a pointer into the ssbo to be sent to the GPU on dispatch
+			/** @brief Delete the GL buffer
+	 		*/
+			~SSBO();
+
+			// The GL buffer has one owner. Moving hands it over
+			SSBO(SSBO const&) = delete;
+			SSBO& operator=(SSBO const&) = delete;
+			SSBO(SSBO&& other) noexcept;
+			SSBO& operator=(SSBO&& other) noexcept;
+
+			/** @brief Copy the data in a pointer into the ssbo to be sent to the GPU on dispatch. Loading again reuses the GL buffer
 			 * @param[in] buffer	A pointer to some buffer
 			 * @param[in] size		The number of bytes to be read from the buffer
 			 * @return				A status code. 0 for success. -1 for failure.
 		 	*/
 			int8_t load(void* buffer, size_t size);
 
-			/** @brief Update a portion of the ssbo data
+			/** @brief Update a portion of the ssbo data. Persistent storage is written directly, in the region writePtr() selected,
+			 *  after waiting for the GPU to finish the commands already submitted
 			 * @param[in] offset	The offset in bytes from the start of the ssbo buffer
 			 * @param[in] buffer	A pointer to some buffer
 			 * @param[in] size		The number of bytes to be read from the buffer
@@ -47,7 +78,24 @@ namespace oglopp {
 		 	*/
 			size_t getSize() const;
 
-			/** @brief Map the SSBO to a buffer
+			/** @brief Get the GL buffer object name
+			 * @return	The buffer name, for binding it to other targets (uniform, atomic counter, indirect)
+		 	*/
+			GLuint getBuffer() const;
+
+			/** @brief Record that a shader wrote to this buffer (storage or atomic counter writes). Compute::dispatch() does this for its buffers
+			 * @return	A reference to this SSBO object
+		 	*/
+			SSBO& markWritten();
+
+			/** @brief Issue the barrier bits needed before this buffer is used in some way, if a shader wrote to it since they were last issued
+			 * @param[in] barriers	The bits for the kind of use, eg. GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT to draw from it
+			 * @return				A reference to this SSBO object
+		 	*/
+			SSBO& sync(GLbitfield barriers);
+
+			/** @brief Map the SSBO to a buffer. Persistent storage is already mapped for writing, so WRITE returns the selected region,
+			 *  after waiting for the GPU to finish the commands already submitted
 			 * @param[in] method	The method of mapping. READ, WRITE, or BOTH
 			 * @return 				A pointer to the mapped buffer
 		 	*/
@@ -58,9 +106,75 @@ namespace oglopp {
 		 	*/
 			SSBO& unmap();
 
-		private:
-			GLuint ssbo;
-			size_t bufferSize;
+			/** @brief Start copying a range of the SSBO back to the CPU without waiting for the GPU. Poll the result with
+			 *  ready() on a later frame, rather than stalling in map() until every write to the buffer has finished
+			 * @param[in] offset	The start of the range in bytes
+			 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+			 * @param[in] ring		The staging buffers to copy into, or nullptr for the shared ring
+			 * @return				The pending readback, or nullptr if the range is out of bounds
+		 	*/
+			std::shared_ptr<Readback> readbackAsync(size_t offset = 0, size_t size = 0, ReadbackRing* ring = nullptr);
+
+			/** @brief Create immutable, persistently mapped storage holding some number of regions of the same size.
+			 * Requires GL 4.4 or ARB_buffer_storage
+			 * @param[in] buffer	The initial contents of every region, or nullptr to zero them
+			 * @param[in] size		The size of a region in bytes
+			 * @param[in] regions	The number of regions. One per frame the CPU may run ahead of the GPU, plus one
+			 * @return				A status code. 0 for success. -1 if the size is 0. -2 if buffer storage is unavailable
+		 	*/
+			int8_t loadPersistent(void* buffer, size_t size, uint32_t regions = 3);
+
+			/** @brief Select the region for a frame and get a pointer the CPU can write it through. Waits only if the GPU
+			 *  is still reading that region from regions frames ago. Only valid after loadPersistent()
+			 * @param[in] frame		A number increasing by one every frame
+			 * @return				A pointer to getSize() writable bytes, or nullptr if the buffer is not persistent
+		 	*/
+			void* writePtr(uint64_t frame);
+
+			/** @brief Check if the buffer was made by loadPersistent()
+			 * @return True if the buffer is persistently mapped
+		 	*/
+			bool isPersistent() const;
+
+			/** @brief Get the number of regions in persistent storage
+			 * @return The region count, or 1 for a regular buffer
+		 	*/
+			uint32_t getRegionCount() const;
+
+			/** @brief Get the byte offset of the region writePtr() last selected
+			 * @return The offset in the GL buffer. Always 0 for a regular buffer
+		 	*/
+			size_t getRegionOffset() const;
+
+		protected:
+			GLuint ssbo = 0;
+			size_t bufferSize = 0;			// The bytes in use. Bounds checks and binding ranges use this
+			size_t capacityBytes = 0;		// The bytes allocated, at least bufferSize
+
+			Hazards::epoch_t lastWrite = 0;
+
+			// Persistent storage. regions is 0 for a regular buffer
+			uint32_t regions = 0;
+			uint32_t region = 0;
+			size_t regionStride = 0;
+			uint8_t* persistent = nullptr;
+			std::vector<GLsync> fences;
+
+			/** @brief Wait for the GPU to finish with every region and go back to a regular buffer. The GL buffer is deleted
+		 	*/
+			void releasePersistent();
+
+			/** @brief Wait for the commands submitted so far to finish, since any of them may read the selected region
+		 	*/
+			void waitForRegion();
+
+			/** @brief Move the contents to a new GL buffer of another capacity. The copy stays on the GPU.
+			 *  Persistent storage becomes a regular buffer holding the selected region
+			 * @param[in] capacity	The new capacity in bytes
+			 * @param[in] keep		The number of leading bytes to copy over
+			 * @return				A status code. 0 for success
+		 	*/
+			int8_t reallocate(size_t capacity, size_t keep);
 	};
 }
 
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <vector>
 #include "oglopp/fbo.h"
+#include "oglopp/hazards.h"
 
 namespace oglopp {
 	/** @brief Texture
@@ -27,6 +28,17 @@ namespace oglopp {
 		unsigned int TID = 0;
 		unsigned int TBO = 0; // Texture Buffer Object, optional
 
+		GLenum internalFormat = GL_RGBA8; // Storage format of render target textures
+
+		Hazards::epoch_t lastWrite = 0; // Last image store to this texture
+
+		/** @brief Get the pixel format and type to pass alongside an internal format when allocating empty storage
+		 * @param[in]	format			The internal format
+		 * @param[out]	pixelFormat		The matching pixel format
+		 * @param[out]	pixelType		The matching pixel type
+		*/
+		static void getPixelFormat(GLenum format, GLenum* pixelFormat, GLenum* pixelType);
+
 		/** @brief Get color register that corresponds with some type. GL_RGB for jpg. GL_RGBA for png
 		 * @return The register defining how to read the color
 		*/
@@ -77,6 +89,15 @@ namespace oglopp {
 		 */
 		Texture(FBO& fbo, int width, int height, bool nearest = false);
 
+		/**
+		 * @brief Create an empty texture with a given storage format. Used for render targets, eg. with FBO::attachTexture()
+		 * @param[in] width				The width of the texture
+		 * @param[in] height			The height of the texture
+		 * @param[in] internalFormat	The storage format, eg. GL_RGBA8, GL_RGB10_A2, GL_RGBA16F or GL_DEPTH24_STENCIL8
+		 * @param[in] nearest			Use nearest-neighbour texture filtering
+		 */
+		Texture(int width, int height, GLenum internalFormat, bool nearest = true);
+
 		/** @brief Texture destructor
 		*/
 		~Texture();
@@ -89,6 +110,36 @@ namespace oglopp {
 		 */
 		Texture& resizeWithFbo(FBO& fbo, int rboWidth, int rboHeight);
 
+		/**
+		 * @brief Reallocate the storage of a render target texture. The contents are lost
+		 * @param[in] newWidth	The new width
+		 * @param[in] newHeight	The new height
+		 * @return				A reference to this texture object
+		 */
+		Texture& resize(int newWidth, int newHeight);
+
+		/** @brief Get the internal storage format of a render target texture
+		 * @return The internal format
+		*/
+		GLenum getInternalFormat() const;
+
+		/** @brief Get the GLSL image format qualifier of an internal format, for image2D declarations
+		 * @param[in] format	The internal format
+		 * @return				The qualifier, eg. "rgba16f". nullptr if the format cannot be used as an image
+		*/
+		static const char* getImageFormat(GLenum format);
+
+		/** @brief Record that a shader wrote to this texture with imageStore. Compute::dispatch() does this for its images
+		 * @return A reference to this texture object
+		*/
+		Texture& markWritten();
+
+		/** @brief Issue the barrier bits needed before this texture is used in some way, if a shader stored to it since they were last issued
+		 * @param[in] barriers	The bits for the kind of use, eg. GL_FRAMEBUFFER_BARRIER_BIT to blit from it
+		 * @return				A reference to this texture object
+		*/
+		Texture& sync(GLbitfield barriers);
+
 		/** @brief Load an image path into the texture
 		*  @param[in]	path	The filepath to load
 		*  @param[in]	type	The type of the texture file
@@ -146,7 +197,7 @@ namespace oglopp {
 		*/
 		unsigned int getTexture();
 
-		/** @brief Bind this texture to some texture ID. Called before drawing each shape
+		/** @brief Bind this texture to some texture ID. Called before drawing each shape. Waits for image stores to it first
 		 * @param[in] id	The texture ID to bind to.
 	 	*/
 		Texture& bind(uint16_t id);
@@ -0,0 +1,109 @@
+#ifndef OGLOPP_TUNER_H
+#define OGLOPP_TUNER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "compute.h"
+
+/*
+ - The kernel declares `layout (local_size_x = LOCAL_SIZE_X) in;`. The tuner compiles it once per candidate size,
+   with `#define LOCAL_SIZE_X <size>` inserted after the #version line
+ - Each candidate runs the caller's dispatch a few times, timed on the GPU with GL_TIME_ELAPSED queries. The fastest wins
+ - Winners are saved to a cache file keyed by a hash of the source, GL_RENDERER and GL_VERSION, so a new driver or
+   a changed kernel is tuned again and everything else is compiled once
+*/
+
+namespace oglopp {
+	/** @brief Picks the fastest local_size_x for a compute kernel on the current device
+	*/
+	class ComputeTuner {
+	public:
+		// Binds the kernel's inputs and dispatches it, eg. with dispatchElements(). Called for every timed run
+		typedef std::function<void(Compute&)> RunFunction;
+
+		static constexpr const char* LOCAL_SIZE_DEFINE = "LOCAL_SIZE_X";
+
+		/** @brief Create a tuner and load its cache file, if there is one
+		 * @param[in] cachePath		The file the winning sizes are stored in
+	 	*/
+		ComputeTuner(std::string const& cachePath = "oglopp-tuning.cache");
+
+		/** @brief Set the local sizes to try. Sizes the device does not allow are skipped
+		 * @param[in] sizes		The candidate local_size_x values
+		 * @return				A reference to this object
+	 	*/
+		ComputeTuner& setCandidates(std::vector<GLint> const& sizes);
+
+		/** @brief Set how many times each candidate runs
+		 * @param[in] warmup	Untimed runs first, so compilation and caches settle
+		 * @param[in] timed		Timed runs. The fastest one counts
+		 * @return				A reference to this object
+	 	*/
+		ComputeTuner& setRuns(uint32_t warmup, uint32_t timed);
+
+		/** @brief Compile a kernel with its best local size, tuning it first if the cache has no entry for it on this device
+		 * @param[in] source	The compute shader source, using LOCAL_SIZE_X
+		 * @param[in] run		Dispatches the kernel over representative inputs
+		 * @param[in] binding	The SSBO binding passed to the Compute constructor
+		 * @return				The compiled kernel
+	 	*/
+		std::unique_ptr<Compute> tune(std::string const& source, RunFunction run, GLuint binding = 0);
+
+		/** @brief Get the cached local size of a kernel on this device
+		 * @param[in] source	The compute shader source
+		 * @return				The local size, or 0 if the kernel has not been tuned on this device
+	 	*/
+		GLint getCachedSize(std::string const& source) const;
+
+		/** @brief Insert a #define after the #version line of a shader
+		 * @param[in] source	The shader source
+		 * @param[in] name		The macro name
+		 * @param[in] value		The macro value
+		 * @return				The new source
+	 	*/
+		static std::string injectDefine(std::string const& source, std::string const& name, std::string const& value);
+
+	private:
+		struct CacheEntry {
+			GLint size;
+			std::string renderer;	// Only for people reading the file
+		};
+
+		std::string cachePath;
+		std::map<std::string, CacheEntry> cache;	// Key (hex hash) to local size
+
+		std::vector<GLint> candidates = {32, 64, 128, 256, 512, 1024};
+		uint32_t warmupRuns = 2;
+		uint32_t timedRuns = 5;
+
+		/** @brief Get the cache key of a kernel on the current device
+		 * @param[in] source	The compute shader source
+		 * @return				The key
+	 	*/
+		static std::string getKey(std::string const& source);
+
+		/** @brief Time one candidate
+		 * @param[in] kernel	The kernel compiled with the candidate size
+		 * @param[in] run		The dispatch function
+		 * @return				The fastest run in nanoseconds
+	 	*/
+		uint64_t time(Compute& kernel, RunFunction const& run) const;
+
+		/** @brief Read the cache file
+		 * @return A status code. 0 for success. -1 if the file could not be opened
+	 	*/
+		int8_t load();
+
+		/** @brief Write the cache file
+		 * @return A status code. 0 for success. -1 if the file could not be opened
+	 	*/
+		int8_t save() const;
+	};
+}
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef OGLOPP_TYPEDSSBO_H
+#define OGLOPP_TYPEDSSBO_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "defines.h"
+#include "ssbo.h"
+#include "shader.h"
+
+/*
+ - A TypedSSBO<T> holds an array of T laid out as a std430 `T data[]` block member. The element type is checked at compile time:
+   - It must be trivially copyable, since it is copied to the GPU byte for byte
+   - It may not be a 3 component vector or a matrix with 3 rows. std430 pads those to 16 bytes in an array while glm packs them
+     into 12, so a vec3 array silently reads every element after the first from the wrong place. Use vec4 (or pad the struct)
+   - Its size must be a multiple of its std430 alignment, which is the array stride the shader will use
+ - std430 aligns a struct to its largest member, which C++ can't see: glm types are only aligned to their scalars. So a struct
+   element declares its alignment with OGLOPP_STD430_STRUCT(Type, alignment) after its definition, and each member is checked
+   against it, and against its own alignment, with OGLOPP_STD430_MEMBER(Type, member). Structs that were not declared don't compile
+ - The element checks are made when the buffer is first filled, not when TypedSSBO<T> is named, so a class can hold a
+   TypedSSBO of its own nested struct with the declaration after the class
+ - The stride of an actual block can be checked with checkLayout() once the program is linked
+ - size() is the number of elements in use. The buffer grows geometrically, so repeated resize() or push() calls stay amortised
+   O(1), and existing contents are copied on the GPU with glCopyBufferSubData instead of a round trip through the CPU
+ - map() returns a std::span over a range of elements, valid until unmap()
+ - assignPersistent() switches to persistently mapped regions (see ssbo.h), written through writeSpan(frame). Growing the buffer
+   afterwards goes back to regular storage
+*/
+
+namespace oglopp {
+
+	/** @brief The std430 base alignment of a type. Scalars use their C++ alignment, which matches std430 for int, uint, float
+	 * and double. Structs must be declared with OGLOPP_STD430_STRUCT
+	*/
+	template <typename T>
+	struct Std430 {
+		static_assert(!std::is_class<T>::value, "Declare the std430 alignment of the struct with OGLOPP_STD430_STRUCT(Type, alignment)");
+
+		static constexpr size_t alignment = alignof(T);
+		static constexpr bool padded = false;		// True if std430 stores the type with padding the C++ type does not have
+	};
+
+	template <glm::length_t L, typename T, glm::qualifier Q>
+	struct Std430<glm::vec<L, T, Q>> {
+		static constexpr size_t alignment = (L == 1 ? 1 : (L == 2 ? 2 : 4)) * sizeof(T);
+		static constexpr bool padded = L == 3;
+	};
+
+	// A matrix is an array of column vectors, each aligned like a vec4
+	template <glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+	struct Std430<glm::mat<C, R, T, Q>> {
+		static constexpr size_t alignment = Std430<glm::vec<R, T, Q>>::alignment;
+		static constexpr bool padded = R == 3;
+	};
+
+	template <typename T, size_t N>
+	struct Std430<T[N]> {
+		static constexpr size_t alignment = Std430<T>::alignment;
+		static constexpr bool padded = Std430<T>::padded || sizeof(T) % Std430<T>::alignment != 0;
+	};
+
+	/** @brief Declare the std430 alignment of a struct: the largest alignment of its members. Use it in namespace oglopp,
+	 * after the struct definition
+	 * @param[in] Type		The struct
+	 * @param[in] align		Its alignment in bytes, eg. 16 if it has a vec4, uvec4 or mat4 member
+	*/
+	#define OGLOPP_STD430_STRUCT(Type, align) \
+		template <> \
+		struct Std430<Type> { \
+			static constexpr size_t alignment = align; \
+			static constexpr bool padded = false; \
+		}
+
+	/** @brief Check at compile time that a struct member sits where std430 would put it, and that the struct's declared
+	 * alignment covers it
+	 * @param[in] Type		The struct, declared with OGLOPP_STD430_STRUCT
+	 * @param[in] member	The member name
+	*/
+	#define OGLOPP_STD430_MEMBER(Type, member) \
+		static_assert(::oglopp::Std430<decltype(Type::member)>::alignment <= ::oglopp::Std430<Type>::alignment, \
+			#Type " is declared with a smaller std430 alignment than " #member " has"); \
+		static_assert(offsetof(Type, member) % ::oglopp::Std430<decltype(Type::member)>::alignment == 0, \
+			#Type "::" #member " is not aligned as std430 requires. Reorder the members or add padding"); \
+		static_assert(!::oglopp::Std430<decltype(Type::member)>::padded, \
+			#Type "::" #member " is padded in std430 but not in C++. Use a 4 component type or add padding")
+
+	/** @brief An SSBO holding an array of one std430 compatible type
+	*/
+	template <typename T>
+	class TypedSSBO : public SSBO {
+		/** @brief Check the element type. Called where the buffer is filled, so T's Std430 declaration can come after this is named
+	 	*/
+		static constexpr void checkElement() {
+			static_assert(std::is_trivially_copyable<T>::value, "TypedSSBO elements are copied byte for byte and must be trivially copyable");
+			static_assert(!Std430<T>::padded, "std430 pads this type to 16 bytes in an array but C++ does not. Use a vec4 (or a padded struct) instead of a vec3");
+			static_assert(sizeof(T) % Std430<T>::alignment == 0, "The element size must be a multiple of its std430 alignment");
+		}
+
+		public:
+			static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+			/** @brief Create an empty typed SSBO. Nothing is allocated until it is resized or assigned
+		 	*/
+			TypedSSBO() = default;
+
+			/** @brief Create a typed SSBO holding some number of copies of a value
+			 * @param[in] count	The number of elements
+			 * @param[in] value	The value of every element
+		 	*/
+			explicit TypedSSBO(size_t count, T const& value = T()) {
+				std::vector<T> values(count, value);
+				this->assign(values);
+			}
+
+			/** @brief Create a typed SSBO holding a copy of some values
+			 * @param[in] values	The values
+		 	*/
+			explicit TypedSSBO(std::span<const T> values) {
+				this->assign(values);
+			}
+
+			/** @brief Replace the contents, growing the buffer if needed
+			 * @param[in] values	The new contents
+			 * @return				A reference to this object
+		 	*/
+			TypedSSBO& assign(std::span<const T> values) {
+				this->resize(values.size(), false);
+				return this->set(0, values);
+			}
+
+			/** @brief Copy some values into the buffer
+			 * @param[in] first		The index of the first element to overwrite
+			 * @param[in] values	The values. They must fit in size()
+			 * @return				A reference to this object
+		 	*/
+			TypedSSBO& set(size_t first, std::span<const T> values) {
+				if (values.empty()) {
+					return *this;
+				}
+
+				if (first + values.size() > this->count) {
+					std::cout << "[Oglopp] TypedSSBO::set: writing " << values.size() << " elements at " << first << " overruns " << this->count << std::endl;
+					return *this;
+				}
+
+				this->update(first * sizeof(T), const_cast<T*>(values.data()), values.size() * sizeof(T));
+				return *this;
+			}
+
+			/** @brief Append one element, growing the buffer if needed
+			 * @param[in] value	The element
+			 * @return			A reference to this object
+		 	*/
+			TypedSSBO& push(T const& value) {
+				this->resize(this->count + 1);
+				return this->set(this->count - 1, std::span<const T>(&value, 1));
+			}
+
+			/** @brief Make sure the buffer can hold some number of elements without reallocating
+			 * @param[in] capacity	The number of elements
+			 * @param[in] keep		True to copy the current contents into the new buffer
+			 * @return				A reference to this object
+		 	*/
+			TypedSSBO& reserve(size_t capacity, bool keep = true) {
+				if (capacity * sizeof(T) > this->capacityBytes) {
+					this->reallocate(capacity * sizeof(T), keep ? this->bufferSize : 0);
+				}
+
+				return *this;
+			}
+
+			/** @brief Change the number of elements in use. Growing past the capacity reallocates to at least 1.5x the old capacity.
+			 * New elements are undefined. Shrinking keeps the allocation
+			 * @param[in] count	The number of elements
+			 * @param[in] keep	True to copy the current contents into a new buffer
+			 * @return			A reference to this object
+		 	*/
+			TypedSSBO& resize(size_t count, bool keep = true) {
+				TypedSSBO::checkElement();
+
+				size_t capacity = this->capacity();
+				if (count > capacity) {
+					this->reserve(std::max(count, capacity + capacity / 2), keep);
+				}
+
+				this->count = count;
+				this->bufferSize = count * sizeof(T);
+
+				return *this;
+			}
+
+			/** @brief Get the number of elements in use
+			 * @return The element count
+		 	*/
+			size_t size() const {
+				return this->count;
+			}
+
+			/** @brief Get the number of elements the buffer can hold without reallocating
+			 * @return The capacity in elements
+		 	*/
+			size_t capacity() const {
+				return this->capacityBytes / sizeof(T);
+			}
+
+			/** @brief Map a range of elements into CPU memory, for reading and writing. Persistent storage can only be written,
+			 * so it is mapped for writing. Read it with readbackAsync()
+			 * @param[in] first		The index of the first element
+			 * @param[in] count		The number of elements. npos for the rest of the buffer
+			 * @return				The mapped elements, or an empty span on failure
+		 	*/
+			std::span<T> map(size_t first = 0, size_t count = npos) {
+				return this->map(first, count, this->isPersistent() ? WRITE : BOTH);
+			}
+
+			/** @brief Map a range of elements into CPU memory. Pending shader writes are waited for first
+			 * @param[in] first		The index of the first element
+			 * @param[in] count		The number of elements. npos for the rest of the buffer
+			 * @param[in] method	Whether the range is read, written, or both. Only WRITE for persistent storage
+			 * @return				The mapped elements, or an empty span on failure
+		 	*/
+			std::span<T> map(size_t first, size_t count, MapMethod method) {
+				if (count == npos) {
+					count = first < this->count ? this->count - first : 0;
+				}
+
+				if (count == 0 || first + count > this->count) {
+					std::cout << "[Oglopp] TypedSSBO::map: range of " << count << " elements at " << first << " is outside " << this->count << std::endl;
+					return {};
+				}
+
+				// Persistent storage is always mapped
+				if (this->isPersistent()) {
+					T* mapped = static_cast<T*>(SSBO::map(method));
+					return mapped != nullptr ? std::span<T>(mapped + first, count) : std::span<T>();
+				}
+
+				this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+				GLbitfield access = method == READ ? GL_MAP_READ_BIT : (method == WRITE ? GL_MAP_WRITE_BIT : GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
+
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
+				T* mapped = static_cast<T*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, first * sizeof(T), count * sizeof(T), access));
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+				if (mapped == nullptr) {
+					return {};
+				}
+
+				return std::span<T>(mapped, count);
+			}
+
+			/** @brief Replace the contents with persistently mapped storage, with a copy of some values in every region
+			 * @param[in] values	The new contents
+			 * @param[in] regions	The number of regions
+			 * @return				A status code from SSBO::loadPersistent()
+		 	*/
+			int8_t assignPersistent(std::span<const T> values, uint32_t regions = 3) {
+				TypedSSBO::checkElement();
+
+				int8_t status = this->loadPersistent(const_cast<T*>(values.data()), values.size() * sizeof(T), regions);
+				this->count = status == 0 ? values.size() : 0;
+
+				return status;
+			}
+
+			/** @brief Select the region for a frame and get its elements to write. See SSBO::writePtr()
+			 * @param[in] frame		A number increasing by one every frame
+			 * @return				The elements of the region, or an empty span if the buffer is not persistent
+		 	*/
+			std::span<T> writeSpan(uint64_t frame) {
+				T* elements = static_cast<T*>(this->writePtr(frame));
+				return elements != nullptr ? std::span<T>(elements, this->count) : std::span<T>();
+			}
+
+			/** @brief Unmap the range returned by map()
+			 * @return A reference to this object
+		 	*/
+			TypedSSBO& unmap() {
+				SSBO::unmap();
+				return *this;
+			}
+
+			/** @brief Check that the stride of an array block member in a linked program matches sizeof(T).
+			 * This catches layouts the compile time checks cannot see, such as a vec3 inside a struct
+			 * @param[in] shader	The program using the block
+			 * @param[in] variable	The array member as reflected, for example "Particles.particles[0]"
+			 * @return				A status code. 0 if the stride matches, -1 if it differs or the variable is not found
+		 	*/
+			int8_t checkLayout(Shader& shader, const char* variable) const {
+				shader.use();
+
+				GLint program = 0;
+				glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+				GLuint index = glGetProgramResourceIndex(program, GL_BUFFER_VARIABLE, variable);
+				if (index == GL_INVALID_INDEX) {
+					std::cout << "[Oglopp] TypedSSBO::checkLayout: no buffer variable named " << variable << std::endl;
+					return -1;
+				}
+
+				GLenum property = GL_TOP_LEVEL_ARRAY_STRIDE;
+				GLint stride = 0;
+				glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, index, 1, &property, 1, nullptr, &stride);
+
+				if (static_cast<size_t>(stride) != sizeof(T)) {
+					std::cout << "[Oglopp] TypedSSBO::checkLayout: " << variable << " has a stride of " << stride << " bytes but the element type is " << sizeof(T) << std::endl;
+					return -1;
+				}
+
+				return 0;
+			}
+
+		private:
+			size_t count = 0;
+	};
+}
+
+#endif
@@ -1,11 +1,16 @@
 #ifndef OGLOPP_WINDOW_H
 #define OGLOPP_WINDOW_H
 
+#include <vector>
+
 #include "defines.h"
 #include "camera.h"
+#include "shader.h"
 //#include "oglopp/glad/gl.h"
 
 namespace oglopp {
+	class Shape;
+
 	/*
 	 * @brief The resize callback type. A function that takes the new width and height respectively as parameters
 	 * @param [in] width	The new width
@@ -24,6 +29,7 @@ namespace oglopp {
 			NEVER		= GL_NEVER,
 			LESS		= GL_LESS,
 			LEQUAL		= GL_LEQUAL,
+			EQUAL		= GL_EQUAL,
 			GREATER		= GL_GREATER,
 			NOTEQUAL	= GL_NOTEQUAL,
 			GEQUAL		= GL_GEQUAL
@@ -45,6 +51,10 @@ namespace oglopp {
 			bool depthReadonly = false;
 			DepthPass depthPass = DepthPass::LESS;
 
+			// Depth prepass. Opaque shapes are first drawn depth-only, then shaded with an EQUAL depth test so each pixel is shaded once.
+			// The main vertex shaders should declare "invariant gl_Position;" and compute it the same way as Shader::DEPTH_PREPASS_VERTEX
+			bool depthPrepass = false;
+
 			// Face culling
 			bool doFaceCulling = true;
 
@@ -164,9 +174,44 @@ namespace oglopp {
 		 */
 		Window& setCallbackDataPtr(void* newPtr);
 
+		/** @brief Check if the depth prepass is enabled in the window settings
+		 * @return True if the depth prepass is enabled
+	 	*/
+		bool hasDepthPrepass() const;
+
+		/** @brief Get the position-only shader used for the depth prepass. Only valid if the depth prepass is enabled
+		 * @return A pointer to the prepass shader, or nullptr if the depth prepass is disabled
+	 	*/
+		Shader* getPrepassShader();
+
+		/** @brief Disable color writes and enable depth writes for the depth prepass. Does nothing if the depth prepass is disabled
+		 * @return A reference to this window object
+	 	*/
+		Window& beginDepthPrepass();
+
+		/** @brief Enable color writes, disable depth writes and test depth with EQUAL for the main pass. Does nothing if the depth prepass is disabled
+		 * @return A reference to this window object
+	 	*/
+		Window& beginShadingPass();
+
+		/** @brief Restore the depth state from the window settings after the main pass. Does nothing if the depth prepass is disabled
+		 * @return A reference to this window object
+	 	*/
+		Window& endShadingPass();
+
+		/** @brief Draw a list of opaque shapes depth-only with the prepass shader, then switch to the shading pass state.
+		 * 	Draw the same shapes with their real shaders afterwards, then call endShadingPass(). Does nothing if the depth prepass is disabled
+		 * @param[in] shapes	The opaque shapes to write into the depth buffer
+		 * @return				A reference to this window object
+	 	*/
+		Window& depthPrepass(std::vector<Shape*> const& shapes);
+
 	private:
 		uint32_t clearMask;
 
+		// Minimal position-only shader used for the depth prepass
+		Shader prepassShader;
+
 	    GLFWwindow* _window;
 
 		Camera renderCamera;
@@ -0,0 +1,269 @@
+#include "oglopp/billboard.h"
+
+namespace oglopp {
+
+	/** @brief Create a billboard renderer
+	 * @param[in] mode		How the quads are oriented
+	 * @param[in] fetch		GLSL defining `Billboard fetchBillboard(uint instance)` and anything it uses. Empty to read Instance SSBOs
+ 	*/
+	BillboardRenderer::BillboardRenderer(Mode mode, std::string const& fetch) : mode(mode) {
+		std::string vertex = std::string(
+		"#version 450 core\n"\
+		"#extension GL_ARB_shader_draw_parameters : enable\n"\
+		"#define BILLBOARD_MODE ") + std::to_string(mode) + "\n" +
+		BILLBOARD_STRUCT +
+		(fetch.empty() ? BillboardRenderer::getInstanceFetch() : fetch) +
+		\
+		"uniform mat4 view;\n"\
+		"uniform mat4 projection;\n"\
+		"uniform vec3 cameraPosition;\n"\
+		"uniform vec3 axis;\n"\
+		"uniform vec2 viewport;\n"\
+		\
+		"out vec2 corner;\n"\
+		"out vec4 color;\n"\
+		\
+		// gl_InstanceID doesn't include the base instance of an indirect command. Without the extension the base is taken to be 0
+		"#ifdef GL_ARB_shader_draw_parameters\n"\
+			"#define BASE_INSTANCE gl_BaseInstanceARB\n"\
+		"#else\n"\
+			"#define BASE_INSTANCE 0\n"\
+		"#endif\n"\
+		\
+		"const vec2 corners[6] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));\n"\
+		\
+		"void main() {\n"\
+			"Billboard billboard = fetchBillboard(uint(BASE_INSTANCE + gl_InstanceID));\n"\
+			\
+			"corner = corners[gl_VertexID];\n"\
+			"color = billboard.color;\n"\
+			\
+			"float c = cos(billboard.rotation);\n"\
+			"float s = sin(billboard.rotation);\n"\
+			"vec2 offset = mat2(c, s, -s, c) * corner * billboard.size;\n"\
+			\
+			// In the view plane
+			"#if BILLBOARD_MODE == 0\n"\
+				"gl_Position = projection * (view * vec4(billboard.position, 1.0) + vec4(offset, 0.0, 0.0));\n"\
+			\
+			// Turned about the axis to face the camera as well as it can
+			"#elif BILLBOARD_MODE == 1\n"\
+				"vec3 up = normalize(axis);\n"\
+				"vec3 right = cross(up, cameraPosition - billboard.position);\n"\
+				"right = dot(right, right) > 0.0 ? normalize(right) : vec3(1.0, 0.0, 0.0);\n"\
+				"gl_Position = projection * view * vec4(billboard.position + right * offset.x + up * offset.y, 1.0);\n"\
+			\
+			// Offset after projection, in pixels
+			"#else\n"\
+				"gl_Position = projection * view * vec4(billboard.position, 1.0);\n"\
+				"gl_Position.xy += offset * 2.0 / viewport * gl_Position.w;\n"\
+			"#endif\n"\
+		"}\n";
+
+		this->shader = std::make_unique<Shader>(vertex.c_str(),
+		"#version 450 core\n"\
+		"in vec2 corner;\n"\
+		"in vec4 color;\n"\
+		"out vec4 FragColor;\n"\
+		\
+		"uniform bool textured;\n"\
+		"uniform bool opaque;\n"\
+		"uniform sampler2D sprite;\n"\
+		\
+		"void main() {\n"\
+			"vec4 result = color;\n"\
+			"if (textured) {\n"\
+				"result *= texture(sprite, corner * 0.5 + 0.5);\n"\
+			"} else {\n"\
+				"result.a *= 1.0 - smoothstep(0.5, 1.0, length(corner));\n"\
+			"}\n"\
+			\
+			"if (result.a <= (opaque ? 0.5 : 0.0)) {\n"\
+				"discard;\n"\
+			"}\n"\
+			"FragColor = opaque ? vec4(result.rgb, 1.0) : result;\n"\
+		"}\n", ShaderType::RAW);
+
+		// Core profiles need a vertex array bound to draw, even with no attributes
+		glGenVertexArrays(1, &this->vao);
+	}
+
+	BillboardRenderer::~BillboardRenderer() {
+		if (this->vao != 0) {
+			glDeleteVertexArrays(1, &this->vao);
+		}
+	}
+
+	/** @brief Draw some number of billboards with the camera of a window. Call after the camera's projection and view are updated
+	 * @param[in] window		The window
+	 * @param[in] count			The number of billboards
+	 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+	 * @return					A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::draw(Window& window, uint32_t count, SSBO* instances) {
+		return this->draw(glm::mat4(window.getCam().getView()), glm::mat4(window.getCam().getProjection()), count, instances);
+	}
+
+	/** @brief Draw some number of billboards with explicit matrices
+	 * @param[in] view			The view matrix
+	 * @param[in] projection	The projection matrix
+	 * @param[in] count			The number of billboards
+	 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+	 * @return					A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::draw(glm::mat4 const& view, glm::mat4 const& projection, uint32_t count, SSBO* instances) {
+		if (count == 0) {
+			return *this;
+		}
+
+		this->begin(view, projection, instances);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+		this->end();
+
+		return *this;
+	}
+
+	/** @brief Draw the billboards counted by an indirect command, eg. written by a compute pass. Its count must be 6, and its
+	 *  base instance 0 unless the driver has GL_ARB_shader_draw_parameters
+	 * @param[in] window		The window
+	 * @param[in] commands		The draw command buffer
+	 * @param[in] index			The command to draw
+	 * @param[in] instances		The Instance data, or nullptr if the fetch function reads something else
+	 * @return					A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::drawIndirect(Window& window, DrawArraysIndirectBuffer& commands, uint32_t index, SSBO* instances) {
+		this->begin(glm::mat4(window.getCam().getView()), glm::mat4(window.getCam().getProjection()), instances);
+
+		commands.bindIndirect(GL_DRAW_INDIRECT_BUFFER);
+		glDrawArraysIndirect(GL_TRIANGLES, reinterpret_cast<const void*>(commands.getOffset(index)));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		this->end();
+
+		return *this;
+	}
+
+	/** @brief Set the uniforms and state shared by every draw
+	 * @param[in] view			The view matrix
+	 * @param[in] projection	The projection matrix
+	 * @param[in] instances		The Instance data, or nullptr
+ 	*/
+	void BillboardRenderer::begin(glm::mat4 const& view, glm::mat4 const& projection, SSBO* instances) {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		this->shader->use();
+		this->shader->setMat4("view", view);
+		this->shader->setMat4("projection", projection);
+		this->shader->setVec3("cameraPosition", glm::vec3(glm::inverse(view)[3]));
+		this->shader->setVec3("axis", this->axis);
+		this->shader->setVec2("viewport", glm::vec2(viewport[2], viewport[3]));
+		this->shader->setBool("opaque", this->blendMode == OPAQUE);
+		this->shader->setBool("textured", this->texture != nullptr);
+
+		if (this->texture != nullptr) {
+			this->shader->setInt("sprite", 0);
+			this->texture->bind(GL_TEXTURE0);
+		}
+
+		// The vertex shader reads the instances as shader storage
+		if (instances != nullptr) {
+			instances->sync(GL_SHADER_STORAGE_BARRIER_BIT).bind(INSTANCE_BINDING);
+		}
+
+		this->blendWas = glIsEnabled(GL_BLEND);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &this->blendFuncWas[0]);
+		glGetIntegerv(GL_BLEND_DST_RGB, &this->blendFuncWas[1]);
+		glGetIntegerv(GL_BLEND_SRC_ALPHA, &this->blendFuncWas[2]);
+		glGetIntegerv(GL_BLEND_DST_ALPHA, &this->blendFuncWas[3]);
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &this->depthWriteWas);
+
+		if (this->blendMode == OPAQUE) {
+			glDisable(GL_BLEND);
+		} else {
+			// Transparent billboards test depth but don't write it
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, this->blendMode == ADDITIVE ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+			glDepthMask(GL_FALSE);
+		}
+
+		glBindVertexArray(this->vao);
+	}
+
+	/** @brief Restore the state begin() changed
+ 	*/
+	void BillboardRenderer::end() {
+		glBindVertexArray(0);
+
+		glDepthMask(this->depthWriteWas);
+		glBlendFuncSeparate(this->blendFuncWas[0], this->blendFuncWas[1], this->blendFuncWas[2], this->blendFuncWas[3]);
+		if (this->blendWas) {
+			glEnable(GL_BLEND);
+		} else {
+			glDisable(GL_BLEND);
+		}
+	}
+
+	/** @brief Set the axis AXIS_ALIGNED billboards turn about
+	 * @param[in] axis	The world space axis
+	 * @return			A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::setAxis(glm::vec3 const& axis) {
+		this->axis = axis;
+
+		return *this;
+	}
+
+	/** @brief Set a texture to draw instead of the soft disc
+	 * @param[in] texture	The texture, or nullptr for the disc. It must outlive its use by this object
+	 * @return				A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::setTexture(Texture* texture) {
+		this->texture = texture;
+
+		return *this;
+	}
+
+	/** @brief Set how billboards blend with what is behind them
+	 * @param[in] mode	The blend mode
+	 * @return			A reference to this object
+ 	*/
+	BillboardRenderer& BillboardRenderer::setBlendMode(BlendMode mode) {
+		this->blendMode = mode;
+
+		return *this;
+	}
+
+	/** @brief Get the shader, eg. to set uniforms the fetch function uses. Call use() first
+	 * @return A reference to the shader
+ 	*/
+	Shader& BillboardRenderer::getShader() {
+		return *this->shader;
+	}
+
+	/** @brief Get the mode
+	 * @return How the quads are oriented
+ 	*/
+	BillboardRenderer::Mode BillboardRenderer::getMode() const {
+		return this->mode;
+	}
+
+	/** @brief Get the GLSL of the Instance block and the default fetch function
+	 * @param[in] binding	The storage block binding
+	 * @return				The source
+ 	*/
+	std::string BillboardRenderer::getInstanceFetch(GLuint binding) {
+		return
+		"struct Instance {\n"\
+			"vec4 position;\n"\
+			"vec4 color;\n"\
+			"vec4 rotation;\n"\
+		"};\n"\
+		"layout (std430, binding = " + std::to_string(binding) + ") readonly buffer BillboardInstances { Instance instances[]; };\n"\
+		\
+		"Billboard fetchBillboard(uint instance) {\n"\
+			"Instance i = instances[instance];\n"\
+			"return Billboard(i.position.xyz, i.position.w, i.color, i.rotation.x);\n"\
+		"}\n";
+	}
+}
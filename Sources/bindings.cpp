@@ -0,0 +1,281 @@
+#include "oglopp/bindings.h"
+#include "oglopp/glad/gl.h"
+
+#include <algorithm>
+
+namespace oglopp {
+	/** @brief Bind a buffer (or part of it) to a shader storage block
+	 * @param[in] binding	The binding point
+	 * @param[in] buffer	The buffer
+	 * @param[in] offset	The start of the range in bytes. Must respect GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+	 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+	 * @param[in] access	GL_READ_ONLY if the program never writes the block, so later uses need not wait for it
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::storage(GLuint binding, SSBO& buffer, GLintptr offset, GLsizeiptr size, GLenum access) {
+		return this->set({STORAGE_BUFFER, binding, &buffer, nullptr, offset, size, access, 0});
+	}
+
+	/** @brief Bind a buffer (or part of it) to a uniform block
+	 * @param[in] binding	The binding point
+	 * @param[in] buffer	The buffer
+	 * @param[in] offset	The start of the range in bytes. Must respect GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::uniform(GLuint binding, SSBO& buffer, GLintptr offset, GLsizeiptr size) {
+		return this->set({UNIFORM_BUFFER, binding, &buffer, nullptr, offset, size, GL_READ_ONLY, 0});
+	}
+
+	/** @brief Bind a buffer (or part of it) as atomic counters
+	 * @param[in] binding	The binding point
+	 * @param[in] buffer	The buffer
+	 * @param[in] offset	The start of the range in bytes. Must be a multiple of 4
+	 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::atomicCounter(GLuint binding, SSBO& buffer, GLintptr offset, GLsizeiptr size) {
+		return this->set({ATOMIC_COUNTER, binding, &buffer, nullptr, offset, size, GL_READ_WRITE, 0});
+	}
+
+	/** @brief Bind a texture to an image unit for imageLoad/imageStore
+	 * @param[in] unit		The image unit
+	 * @param[in] texture	The texture. It must have been created with an internal format (render target constructor)
+	 * @param[in] access	GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+	 * @param[in] level		The mipmap level
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::image(GLuint unit, Texture& texture, GLenum access, GLint level) {
+		return this->set({IMAGE, unit, nullptr, &texture, 0, 0, access, level});
+	}
+
+	/** @brief Bind a texture to a texture unit for sampling
+	 * @param[in] unit		The texture unit
+	 * @param[in] texture	The texture
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::sampler(GLuint unit, Texture& texture) {
+		return this->set({SAMPLER, unit, nullptr, &texture, 0, 0, GL_READ_ONLY, 0});
+	}
+
+	/** @brief Remove the resource of a kind at a binding point
+	 * @param[in] kind		The kind of binding
+	 * @param[in] binding	The binding point or unit
+	 * @return				A reference to this table
+ 	*/
+	BindingTable& BindingTable::remove(Kind kind, GLuint binding) {
+		this->entries.erase(std::remove_if(this->entries.begin(), this->entries.end(), [kind, binding](Entry const& entry) {
+			return entry.kind == kind && entry.binding == binding;
+		}), this->entries.end());
+
+		return *this;
+	}
+
+	/** @brief Remove every entry
+	 * @return A reference to this table
+ 	*/
+	BindingTable& BindingTable::clear() {
+		this->entries.clear();
+
+		return *this;
+	}
+
+	/** @brief Bind every entry, after issuing the barriers earlier shader writes to them need
+	 * @return A reference to this table
+ 	*/
+	BindingTable& BindingTable::bind() {
+		bool multiBind = BindingTable::hasMultiBind();
+
+		for (Entry const& entry : this->entries) {
+			if (entry.buffer != nullptr) {
+				entry.buffer->sync(BindingTable::getBarrierBit(entry.kind));
+			} else {
+				entry.texture->sync(BindingTable::getBarrierBit(entry.kind));
+			}
+		}
+
+		// Entries are sorted by kind then binding, so each run of consecutive bindings is contiguous
+		size_t start = 0;
+		while (start < this->entries.size()) {
+			Entry const& first = this->entries[start];
+			bool imageRun = first.kind == IMAGE;
+
+			size_t end = start + 1;
+			while (end < this->entries.size()) {
+				Entry const& entry = this->entries[end];
+				if (entry.kind != first.kind || entry.binding != first.binding + (end - start)) {
+					break;
+				}
+
+				// glBindImageTextures always binds level 0 with read/write access and the texture's own format
+				if (imageRun && (entry.access != GL_READ_WRITE || entry.level != 0)) {
+					break;
+				}
+
+				end++;
+			}
+
+			if (imageRun && (first.access != GL_READ_WRITE || first.level != 0)) {
+				end = start + 1;
+			}
+
+			GLsizei count = end - start;
+
+			this->names.clear();
+			this->offsets.clear();
+			this->sizes.clear();
+			for (size_t i = start; i < end; i++) {
+				Entry const& entry = this->entries[i];
+
+				if (entry.buffer != nullptr) {
+					this->names.push_back(entry.buffer->getBuffer());
+					this->offsets.push_back(entry.buffer->getRegionOffset() + entry.offset);
+					this->sizes.push_back(entry.size > 0 ? entry.size : static_cast<GLsizeiptr>(entry.buffer->getSize()) - entry.offset);
+				} else {
+					this->names.push_back(entry.texture->getTexture());
+				}
+			}
+
+			switch (first.kind) {
+				case STORAGE_BUFFER:
+				case UNIFORM_BUFFER:
+				case ATOMIC_COUNTER:
+					if (multiBind) {
+						glBindBuffersRange(BindingTable::getTarget(first.kind), first.binding, count, this->names.data(), this->offsets.data(), this->sizes.data());
+					} else {
+						for (GLsizei i = 0; i < count; i++) {
+							glBindBufferRange(BindingTable::getTarget(first.kind), first.binding + i, this->names[i], this->offsets[i], this->sizes[i]);
+						}
+					}
+					break;
+
+				case IMAGE:
+					if (multiBind && first.access == GL_READ_WRITE && first.level == 0) {
+						glBindImageTextures(first.binding, count, this->names.data());
+					} else {
+						for (GLsizei i = 0; i < count; i++) {
+							Entry const& entry = this->entries[start + i];
+							glBindImageTexture(first.binding + i, this->names[i], entry.level, GL_FALSE, 0, entry.access, entry.texture->getInternalFormat());
+						}
+					}
+					break;
+
+				case SAMPLER:
+					if (multiBind) {
+						glBindTextures(first.binding, count, this->names.data());
+					} else {
+						for (GLsizei i = 0; i < count; i++) {
+							glActiveTexture(GL_TEXTURE0 + first.binding + i);
+							glBindTexture(GL_TEXTURE_2D, this->names[i]);
+						}
+						glActiveTexture(GL_TEXTURE0);
+					}
+					break;
+			}
+
+			start = end;
+		}
+
+		return *this;
+	}
+
+	/** @brief Record that a dispatch or draw wrote every writable buffer and image in the table
+	 * @return A reference to this table
+ 	*/
+	BindingTable& BindingTable::markWritten() {
+		for (Entry const& entry : this->entries) {
+			if (entry.kind == SAMPLER || entry.kind == UNIFORM_BUFFER || entry.access == GL_READ_ONLY) {
+				continue;
+			}
+
+			if (entry.buffer != nullptr) {
+				entry.buffer->markWritten();
+			} else {
+				entry.texture->markWritten();
+			}
+		}
+
+		return *this;
+	}
+
+	/** @brief Find the entry of a kind at a binding point
+	 * @param[in] kind		The kind of binding
+	 * @param[in] binding	The binding point or unit
+	 * @return				A pointer to the entry, or nullptr if there is none
+ 	*/
+	BindingTable::Entry const* BindingTable::find(Kind kind, GLuint binding) const {
+		for (Entry const& entry : this->entries) {
+			if (entry.kind == kind && entry.binding == binding) {
+				return &entry;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/** @brief Get every entry, sorted by kind and binding
+	 * @return The entries
+ 	*/
+	std::vector<BindingTable::Entry> const& BindingTable::getEntries() const {
+		return this->entries;
+	}
+
+	/** @brief Check if multi-bind (GL 4.4 or ARB_multi_bind) is available
+	 * @return True if consecutive bindings are bound with one call
+ 	*/
+	bool BindingTable::hasMultiBind() {
+		return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_multi_bind;
+	}
+
+	/** @brief Add an entry, replacing any entry of the same kind and binding
+	 * @param[in] entry	The entry
+	 * @return			A reference to this table
+ 	*/
+	BindingTable& BindingTable::set(Entry const& entry) {
+		auto position = std::lower_bound(this->entries.begin(), this->entries.end(), entry, [](Entry const& a, Entry const& b) {
+			return a.kind != b.kind ? a.kind < b.kind : a.binding < b.binding;
+		});
+
+		if (position != this->entries.end() && position->kind == entry.kind && position->binding == entry.binding) {
+			*position = entry;
+		} else {
+			this->entries.insert(position, entry);
+		}
+
+		return *this;
+	}
+
+	/** @brief Get the buffer target of a buffer kind
+	 * @param[in] kind	The kind
+	 * @return			The GL buffer target
+ 	*/
+	GLenum BindingTable::getTarget(Kind kind) {
+		switch (kind) {
+			case UNIFORM_BUFFER:
+				return GL_UNIFORM_BUFFER;
+			case ATOMIC_COUNTER:
+				return GL_ATOMIC_COUNTER_BUFFER;
+			default:
+				return GL_SHADER_STORAGE_BUFFER;
+		}
+	}
+
+	/** @brief Get the barrier bit a kind of binding reads through
+	 * @param[in] kind	The kind
+	 * @return			The glMemoryBarrier bit
+ 	*/
+	GLbitfield BindingTable::getBarrierBit(Kind kind) {
+		switch (kind) {
+			case STORAGE_BUFFER:
+				return GL_SHADER_STORAGE_BARRIER_BIT;
+			case UNIFORM_BUFFER:
+				return GL_UNIFORM_BARRIER_BIT;
+			case ATOMIC_COUNTER:
+				return GL_ATOMIC_COUNTER_BARRIER_BIT;
+			case IMAGE:
+				return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+			default:
+				return GL_TEXTURE_FETCH_BARRIER_BIT;
+		}
+	}
+}
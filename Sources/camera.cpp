@@ -176,6 +176,12 @@ namespace oglopp {
 		// Update the view matrix
 		this->face(-this->getBack());
 
+		// Keep the projection parameters around for anything that needs to rebuild the frustum (clustered lighting)
+		this->_near = HLGL_RENDER_NEAR;
+		this->_far = farPlane;
+		this->_aspect = static_cast<double>(width) / static_cast<double>(height);
+		this->_projectionType = projectionType;
+
 		// Update the projection matrix
 		if (projectionType == Projection::PERSPECTIVE) {
 			this->_projection = glm::perspective<double>(glm::radians(this->getFov()), static_cast<double>(width) / static_cast<double>(height), HLGL_RENDER_NEAR, farPlane);
@@ -190,4 +196,32 @@ namespace oglopp {
 
 		return *this;
 	}
+
+	/** @brief Get the near plane used by the last updateProjectionView()
+	 * @return The near plane distance
+ 	*/
+	double Camera::getNear() const {
+		return this->_near;
+	}
+
+	/** @brief Get the far plane used by the last updateProjectionView()
+	 * @return The far plane distance
+ 	*/
+	double Camera::getFar() const {
+		return this->_far;
+	}
+
+	/** @brief Get the aspect ratio (width / height) used by the last updateProjectionView()
+	 * @return The aspect ratio
+ 	*/
+	double Camera::getAspect() const {
+		return this->_aspect;
+	}
+
+	/** @brief Get the projection type used by the last updateProjectionView()
+	 * @return PERSPECTIVE or ORTHO
+ 	*/
+	Camera::Projection Camera::getProjectionType() const {
+		return this->_projectionType;
+	}
 }
@@ -0,0 +1,251 @@
+#include "oglopp/clustered.h"
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace oglopp {
+	/** @brief Create the light and cluster buffers and compile the binning compute shader
+	 * @param[in] maxLights				The maximum number of lights that can be uploaded
+	 * @param[in] grid					The number of clusters in x, y (screen tiles) and z (depth slices)
+	 * @param[in] maxLightsPerCluster	The maximum number of lights stored per cluster. Extra lights are dropped
+	 * @param[in] firstBinding			The first of three consecutive SSBO binding points used by the lights and clusters
+ 	*/
+	ClusteredLights::ClusteredLights(uint32_t maxLights, glm::uvec3 grid, uint32_t maxLightsPerCluster, GLuint firstBinding) :
+		maxLights(maxLights), grid(grid), maxPerCluster(maxLightsPerCluster), binding(firstBinding), lightCount(0),
+		binner(ClusteredLights::getBinningSource(firstBinding, maxLightsPerCluster).c_str(), ShaderType::RAW) {
+
+		uint32_t clusterCount = grid.x * grid.y * grid.z;
+
+		// Allocate the buffers. SSBO::load needs a source pointer, so upload zeros
+		std::vector<Light> emptyLights(maxLights, Light{});
+		this->lights.load(emptyLights.data(), sizeof(Light) * maxLights);
+
+		std::vector<uint32_t> zeros(static_cast<size_t>(clusterCount) * maxLightsPerCluster, 0);
+		this->clusterCounts.load(zeros.data(), sizeof(uint32_t) * clusterCount);
+		this->clusterIndices.load(zeros.data(), sizeof(uint32_t) * zeros.size());
+
+		this->bindings.storage(firstBinding, this->lights).storage(firstBinding + 1, this->clusterCounts).storage(firstBinding + 2, this->clusterIndices);
+		this->binner.setBindings(&this->bindings);
+	}
+
+	/** @brief Upload the lights
+	 * @param[in] lights	A pointer to the lights
+	 * @param[in] count		The number of lights
+	 * @return				A status code. 0 for success. -1 if lights is nullptr. -2 if count is larger than maxLights
+ 	*/
+	int8_t ClusteredLights::setLights(Light const* lights, uint32_t count) {
+		if (lights == nullptr) {
+			return -1;
+		}
+
+		if (count > this->maxLights) {
+			return -2;
+		}
+
+		this->lightCount = count;
+
+		if (count == 0) {
+			return 0;
+		}
+
+		return this->lights.update(0, const_cast<Light*>(lights), sizeof(Light) * count);
+	}
+
+	/** @brief Bin the lights into clusters using the window camera. Call after updateProjectionView() and setLights()
+	 * @param[in] window	The window whose camera is used
+	 * @return				A reference to this object
+ 	*/
+	ClusteredLights& ClusteredLights::update(Window& window) {
+		Camera& cam = window.getCam();
+		uint32_t clusterCount = this->grid.x * this->grid.y * this->grid.z;
+
+		this->binner.use();
+		this->binner.setUIVec3("clusterGrid", this->grid);
+		this->binner.setVec2("clusterNearFar", glm::vec2(cam.getNear(), cam.getFar()));
+		this->binner.setMat4("clusterInverseProjection", glm::mat4(glm::inverse(cam.getProjection())));
+		this->binner.setMat4("clusterView", glm::mat4(cam.getView()));
+		this->binner.setUInt("clusterLightTotal", this->lightCount);
+
+		// One invocation per cluster
+		this->binner.dispatch(static_cast<Compute::group_t>((clusterCount + GROUP_SIZE - 1) / GROUP_SIZE));
+
+		return *this;
+	}
+
+	/** @brief Bind the light and cluster buffers and set the cluster uniforms on a shader which uses getInclude()
+	 * @param[in] shader	The shader to prepare
+	 * @param[in] window	The window being drawn to. Used for the screen size and camera planes
+	 * @return				A reference to this object
+ 	*/
+	ClusteredLights& ClusteredLights::apply(Shader& shader, Window& window) {
+		Camera& cam = window.getCam();
+
+		int width, height;
+		window.getSize(&width, &height);
+
+		shader.use();
+		shader.setUIVec3("clusterGrid", this->grid);
+		shader.setVec2("clusterNearFar", glm::vec2(cam.getNear(), cam.getFar()));
+		shader.setVec2("clusterScreenSize", glm::vec2(width, height));
+
+		this->bindBuffers();
+
+		return *this;
+	}
+
+	/** @brief Get the GLSL to include in fragment shaders (after a #version 430 line or newer).
+	 * 	Provides clusterIndex(gl_FragCoord, viewDepth), clusterLightCount(cluster), clusterLight(cluster, i) and clusterPointLight(...)
+	 * @return The GLSL source
+ 	*/
+	std::string ClusteredLights::getInclude() const {
+		return ClusteredLights::getBufferSource(this->binding, this->maxPerCluster) +
+		"uniform uvec3 clusterGrid;\n"\
+		"uniform vec2 clusterNearFar;\n"\
+		"uniform vec2 clusterScreenSize;\n"\
+
+		// viewDepth is the positive distance along the view direction, -(view * model * pos).z
+		"uint clusterIndex(vec4 fragCoord, float viewDepth) {\n"\
+			"uvec2 tile = min(uvec2(fragCoord.xy / clusterScreenSize * vec2(clusterGrid.xy)), clusterGrid.xy - 1u);\n"\
+			"float slice = log(max(viewDepth, clusterNearFar.x) / clusterNearFar.x) / log(clusterNearFar.y / clusterNearFar.x);\n"\
+			"uint z = min(uint(slice * float(clusterGrid.z)), clusterGrid.z - 1u);\n"\
+			"return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * z);\n"\
+		"}\n"\
+
+		"uint clusterLightCount(uint cluster) {\n"\
+			"return min(clusterCounts[cluster], CLUSTER_MAX_LIGHTS);\n"\
+		"}\n"\
+
+		"ClusterLight clusterLight(uint cluster, uint i) {\n"\
+			"return clusterLights[clusterIndices[cluster * CLUSTER_MAX_LIGHTS + i]];\n"\
+		"}\n" +
+
+		ClusteredLights::POINT_LIGHT_FUNCTION;
+	}
+
+	/** @brief Get the SSBO holding the lights
+	 * @return A reference to the light SSBO
+ 	*/
+	SSBO& ClusteredLights::getLightSSBO() {
+		return this->lights;
+	}
+
+	/** @brief Get the number of uploaded lights
+	 * @return The light count
+ 	*/
+	uint32_t ClusteredLights::getLightCount() const {
+		return this->lightCount;
+	}
+
+	/** @brief Get the cluster grid dimensions
+	 * @return The number of clusters in x, y and z
+ 	*/
+	glm::uvec3 const& ClusteredLights::getGrid() const {
+		return this->grid;
+	}
+
+	/** @brief Get the binning compute shader source
+	 * @param[in] binding			The first SSBO binding point
+	 * @param[in] maxPerCluster		The maximum lights per cluster
+	 * @return						The GLSL source
+ 	*/
+	std::string ClusteredLights::getBinningSource(GLuint binding, uint32_t maxPerCluster) {
+		return "#version 430 core\n"\
+		"layout(local_size_x = " + std::to_string(GROUP_SIZE) + ") in;\n" +
+		ClusteredLights::getBufferSource(binding, maxPerCluster) +
+		"uniform uvec3 clusterGrid;\n"\
+		"uniform vec2 clusterNearFar;\n"\
+		"uniform mat4 clusterInverseProjection;\n"\
+		"uniform mat4 clusterView;\n"\
+		"uniform uint clusterLightTotal;\n"\
+
+		"shared vec4 sharedLights[" + std::to_string(GROUP_SIZE) + "];\n"\
+
+		// Unproject an NDC point to view space
+		"vec3 toView(vec3 ndc) {\n"\
+			"vec4 v = clusterInverseProjection * vec4(ndc, 1.0);\n"\
+			"return v.xyz / v.w;\n"\
+		"}\n"\
+
+		// Point on the line through the near and far plane points at a view depth. Works for perspective and ortho
+		"vec3 atDepth(vec3 nearPoint, vec3 farPoint, float depth) {\n"\
+			"float t = (depth + nearPoint.z) / (nearPoint.z - farPoint.z);\n"\
+			"return mix(nearPoint, farPoint, t);\n"\
+		"}\n"\
+
+		"void main() {\n"\
+			"uint cluster = gl_GlobalInvocationID.x;\n"\
+			"uint total = clusterGrid.x * clusterGrid.y * clusterGrid.z;\n"\
+			"bool valid = cluster < total;\n"\
+
+			// Cluster bounds in view space
+			"vec3 boxMin = vec3(0.0);\n"\
+			"vec3 boxMax = vec3(0.0);\n"\
+			"if (valid) {\n"\
+				"uvec3 id = uvec3(cluster % clusterGrid.x, (cluster / clusterGrid.x) % clusterGrid.y, cluster / (clusterGrid.x * clusterGrid.y));\n"\
+				"vec2 ndcMin = vec2(id.xy) / vec2(clusterGrid.xy) * 2.0 - 1.0;\n"\
+				"vec2 ndcMax = vec2(id.xy + 1u) / vec2(clusterGrid.xy) * 2.0 - 1.0;\n"\
+				"float ratio = clusterNearFar.y / clusterNearFar.x;\n"\
+				"float depthNear = clusterNearFar.x * pow(ratio, float(id.z) / float(clusterGrid.z));\n"\
+				"float depthFar = clusterNearFar.x * pow(ratio, float(id.z + 1u) / float(clusterGrid.z));\n"\
+				"boxMin = vec3(1e30);\n"\
+				"boxMax = vec3(-1e30);\n"\
+				"for (int c = 0; c < 4; c++) {\n"\
+					"vec2 ndc = vec2((c & 1) == 0 ? ndcMin.x : ndcMax.x, (c & 2) == 0 ? ndcMin.y : ndcMax.y);\n"\
+					"vec3 nearPoint = toView(vec3(ndc, -1.0));\n"\
+					"vec3 farPoint = toView(vec3(ndc, 1.0));\n"\
+					"vec3 a = atDepth(nearPoint, farPoint, depthNear);\n"\
+					"vec3 b = atDepth(nearPoint, farPoint, depthFar);\n"\
+					"boxMin = min(boxMin, min(a, b));\n"\
+					"boxMax = max(boxMax, max(a, b));\n"\
+				"}\n"\
+			"}\n"\
+
+			// Test the lights in batches loaded into shared memory by the whole group
+			"uint count = 0u;\n"\
+			"uint base = cluster * CLUSTER_MAX_LIGHTS;\n"\
+			"for (uint batch = 0u; batch < clusterLightTotal; batch += gl_WorkGroupSize.x) {\n"\
+				"uint load = batch + gl_LocalInvocationID.x;\n"\
+				"if (load < clusterLightTotal) {\n"\
+					"vec4 light = clusterLights[load].position;\n"\
+					"sharedLights[gl_LocalInvocationID.x] = vec4((clusterView * vec4(light.xyz, 1.0)).xyz, light.w);\n"\
+				"}\n"\
+				"barrier();\n"\
+
+				"uint batchSize = min(gl_WorkGroupSize.x, clusterLightTotal - batch);\n"\
+				"for (uint i = 0u; valid && i < batchSize && count < CLUSTER_MAX_LIGHTS; i++) {\n"\
+					"vec4 light = sharedLights[i];\n"\
+					"vec3 closest = clamp(light.xyz, boxMin, boxMax);\n"\
+					"vec3 d = closest - light.xyz;\n"\
+					"if (dot(d, d) <= light.w * light.w) {\n"\
+						"clusterIndices[base + count] = batch + i;\n"\
+						"count++;\n"\
+					"}\n"\
+				"}\n"\
+				"barrier();\n"\
+			"}\n"\
+
+			"if (valid) {\n"\
+				"clusterCounts[cluster] = count;\n"\
+			"}\n"\
+		"}\n";
+	}
+
+	/** @brief Get the buffer declarations shared by the compute and fragment shaders
+	 * @param[in] binding			The first SSBO binding point
+	 * @param[in] maxPerCluster		The maximum lights per cluster
+	 * @return						The GLSL source
+ 	*/
+	std::string ClusteredLights::getBufferSource(GLuint binding, uint32_t maxPerCluster) {
+		return std::string("#define CLUSTER_MAX_LIGHTS ") + std::to_string(maxPerCluster) + "u\n" +
+		ClusteredLights::LIGHT_STRUCT +
+		"layout(std430, binding = " + std::to_string(binding) + ") buffer ClusterLightBuffer { ClusterLight clusterLights[]; };\n"\
+		"layout(std430, binding = " + std::to_string(binding + 1) + ") buffer ClusterCountBuffer { uint clusterCounts[]; };\n"\
+		"layout(std430, binding = " + std::to_string(binding + 2) + ") buffer ClusterIndexBuffer { uint clusterIndices[]; };\n";
+	}
+
+	/** @brief Bind the three buffers to their binding points
+ 	*/
+	void ClusteredLights::bindBuffers() {
+		this->bindings.bind();
+	}
+}
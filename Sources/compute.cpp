@@ -1,7 +1,9 @@
 #include "oglopp/compute.h"
 #include "oglopp/glad/gl.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 
 namespace oglopp {
 	/** @brief Compute default constructor
@@ -30,6 +32,97 @@ namespace oglopp {
 		return this->ssbo;
 	}
 
+	/** @brief Bind a texture to an image unit for imageLoad/imageStore. Every dispatch waits for earlier writes to it and,
+	 *  unless read-only, marks it written, until another texture is bound to the unit or unbindImage() is called.
+	 *  It must stay alive until then
+	 * @param[in] unit		The image unit, matching layout(binding = unit) on the image2D
+	 * @param[in] texture	The texture. It must have been created with an internal format (render target constructor)
+	 * @param[in] access	GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+	 * @param[in] level		The mipmap level
+	 * @return				A reference to this compute object
+ 	*/
+	Compute& Compute::bindImage(GLuint unit, Texture& texture, GLenum access, GLint level) {
+		glBindImageTexture(unit, texture.getTexture(), level, GL_FALSE, 0, access, texture.getInternalFormat());
+
+		// Tracked whatever the access, so every dispatch waits for earlier writes before using it
+		this->boundImages[unit] = {&texture, access};
+
+		return *this;
+	}
+
+	/** @brief Bind a texture to a texture unit for sampling with texture()/texelFetch()
+	 * @param[in] unit		The texture unit, matching layout(binding = unit) on the sampler2D
+	 * @param[in] texture	The texture
+	 * @return				A reference to this compute object
+ 	*/
+	Compute& Compute::bindSampler(GLuint unit, Texture& texture) {
+		texture.bind(GL_TEXTURE0 + unit);
+		glActiveTexture(GL_TEXTURE0);
+
+		return *this;
+	}
+
+	/** @brief Bind another SSBO at its own binding point, in addition to the one set with setSSBO(). Every dispatch waits for
+	 *  earlier writes to it and, unless read-only, marks it written, until another SSBO is bound to the point or
+	 *  unbindSSBO() is called. It must stay alive until then
+	 * @param[in] binding	The binding point
+	 * @param[in] buffer	The SSBO
+	 * @param[in] access	GL_READ_ONLY if the shader never writes the block, so later uses need not wait for it
+	 * @return				A reference to this compute object
+ 	*/
+	Compute& Compute::bindSSBO(GLuint binding, SSBO& buffer, GLenum access) {
+		buffer.bind(binding);
+
+		// Tracked whatever the access, so every dispatch waits for earlier writes before using it
+		this->boundBuffers[binding] = {&buffer, access};
+
+		return *this;
+	}
+
+	/** @brief Unbind an image unit bound with bindImage(), so dispatches stop tracking its texture
+	 * @param[in] unit		The image unit
+	 * @return				A reference to this compute object
+ 	*/
+	Compute& Compute::unbindImage(GLuint unit) {
+		glBindImageTexture(unit, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA8);
+		this->boundImages.erase(unit);
+
+		return *this;
+	}
+
+	/** @brief Unbind a binding point bound with bindSSBO(), so dispatches stop tracking its SSBO
+	 * @param[in] binding	The binding point
+	 * @return				A reference to this compute object
+ 	*/
+	Compute& Compute::unbindSSBO(GLuint binding) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+		this->boundBuffers.erase(binding);
+
+		return *this;
+	}
+
+	/** @brief Set the binding table bound before every dispatch, and check that it covers every buffer block,
+	 *  atomic counter buffer, image and sampler the program uses. The table is used even if the check fails
+	 * @param[in] table		The binding table, or nullptr to stop using one. It must outlive its use by this object
+	 * @return				A status code. 0 for success. -1 if the program uses a binding the table lacks or a range is too small
+ 	*/
+	int8_t Compute::setBindings(BindingTable* table) {
+		this->bindings = table;
+
+		if (table == nullptr) {
+			return 0;
+		}
+
+		return this->validateBindings(*table);
+	}
+
+	/** @brief Get the binding table set with setBindings()
+	 * @return A pointer to the table, or nullptr
+ 	*/
+	BindingTable* Compute::getBindings() {
+		return this->bindings;
+	}
+
 	/** @brief Dispatch some groups with the loaded compute shader
 	 * @param[in] xGroups	The number of groups in the x dimension (not optional)
 	 * @param[in] yGroups	The number of groups in the y dimension (optional - default is 1)
@@ -42,16 +135,14 @@ namespace oglopp {
 		}
 
 		// Use this shader program
-		if (this->ssbo != nullptr) {
-			this->ssbo->bind(this->binding);
-		}
+		this->prepareResources();
 		this->use();
 
 		// Dispatch
 		glDispatchCompute(xGroups, yGroups, zGroups);
 
-		// Ensure all shader writes are visible
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		// Later uses of what was written wait for it, rather than every dispatch waiting here
+		this->markResourcesWritten();
 
 		// Unbind
 		SSBO::unbind();
@@ -63,25 +154,99 @@ namespace oglopp {
 		return this->dispatch(groups.x, groups.y, groups.z);
 	}
 
-	/** @brief Dispatch a buffer object specifying number of groups with the loaded compute shader
-	 * @param[in] pBufferObject	A GLintptr pointing to some buffer object
-	 * @return					A status code. 0 for success. -1 for failure.
+	/** @brief Dispatch enough groups to cover every pixel of an image, using the shader's local size
+	 * @param[in] width		The image width in pixels
+	 * @param[in] height	The image height in pixels
+	 * @return				A status code. 0 for success. -1 for failure.
  	*/
-	int8_t Compute::dispatch(GLintptr pBufferObject) {
-		if (this->ssbo != nullptr) {
-			//return -1;
-			// Use this shader program
-			this->ssbo->bind();
+	int8_t Compute::dispatchImage(int width, int height) {
+		return this->dispatch((width + this->localSize.x - 1) / this->localSize.x, (height + this->localSize.y - 1) / this->localSize.y);
+	}
+
+	/** @brief Run one invocation per element, for shaders using ELEMENT_INDEX_FUNCTION. Counts needing more groups than
+	 *  the device allows are split into several dispatches, each given its first element through elementOffset
+	 * @param[in] count		The number of elements
+	 * @return				A status code. 0 for success. -1 for failure.
+ 	*/
+	int8_t Compute::dispatchElements(uint32_t count) {
+		if (count == 0) {
+			return 0;
+		}
+
+		uint64_t groupInvocations = static_cast<uint64_t>(this->localSize.x) * this->localSize.y * this->localSize.z;
+		uint64_t groups = (count + groupInvocations - 1) / groupInvocations;
+		uint64_t maxGroups = Compute::getLimits().maxGroupCount.x;
+
+		this->prepareResources();
+		this->use();
+
+		if (this->elementCountLocation >= 0) {
+			glUniform1ui(this->elementCountLocation, count);
 		}
 
+		// The pieces touch different elements, so they need no barrier between them
+		for (uint64_t firstGroup = 0; firstGroup < groups; firstGroup += maxGroups) {
+			if (this->elementOffsetLocation >= 0) {
+				glUniform1ui(this->elementOffsetLocation, static_cast<GLuint>(firstGroup * groupInvocations));
+			} else if (firstGroup > 0) {
+				std::cout << "[Oglopp] Compute dispatch of " << count << " elements needs splitting, but the shader has no elementOffset uniform" << std::endl;
+				break;
+			}
 
+			glDispatchCompute(static_cast<GLuint>(std::min(groups - firstGroup, maxGroups)), 1, 1);
+		}
+
+		this->markResourcesWritten();
+
+		// Unbind
+		SSBO::unbind();
+
+		return 0;
+	}
+
+	/** @brief Dispatch the group counts stored in an indirect buffer, eg. written by an earlier dispatch
+	 * @param[in] commands	The buffer of dispatch commands
+	 * @param[in] index		The command to dispatch
+	 * @return				A status code. 0 for success. -1 if the index is out of range
+ 	*/
+	int8_t Compute::dispatchIndirect(DispatchIndirectBuffer& commands, uint32_t index) {
+		if (index >= commands.getCapacity()) {
+			std::cout << "[Oglopp] Indirect dispatch command " << index << " is out of range" << std::endl;
+			return -1;
+		}
+
+		this->prepareResources();
 		this->use();
 
+		// Waits for the shader which wrote the group counts, if any
+		commands.bindIndirect(GL_DISPATCH_INDIRECT_BUFFER);
+		glDispatchComputeIndirect(commands.getOffset(index));
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+		this->markResourcesWritten();
+
+		// Unbind
+		SSBO::unbind();
+
+		return 0;
+	}
+
+	/** @brief Dispatch the group counts at some offset of the bound GL_DISPATCH_INDIRECT_BUFFER.
+	 *  The caller binds the buffer. Prefer dispatchIndirect(), which binds it and waits for writes to it
+	 * @param[in] pBufferObject	The offset in bytes of the command in the bound indirect buffer
+	 * @return					A status code. 0 for success. -1 for failure.
+ 	*/
+	int8_t Compute::dispatch(GLintptr pBufferObject) {
+		this->prepareResources();
+		this->use();
+
+		// The bound indirect buffer is not tracked, so wait for any earlier shader write
+		Hazards::requireAll(GL_COMMAND_BARRIER_BIT);
+
 		// Dispatch
 		glDispatchComputeIndirect(pBufferObject);
 
-		// Ensure all shader writes are visible
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		this->markResourcesWritten();
 
 		// Unbind
 		SSBO::unbind();
@@ -89,6 +254,53 @@ namespace oglopp {
 		return 0;
 	}
 
+	/** @brief Bind the SSBO and binding table, and issue the barriers everything the dispatch uses needs
+ 	*/
+	void Compute::prepareResources() {
+		if (this->bindings != nullptr) {
+			this->bindings->bind();
+		}
+
+		if (this->ssbo != nullptr) {
+			this->ssbo->sync(GL_SHADER_STORAGE_BARRIER_BIT);
+			this->ssbo->bind(this->binding);
+		}
+
+		// Read-only bindings wait too, and writes after earlier writes need ordering. sync() is free once nothing is pending
+		for (auto const& [unit, image] : this->boundImages) {
+			image.texture->sync(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+
+		for (auto const& [binding, bound] : this->boundBuffers) {
+			bound.buffer->sync(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+	}
+
+	/** @brief Mark everything the dispatch may have written
+ 	*/
+	void Compute::markResourcesWritten() {
+		if (this->bindings != nullptr) {
+			this->bindings->markWritten();
+		}
+
+		if (this->ssbo != nullptr) {
+			this->ssbo->markWritten();
+		}
+
+		// Still bound, so kept for the next dispatch too
+		for (auto const& [unit, image] : this->boundImages) {
+			if (image.access != GL_READ_ONLY) {
+				image.texture->markWritten();
+			}
+		}
+
+		for (auto const& [binding, bound] : this->boundBuffers) {
+			if (bound.access != GL_READ_ONLY) {
+				bound.buffer->markWritten();
+			}
+		}
+	}
+
 	/** @brief Get a constant reference to the SSBO binding
 	 * @return The SSBO binding int
  	*/
@@ -107,13 +319,9 @@ namespace oglopp {
 			return false;
 		}
 
-		GLint maxGroupsX, maxGroupsY, maxGroupsZ;
-		maxGroupsX = maxGroupsY = maxGroupsZ = 16;
-		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &maxGroupsX);
-		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 1, &maxGroupsY);
-		glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 2, &maxGroupsZ);
+		glm::ivec3 const& maxGroups = Compute::getLimits().maxGroupCount;
 
-		return !(xCount > maxGroupsX || yCount > maxGroupsY || zCount > maxGroupsZ);
+		return !(xCount > maxGroups.x || yCount > maxGroups.y || zCount > maxGroups.z);
 	}
 
 	/** @brief Check if a group's size is valid.
@@ -121,7 +329,54 @@ namespace oglopp {
 	 * @return					True if valid, false otherwise
  	*/
 	const bool Compute::groupSizeIsValid(group_t groupSize) {
-		return true;
+		return groupSize >= 1 && groupSize <= Compute::getLimits().maxGroupInvocations;
+	}
+
+	/** @brief Check if a local size is valid in each dimension and in total
+	 * @param[in] localSize		The local size to check
+	 * @return					True if valid, false otherwise
+ 	*/
+	const bool Compute::groupSizeIsValid(glm::ivec3 localSize) {
+		Limits const& limits = Compute::getLimits();
+
+		for (int i = 0; i < 3; i++) {
+			if (localSize[i] < 1 || localSize[i] > limits.maxGroupSize[i]) {
+				return false;
+			}
+		}
+
+		return Compute::groupSizeIsValid(localSize.x * localSize.y * localSize.z);
+	}
+
+	/** @brief Get the device's compute limits. Queried on the first call only
+	 * @return	A constant reference to the limits
+ 	*/
+	Compute::Limits const& Compute::getLimits() {
+		static Limits limits;
+		static bool queried = false;
+
+		if (!queried) {
+			// The minimums the GL 4.3 specification guarantees, in case a query fails
+			limits = {glm::ivec3(65535), glm::ivec3(1024, 1024, 64), 1024, 32768};
+
+			for (GLuint i = 0; i < 3; i++) {
+				glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, i, &limits.maxGroupCount[i]);
+				glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, i, &limits.maxGroupSize[i]);
+			}
+			glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &limits.maxGroupInvocations);
+			glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &limits.maxSharedMemory);
+
+			queried = true;
+		}
+
+		return limits;
+	}
+
+	/** @brief Get the local size declared by the shader
+	 * @return	The local size
+ 	*/
+	glm::ivec3 Compute::getLocalSize() const {
+		return this->localSize;
 	}
 
 	/** @brief Load a list of shaders into this shader object
@@ -151,9 +406,140 @@ namespace oglopp {
 		if(!success) {
 			glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
 			std::cout << "[Oglopp] Compute shader linking failed!\n" << infoLog << std::endl;
+		} else {
+			// Reflect the local size and the uniforms dispatchElements() sets
+			glGetProgramiv(this->ID, GL_COMPUTE_WORK_GROUP_SIZE, &this->localSize[0]);
+			this->elementOffsetLocation = glGetUniformLocation(this->ID, "elementOffset");
+			this->elementCountLocation = glGetUniformLocation(this->ID, "elementCount");
+
+			if (!Compute::groupSizeIsValid(this->localSize)) {
+				std::cout << "[Oglopp] Compute shader local size [" << this->localSize.x << ", " << this->localSize.y << ", " << this->localSize.z << "] is larger than the device allows" << std::endl;
+			}
 		}
 
 		// Delete the shader now that it's been linked
 		glDeleteShader(computeIndex);
 	}
+
+	/** @brief Check a binding table against the resources reflected from the linked program
+	 * @param[in] table		The binding table
+	 * @return				A status code. 0 for success. -1 if anything the program uses is missing or too small
+ 	*/
+	int8_t Compute::validateBindings(BindingTable const& table) const {
+		int8_t status = 0;
+		char name[256];
+
+		// Buffer blocks and atomic counter buffers
+		struct BufferInterface {
+			GLenum interface;
+			BindingTable::Kind kind;
+			const char* description;
+		};
+
+		const BufferInterface buffers[] = {
+			{GL_SHADER_STORAGE_BLOCK, BindingTable::STORAGE_BUFFER, "storage block"},
+			{GL_UNIFORM_BLOCK, BindingTable::UNIFORM_BUFFER, "uniform block"},
+			{GL_ATOMIC_COUNTER_BUFFER, BindingTable::ATOMIC_COUNTER, "atomic counter buffer"}
+		};
+
+		for (BufferInterface const& buffer : buffers) {
+			GLint count = 0;
+			glGetProgramInterfaceiv(this->ID, buffer.interface, GL_ACTIVE_RESOURCES, &count);
+
+			for (GLint i = 0; i < count; i++) {
+				const GLenum properties[] = {GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+				GLint values[2] = {0, 0};
+				glGetProgramResourceiv(this->ID, buffer.interface, i, 2, properties, 2, nullptr, values);
+
+				// Atomic counter buffers have no name
+				std::string label = std::to_string(values[0]);
+				if (buffer.interface != GL_ATOMIC_COUNTER_BUFFER) {
+					glGetProgramResourceName(this->ID, buffer.interface, i, sizeof(name), nullptr, name);
+					label = std::string(name) + " (binding " + label + ")";
+				}
+
+				BindingTable::Entry const* entry = table.find(buffer.kind, values[0]);
+				if (entry == nullptr) {
+					std::cout << "[Oglopp] Binding table has nothing for " << buffer.description << " " << label << std::endl;
+					status = -1;
+					continue;
+				}
+
+				// For blocks ending in an unsized array this is the size of everything before the array
+				GLsizeiptr bound = entry->size > 0 ? entry->size : static_cast<GLsizeiptr>(entry->buffer->getSize()) - entry->offset;
+				if (bound < values[1]) {
+					std::cout << "[Oglopp] Binding table range for " << buffer.description << " " << label << " is " << bound << " bytes, the program needs " << values[1] << std::endl;
+					status = -1;
+				}
+			}
+		}
+
+		// Samplers and images, which are uniforms outside of any block
+		GLint count = 0;
+		glGetProgramInterfaceiv(this->ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+		for (GLint i = 0; i < count; i++) {
+			const GLenum properties[] = {GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX, GL_ARRAY_SIZE};
+			GLint values[4] = {0, -1, -1, 1};
+			glGetProgramResourceiv(this->ID, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+
+			BindingTable::Kind kind;
+			if (values[1] < 0 || values[2] != -1 || !Compute::getOpaqueKind(values[0], &kind)) {
+				continue;
+			}
+
+			glGetProgramResourceName(this->ID, GL_UNIFORM, i, sizeof(name), nullptr, name);
+
+			// Each array element has its own unit
+			for (GLint element = 0; element < values[3]; element++) {
+				GLint unit = 0;
+				glGetUniformiv(this->ID, values[1] + element, &unit);
+
+				if (table.find(kind, unit) == nullptr) {
+					std::cout << "[Oglopp] Binding table has no " << (kind == BindingTable::IMAGE ? "image" : "texture") << " at unit " << unit << " for " << name << std::endl;
+					status = -1;
+				}
+			}
+		}
+
+		return status;
+	}
+
+	/** @brief Get the binding kind of a uniform type
+	 * @param[in] type	The uniform type, eg. GL_SAMPLER_2D
+	 * @param[out] kind	The kind, SAMPLER or IMAGE
+	 * @return			True if the type is a sampler or image
+ 	*/
+	bool Compute::getOpaqueKind(GLenum type, BindingTable::Kind* kind) {
+		switch (type) {
+			case GL_SAMPLER_1D:
+			case GL_SAMPLER_2D:
+			case GL_SAMPLER_3D:
+			case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW:
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_BUFFER:
+			case GL_INT_SAMPLER_2D:
+			case GL_INT_SAMPLER_BUFFER:
+			case GL_UNSIGNED_INT_SAMPLER_2D:
+			case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+				*kind = BindingTable::SAMPLER;
+				return true;
+
+			case GL_IMAGE_1D:
+			case GL_IMAGE_2D:
+			case GL_IMAGE_3D:
+			case GL_IMAGE_CUBE:
+			case GL_IMAGE_2D_ARRAY:
+			case GL_IMAGE_BUFFER:
+			case GL_INT_IMAGE_2D:
+			case GL_INT_IMAGE_BUFFER:
+			case GL_UNSIGNED_INT_IMAGE_2D:
+			case GL_UNSIGNED_INT_IMAGE_BUFFER:
+				*kind = BindingTable::IMAGE;
+				return true;
+		}
+
+		return false;
+	}
 }
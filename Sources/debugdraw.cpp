@@ -0,0 +1,327 @@
+#include "oglopp/debugdraw.h"
+
+#ifndef OGLOPP_NO_DEBUG_DRAW
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+
+#include "oglopp/shader.h"
+#include "oglopp/typedssbo.h"
+
+namespace oglopp {
+	namespace debug {
+		static constexpr GLuint VERTEX_BINDING = 0;
+
+		// One line end. GLSL declares it as 4 scalars so it packs into 16 bytes like this
+		struct Vertex {
+			glm::vec3 position;
+			uint32_t color;
+		};
+	}
+
+	OGLOPP_STD430_STRUCT(debug::Vertex, 4);
+
+	namespace debug {
+
+		// Everything kept between calls. Allocated once and never destroyed, so nothing touches GL after the context is gone
+		struct State {
+			bool enabled = true;
+			std::vector<Vertex> lines;
+			std::vector<Vertex> overlay;
+
+			uint64_t frame = 0;
+			std::unique_ptr<Shader> shader;
+			std::unique_ptr<TypedSSBO<Vertex>> ring;
+			GLuint vao = 0;
+		};
+
+		static State& state() {
+			static State* instance = new State();
+			return *instance;
+		}
+
+		// The 12 edges of a cube between its 8 corners, corner bit 0 is +x, bit 1 +y and bit 2 +z
+		static constexpr uint8_t BOX_EDGES[24] = {0, 1, 2, 3, 4, 5, 6, 7, 0, 2, 1, 3, 4, 6, 5, 7, 0, 4, 1, 5, 2, 6, 3, 7};
+
+		/** @brief Add the edges of a cube from 8 corners
+		 * @param[in] corners	The corners, ordered by the bits of their index
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything
+	 	*/
+		static void cube(glm::vec3 const* corners, glm::vec4 const& color, bool overlay) {
+			for (int i = 0; i < 24; i += 2) {
+				line(corners[BOX_EDGES[i]], corners[BOX_EDGES[i + 1]], color, overlay);
+			}
+		}
+
+		/** @brief Draw a line
+		 * @param[in] from		One end
+		 * @param[in] to		The other end
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+	 	*/
+		void line(glm::vec3 const& from, glm::vec3 const& to, glm::vec4 const& color, bool overlay) {
+			State& debug = state();
+			if (!debug.enabled) {
+				return;
+			}
+
+			uint32_t packed = glm::packUnorm4x8(color);
+			std::vector<Vertex>& vertices = overlay ? debug.overlay : debug.lines;
+			vertices.push_back(Vertex{from, packed});
+			vertices.push_back(Vertex{to, packed});
+		}
+
+		/** @brief Draw the edges of an axis aligned box
+		 * @param[in] min		The lowest corner
+		 * @param[in] max		The highest corner
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+	 	*/
+		void box(glm::vec3 const& min, glm::vec3 const& max, glm::vec4 const& color, bool overlay) {
+			if (!state().enabled) {
+				return;
+			}
+
+			glm::vec3 corners[8];
+			for (int i = 0; i < 8; i++) {
+				corners[i] = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+			}
+
+			cube(corners, color, overlay);
+		}
+
+		/** @brief Draw the edges of a transformed box
+		 * @param[in] transform		The transform of a cube from -1 to 1 on each axis, eg. a model matrix
+		 * @param[in] color			The color
+		 * @param[in] overlay		True to draw over everything instead of testing depth
+	 	*/
+		void box(glm::mat4 const& transform, glm::vec4 const& color, bool overlay) {
+			if (!state().enabled) {
+				return;
+			}
+
+			glm::vec3 corners[8];
+			for (int i = 0; i < 8; i++) {
+				glm::vec4 corner = transform * glm::vec4(i & 1 ? 1.0 : -1.0, i & 2 ? 1.0 : -1.0, i & 4 ? 1.0 : -1.0, 1.0);
+				corners[i] = glm::vec3(corner) / corner.w;
+			}
+
+			cube(corners, color, overlay);
+		}
+
+		/** @brief Draw a sphere as three circles, one about each axis
+		 * @param[in] center	The center
+		 * @param[in] radius	The radius
+		 * @param[in] color		The color
+		 * @param[in] overlay	True to draw over everything instead of testing depth
+		 * @param[in] segments	The lines per circle
+	 	*/
+		void sphere(glm::vec3 const& center, float radius, glm::vec4 const& color, bool overlay, uint32_t segments) {
+			if (!state().enabled || segments < 3) {
+				return;
+			}
+
+			float step = 6.28318530718f / segments;
+			glm::vec2 last(radius, 0.0);
+
+			for (uint32_t i = 1; i <= segments; i++) {
+				glm::vec2 next = glm::vec2(std::cos(i * step), std::sin(i * step)) * radius;
+
+				line(center + glm::vec3(last.x, last.y, 0.0), center + glm::vec3(next.x, next.y, 0.0), color, overlay);
+				line(center + glm::vec3(last.x, 0.0, last.y), center + glm::vec3(next.x, 0.0, next.y), color, overlay);
+				line(center + glm::vec3(0.0, last.x, last.y), center + glm::vec3(0.0, next.x, next.y), color, overlay);
+
+				last = next;
+			}
+		}
+
+		/** @brief Draw the edges of the volume a view and projection see, eg. a shadow or culling camera
+		 * @param[in] viewProjection	The projection matrix times the view matrix
+		 * @param[in] color				The color
+		 * @param[in] overlay			True to draw over everything instead of testing depth
+	 	*/
+		void frustum(glm::mat4 const& viewProjection, glm::vec4 const& color, bool overlay) {
+			if (!state().enabled) {
+				return;
+			}
+
+			// The corners of clip space, taken back to world space
+			box(glm::inverse(viewProjection), color, overlay);
+		}
+
+		/** @brief Draw the axes of a transform, x red, y green and z blue
+		 * @param[in] transform		The transform, eg. a model matrix
+		 * @param[in] size			The length of each axis before the transform
+		 * @param[in] overlay		True to draw over everything instead of testing depth
+	 	*/
+		void axes(glm::mat4 const& transform, float size, bool overlay) {
+			if (!state().enabled) {
+				return;
+			}
+
+			glm::vec3 origin = glm::vec3(transform[3]);
+			for (int axis = 0; axis < 3; axis++) {
+				glm::vec4 end(0.0, 0.0, 0.0, 1.0);
+				end[axis] = size;
+
+				glm::vec4 color(0.0, 0.0, 0.0, 1.0);
+				color[axis] = 1.0;
+
+				line(origin, glm::vec3(transform * end), color, overlay);
+			}
+		}
+
+		/** @brief Draw everything added since the last flush with a window's camera, then forget it.
+		 * Call after the camera's projection and view are updated for the frame
+		 * @param[in] window	The window
+	 	*/
+		void flush(Window& window) {
+			flush(glm::mat4(window.getCam().getView()), glm::mat4(window.getCam().getProjection()));
+		}
+
+		/** @brief Draw everything added since the last flush with explicit matrices, then forget it
+		 * @param[in] view			The view matrix
+		 * @param[in] projection	The projection matrix
+	 	*/
+		void flush(glm::mat4 const& view, glm::mat4 const& projection) {
+			State& debug = state();
+
+			size_t depthTested = debug.lines.size();
+			size_t total = depthTested + debug.overlay.size();
+			if (!debug.enabled || total == 0) {
+				clear();
+				return;
+			}
+
+			if (debug.shader == nullptr) {
+				debug.shader = std::make_unique<Shader>(
+				"#version 450 core\n"\
+				"struct Vertex {\n"\
+					"float x;\n"\
+					"float y;\n"\
+					"float z;\n"\
+					"uint color;\n"\
+				"};\n"\
+				"layout (std430, binding = 0) readonly buffer DebugVertices { Vertex vertices[]; };\n"\
+				\
+				"uniform mat4 viewProjection;\n"\
+				"out vec4 color;\n"\
+				\
+				"void main() {\n"\
+					"Vertex vertex = vertices[gl_VertexID];\n"\
+					"gl_Position = viewProjection * vec4(vertex.x, vertex.y, vertex.z, 1.0);\n"\
+					"color = unpackUnorm4x8(vertex.color);\n"\
+				"}\n",
+				\
+				"#version 450 core\n"\
+				"in vec4 color;\n"\
+				"out vec4 FragColor;\n"\
+				"void main() {\n"\
+					"FragColor = color;\n"\
+				"}\n", ShaderType::RAW);
+
+				debug.ring = std::make_unique<TypedSSBO<Vertex>>();
+
+				// Core profiles need a vertex array bound to draw, even with no attributes
+				glGenVertexArrays(1, &debug.vao);
+			}
+
+			// The ring only grows, with room to spare so a few more lines don't make it grow every frame
+			if (debug.ring->size() < total) {
+				std::vector<Vertex> empty(total + total / 2, Vertex{});
+				if (debug.ring->assignPersistent(empty) != 0) {
+					debug.ring->assign(empty);
+				}
+			}
+
+			std::span<Vertex> region = debug.ring->writeSpan(debug.frame++);
+			if (!region.empty()) {
+				std::copy(debug.lines.begin(), debug.lines.end(), region.begin());
+				std::copy(debug.overlay.begin(), debug.overlay.end(), region.begin() + depthTested);
+			} else {
+				// Without persistent storage, through glBufferSubData
+				debug.ring->set(0, debug.lines);
+				debug.ring->set(depthTested, debug.overlay);
+			}
+
+			debug.shader->use();
+			debug.shader->setMat4("viewProjection", projection * view);
+			debug.ring->bind(VERTEX_BINDING);
+
+			GLboolean depthWas = glIsEnabled(GL_DEPTH_TEST);
+			glBindVertexArray(debug.vao);
+
+			if (depthTested > 0) {
+				glEnable(GL_DEPTH_TEST);
+				glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(depthTested));
+			}
+
+			if (total > depthTested) {
+				glDisable(GL_DEPTH_TEST);
+				glDrawArrays(GL_LINES, static_cast<GLint>(depthTested), static_cast<GLsizei>(total - depthTested));
+			}
+
+			glBindVertexArray(0);
+			if (depthWas) {
+				glEnable(GL_DEPTH_TEST);
+			} else {
+				glDisable(GL_DEPTH_TEST);
+			}
+
+			clear();
+		}
+
+		/** @brief Forget everything added since the last flush without drawing it
+	 	*/
+		void clear() {
+			// clear() keeps the capacity, so the next frame appends without allocating
+			state().lines.clear();
+			state().overlay.clear();
+		}
+
+		/** @brief Turn debug drawing on or off. Off, every call returns at once
+		 * @param[in] enabled	True to draw
+	 	*/
+		void setEnabled(bool enabled) {
+			state().enabled = enabled;
+
+			if (!enabled) {
+				clear();
+			}
+		}
+
+		/** @brief Check whether debug drawing is on
+		 * @return True if calls are drawn
+	 	*/
+		bool isEnabled() {
+			return state().enabled;
+		}
+
+		/** @brief Get the number of lines added since the last flush
+		 * @return The line count, depth tested and overlay
+	 	*/
+		size_t getLineCount() {
+			return (state().lines.size() + state().overlay.size()) / 2;
+		}
+
+		/** @brief Release the GL objects. The next flush() makes them again
+	 	*/
+		void shutdown() {
+			State& debug = state();
+
+			debug.shader.reset();
+			debug.ring.reset();
+
+			if (debug.vao != 0) {
+				glDeleteVertexArrays(1, &debug.vao);
+				debug.vao = 0;
+			}
+		}
+	}
+}
+
+#endif
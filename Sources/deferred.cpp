@@ -0,0 +1,261 @@
+#include "oglopp/deferred.h"
+#include "oglopp/clustered.h"
+
+#include <iostream>
+#include <glm/glm.hpp>
+
+namespace oglopp {
+	/** @brief Create the G-buffer and compile the lighting shader
+	 * @param[in] width		The width of the G-buffer
+	 * @param[in] height	The height of the G-buffer
+	 * @param[in] settings	The storage formats
+ 	*/
+	DeferredRenderer::DeferredRenderer(int width, int height, Settings const& settings) :
+		settings(settings), width(width), height(height),
+		gbuffer(width, height, FBO::Description{{{settings.albedoFormat, true, true}, {settings.normalFormat, true, true}}, true, {settings.depthFormat, true, true}, 0}),
+		output(width, height, FBO::Description{{{settings.lightFormat, true, false}}, false, {}, 0}),
+		lighting(DeferredRenderer::getLightingSource(settings).c_str(), ShaderType::RAW, settings.lightBinding) {
+
+		if (!this->gbuffer.isComplete()) {
+			std::cout << "[Oglopp] Deferred G-buffer is incomplete" << std::endl;
+		}
+	}
+
+	DeferredRenderer::DeferredRenderer(int width, int height) : DeferredRenderer(width, height, Settings()) {}
+
+	/** @brief Bind and clear the G-buffer. Draw opaque geometry with shaders which use getGBufferInclude()
+	 * @return A reference to this object
+ 	*/
+	DeferredRenderer& DeferredRenderer::beginGeometryPass() {
+		this->gbuffer.bind(true);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		return *this;
+	}
+
+	/** @brief Return to the default framebuffer
+	 * @return A reference to this object
+ 	*/
+	DeferredRenderer& DeferredRenderer::endGeometryPass() {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return *this;
+	}
+
+	/** @brief Accumulate the lights into the output texture
+	 * @param[in] window		The window whose camera was used for the geometry pass
+	 * @param[in] lights		An SSBO of ClusteredLights::Light
+	 * @param[in] lightCount	The number of lights in the SSBO
+	 * @return					A reference to this object
+ 	*/
+	DeferredRenderer& DeferredRenderer::lightingPass(Window& window, SSBO& lights, uint32_t lightCount) {
+		Camera& cam = window.getCam();
+
+		this->lighting.use();
+		this->lighting.setInt("gAlbedoSpecular", 0);
+		this->lighting.setInt("gNormalShininess", 1);
+		this->lighting.setInt("gDepth", 2);
+		this->lighting.setMat4("view", glm::mat4(cam.getView()));
+		this->lighting.setMat4("inverseView", glm::mat4(glm::inverse(cam.getView())));
+		this->lighting.setMat4("inverseProjection", glm::mat4(glm::inverse(cam.getProjection())));
+		this->lighting.setVec3("viewPos", cam.getPos());
+		this->lighting.setVec3("ambient", this->settings.ambient);
+		this->lighting.setVec4("background", this->settings.background);
+		this->lighting.setUInt("lightCount", lightCount);
+		this->lighting.setIVec2("screenSize", glm::ivec2(this->width, this->height));
+
+		this->lighting.bindSampler(0, this->getAlbedo());
+		this->lighting.bindSampler(1, this->getNormal());
+		this->lighting.bindSampler(2, this->getDepth());
+		this->lighting.bindImage(0, this->getOutput(), GL_WRITE_ONLY);
+		this->lighting.setSSBO(&lights);
+
+		this->lighting.dispatchImage(this->width, this->height);
+
+		return *this;
+	}
+
+	/** @brief Copy the lit image to the default framebuffer
+	 * @param[in] window	The window to present to
+	 * @param[in] copyDepth	Also copy the G-buffer depth, so forward passes (transparency, debug) can draw on top
+	 * @return				A reference to this object
+ 	*/
+	DeferredRenderer& DeferredRenderer::present(Window& window, bool copyDepth) {
+		int windowWidth, windowHeight;
+		window.getSize(&windowWidth, &windowHeight);
+
+		this->getOutput().sync(GL_FRAMEBUFFER_BARRIER_BIT);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, this->output.getFbo());
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+		// Depth can only be copied 1:1
+		if (copyDepth && windowWidth == this->width && windowHeight == this->height) {
+			this->gbuffer.resolve(nullptr, GL_DEPTH_BUFFER_BIT);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return *this;
+	}
+
+	/** @brief Resize every render target
+	 * @param[in] width		The new width
+	 * @param[in] height	The new height
+	 * @return				A reference to this object
+ 	*/
+	DeferredRenderer& DeferredRenderer::resize(int width, int height) {
+		this->width = width;
+		this->height = height;
+
+		this->gbuffer.resize(width, height);
+		this->output.resize(width, height);
+
+		return *this;
+	}
+
+	/** @brief Get the GLSL for geometry pass fragment shaders. Declares the G-buffer outputs and
+	 * 	writeGBuffer(vec3 albedo, float specular, vec3 normal, float shininess)
+	 * @return The GLSL source
+ 	*/
+	std::string DeferredRenderer::getGBufferInclude() {
+		return std::string(
+		"layout (location = 0) out vec4 gAlbedoSpecular;\n"\
+		"layout (location = 1) out vec4 gNormalShininess;\n") +
+		DeferredRenderer::OCTAHEDRAL_FUNCTIONS +
+		"void writeGBuffer(vec3 albedo, float specular, vec3 normal, float shininess) {\n"\
+			"gAlbedoSpecular = vec4(albedo, specular);\n"\
+			"gNormalShininess = vec4(encodeOctahedral(normalize(normal)), clamp(shininess / 256.0, 0.0, 1.0), 0.0);\n"\
+		"}\n";
+	}
+
+	Texture& DeferredRenderer::getAlbedo() {
+		return *this->gbuffer.getColor(0);
+	}
+
+	Texture& DeferredRenderer::getNormal() {
+		return *this->gbuffer.getColor(1);
+	}
+
+	Texture& DeferredRenderer::getDepth() {
+		return *this->gbuffer.getDepth();
+	}
+
+	Texture& DeferredRenderer::getOutput() {
+		return *this->output.getColor(0);
+	}
+
+	/** @brief Get the lighting compute shader source
+	 * @param[in] settings	The formats and light binding
+	 * @return				The GLSL source
+ 	*/
+	std::string DeferredRenderer::getLightingSource(Settings const& settings) {
+		return std::string("#version 430 core\n") +
+		"layout (local_size_x = " + std::to_string(TILE_SIZE) + ", local_size_y = " + std::to_string(TILE_SIZE) + ") in;\n"\
+		"#define MAX_TILE_LIGHTS " + std::to_string(MAX_TILE_LIGHTS) + "u\n" +
+		ClusteredLights::LIGHT_STRUCT +
+		"layout (std430, binding = " + std::to_string(settings.lightBinding) + ") readonly buffer DeferredLightBuffer { ClusterLight lights[]; };\n"\
+		"layout (binding = 0, " + Texture::getImageFormat(settings.lightFormat) + ") uniform writeonly image2D lightOutput;\n"\
+		"uniform sampler2D gAlbedoSpecular;\n"\
+		"uniform sampler2D gNormalShininess;\n"\
+		"uniform sampler2D gDepth;\n"\
+		"uniform mat4 view;\n"\
+		"uniform mat4 inverseView;\n"\
+		"uniform mat4 inverseProjection;\n"\
+		"uniform vec3 viewPos;\n"\
+		"uniform vec3 ambient;\n"\
+		"uniform vec4 background;\n"\
+		"uniform uint lightCount;\n"\
+		"uniform ivec2 screenSize;\n"\
+
+		"shared uint tileMinDepth;\n"\
+		"shared uint tileMaxDepth;\n"\
+		"shared uint tileLightCount;\n"\
+		"shared uint tileLights[MAX_TILE_LIGHTS];\n" +
+
+		DeferredRenderer::OCTAHEDRAL_FUNCTIONS +
+		ClusteredLights::POINT_LIGHT_FUNCTION +
+
+		// Rebuild a view space position from a uv and a [0, 1] depth
+		"vec3 viewFromDepth(vec2 uv, float depth) {\n"\
+			"vec4 v = inverseProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);\n"\
+			"return v.xyz / v.w;\n"\
+		"}\n"\
+
+		"void main() {\n"\
+			"ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"\
+			"bool inside = all(lessThan(pixel, screenSize));\n"\
+
+			"if (gl_LocalInvocationIndex == 0u) {\n"\
+				"tileMinDepth = 0xFFFFFFFFu;\n"\
+				"tileMaxDepth = 0u;\n"\
+				"tileLightCount = 0u;\n"\
+			"}\n"\
+			"barrier();\n"\
+
+			// Depths are in [0, 1], so their bit patterns sort like the floats
+			"float depth = inside ? texelFetch(gDepth, pixel, 0).r : 1.0;\n"\
+			"bool geometry = inside && depth < 1.0;\n"\
+			"if (geometry) {\n"\
+				"atomicMin(tileMinDepth, floatBitsToUint(depth));\n"\
+				"atomicMax(tileMaxDepth, floatBitsToUint(depth));\n"\
+			"}\n"\
+			"barrier();\n"\
+
+			// Cull the lights against the view space bounds of the tile
+			"if (tileMinDepth <= tileMaxDepth) {\n"\
+				"float minDepth = uintBitsToFloat(tileMinDepth);\n"\
+				"float maxDepth = uintBitsToFloat(tileMaxDepth);\n"\
+				"vec2 uvMin = vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) / vec2(screenSize);\n"\
+				"vec2 uvMax = vec2((gl_WorkGroupID.xy + 1u) * gl_WorkGroupSize.xy) / vec2(screenSize);\n"\
+				"vec3 boxMin = vec3(1e30);\n"\
+				"vec3 boxMax = vec3(-1e30);\n"\
+				"for (int c = 0; c < 8; c++) {\n"\
+					"vec3 corner = viewFromDepth(vec2((c & 1) == 0 ? uvMin.x : uvMax.x, (c & 2) == 0 ? uvMin.y : uvMax.y), (c & 4) == 0 ? minDepth : maxDepth);\n"\
+					"boxMin = min(boxMin, corner);\n"\
+					"boxMax = max(boxMax, corner);\n"\
+				"}\n"\
+
+				"uint groupSize = gl_WorkGroupSize.x * gl_WorkGroupSize.y;\n"\
+				"for (uint i = gl_LocalInvocationIndex; i < lightCount; i += groupSize) {\n"\
+					"vec4 light = lights[i].position;\n"\
+					"vec3 center = (view * vec4(light.xyz, 1.0)).xyz;\n"\
+					"vec3 d = clamp(center, boxMin, boxMax) - center;\n"\
+					"if (dot(d, d) <= light.w * light.w) {\n"\
+						"uint slot = atomicAdd(tileLightCount, 1u);\n"\
+						"if (slot < MAX_TILE_LIGHTS) {\n"\
+							"tileLights[slot] = i;\n"\
+						"}\n"\
+					"}\n"\
+				"}\n"\
+			"}\n"\
+			"barrier();\n"\
+
+			"if (!inside) {\n"\
+				"return;\n"\
+			"}\n"\
+
+			"if (!geometry) {\n"\
+				"imageStore(lightOutput, pixel, background);\n"\
+				"return;\n"\
+			"}\n"\
+
+			// Unpack the G-buffer and shade with the tile's lights
+			"vec4 albedoSpecular = texelFetch(gAlbedoSpecular, pixel, 0);\n"\
+			"vec4 normalShininess = texelFetch(gNormalShininess, pixel, 0);\n"\
+			"vec3 normal = decodeOctahedral(normalShininess.xy);\n"\
+			"float shininess = max(normalShininess.z * 256.0, 1.0);\n"\
+			"vec2 uv = (vec2(pixel) + 0.5) / vec2(screenSize);\n"\
+			"vec3 fragPos = (inverseView * vec4(viewFromDepth(uv, depth), 1.0)).xyz;\n"\
+			"vec3 viewDir = normalize(viewPos - fragPos);\n"\
+
+			"vec3 result = albedoSpecular.rgb * ambient;\n"\
+			"uint count = min(tileLightCount, MAX_TILE_LIGHTS);\n"\
+			"for (uint i = 0u; i < count; i++) {\n"\
+				"result += clusterPointLight(lights[tileLights[i]], fragPos, normal, viewDir, albedoSpecular.rgb, vec3(albedoSpecular.a), shininess);\n"\
+			"}\n"\
+
+			"imageStore(lightOutput, pixel, vec4(result, 1.0));\n"\
+		"}\n";
+	}
+}
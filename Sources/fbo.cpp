@@ -1,33 +1,89 @@
 #include "oglopp/fbo.h"
+#include "oglopp/texture.h"
 #include "oglopp/glad/gl.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace oglopp {
-	/** @brief Create a new SSBO object. Default constructor
+	/**
+	 * @brief Create a new FBO with only a depth/stencil renderbuffer. Color textures are attached with attachTexture()
+	 * @param[in] rboWidth	The initial width of the rbo
+	 * @param[in] rboHeight The initial height of the rbo
+	*/
+	FBO::FBO(unsigned int rboWidth, unsigned int rboHeight) : FBO(rboWidth, rboHeight, Description{{}, true, {GL_DEPTH24_STENCIL8, false, false}, 0}) {}
+
+	/**
+	 * @brief Create a new FBO and every attachment in a description
+	 * @param[in] width			The initial width
+	 * @param[in] height		The initial height
+	 * @param[in] description	The attachments to create
 	*/
-	FBO::FBO(unsigned int rboWidth, unsigned int rboHeight): width(rboWidth), height(rboHeight) {
+	FBO::FBO(unsigned int newWidth, unsigned int newHeight, Description const& description) : width(newWidth), height(newHeight), description(description) {
 		glGenFramebuffers(1, &this->fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
 
-		glGenRenderbuffers(1, &this->rbo);
-		glBindRenderbuffer(GL_RENDERBUFFER, this->rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, rboWidth, rboHeight); // use a single renderbuffer object for both a depth AND stencil buffer.
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->rbo);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		bool multisampled = description.samples > 0;
+
+		// Color attachments
+		for (size_t i = 0; i < description.colors.size(); i++) {
+			Attachment const& color = description.colors[i];
+			GLenum attachment = GL_COLOR_ATTACHMENT0 + i;
+
+			if (color.sampleable && !multisampled) {
+				this->colorTextures.push_back(std::make_unique<Texture>(newWidth, newHeight, color.format, color.nearest));
+				this->colorRenderbuffers.push_back(0);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, this->colorTextures.back()->getTexture(), 0);
+			} else {
+				GLuint renderbuffer;
+				glGenRenderbuffers(1, &renderbuffer);
+				this->storeRenderbuffer(renderbuffer, color.format);
+				this->colorTextures.push_back(nullptr);
+				this->colorRenderbuffers.push_back(renderbuffer);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer);
+			}
+		}
+
+		// Depth attachment
+		if (description.hasDepth) {
+			GLenum attachment = FBO::getDepthAttachment(description.depth.format);
+
+			if (description.depth.sampleable && !multisampled) {
+				this->depthTexture = std::make_unique<Texture>(newWidth, newHeight, description.depth.format, description.depth.nearest);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, this->depthTexture->getTexture(), 0);
+			} else {
+				glGenRenderbuffers(1, &this->rbo);
+				this->storeRenderbuffer(this->rbo, description.depth.format);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, this->rbo);
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		this->setDrawBuffers(description.colors.size());
 	}
 
 	FBO::~FBO() {
 		glDeleteFramebuffers(1, &this->fbo);
 		glDeleteRenderbuffers(1, &this->rbo);
+
+		for (GLuint renderbuffer : this->colorRenderbuffers) {
+			glDeleteRenderbuffers(1, &renderbuffer);
+		}
 	}
 
-	/** @brief Bind the SSBO to some binding number. Default is 0 if not specified
-	 * @return				A reference to the SSBO 0
+	/** @brief Bind the FBO for drawing and reading. Does not change any other state unless asked to
+	 * @param[in] setViewport	Also set the viewport to the size of the FBO. unbind() doesn't restore it
+	 * @return	A reference to the FBO object
  	*/
-	FBO& FBO::bind() {
+	FBO& FBO::bind(bool setViewport) {
+		this->syncAttachments();
 		glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
-		// Enable depth test
-		glEnable(GL_DEPTH_TEST);
-		glViewport(0, 0, this->width, this->height);
+
+		if (setViewport) {
+			glViewport(0, 0, this->width, this->height);
+		}
+
 		return *this;
 	}
 
@@ -35,32 +91,175 @@ namespace oglopp {
  	*/
 	void FBO::unbind() {
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDisable(GL_DEPTH_TEST);
 	}
 
 
 	/**
-	 * @brief Check if the framebuffer is complete after loading
+	 * @brief Check if this framebuffer is complete
 	 * @return True if complete, false otherwise
 	 */
 	bool FBO::isComplete() const {
-		return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		GLint bound;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, bound);
+
+		return complete;
 	}
 
 	/**
-	 * @brief Resize the rbo
+	 * @brief Resize the rbo and every attachment owned by this FBO. Their contents are lost
 	 * @param[in] rboWidth	The initial width of the rbo
 	 * @param[in] rboHeight The initial height of the rbo
 	 */
 	void FBO::resize(unsigned int rboWidth, unsigned int rboHeight) {
-		glBindRenderbuffer(GL_RENDERBUFFER, this->rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, rboWidth, rboHeight);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
 		this->width = rboWidth;
 		this->height = rboHeight;
+
+		for (size_t i = 0; i < this->colorTextures.size(); i++) {
+			if (this->colorTextures[i] != nullptr) {
+				this->colorTextures[i]->resize(rboWidth, rboHeight);
+			} else {
+				this->storeRenderbuffer(this->colorRenderbuffers[i], this->description.colors[i].format);
+			}
+		}
+
+		if (this->depthTexture != nullptr) {
+			this->depthTexture->resize(rboWidth, rboHeight);
+		} else if (this->rbo != 0) {
+			this->storeRenderbuffer(this->rbo, this->description.depth.format);
+		}
+	}
+
+	/**
+	 * @brief Select how many color attachments fragment shader outputs are written to (COLOR_ATTACHMENT0 to count - 1)
+	 * @param[in] count	The number of color attachments
+	 * @return			A reference to the FBO object
+	 */
+	FBO& FBO::setDrawBuffers(uint8_t count) {
+		glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+
+		if (count == 0) {
+			// Depth-only
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		} else {
+			std::vector<GLenum> buffers(count);
+			for (uint8_t i = 0; i < count; i++) {
+				buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+			}
+
+			glDrawBuffers(count, buffers.data());
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		this->drawBufferCount = count;
+
+		return *this;
+	}
+
+	/**
+	 * @brief Attach a texture which is not owned by this FBO
+	 * @param[in] texture		The texture to attach
+	 * @param[in] attachment	The attachment point, eg. GL_COLOR_ATTACHMENT1 or GL_DEPTH_STENCIL_ATTACHMENT
+	 * @return					A reference to the FBO object
+	 */
+	FBO& FBO::attachTexture(Texture& texture, GLenum attachment) {
+		glBindFramebuffer(GL_FRAMEBUFFER, this->fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture.getTexture(), 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Make sure fragment outputs reach the new color attachment
+		if (attachment >= GL_COLOR_ATTACHMENT0 && attachment <= GL_COLOR_ATTACHMENT15) {
+			uint8_t count = attachment - GL_COLOR_ATTACHMENT0 + 1;
+			if (count > this->drawBufferCount) {
+				this->setDrawBuffers(count);
+			}
+		}
+
+		return *this;
 	}
 
+	/**
+	 * @brief Copy (and resolve, for MSAA) the color attachments of this FBO into another FBO with glBlitFramebuffer
+	 * @param[in] target	The FBO to copy to. nullptr for the default framebuffer, which only receives color attachment 0
+	 * @param[in] mask		The buffers to copy. Any of GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT and GL_STENCIL_BUFFER_BIT
+	 * @return				A reference to the FBO object
+	 */
+	FBO& FBO::resolve(FBO* target, GLbitfield mask) {
+		this->syncAttachments();
+		if (target != nullptr) {
+			target->syncAttachments();
+		}
+
+		GLuint targetFbo = (target == nullptr) ? 0 : target->getFbo();
+		int targetWidth = (target == nullptr) ? this->width : target->getWidth();
+		int targetHeight = (target == nullptr) ? this->height : target->getHeight();
+
+		// Scaling is only allowed for color, and only without MSAA
+		GLenum filter = (mask == GL_COLOR_BUFFER_BIT && this->description.samples == 0) ? GL_LINEAR : GL_NEAREST;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, this->fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFbo);
+
+		uint8_t count = (target == nullptr) ? 1 : std::min(this->drawBufferCount, target->drawBufferCount);
+
+		if ((mask & GL_COLOR_BUFFER_BIT) && count > 1) {
+			// A blit writes to every draw buffer, so copy the color attachments one at a time
+			if (mask != GL_COLOR_BUFFER_BIT) {
+				glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, targetWidth, targetHeight, mask & ~GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
+
+			for (uint8_t i = 0; i < count; i++) {
+				glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+				glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
+				glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, filter);
+			}
+
+			// Restore the read and draw buffers, which are stored per framebuffer
+			this->setDrawBuffers(this->drawBufferCount);
+			target->setDrawBuffers(target->drawBufferCount);
+		} else {
+			glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, targetWidth, targetHeight, mask, filter);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Get an owned color texture
+	 * @param[in] index	The color attachment index
+	 * @return			A pointer to the texture, or nullptr if the attachment is a renderbuffer or does not exist
+	 */
+	Texture* FBO::getColor(uint8_t index) {
+		if (index >= this->colorTextures.size()) {
+			return nullptr;
+		}
+
+		return this->colorTextures[index].get();
+	}
+
+	/**
+	 * @brief Get the owned depth texture
+	 * @return A pointer to the texture, or nullptr if the depth attachment is a renderbuffer or does not exist
+	 */
+	Texture* FBO::getDepth() {
+		return this->depthTexture.get();
+	}
+
+	/**
+	 * @brief Get the number of color attachments
+	 * @return The color attachment count
+	 */
+	uint8_t FBO::getColorCount() const {
+		return this->drawBufferCount;
+	}
 
 	unsigned int FBO::getFbo() const {
 		return this->fbo;
@@ -77,4 +276,49 @@ namespace oglopp {
 	unsigned int FBO::getHeight() const {
 		return this->height;
 	}
+
+	/**
+	 * @brief Get the attachment point of a depth format
+	 * @param[in] format	The depth format
+	 * @return				GL_DEPTH_STENCIL_ATTACHMENT for depth/stencil formats, GL_DEPTH_ATTACHMENT otherwise
+	 */
+	GLenum FBO::getDepthAttachment(GLenum format) {
+		if (format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8) {
+			return GL_DEPTH_STENCIL_ATTACHMENT;
+		}
+
+		return GL_DEPTH_ATTACHMENT;
+	}
+
+	/**
+	 * @brief Allocate the storage of a renderbuffer at the current size
+	 * @param[in] renderbuffer	The renderbuffer
+	 * @param[in] format		The internal format
+	 */
+	void FBO::storeRenderbuffer(GLuint renderbuffer, GLenum format) {
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+
+		if (this->description.samples > 0) {
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, this->description.samples, format, this->width, this->height);
+		} else {
+			glRenderbufferStorage(GL_RENDERBUFFER, format, this->width, this->height);
+		}
+
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+
+	/**
+	 * @brief Issue the framebuffer barrier if a shader stored to an owned attachment texture since it was last issued
+	 */
+	void FBO::syncAttachments() {
+		for (std::unique_ptr<Texture> const& texture : this->colorTextures) {
+			if (texture != nullptr) {
+				texture->sync(GL_FRAMEBUFFER_BARRIER_BIT);
+			}
+		}
+
+		if (this->depthTexture != nullptr) {
+			this->depthTexture->sync(GL_FRAMEBUFFER_BARRIER_BIT);
+		}
+	}
 }
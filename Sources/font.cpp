@@ -0,0 +1,564 @@
+#include "oglopp/font.h"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb/stb_truetype.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace oglopp {
+	static constexpr uint32_t REPLACEMENT = '?';
+
+	/** @brief Decode the next codepoint of some UTF-8 text
+	 * @param[in]		text	The text
+	 * @param[in,out]	index	The byte to decode from. Moved past the codepoint
+	 * @return					The codepoint, or 0xFFFD for a malformed sequence
+ 	*/
+	static uint32_t decodeUtf8(std::string_view text, size_t& index) {
+		uint8_t lead = static_cast<uint8_t>(text[index++]);
+		if (lead < 0x80) {
+			return lead;
+		}
+
+		int continuation = lead >= 0xF0 ? 3 : (lead >= 0xE0 ? 2 : (lead >= 0xC0 ? 1 : -1));
+		if (continuation < 0) {
+			return 0xFFFD;
+		}
+
+		uint32_t codepoint = lead & (0x3F >> continuation);
+		for (int i = 0; i < continuation; i++) {
+			if (index >= text.size() || (static_cast<uint8_t>(text[index]) & 0xC0) != 0x80) {
+				return 0xFFFD;
+			}
+			codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[index++]) & 0x3F);
+		}
+
+		return codepoint;
+	}
+
+	/** @brief Load a font file and build the atlas with the default settings
+	 * @param[in] path		The TTF or OTF file
+	 * @return				A status code. 0 on success. -1 if the file can't be read or isn't a font
+ 	*/
+	int8_t Font::load(std::string const& path) {
+		return this->load(path, Settings());
+	}
+
+	/** @brief Load a font file and build the atlas
+	 * @param[in] path		The TTF or OTF file
+	 * @param[in] settings	How the atlas is made
+	 * @return				A status code. 0 on success. -1 if the file can't be read or isn't a font
+ 	*/
+	int8_t Font::load(std::string const& path, Settings const& settings) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			std::cout << "[Oglopp] Failed to open font " << path << std::endl;
+			return -1;
+		}
+
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return this->loadMem(data.data(), data.size(), settings);
+	}
+
+	/** @brief Load a font from memory and build the atlas
+	 * @param[in] data		The font file
+	 * @param[in] size		The size of the file in bytes
+	 * @param[in] settings	How the atlas is made
+	 * @return				A status code. 0 on success. -1 if the data isn't a font
+ 	*/
+	int8_t Font::loadMem(const uint8_t* data, size_t size, Settings const& settings) {
+		stbtt_fontinfo info;
+		int offset = size > 0 ? stbtt_GetFontOffsetForIndex(data, 0) : -1;
+		if (offset < 0 || !stbtt_InitFont(&info, data, offset)) {
+			std::cout << "[Oglopp] Failed to read font data" << std::endl;
+			return -1;
+		}
+
+		this->settings = settings;
+		this->glyphs.clear();
+		this->kerning.clear();
+
+		float scale = stbtt_ScaleForPixelHeight(&info, settings.pixelHeight);
+
+		int ascent, descent, lineGap;
+		stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+		this->ascent = ascent * scale;
+		this->lineHeight = (ascent - descent + lineGap) * scale;
+
+		// Rasterize every glyph the font has in the ranges. The field is 0.5 on the outline and moves by 0.5 over the padding
+		struct Bitmap {
+			uint32_t codepoint;
+			unsigned char* pixels;
+			int width;
+			int height;
+		};
+		std::vector<Bitmap> bitmaps;
+		std::vector<uint32_t> codepoints;
+
+		for (std::pair<uint32_t, uint32_t> const& range : settings.ranges) {
+			for (uint32_t codepoint = range.first; codepoint <= range.second; codepoint++) {
+				if (stbtt_FindGlyphIndex(&info, static_cast<int>(codepoint)) == 0 && codepoint != ' ') {
+					continue;
+				}
+
+				int advance, bearing;
+				stbtt_GetCodepointHMetrics(&info, static_cast<int>(codepoint), &advance, &bearing);
+
+				Bitmap bitmap{codepoint, nullptr, 0, 0};
+				int xoff = 0, yoff = 0;
+				bitmap.pixels = stbtt_GetCodepointSDF(&info, scale, static_cast<int>(codepoint), settings.padding, 128,
+					128.0f / std::max(settings.padding, 1), &bitmap.width, &bitmap.height, &xoff, &yoff);
+
+				Glyph glyph{};
+				glyph.offset = glm::vec2(xoff, yoff);
+				glyph.size = bitmap.pixels != nullptr ? glm::vec2(bitmap.width, bitmap.height) : glm::vec2(0.0);
+				glyph.advance = advance * scale;
+				this->glyphs[codepoint] = glyph;
+				codepoints.push_back(codepoint);
+
+				if (bitmap.pixels != nullptr) {
+					bitmaps.push_back(bitmap);
+				}
+			}
+		}
+
+		// Shelf packing, tallest first, so each shelf wastes little above its shorter glyphs
+		std::sort(bitmaps.begin(), bitmaps.end(), [](Bitmap const& a, Bitmap const& b) { return a.height > b.height; });
+
+		int width = settings.atlasWidth;
+		int x = 0, y = 0, shelf = 0;
+		std::vector<glm::ivec2> positions(bitmaps.size());
+
+		for (size_t i = 0; i < bitmaps.size(); i++) {
+			if (x + bitmaps[i].width > width) {
+				x = 0;
+				y += shelf + 1;
+				shelf = 0;
+			}
+
+			positions[i] = glm::ivec2(x, y);
+			x += bitmaps[i].width + 1;
+			shelf = std::max(shelf, bitmaps[i].height);
+		}
+		int height = std::max(y + shelf, 1);
+
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height, 0);
+		for (size_t i = 0; i < bitmaps.size(); i++) {
+			Bitmap const& bitmap = bitmaps[i];
+			for (int row = 0; row < bitmap.height; row++) {
+				std::copy_n(bitmap.pixels + row * bitmap.width, std::min(bitmap.width, width),
+					pixels.begin() + (positions[i].y + row) * width + positions[i].x);
+			}
+
+			// Atlas rows are uploaded top first, so v grows down the glyph like y does
+			glm::vec2 topLeft = glm::vec2(positions[i]) / glm::vec2(width, height);
+			glm::vec2 bottomRight = glm::vec2(positions[i] + glm::ivec2(bitmap.width, bitmap.height)) / glm::vec2(width, height);
+			this->glyphs[bitmap.codepoint].region = glm::vec4(topLeft, bottomRight);
+
+			stbtt_FreeSDF(bitmap.pixels, nullptr);
+		}
+
+		// Every pair, once, so layout never needs the font file
+		for (uint32_t first : codepoints) {
+			for (uint32_t second : codepoints) {
+				int kern = stbtt_GetCodepointKernAdvance(&info, static_cast<int>(first), static_cast<int>(second));
+				if (kern != 0) {
+					this->kerning[(uint64_t(first) << 32) | second] = kern * scale;
+				}
+			}
+		}
+
+		this->atlas = std::make_unique<Texture>(width, height, GL_R8, false);
+		this->atlas->bind();
+
+		GLint alignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		return 0;
+	}
+
+	/** @brief Place the glyphs of some text
+	 * @param[in] text		UTF-8 text
+	 * @param[in] size		The line height in pixels to lay out at
+	 * @param[in] maxWidth	The width lines break at, in pixels. 0 to only break at '\n'
+	 * @param[out] glyphs	Appended with the glyphs to draw, or nullptr to only measure
+	 * @return				The width of the widest line and the height of all the lines
+ 	*/
+	glm::vec2 Font::layout(std::string_view text, float size, float maxWidth, std::vector<PlacedGlyph>* glyphs) const {
+		if (!this->isLoaded() || text.empty()) {
+			return glm::vec2(0.0);
+		}
+
+		float scale = size / this->lineHeight;
+		Glyph const* fallback = this->getGlyph(REPLACEMENT);
+
+		auto find = [&](uint32_t codepoint) {
+			Glyph const* glyph = this->getGlyph(codepoint);
+			return glyph != nullptr ? glyph : fallback;
+		};
+
+		// The width of the word starting at a byte, with its kerning, up to the next space or newline
+		auto wordWidth = [&](size_t index) {
+			float width = 0.0;
+			uint32_t previous = 0;
+
+			while (index < text.size()) {
+				size_t next = index;
+				uint32_t codepoint = decodeUtf8(text, next);
+				if (codepoint == ' ' || codepoint == '\n') {
+					break;
+				}
+
+				Glyph const* glyph = find(codepoint);
+				if (glyph != nullptr) {
+					width += (this->getKerning(previous, codepoint) + glyph->advance) * scale;
+				}
+
+				previous = codepoint;
+				index = next;
+			}
+
+			return width;
+		};
+
+		glm::vec2 pen(0.0, this->ascent * scale);
+		float widest = 0.0;
+		uint32_t lines = 1;
+		uint32_t previous = 0;
+
+		auto newLine = [&]() {
+			widest = std::max(widest, pen.x);
+			pen = glm::vec2(0.0, pen.y + size);
+			previous = 0;
+			lines++;
+		};
+
+		size_t index = 0;
+		while (index < text.size()) {
+			uint32_t codepoint = decodeUtf8(text, index);
+
+			if (codepoint == '\n') {
+				newLine();
+				continue;
+			}
+
+			Glyph const* glyph = find(codepoint);
+			if (glyph == nullptr) {
+				continue;
+			}
+
+			// Break at a space when the word after it would cross the width. The space itself is dropped
+			if (codepoint == ' ' && maxWidth > 0.0 && pen.x > 0.0 && pen.x + (glyph->advance * scale) + wordWidth(index) > maxWidth) {
+				newLine();
+				continue;
+			}
+
+			pen.x += this->getKerning(previous, codepoint) * scale;
+
+			if (glyphs != nullptr && glyph->size.x > 0.0) {
+				glyphs->push_back(PlacedGlyph{pen + glyph->offset * scale, glyph->size * scale, glyph});
+			}
+
+			pen.x += glyph->advance * scale;
+			previous = codepoint;
+		}
+
+		widest = std::max(widest, pen.x);
+
+		return glm::vec2(widest, lines * size);
+	}
+
+	/** @brief Measure some text without placing it
+	 * @param[in] text		UTF-8 text
+	 * @param[in] size		The line height in pixels
+	 * @param[in] maxWidth	The width lines break at, in pixels. 0 to only break at '\n'
+	 * @return				The width of the widest line and the height of all the lines
+ 	*/
+	glm::vec2 Font::measure(std::string_view text, float size, float maxWidth) const {
+		return this->layout(text, size, maxWidth, nullptr);
+	}
+
+	/** @brief Get a glyph
+	 * @param[in] codepoint		The codepoint
+	 * @return					The glyph, or nullptr if it wasn't loaded
+ 	*/
+	Font::Glyph const* Font::getGlyph(uint32_t codepoint) const {
+		auto found = this->glyphs.find(codepoint);
+		return found != this->glyphs.end() ? &found->second : nullptr;
+	}
+
+	/** @brief Get the kerning between two glyphs
+	 * @param[in] first		The codepoint on the left
+	 * @param[in] second	The codepoint on the right
+	 * @return				The pen adjustment in pixels at the rasterized size. Usually 0 or negative
+ 	*/
+	float Font::getKerning(uint32_t first, uint32_t second) const {
+		if (this->kerning.empty()) {
+			return 0.0;
+		}
+
+		auto found = this->kerning.find((uint64_t(first) << 32) | second);
+		return found != this->kerning.end() ? found->second : 0.0f;
+	}
+
+	/** @brief Get the distance from one baseline to the next
+	 * @return The line height in pixels at the rasterized size
+ 	*/
+	float Font::getLineHeight() const {
+		return this->lineHeight;
+	}
+
+	/** @brief Get the distance from the top of a line to its baseline
+	 * @return The ascent in pixels at the rasterized size
+ 	*/
+	float Font::getAscent() const {
+		return this->ascent;
+	}
+
+	/** @brief Get the settings the atlas was made with
+	 * @return A reference to the settings
+ 	*/
+	Font::Settings const& Font::getSettings() const {
+		return this->settings;
+	}
+
+	/** @brief Get the atlas
+	 * @return The atlas texture, one red channel of distance, or nullptr before load()
+ 	*/
+	Texture* Font::getAtlas() {
+		return this->atlas.get();
+	}
+
+	/** @brief Check whether a font has been loaded
+	 * @return True if load() or loadMem() succeeded
+ 	*/
+	bool Font::isLoaded() const {
+		return this->atlas != nullptr;
+	}
+
+	TextRenderer::TextRenderer() {
+		this->shader = std::make_unique<Shader>(
+		"#version 450 core\n"\
+		"struct Instance {\n"\
+			"vec4 rect;\n"\
+			"vec4 region;\n"\
+			"vec4 color;\n"\
+		"};\n"\
+		"layout (std430, binding = 0) readonly buffer Glyphs { Instance glyphs[]; };\n"\
+		\
+		"uniform mat4 projection;\n"\
+		"uniform uint firstGlyph;\n"\
+		\
+		"out vec2 texCoord;\n"\
+		"out vec4 color;\n"\
+		\
+		"const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));\n"\
+		\
+		"void main() {\n"\
+			"Instance glyph = glyphs[firstGlyph + gl_InstanceID];\n"\
+			"vec2 corner = corners[gl_VertexID];\n"\
+			\
+			"gl_Position = projection * vec4(glyph.rect.xy + corner * glyph.rect.zw, 0.0, 1.0);\n"\
+			"texCoord = mix(glyph.region.xy, glyph.region.zw, corner);\n"\
+			"color = glyph.color;\n"\
+		"}\n",
+		\
+		"#version 450 core\n"\
+		"in vec2 texCoord;\n"\
+		"in vec4 color;\n"\
+		"out vec4 FragColor;\n"\
+		\
+		"uniform sampler2D atlas;\n"\
+		\
+		"void main() {\n"\
+			// The field changes by fwidth() a pixel at any scale, so the edge is antialiased over about one pixel
+			"float distance = texture(atlas, texCoord).r;\n"\
+			"float smoothing = max(fwidth(distance) * 0.75, 1e-4);\n"\
+			"float coverage = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);\n"\
+			\
+			"if (coverage <= 0.0) {\n"\
+				"discard;\n"\
+			"}\n"\
+			"FragColor = vec4(color.rgb, color.a * coverage);\n"\
+		"}\n", ShaderType::RAW);
+
+		// Core profiles need a vertex array bound to draw, even with no attributes
+		glGenVertexArrays(1, &this->vao);
+	}
+
+	TextRenderer::~TextRenderer() {
+		if (this->vao != 0) {
+			glDeleteVertexArrays(1, &this->vao);
+		}
+	}
+
+	/** @brief Start a batch in pixels over the current viewport, origin at the top left, y down
+	 * @return A reference to this object
+ 	*/
+	TextRenderer& TextRenderer::begin() {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		return this->begin(glm::ortho(0.0f, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]), 0.0f, -1.0f, 1.0f));
+	}
+
+	/** @brief Start a batch with a projection. Text is laid out y down, so give one whose y points down too
+	 * @param[in] projection	Transforms text positions to clip space
+	 * @return					A reference to this object
+ 	*/
+	TextRenderer& TextRenderer::begin(glm::mat4 const& projection) {
+		this->projection = projection;
+
+		// The lists keep their capacity for the next batch
+		this->fonts.clear();
+		for (std::vector<Instance>& batch : this->batches) {
+			batch.clear();
+		}
+
+		return *this;
+	}
+
+	/** @brief Add some text
+	 * @param[in] font		The font. It must live until end()
+	 * @param[in] text		UTF-8 text
+	 * @param[in] position	The top left of the text
+	 * @param[in] size		The line height
+	 * @param[in] color		The color
+	 * @param[in] maxWidth	The width lines break at. 0 to only break at '\n'
+	 * @return				The width of the widest line and the height of all the lines
+ 	*/
+	glm::vec2 TextRenderer::draw(Font& font, std::string_view text, glm::vec2 const& position, float size, glm::vec4 const& color, float maxWidth) {
+		if (!font.isLoaded()) {
+			return glm::vec2(0.0);
+		}
+
+		// There are only ever a few fonts, so a search beats a map
+		size_t index = std::find(this->fonts.begin(), this->fonts.end(), &font) - this->fonts.begin();
+		if (index == this->fonts.size()) {
+			this->fonts.push_back(&font);
+			if (this->batches.size() < this->fonts.size()) {
+				this->batches.emplace_back();
+			}
+		}
+
+		this->placed.clear();
+		glm::vec2 extent = font.layout(text, size, maxWidth, &this->placed);
+
+		std::vector<Instance>& batch = this->batches[index];
+		for (Font::PlacedGlyph const& glyph : this->placed) {
+			batch.push_back(Instance{glm::vec4(position + glyph.position, glyph.size), glyph.glyph->region, color});
+		}
+
+		return extent;
+	}
+
+	/** @brief Upload the batch and draw it, one draw per font
+	 * @return A reference to this object
+ 	*/
+	TextRenderer& TextRenderer::end() {
+		this->drawn = 0;
+		this->draws = 0;
+
+		for (size_t i = 0; i < this->fonts.size(); i++) {
+			this->drawn += this->batches[i].size();
+		}
+
+		if (this->drawn == 0) {
+			return *this;
+		}
+
+		// The ring only grows, with room to spare so a little more text doesn't make it grow every frame
+		if (this->ring.size() < this->drawn) {
+			std::vector<Instance> empty(this->drawn + this->drawn / 2, Instance{});
+			if (this->ring.assignPersistent(empty) != 0) {
+				this->ring.assign(empty);
+			}
+		}
+
+		// Without persistent storage, the glyphs go through a copy instead
+		std::vector<Instance> staging;
+		std::span<Instance> out = this->ring.writeSpan(this->frame++);
+		if (out.empty()) {
+			staging.resize(this->drawn);
+			out = staging;
+		}
+
+		std::vector<uint32_t> firsts(this->fonts.size());
+		uint32_t cursor = 0;
+		for (size_t i = 0; i < this->fonts.size(); i++) {
+			firsts[i] = cursor;
+			std::copy(this->batches[i].begin(), this->batches[i].end(), out.begin() + cursor);
+			cursor += static_cast<uint32_t>(this->batches[i].size());
+		}
+
+		if (!staging.empty()) {
+			this->ring.set(0, staging);
+		}
+
+		this->shader->use();
+		this->shader->setMat4("projection", this->projection);
+		this->shader->setInt("atlas", 0);
+
+		this->ring.bind(GLYPH_BINDING);
+
+		GLboolean blendWas = glIsEnabled(GL_BLEND);
+		GLboolean depthWas = glIsEnabled(GL_DEPTH_TEST);
+		GLint blendFuncWas[4];
+		glGetIntegerv(GL_BLEND_SRC_RGB, &blendFuncWas[0]);
+		glGetIntegerv(GL_BLEND_DST_RGB, &blendFuncWas[1]);
+		glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendFuncWas[2]);
+		glGetIntegerv(GL_BLEND_DST_ALPHA, &blendFuncWas[3]);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		glBindVertexArray(this->vao);
+
+		for (size_t i = 0; i < this->fonts.size(); i++) {
+			if (this->batches[i].empty()) {
+				continue;
+			}
+
+			// The shader adds the first glyph itself. gl_BaseInstance would need GLSL 4.60
+			this->fonts[i]->getAtlas()->bind(GL_TEXTURE0);
+			this->shader->setUInt("firstGlyph", firsts[i]);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(this->batches[i].size()));
+			this->draws++;
+		}
+
+		glBindVertexArray(0);
+
+		glBlendFuncSeparate(blendFuncWas[0], blendFuncWas[1], blendFuncWas[2], blendFuncWas[3]);
+		if (!blendWas) {
+			glDisable(GL_BLEND);
+		}
+		if (depthWas) {
+			glEnable(GL_DEPTH_TEST);
+		}
+
+		return *this;
+	}
+
+	/** @brief Get the number of glyphs the last end() drew
+	 * @return The glyph count
+ 	*/
+	size_t TextRenderer::getGlyphCount() const {
+		return this->drawn;
+	}
+
+	/** @brief Get the number of draws the last end() made
+	 * @return The draw count
+ 	*/
+	size_t TextRenderer::getDrawCount() const {
+		return this->draws;
+	}
+}
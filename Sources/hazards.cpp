@@ -0,0 +1,71 @@
+#include "oglopp/hazards.h"
+#include "oglopp/glad/gl.h"
+
+namespace oglopp {
+	Hazards::epoch_t Hazards::epoch = 0;
+	Hazards::epoch_t Hazards::issued[Hazards::BIT_COUNT] = {};
+	uint64_t Hazards::barrierCount = 0;
+
+	/** @brief Record an incoherent write to a resource
+	 * @param[in,out] lastWrite	The resource's last write epoch, updated to the new epoch
+ 	*/
+	void Hazards::written(epoch_t& lastWrite) {
+		lastWrite = ++Hazards::epoch;
+	}
+
+	/** @brief Issue whichever of the barrier bits are needed before a resource is used
+	 * @param[in] lastWrite		The resource's last write epoch
+	 * @param[in] barriers		The barrier bits for the kind of use, eg. GL_TEXTURE_FETCH_BARRIER_BIT
+	 * @return					The bits which were issued
+ 	*/
+	GLbitfield Hazards::require(epoch_t lastWrite, GLbitfield barriers) {
+		if (lastWrite == 0) {
+			return 0;
+		}
+
+		GLbitfield needed = 0;
+		for (int bit = 0; bit < BIT_COUNT; bit++) {
+			if ((barriers & (1u << bit)) && Hazards::issued[bit] < lastWrite) {
+				needed |= 1u << bit;
+			}
+		}
+
+		if (needed == 0) {
+			return 0;
+		}
+
+		glMemoryBarrier(needed);
+		Hazards::barrierCount++;
+
+		// A barrier covers every write issued before it, not only this resource's
+		for (int bit = 0; bit < BIT_COUNT; bit++) {
+			if (needed & (1u << bit)) {
+				Hazards::issued[bit] = Hazards::epoch;
+			}
+		}
+
+		return needed;
+	}
+
+	/** @brief Issue barrier bits needed since any write. For uses which cannot be tied to a resource, eg. an indirect buffer bound by the caller
+	 * @param[in] barriers	The barrier bits
+	 * @return				The bits which were issued
+ 	*/
+	GLbitfield Hazards::requireAll(GLbitfield barriers) {
+		return Hazards::require(Hazards::epoch, barriers);
+	}
+
+	/** @brief Get the epoch of the latest write
+	 * @return The epoch
+ 	*/
+	Hazards::epoch_t Hazards::getEpoch() {
+		return Hazards::epoch;
+	}
+
+	/** @brief Get the number of glMemoryBarrier calls issued so far
+	 * @return The count
+ 	*/
+	uint64_t Hazards::getBarrierCount() {
+		return Hazards::barrierCount;
+	}
+}
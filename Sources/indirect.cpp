@@ -0,0 +1,184 @@
+#include "oglopp/indirect.h"
+#include "oglopp/glad/gl.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace oglopp {
+	/** @brief Allocate the count and commands
+	 * @param[in] capacity	The number of commands
+	 * @param[in] stride	The size of one command in bytes
+ 	*/
+	IndirectBuffer::IndirectBuffer(uint32_t capacity, GLsizei stride) : capacity(capacity), stride(stride) {
+		std::vector<uint8_t> zeroes(COMMANDS_OFFSET + static_cast<size_t>(capacity) * stride, 0);
+		this->load(zeroes.data(), zeroes.size());
+	}
+
+	/** @brief Clear the count and every command to zero
+	 * @return A reference to this buffer
+ 	*/
+	IndirectBuffer& IndirectBuffer::reset() {
+		std::vector<uint8_t> zeroes(this->getSize(), 0);
+		this->update(0, zeroes.data(), zeroes.size());
+
+		return *this;
+	}
+
+	/** @brief Set the command count from the CPU. Not needed when a shader appends the commands
+	 * @param[in] count	The number of commands
+	 * @return			A reference to this buffer
+ 	*/
+	IndirectBuffer& IndirectBuffer::setCount(uint32_t count) {
+		GLuint value = std::min(count, this->capacity);
+		this->update(0, &value, sizeof(value));
+
+		return *this;
+	}
+
+	/** @brief Get the number of commands the buffer can hold
+	 * @return The capacity
+ 	*/
+	uint32_t IndirectBuffer::getCapacity() const {
+		return this->capacity;
+	}
+
+	/** @brief Get the size of one command in bytes
+	 * @return The stride
+ 	*/
+	GLsizei IndirectBuffer::getStride() const {
+		return this->stride;
+	}
+
+	/** @brief Get the byte offset of a command, as passed to the indirect GL calls
+	 * @param[in] index	The command index
+	 * @return			The offset in bytes
+ 	*/
+	GLintptr IndirectBuffer::getOffset(uint32_t index) const {
+		return COMMANDS_OFFSET + static_cast<GLintptr>(index) * this->stride;
+	}
+
+	/** @brief Bind the buffer to an indirect target, after the barrier a shader write to it needs
+	 * @param[in] target	GL_DISPATCH_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER or GL_PARAMETER_BUFFER
+	 * @return				A reference to this buffer
+ 	*/
+	IndirectBuffer& IndirectBuffer::bindIndirect(GLenum target) {
+		this->sync(GL_COMMAND_BARRIER_BIT);
+		glBindBuffer(target, this->ssbo);
+
+		return *this;
+	}
+
+	/** @brief Check if the GPU side count can be used by multi-draws (GL 4.6 or ARB_indirect_parameters)
+	 * @return True if glMultiDraw*IndirectCount is available
+ 	*/
+	bool IndirectBuffer::hasIndirectCount() {
+		return GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+	}
+
+	/** @brief Write one command from the CPU
+	 * @param[in] index		The command index
+	 * @param[in] command	A pointer to the command, stride bytes long
+	 * @return				A status code. 0 for success. -1 if the index is out of range
+ 	*/
+	int8_t IndirectBuffer::setCommand(uint32_t index, void const* command) {
+		if (index >= this->capacity) {
+			std::cout << "[Oglopp] Indirect command " << index << " is out of range of a buffer of " << this->capacity << std::endl;
+			return -1;
+		}
+
+		this->update(this->getOffset(index), const_cast<void*>(command), this->stride);
+
+		return 0;
+	}
+
+	/** @brief Build the GLSL declaration of a command block
+	 * @param[in] commandStruct	The GLSL struct of one command, named Command
+	 * @param[in] binding		The storage block binding
+	 * @param[in] blockName		The block name
+	 * @return					The declaration
+ 	*/
+	std::string IndirectBuffer::getDeclaration(const char* commandStruct, GLuint binding, std::string const& blockName) {
+		return std::string(commandStruct) +
+			"layout (std430, binding = " + std::to_string(binding) + ") buffer " + blockName + " {\n"\
+			"	uint commandCount;\n"\
+			"	uint commandPad0, commandPad1, commandPad2;\n"\
+			"	Command commands[];\n"\
+			"};\n";
+	}
+
+	/** @brief Create a buffer of zeroed commands
+	 * @param[in] capacity	The number of commands
+ 	*/
+	DispatchIndirectBuffer::DispatchIndirectBuffer(uint32_t capacity) : IndirectBuffer(capacity, sizeof(Command)) {}
+
+	/** @brief Write one command from the CPU
+	 * @param[in] index		The command index
+	 * @param[in] command	The command
+	 * @return				A reference to this buffer
+ 	*/
+	DispatchIndirectBuffer& DispatchIndirectBuffer::set(uint32_t index, Command const& command) {
+		this->setCommand(index, &command);
+
+		return *this;
+	}
+
+	/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+	 * @param[in] binding	The storage block binding
+	 * @param[in] blockName	The block name
+	 * @return				The declaration
+ 	*/
+	std::string DispatchIndirectBuffer::getDeclaration(GLuint binding, std::string const& blockName) {
+		return IndirectBuffer::getDeclaration(COMMAND_STRUCT, binding, blockName);
+	}
+
+	/** @brief Create a buffer of zeroed commands
+	 * @param[in] capacity	The number of commands
+ 	*/
+	DrawArraysIndirectBuffer::DrawArraysIndirectBuffer(uint32_t capacity) : IndirectBuffer(capacity, sizeof(Command)) {}
+
+	/** @brief Write one command from the CPU
+	 * @param[in] index		The command index
+	 * @param[in] command	The command
+	 * @return				A reference to this buffer
+ 	*/
+	DrawArraysIndirectBuffer& DrawArraysIndirectBuffer::set(uint32_t index, Command const& command) {
+		this->setCommand(index, &command);
+
+		return *this;
+	}
+
+	/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+	 * @param[in] binding	The storage block binding
+	 * @param[in] blockName	The block name
+	 * @return				The declaration
+ 	*/
+	std::string DrawArraysIndirectBuffer::getDeclaration(GLuint binding, std::string const& blockName) {
+		return IndirectBuffer::getDeclaration(COMMAND_STRUCT, binding, blockName);
+	}
+
+	/** @brief Create a buffer of zeroed commands
+	 * @param[in] capacity	The number of commands
+ 	*/
+	DrawElementsIndirectBuffer::DrawElementsIndirectBuffer(uint32_t capacity) : IndirectBuffer(capacity, sizeof(Command)) {}
+
+	/** @brief Write one command from the CPU
+	 * @param[in] index		The command index
+	 * @param[in] command	The command
+	 * @return				A reference to this buffer
+ 	*/
+	DrawElementsIndirectBuffer& DrawElementsIndirectBuffer::set(uint32_t index, Command const& command) {
+		this->setCommand(index, &command);
+
+		return *this;
+	}
+
+	/** @brief Get the GLSL declaration of the buffer: the Command struct and a block with commandCount and commands[]
+	 * @param[in] binding	The storage block binding
+	 * @param[in] blockName	The block name
+	 * @return				The declaration
+ 	*/
+	std::string DrawElementsIndirectBuffer::getDeclaration(GLuint binding, std::string const& blockName) {
+		return IndirectBuffer::getDeclaration(COMMAND_STRUCT, binding, blockName);
+	}
+}
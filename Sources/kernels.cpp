@@ -0,0 +1,220 @@
+#include "oglopp/kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace oglopp {
+	/** @brief Separable gaussian blur. Each work group caches a row (or column) segment and its apron in shared memory,
+	 *  so every texel is fetched once per pass instead of once per tap
+	 * @param[in] source		The texture to blur
+	 * @param[in] target		The texture to write the result to. Same size as the source
+	 * @param[in] temporary		Holds the horizontal pass. Same size and format as the target
+	 * @param[in] radius		The number of texels on each side of the center. Clamped to BLUR_MAX_RADIUS
+	 * @param[in] sigma			The gaussian's standard deviation in texels. 0 for radius / 2
+	 * @return					A status code. 0 for success. -1 if the textures are not the same size
+ 	*/
+	int8_t ImageKernels::blur(Texture& source, Texture& target, Texture& temporary, int radius, float sigma) {
+		int width, height, targetWidth, targetHeight, temporaryWidth, temporaryHeight;
+		source.getSize(&width, &height);
+		target.getSize(&targetWidth, &targetHeight);
+		temporary.getSize(&temporaryWidth, &temporaryHeight);
+
+		if (width != targetWidth || height != targetHeight || width != temporaryWidth || height != temporaryHeight) {
+			return -1;
+		}
+
+		if (this->blurKernel == nullptr) {
+			this->blurKernel = std::make_unique<Compute>(ImageKernels::getBlurSource().c_str(), ShaderType::RAW);
+		}
+
+		radius = std::min(std::max(radius, 0), static_cast<int>(BLUR_MAX_RADIUS));
+		if (sigma <= 0.f) {
+			sigma = std::max(radius * 0.5f, 0.5f);
+		}
+
+		Compute& kernel = *this->blurKernel;
+		kernel.use();
+		kernel.setInt("radius", radius);
+		kernel.setFloat("sigma", sigma);
+
+		// Horizontal: one group per tile of a row
+		kernel.setIVec2("direction", glm::ivec2(1, 0));
+		kernel.bindSampler(0, source).bindImage(0, temporary, GL_WRITE_ONLY);
+		kernel.dispatch((width + BLUR_TILE - 1) / BLUR_TILE, height);
+
+		// Vertical: one group per tile of a column
+		kernel.setIVec2("direction", glm::ivec2(0, 1));
+		kernel.bindSampler(0, temporary).bindImage(0, target, GL_WRITE_ONLY);
+		kernel.dispatch((height + BLUR_TILE - 1) / BLUR_TILE, width);
+
+		return 0;
+	}
+
+	/** @brief Average each 2x2 block of the source into one pixel of the target
+	 * @param[in] source	The texture to downsample
+	 * @param[in] target	The texture to write to. Half the size of the source, rounded up
+	 * @return				A status code. 0 for success. -1 if the target is too small
+ 	*/
+	int8_t ImageKernels::downsample(Texture& source, Texture& target) {
+		int width, height, targetWidth, targetHeight;
+		source.getSize(&width, &height);
+		target.getSize(&targetWidth, &targetHeight);
+
+		if (targetWidth < (width + 1) / 2 || targetHeight < (height + 1) / 2) {
+			return -1;
+		}
+
+		if (this->downsampleKernel == nullptr) {
+			this->downsampleKernel = std::make_unique<Compute>(ImageKernels::getDownsampleSource().c_str(), ShaderType::RAW);
+		}
+
+		Compute& kernel = *this->downsampleKernel;
+		kernel.bindSampler(0, source).bindImage(0, target, GL_WRITE_ONLY);
+
+		return kernel.dispatchImage((width + 1) / 2, (height + 1) / 2);
+	}
+
+	/** @brief Count the luminance of every pixel into HISTOGRAM_BINS bins. Each work group counts into shared memory first,
+	 *  so the global buffer only sees one atomic per bin per group
+	 * @param[in] source	The texture to read
+	 * @param[out] bins		Receives HISTOGRAM_BINS uints. It must already hold at least that many. It is cleared first
+	 * @param[in] minimum	The luminance mapped to the first bin
+	 * @param[in] maximum	The luminance mapped to the last bin
+	 * @return				A status code. 0 for success. -1 if the buffer is too small
+ 	*/
+	int8_t ImageKernels::histogram(Texture& source, SSBO& bins, float minimum, float maximum) {
+		if (bins.getSize() < HISTOGRAM_BINS * sizeof(GLuint)) {
+			return -1;
+		}
+
+		if (this->histogramKernel == nullptr) {
+			this->histogramKernel = std::make_unique<Compute>(ImageKernels::getHistogramSource().c_str(), ShaderType::RAW, 0);
+		}
+
+		int width, height;
+		source.getSize(&width, &height);
+
+		std::vector<GLuint> zeros(HISTOGRAM_BINS, 0);
+		bins.update(0, zeros.data(), zeros.size() * sizeof(GLuint));
+
+		Compute& kernel = *this->histogramKernel;
+		kernel.use();
+		kernel.setFloat("minimum", minimum);
+		kernel.setFloat("range", std::max(maximum - minimum, 1e-6f));
+		kernel.setSSBO(&bins);
+		kernel.bindSampler(0, source);
+
+		return kernel.dispatchImage(width, height);
+	}
+
+	/** @brief Get the GLSL of the blur kernel
+	 * @return The GLSL source
+ 	*/
+	std::string ImageKernels::getBlurSource() {
+		return std::string("#version 450 core\n") +
+		"#define TILE " + std::to_string(BLUR_TILE) + "\n"\
+		"#define MAX_RADIUS " + std::to_string(BLUR_MAX_RADIUS) + "\n"\
+		"layout (local_size_x = TILE) in;\n"\
+		"layout (binding = 0) uniform sampler2D source;\n"\
+		"layout (binding = 0) uniform writeonly image2D target;\n"\
+		"uniform ivec2 direction;\n"\
+		"uniform int radius;\n"\
+		"uniform float sigma;\n"\
+
+		"shared vec4 cache[TILE + 2 * MAX_RADIUS];\n"\
+
+		"void main() {\n"\
+			"ivec2 size = textureSize(source, 0);\n"\
+			"ivec2 across = direction.yx;\n"\
+			"int extent = size.x * direction.x + size.y * direction.y;\n"\
+			"int line = int(gl_WorkGroupID.y);\n"\
+			"int first = int(gl_WorkGroupID.x) * TILE;\n"\
+			"int lane = int(gl_LocalInvocationID.x);\n"\
+
+			// Load the tile and its apron, clamping at the edges
+			"for (int i = lane; i < TILE + 2 * radius; i += TILE) {\n"\
+				"int along = clamp(first - radius + i, 0, extent - 1);\n"\
+				"cache[i] = texelFetch(source, direction * along + across * line, 0);\n"\
+			"}\n"\
+			"barrier();\n"\
+
+			"int along = first + lane;\n"\
+			"if (along >= extent) {\n"\
+				"return;\n"\
+			"}\n"\
+
+			"vec4 sum = vec4(0.0);\n"\
+			"float total = 0.0;\n"\
+			"for (int i = -radius; i <= radius; i++) {\n"\
+				"float weight = exp(-float(i * i) / (2.0 * sigma * sigma));\n"\
+				"sum += cache[lane + radius + i] * weight;\n"\
+				"total += weight;\n"\
+			"}\n"\
+
+			"imageStore(target, direction * along + across * line, sum / total);\n"\
+		"}\n";
+	}
+
+	/** @brief Get the GLSL of the downsample kernel
+	 * @return The GLSL source
+ 	*/
+	std::string ImageKernels::getDownsampleSource() {
+		return std::string("#version 450 core\n") +
+		"layout (local_size_x = " + std::to_string(DOWNSAMPLE_LOCAL_SIZE) + ", local_size_y = " + std::to_string(DOWNSAMPLE_LOCAL_SIZE) + ") in;\n"\
+		"layout (binding = 0) uniform sampler2D source;\n"\
+		"layout (binding = 0) uniform writeonly image2D target;\n"\
+
+		"void main() {\n"\
+			"ivec2 size = textureSize(source, 0);\n"\
+			"ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"\
+			"if (any(greaterThanEqual(pixel * 2, size))) {\n"\
+				"return;\n"\
+			"}\n"\
+
+			// Odd edges repeat their last texel
+			"ivec2 base = pixel * 2;\n"\
+			"ivec2 last = size - 1;\n"\
+			"vec4 sum = texelFetch(source, base, 0)\n"\
+				"+ texelFetch(source, min(base + ivec2(1, 0), last), 0)\n"\
+				"+ texelFetch(source, min(base + ivec2(0, 1), last), 0)\n"\
+				"+ texelFetch(source, min(base + ivec2(1, 1), last), 0);\n"\
+
+			"imageStore(target, pixel, sum * 0.25);\n"\
+		"}\n";
+	}
+
+	/** @brief Get the GLSL of the histogram kernel
+	 * @return The GLSL source
+ 	*/
+	std::string ImageKernels::getHistogramSource() {
+		return std::string("#version 450 core\n") +
+		"#define BINS " + std::to_string(HISTOGRAM_BINS) + "\n"\
+		"layout (local_size_x = " + std::to_string(HISTOGRAM_LOCAL_SIZE) + ", local_size_y = " + std::to_string(HISTOGRAM_LOCAL_SIZE) + ") in;\n"\
+		"layout (binding = 0) uniform sampler2D source;\n"\
+		"layout (std430, binding = 0) buffer HistogramBuffer { uint bins[]; };\n"\
+		"uniform float minimum;\n"\
+		"uniform float range;\n"\
+
+		"shared uint localBins[BINS];\n"\
+
+		"void main() {\n"\
+			// One bin per invocation
+			"uint lane = gl_LocalInvocationIndex;\n"\
+			"localBins[lane] = 0u;\n"\
+			"barrier();\n"\
+
+			"ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"\
+			"if (all(lessThan(pixel, textureSize(source, 0)))) {\n"\
+				"vec3 rgb = texelFetch(source, pixel, 0).rgb;\n"\
+				"float luminance = dot(rgb, vec3(0.2126, 0.7152, 0.0722));\n"\
+				"int bin = clamp(int((luminance - minimum) / range * float(BINS)), 0, BINS - 1);\n"\
+				"atomicAdd(localBins[bin], 1u);\n"\
+			"}\n"\
+			"barrier();\n"\
+
+			"if (localBins[lane] != 0u) {\n"\
+				"atomicAdd(bins[lane], localBins[lane]);\n"\
+			"}\n"\
+		"}\n";
+	}
+}
@@ -0,0 +1,469 @@
+#include "oglopp/particles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <iostream>
+
+namespace oglopp {
+
+	/** @brief Create a particle pool. Every particle starts dead
+	 * @param[in] capacity	The most particles alive at once
+ 	*/
+	ParticleSystem::ParticleSystem(uint32_t capacity) : capacity(std::max<uint32_t>(capacity, 1)), dispatchArgs(1), drawCommand(1) {
+		this->particles.resize(this->capacity, false);
+
+		// The dead list starts full, so particle i is the i-th from the end to be emitted
+		std::vector<GLuint> indices(this->capacity);
+		for (uint32_t i = 0; i < this->capacity; i++) {
+			indices[i] = this->capacity - 1 - i;
+		}
+		this->deadList.load(indices.data(), indices.size() * sizeof(GLuint));
+
+		std::vector<GLuint> zeros(this->capacity * 2, 0);
+		this->aliveLists.load(zeros.data(), zeros.size() * sizeof(GLuint));
+
+		// deadCount, aliveCount[2], padding
+		GLint counts[4] = {static_cast<GLint>(this->capacity), 0, 0, 0};
+		this->counters.load(counts, sizeof(counts));
+
+		std::string header = ParticleSystem::getKernelHeader(LOCAL_SIZE);
+		std::string single = ParticleSystem::getKernelHeader(1);
+
+		// Pops a dead particle per invocation and appends it to the current alive list
+		this->emitKernel = std::make_unique<Compute>((header + Compute::ELEMENT_INDEX_FUNCTION +
+		"uniform uint seed;\n"\
+		"uniform vec3 emitPosition;\n"\
+		"uniform vec3 emitVelocity;\n"\
+		"uniform float spread;\n"\
+		"uniform float lifetime;\n"\
+		"uniform float lifetimeVariance;\n"\
+		"uniform float startSize;\n"\
+		"uniform float endSize;\n"\
+		"uniform float spin;\n"\
+		"uniform uint startColor;\n"\
+		"uniform uint endColor;\n"\
+		\
+		"uint hash(uint x) {\n"\
+			"x ^= x >> 16; x *= 0x7feb352du;\n"\
+			"x ^= x >> 15; x *= 0x846ca68bu;\n"\
+			"return x ^ (x >> 16);\n"\
+		"}\n"\
+		\
+		// Uniform in [-1, 1]
+		"float random(inout uint state) {\n"\
+			"state = hash(state);\n"\
+			"return float(state) / 2147483647.5 - 1.0;\n"\
+		"}\n"\
+		\
+		"void main() {\n"\
+			"uint index = elementIndex();\n"\
+			"if (index >= elementCount) {\n"\
+				"return;\n"\
+			"}\n"\
+			\
+			// Emits run alone, so the dead list only shrinks here. Overshooting below zero is put back
+			"int available = atomicAdd(deadCount, -1);\n"\
+			"if (available <= 0) {\n"\
+				"atomicAdd(deadCount, 1);\n"\
+				"return;\n"\
+			"}\n"\
+			"uint particle = dead[available - 1];\n"\
+			\
+			"uint state = hash(index ^ hash(seed));\n"\
+			"Particle p;\n"\
+			"p.position = vec4(emitPosition, 0.0);\n"\
+			"p.velocity.xyz = emitVelocity + vec3(random(state), random(state), random(state)) * spread;\n"\
+			"p.velocity.w = max(lifetime + random(state) * lifetimeVariance, 0.001);\n"\
+			"p.size = vec4(startSize, endSize, random(state) * 3.14159265, random(state) * spin);\n"\
+			"p.color = uvec4(startColor, endColor, 0, 0);\n"\
+			"particles[particle] = p;\n"\
+			\
+			"alive[current * capacity + atomicAdd(aliveCount[current], 1)] = particle;\n"\
+		"}\n").c_str(), ShaderType::RAW);
+
+		// Sizes the update dispatch from the alive count and empties the list it appends to
+		this->prepareKernel = std::make_unique<Compute>((single + DispatchIndirectBuffer::getDeclaration(COMMANDS) +
+		"void main() {\n"\
+			"uint groups = (aliveCount[current] + " + std::to_string(LOCAL_SIZE - 1) + ") / " + std::to_string(LOCAL_SIZE) + ";\n"\
+			"commandCount = 1;\n"\
+			"commands[0].numGroupsX = clamp(groups, 1u, " + std::to_string(MAX_UPDATE_GROUPS) + "u);\n"\
+			"commands[0].numGroupsY = 1;\n"\
+			"commands[0].numGroupsZ = 1;\n"\
+			"aliveCount[1 - current] = 0;\n"\
+		"}\n").c_str(), ShaderType::RAW);
+
+		// Ages and moves the live particles, appending survivors to the other list and retiring the rest
+		this->updateKernel = std::make_unique<Compute>((header +
+		"uniform float dt;\n"\
+		"uniform vec3 gravity;\n"\
+		"uniform float drag;\n"\
+		\
+		"void main() {\n"\
+			"uint count = aliveCount[current];\n"\
+			"uint next = 1 - current;\n"\
+			"uint stride = gl_NumWorkGroups.x * gl_WorkGroupSize.x;\n"\
+			\
+			"for (uint i = gl_GlobalInvocationID.x; i < count; i += stride) {\n"\
+				"uint index = alive[current * capacity + i];\n"\
+				"Particle p = particles[index];\n"\
+				\
+				"p.position.w += dt;\n"\
+				"if (p.position.w >= p.velocity.w) {\n"\
+					"dead[atomicAdd(deadCount, 1)] = index;\n"\
+					"continue;\n"\
+				"}\n"\
+				\
+				"p.velocity.xyz = (p.velocity.xyz + gravity * dt) * max(1.0 - drag * dt, 0.0);\n"\
+				"p.position.xyz += p.velocity.xyz * dt;\n"\
+				"particles[index] = p;\n"\
+				\
+				"alive[next * capacity + atomicAdd(aliveCount[next], 1)] = index;\n"\
+			"}\n"\
+		"}\n").c_str(), ShaderType::RAW);
+
+		// Writes the instance count of the draw
+		this->finalizeKernel = std::make_unique<Compute>((single + DrawArraysIndirectBuffer::getDeclaration(COMMANDS) +
+		"void main() {\n"\
+			"commandCount = 1;\n"\
+			"commands[0].count = 6;\n"\
+			"commands[0].instanceCount = aliveCount[current];\n"\
+			"commands[0].first = 0;\n"\
+			"commands[0].baseInstance = 0;\n"\
+		"}\n").c_str(), ShaderType::RAW);
+
+		// Depth keys for sorting back to front. Past the alive count, keys sort last
+		this->sortKeysKernel = std::make_unique<Compute>((header + Compute::ELEMENT_INDEX_FUNCTION +
+		"layout (std430, binding = " + std::to_string(SORT_KEYS) + ") writeonly buffer SortKeys { uint keys[]; };\n"\
+		"layout (std430, binding = " + std::to_string(SORT_VALUES) + ") writeonly buffer SortValues { uint values[]; };\n"\
+		"uniform mat4 view;\n"\
+		"uniform float far;\n"\
+		\
+		"void main() {\n"\
+			"uint i = elementIndex();\n"\
+			"if (i >= elementCount) {\n"\
+				"return;\n"\
+			"}\n"\
+			\
+			"if (i >= aliveCount[current]) {\n"\
+				"keys[i] = 0xFFFFu;\n"\
+				"values[i] = 0;\n"\
+				"return;\n"\
+			"}\n"\
+			\
+			"uint index = alive[current * capacity + i];\n"\
+			"float depth = -(view * vec4(particles[index].position.xyz, 1.0)).z;\n"\
+			"keys[i] = 0xFFFEu - uint(clamp(depth / far, 0.0, 1.0) * 65534.0);\n"\
+			"values[i] = index;\n"\
+		"}\n").c_str(), ShaderType::RAW);
+
+		// The billboards are read straight from the pool, in the order of the alive list or the sorted one
+		this->renderer = std::make_unique<BillboardRenderer>(BillboardRenderer::CAMERA_FACING, ParticleSystem::getPoolDeclaration("readonly") +
+		"layout (std430, binding = " + std::to_string(ALIVE_LISTS) + ") readonly buffer DrawOrder { uint order[]; };\n"\
+		"uniform uint orderOffset;\n"\
+		\
+		"Billboard fetchBillboard(uint instance) {\n"\
+			"Particle p = particles[order[orderOffset + instance]];\n"\
+			"float t = clamp(p.position.w / p.velocity.w, 0.0, 1.0);\n"\
+			"vec4 color = mix(unpackUnorm4x8(p.color.x), unpackUnorm4x8(p.color.y), t);\n"\
+			"return Billboard(p.position.xyz, mix(p.size.x, p.size.y, t), color, p.size.z + p.size.w * p.position.w);\n"\
+		"}\n");
+		this->renderer->setBlendMode(BillboardRenderer::ADDITIVE);
+	}
+
+	/** @brief Add an emitter, run by every update()
+	 * @param[in] emitter	The emitter settings
+	 * @return				The emitter index
+ 	*/
+	size_t ParticleSystem::addEmitter(Emitter const& emitter) {
+		this->emitters.push_back(emitter);
+		this->emitCarry.push_back(0.0);
+
+		return this->emitters.size() - 1;
+	}
+
+	/** @brief Get an emitter to change its settings
+	 * @param[in] index		The emitter index
+	 * @return				A reference to the emitter
+ 	*/
+	ParticleSystem::Emitter& ParticleSystem::getEmitter(size_t index) {
+		return this->emitters.at(index);
+	}
+
+	/** @brief Get the number of emitters
+	 * @return The emitter count
+ 	*/
+	size_t ParticleSystem::getEmitterCount() const {
+		return this->emitters.size();
+	}
+
+	/** @brief Bind the pool, lists and counters to a kernel
+	 * @param[in] kernel	The kernel about to be dispatched
+ 	*/
+	void ParticleSystem::bindPool(Compute& kernel) {
+		kernel.bindSSBO(PARTICLES, this->particles);
+		kernel.bindSSBO(DEAD_LIST, this->deadList);
+		kernel.bindSSBO(ALIVE_LISTS, this->aliveLists);
+		kernel.bindSSBO(COUNTERS, this->counters);
+
+		kernel.setUInt("capacity", this->capacity);
+		kernel.setUInt("current", this->current);
+	}
+
+	/** @brief Emit a burst of particles now. They are simulated from the next update()
+	 * @param[in] emitter	The emitter settings. The rate is ignored
+	 * @param[in] count		The number of particles
+	 * @return				A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::emit(Emitter const& emitter, uint32_t count) {
+		if (count == 0) {
+			return *this;
+		}
+
+		Compute& kernel = *this->emitKernel;
+		kernel.use();
+		this->bindPool(kernel);
+
+		kernel.setUInt("seed", this->seed++);
+		kernel.setVec3("emitPosition", emitter.position);
+		kernel.setVec3("emitVelocity", emitter.velocity);
+		kernel.setFloat("spread", emitter.spread);
+		kernel.setFloat("lifetime", emitter.lifetime);
+		kernel.setFloat("lifetimeVariance", emitter.lifetimeVariance);
+		kernel.setFloat("startSize", emitter.startSize);
+		kernel.setFloat("endSize", emitter.endSize);
+		kernel.setFloat("spin", emitter.spin);
+		kernel.setUInt("startColor", glm::packUnorm4x8(emitter.startColor));
+		kernel.setUInt("endColor", glm::packUnorm4x8(emitter.endColor));
+
+		kernel.dispatchElements(std::min(count, this->capacity));
+
+		return *this;
+	}
+
+	/** @brief Run the emitters, then age, move and retire every live particle
+	 * @param[in] dt	The time step in seconds
+	 * @return			A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::update(float dt) {
+		for (size_t i = 0; i < this->emitters.size(); i++) {
+			if (!this->emitters[i].enabled) {
+				continue;
+			}
+
+			this->emitCarry[i] += static_cast<double>(this->emitters[i].rate) * dt;
+			double whole = std::floor(this->emitCarry[i]);
+			this->emitCarry[i] -= whole;
+
+			this->emit(this->emitters[i], static_cast<uint32_t>(std::min(whole, static_cast<double>(this->capacity))));
+		}
+
+		this->prepareKernel->use();
+		this->bindPool(*this->prepareKernel);
+		this->prepareKernel->bindSSBO(COMMANDS, this->dispatchArgs);
+		this->prepareKernel->dispatch(static_cast<Compute::group_t>(1));
+
+		this->updateKernel->use();
+		this->bindPool(*this->updateKernel);
+		this->updateKernel->setFloat("dt", dt);
+		this->updateKernel->setVec3("gravity", this->gravity);
+		this->updateKernel->setFloat("drag", this->drag);
+		this->updateKernel->dispatchIndirect(this->dispatchArgs);
+
+		// The survivors are on the other list now
+		this->current = 1 - this->current;
+
+		this->finalizeKernel->use();
+		this->bindPool(*this->finalizeKernel);
+		this->finalizeKernel->bindSSBO(COMMANDS, this->drawCommand);
+		this->finalizeKernel->dispatch(static_cast<Compute::group_t>(1));
+
+		return *this;
+	}
+
+	/** @brief Draw the live particles. Call after the camera's projection and view are updated for the frame
+	 * @param[in] window	The window whose camera to draw from
+	 * @return				A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::draw(Window& window) {
+		glm::mat4 view(window.getCam().getView());
+
+		SSBO* order = &this->aliveLists;
+		GLuint orderOffset = this->current * this->capacity;
+
+		if (this->sorting) {
+			if (this->primitives == nullptr) {
+				this->primitives = std::make_unique<ComputePrimitives>();
+			}
+
+			if (this->sortKeys.getSize() < this->capacity * sizeof(GLuint)) {
+				std::vector<GLuint> zeros(this->capacity, 0);
+				this->sortKeys.load(zeros.data(), zeros.size() * sizeof(GLuint));
+				this->sortValues.load(zeros.data(), zeros.size() * sizeof(GLuint));
+			}
+
+			Compute& kernel = *this->sortKeysKernel;
+			kernel.use();
+			this->bindPool(kernel);
+			kernel.bindSSBO(SORT_KEYS, this->sortKeys, GL_WRITE_ONLY);
+			kernel.bindSSBO(SORT_VALUES, this->sortValues, GL_WRITE_ONLY);
+			kernel.setMat4("view", view);
+			kernel.setFloat("far", static_cast<float>(window.getCam().getFar()));
+			kernel.dispatchElements(this->capacity);
+
+			this->primitives->sort(this->sortKeys, &this->sortValues, this->capacity, 16);
+
+			order = &this->sortValues;
+			orderOffset = 0;
+		}
+
+		this->renderer->getShader().use();
+		this->renderer->getShader().setUInt("orderOffset", orderOffset);
+
+		this->particles.sync(GL_SHADER_STORAGE_BARRIER_BIT).bind(PARTICLES);
+		order->sync(GL_SHADER_STORAGE_BARRIER_BIT).bind(ALIVE_LISTS);
+
+		this->renderer->drawIndirect(window, this->drawCommand);
+
+		return *this;
+	}
+
+	/** @brief Set the acceleration applied to every particle
+	 * @param[in] gravity	The acceleration
+	 * @return				A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::setGravity(glm::vec3 const& gravity) {
+		this->gravity = gravity;
+
+		return *this;
+	}
+
+	/** @brief Set the fraction of velocity lost per second
+	 * @param[in] drag	The drag
+	 * @return			A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::setDrag(float drag) {
+		this->drag = drag;
+
+		return *this;
+	}
+
+	/** @brief Draw back to front, sorted on the GPU every draw
+	 * @param[in] sorting	True to sort
+	 * @return				A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::setSorting(bool sorting) {
+		this->sorting = sorting;
+
+		return *this;
+	}
+
+	/** @brief Set how particles blend with what is behind them
+	 * @param[in] mode	The blend mode. ALPHA looks right with sorting on
+	 * @return			A reference to this object
+ 	*/
+	ParticleSystem& ParticleSystem::setBlendMode(BillboardRenderer::BlendMode mode) {
+		this->renderer->setBlendMode(mode);
+
+		return *this;
+	}
+
+	/** @brief Get the pool size
+	 * @return The most particles alive at once
+ 	*/
+	uint32_t ParticleSystem::getCapacity() const {
+		return this->capacity;
+	}
+
+	/** @brief Get the particle pool, eg. to draw it some other way
+	 * @return The particles. Dead ones hold stale data
+ 	*/
+	TypedSSBO<ParticleSystem::Particle>& ParticleSystem::getParticles() {
+		return this->particles;
+	}
+
+	/** @brief Get the draw command written by the last update(). Its instance count is the number of live particles
+	 * @return The draw command buffer
+ 	*/
+	DrawArraysIndirectBuffer& ParticleSystem::getDrawCommand() {
+		return this->drawCommand;
+	}
+
+	/** @brief Read the lists back and check that every particle is on exactly one of them. This waits for the GPU
+	 * @param[out] alive	The number of live particles, or nullptr
+	 * @return				A status code. 0 if the lists are consistent. -1 otherwise
+ 	*/
+	int8_t ParticleSystem::validate(uint32_t* alive) {
+		GLint counts[4];
+		std::memcpy(counts, this->counters.map(SSBO::READ), sizeof(counts));
+		this->counters.unmap();
+
+		int64_t deadCount = counts[0];
+		int64_t aliveCount = counts[1 + this->current];
+
+		if (alive != nullptr) {
+			*alive = static_cast<uint32_t>(std::max<int64_t>(aliveCount, 0));
+		}
+
+		if (deadCount < 0 || aliveCount < 0 || deadCount + aliveCount != this->capacity) {
+			std::cout << "[Oglopp] Particle lists hold " << deadCount << " dead and " << aliveCount << " live particles, but the pool holds " << this->capacity << std::endl;
+			return -1;
+		}
+
+		std::vector<uint8_t> seen(this->capacity, 0);
+		int8_t status = 0;
+
+		auto check = [&](const GLuint* list, int64_t count, const char* name) {
+			for (int64_t i = 0; i < count && status == 0; i++) {
+				if (list[i] >= this->capacity || seen[list[i]]++ != 0) {
+					std::cout << "[Oglopp] Particle " << list[i] << " on the " << name << " list is out of range or listed twice" << std::endl;
+					status = -1;
+				}
+			}
+		};
+
+		check(static_cast<const GLuint*>(this->deadList.map(SSBO::READ)), deadCount, "dead");
+		this->deadList.unmap();
+
+		check(static_cast<const GLuint*>(this->aliveLists.map(SSBO::READ)) + this->current * this->capacity, aliveCount, "alive");
+		this->aliveLists.unmap();
+
+		return status;
+	}
+
+	/** @brief Get the GLSL shared by every kernel: the particle struct, the pool, the lists and the counters
+	 * @param[in] localSize		The local size of the kernel
+	 * @return					The source, starting with the #version line
+ 	*/
+	std::string ParticleSystem::getKernelHeader(uint32_t localSize) {
+		return
+		"#version 450 core\n"\
+		"layout (local_size_x = " + std::to_string(localSize) + ") in;\n" +
+		ParticleSystem::getPoolDeclaration("") +
+		"layout (std430, binding = " + std::to_string(DEAD_LIST) + ") buffer DeadList { uint dead[]; };\n"\
+		"layout (std430, binding = " + std::to_string(ALIVE_LISTS) + ") buffer AliveLists { uint alive[]; };\n"\
+		"layout (std430, binding = " + std::to_string(COUNTERS) + ") buffer ParticleCounters {\n"\
+			"int deadCount;\n"\
+			"uint aliveCount[2];\n"\
+			"uint counterPad;\n"\
+		"};\n"\
+		"uniform uint capacity;\n"\
+		"uniform uint current;\n";
+	}
+
+	/** @brief Get the GLSL of the particle struct and the pool block
+	 * @param[in] qualifier		The block memory qualifier, eg. readonly, or an empty string
+	 * @return					The source
+ 	*/
+	std::string ParticleSystem::getPoolDeclaration(std::string const& qualifier) {
+		return
+		"struct Particle {\n"\
+			"vec4 position;\n"\
+			"vec4 velocity;\n"\
+			"vec4 size;\n"\
+			"uvec4 color;\n"\
+		"};\n"\
+		"layout (std430, binding = " + std::to_string(PARTICLES) + ") " + qualifier + " buffer Particles { Particle particles[]; };\n";
+	}
+}
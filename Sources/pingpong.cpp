@@ -0,0 +1,132 @@
+#include "oglopp/pingpong.h"
+
+#include <iostream>
+
+namespace oglopp {
+
+	/** @brief Create the buffer pair. Nothing is allocated until load()
+	 * @param[in] readBinding	The binding of the current state
+	 * @param[in] writeBinding	The binding of the next state
+ 	*/
+	PingPongBuffer::PingPongBuffer(GLuint readBinding, GLuint writeBinding) : readBinding(readBinding), writeBinding(writeBinding) {}
+
+	/** @brief Load the same initial state into both buffers
+	 * @param[in] buffer	A pointer to the initial state
+	 * @param[in] size		The size of the state in bytes
+	 * @return				A status code. 0 for success. -1 for failure
+ 	*/
+	int8_t PingPongBuffer::load(void* buffer, size_t size) {
+		if (this->buffers[0].load(buffer, size) != 0 || this->buffers[1].load(buffer, size) != 0) {
+			return -1;
+		}
+
+		this->current = 0;
+		this->steps = 0;
+
+		return 0;
+	}
+
+	/** @brief Change the binding points
+	 * @param[in] readBinding	The binding of the current state
+	 * @param[in] writeBinding	The binding of the next state
+	 * @return					A reference to this object
+ 	*/
+	PingPongBuffer& PingPongBuffer::setBindings(GLuint readBinding, GLuint writeBinding) {
+		this->readBinding = readBinding;
+		this->writeBinding = writeBinding;
+
+		return *this;
+	}
+
+	/** @brief Bind the current state for reading and the other buffer for writing
+	 * @param[in] compute	The compute program about to be dispatched
+	 * @return				A reference to this object
+ 	*/
+	PingPongBuffer& PingPongBuffer::bind(Compute& compute) {
+		compute.bindSSBO(this->readBinding, this->getRead(), GL_READ_ONLY);
+		compute.bindSSBO(this->writeBinding, this->getWrite(), GL_WRITE_ONLY);
+
+		return *this;
+	}
+
+	/** @brief Make the buffer last written the current state
+	 * @return A reference to this object
+ 	*/
+	PingPongBuffer& PingPongBuffer::swap() {
+		this->current ^= 1;
+		this->steps++;
+
+		return *this;
+	}
+
+	/** @brief Run some number of simulation substeps, each reading the state the previous one wrote.
+	 *  The shader uses Compute::ELEMENT_INDEX_FUNCTION
+	 * @param[in] compute		The compute program
+	 * @param[in] elements		The number of elements to dispatch per substep
+	 * @param[in] substeps		The number of substeps
+	 * @param[in] perSubstep	Called before every dispatch with the substep index, or nullptr
+	 * @return					A status code. 0 for success. -1 if a dispatch failed
+ 	*/
+	int8_t PingPongBuffer::step(Compute& compute, uint32_t elements, uint32_t substeps, SubstepFunction const& perSubstep) {
+		if (this->buffers[0].getSize() == 0) {
+			std::cout << "[Oglopp] PingPongBuffer::step before load()" << std::endl;
+			return -1;
+		}
+
+		compute.use();
+
+		for (uint32_t i = 0; i < substeps; i++) {
+			if (perSubstep != nullptr) {
+				perSubstep(compute, i);
+			}
+
+			// The read buffer was written by the previous substep, so binding it issues the one barrier needed
+			this->bind(compute);
+
+			if (compute.dispatchElements(elements) != 0) {
+				return -1;
+			}
+
+			this->swap();
+		}
+
+		return 0;
+	}
+
+	/** @brief Get the buffer holding the current state
+	 * @return The current state
+ 	*/
+	SSBO& PingPongBuffer::getRead() {
+		return this->buffers[this->current];
+	}
+
+	/** @brief Get the buffer the next substep writes
+	 * @return The next state
+ 	*/
+	SSBO& PingPongBuffer::getWrite() {
+		return this->buffers[this->current ^ 1];
+	}
+
+	/** @brief Get the number of swaps so far
+	 * @return The step count
+ 	*/
+	uint64_t PingPongBuffer::getStepCount() const {
+		return this->steps;
+	}
+
+	/** @brief Get the GLSL declaration of both blocks, as arrays of some type named current and next
+	 * @param[in] type			The element type, eg. vec4 or a struct declared before it
+	 * @param[in] readBinding	The binding of the current state
+	 * @param[in] writeBinding	The binding of the next state
+	 * @return					The GLSL source
+ 	*/
+	std::string PingPongBuffer::getDeclaration(std::string const& type, GLuint readBinding, GLuint writeBinding) {
+		return
+		"layout (std430, binding = " + std::to_string(readBinding) + ") readonly buffer PingPongRead {\n"\
+			+ type + " current[];\n"\
+		"};\n"\
+		"layout (std430, binding = " + std::to_string(writeBinding) + ") writeonly buffer PingPongWrite {\n"\
+			+ type + " next[];\n"\
+		"};\n";
+	}
+}
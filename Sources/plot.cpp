@@ -0,0 +1,364 @@
+#include "oglopp/plot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace oglopp {
+
+	LinePlot::LinePlot() {
+		this->shader = std::make_unique<Shader>(
+		"#version 450 core\n"\
+		"layout (std430, binding = 0) readonly buffer PlotPoints { vec2 points[]; };\n"\
+		\
+		"uniform vec2 scale;\n"\
+		"uniform vec2 offset;\n"\
+		"uniform vec2 viewport;\n"\
+		"uniform float halfWidth;\n"\
+		\
+		"out vec2 pixel;\n"\
+		"flat out vec2 from;\n"\
+		"flat out vec2 to;\n"\
+		\
+		// x runs along the segment from its start to its end, y across it
+		"const vec2 corners[6] = vec2[](vec2(0.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(0.0, -1.0), vec2(1.0, 1.0), vec2(0.0, 1.0));\n"\
+		\
+		"void main() {\n"\
+			// The segment's ends in pixels
+			"from = ((points[gl_InstanceID] * scale + offset) * 0.5 + 0.5) * viewport;\n"\
+			"to = ((points[gl_InstanceID + 1] * scale + offset) * 0.5 + 0.5) * viewport;\n"\
+			\
+			"vec2 direction = to - from;\n"\
+			"float len = length(direction);\n"\
+			"direction = len > 0.0 ? direction / len : vec2(1.0, 0.0);\n"\
+			"vec2 normal = vec2(-direction.y, direction.x);\n"\
+			\
+			// Past the ends for the round caps, and a pixel more for the antialiasing
+			"float extent = halfWidth + 1.0;\n"\
+			"vec2 corner = corners[gl_VertexID];\n"\
+			"pixel = mix(from - direction * extent, to + direction * extent, corner.x) + normal * corner.y * extent;\n"\
+			\
+			"gl_Position = vec4(pixel / viewport * 2.0 - 1.0, 0.0, 1.0);\n"\
+		"}\n",
+		\
+		"#version 450 core\n"\
+		"in vec2 pixel;\n"\
+		"flat in vec2 from;\n"\
+		"flat in vec2 to;\n"\
+		"out vec4 FragColor;\n"\
+		\
+		"uniform vec4 color;\n"\
+		"uniform float halfWidth;\n"\
+		\
+		"void main() {\n"\
+			// The distance to the nearest point of the segment makes a capsule, so neighbouring segments join round
+			"vec2 segment = to - from;\n"\
+			"float along = dot(segment, segment) > 0.0 ? clamp(dot(pixel - from, segment) / dot(segment, segment), 0.0, 1.0) : 0.0;\n"\
+			"float distance = length(pixel - from - segment * along);\n"\
+			\
+			"float coverage = clamp(halfWidth + 0.5 - distance, 0.0, 1.0);\n"\
+			"if (coverage <= 0.0) {\n"\
+				"discard;\n"\
+			"}\n"\
+			"FragColor = vec4(color.rgb, color.a * coverage);\n"\
+		"}\n", ShaderType::RAW);
+
+		// Core profiles need a vertex array bound to draw, even with no attributes
+		glGenVertexArrays(1, &this->vao);
+	}
+
+	LinePlot::~LinePlot() {
+		if (this->vao != 0) {
+			glDeleteVertexArrays(1, &this->vao);
+		}
+	}
+
+	/** @brief Replace the series and rebuild the pyramid
+	 * @param[in] samples	The values, evenly spaced along x
+	 * @param[in] start		The x of the first sample
+	 * @param[in] step		The x distance between samples. Must be positive
+	 * @return				A reference to this object
+ 	*/
+	LinePlot& LinePlot::setData(std::span<const float> samples, double start, double step) {
+		this->samples.assign(samples.begin(), samples.end());
+		this->start = start;
+		this->step = step;
+		this->levels.clear();
+		this->dirty = true;
+
+		if (this->samples.size() < 2) {
+			return *this;
+		}
+
+		// The first level pairs up samples, every other one pairs up the runs below it. An odd run out is carried up alone
+		std::vector<glm::vec2> level((this->samples.size() + 1) / 2);
+		for (size_t i = 0; i < level.size(); i++) {
+			float a = this->samples[i * 2];
+			float b = i * 2 + 1 < this->samples.size() ? this->samples[i * 2 + 1] : a;
+			level[i] = glm::vec2(std::min(a, b), std::max(a, b));
+		}
+		this->levels.push_back(std::move(level));
+
+		while (this->levels.back().size() > 1) {
+			std::vector<glm::vec2> const& below = this->levels.back();
+			std::vector<glm::vec2> above((below.size() + 1) / 2);
+
+			for (size_t i = 0; i < above.size(); i++) {
+				glm::vec2 a = below[i * 2];
+				glm::vec2 b = i * 2 + 1 < below.size() ? below[i * 2 + 1] : a;
+				above[i] = glm::vec2(std::min(a.x, b.x), std::max(a.y, b.y));
+			}
+
+			this->levels.push_back(std::move(above));
+		}
+
+		return *this;
+	}
+
+	/** @brief Set the part of the plot which fills the viewport
+	 * @param[in] xMin	The x at the left edge
+	 * @param[in] xMax	The x at the right edge
+	 * @param[in] yMin	The y at the bottom edge
+	 * @param[in] yMax	The y at the top edge
+	 * @return			A reference to this object
+ 	*/
+	LinePlot& LinePlot::setView(double xMin, double xMax, float yMin, float yMax) {
+		// Only x decides which points are written. y is applied in the vertex shader
+		this->dirty = this->dirty || xMin != this->xMin || xMax != this->xMax;
+
+		this->xMin = xMin;
+		this->xMax = xMax;
+		this->yMin = yMin;
+		this->yMax = yMax;
+
+		return *this;
+	}
+
+	/** @brief Set the view to the whole series, from the lowest to the highest sample
+	 * @return A reference to this object
+ 	*/
+	LinePlot& LinePlot::fitView() {
+		if (this->samples.empty()) {
+			return *this;
+		}
+
+		double end = this->start + (this->samples.size() - 1) * this->step;
+		glm::vec2 range = this->getRange(this->start, end);
+
+		// A flat series still needs some height to map to
+		float margin = range.y > range.x ? (range.y - range.x) * 0.05f : 1.0f;
+
+		return this->setView(this->start, std::max(end, this->start + this->step), range.x - margin, range.y + margin);
+	}
+
+	/** @brief Get the lowest and highest sample between two x values, from the pyramid
+	 * @param[in] xMin	The start of the range
+	 * @param[in] xMax	The end of the range
+	 * @return			The lowest sample in x and the highest in y. Both 0 with no samples in the range
+ 	*/
+	glm::vec2 LinePlot::getRange(double xMin, double xMax) const {
+		double first = std::ceil((xMin - this->start) / this->step);
+		double last = std::floor((xMax - this->start) / this->step);
+		first = std::max(first, 0.0);
+		last = std::min(last, static_cast<double>(this->samples.size()) - 1.0);
+
+		if (this->samples.empty() || first > last) {
+			return glm::vec2(0.0);
+		}
+
+		// Climb the pyramid from both ends, taking a run whenever its sibling is outside the range, so it reads O(log n) runs
+		glm::vec2 range(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+		size_t a = static_cast<size_t>(first);
+		size_t b = static_cast<size_t>(last) + 1;
+
+		auto take = [&](uint32_t level, size_t index) {
+			glm::vec2 run = level == 0 ? glm::vec2(this->samples[index]) : this->levels[level - 1][index];
+			range = glm::vec2(std::min(range.x, run.x), std::max(range.y, run.y));
+		};
+
+		for (uint32_t level = 0; a < b; level++) {
+			if (a & 1) {
+				take(level, a++);
+			}
+			if (b & 1) {
+				take(level, --b);
+			}
+
+			a >>= 1;
+			b >>= 1;
+		}
+
+		return range;
+	}
+
+	/** @brief Set the line color
+	 * @param[in] color	The color
+	 * @return			A reference to this object
+ 	*/
+	LinePlot& LinePlot::setColor(glm::vec4 const& color) {
+		this->color = color;
+
+		return *this;
+	}
+
+	/** @brief Set the line width
+	 * @param[in] pixels	The width in pixels
+	 * @return				A reference to this object
+ 	*/
+	LinePlot& LinePlot::setWidth(float pixels) {
+		this->width = pixels;
+
+		return *this;
+	}
+
+	/** @brief Write the points of the view for the viewport width into the next region of the ring
+ 	*/
+	void LinePlot::stream() {
+		this->points = 0;
+		this->pointsOrigin = this->xMin;
+
+		// One or two runs a pixel. Below two samples a pixel, the samples themselves
+		double samplesPerPixel = (this->xMax - this->xMin) / this->step / std::max(this->viewportWidth, 1);
+		this->level = samplesPerPixel < 2.0 ? 0 : static_cast<uint32_t>(std::min<double>(std::floor(std::log2(samplesPerPixel)), this->levels.size()));
+
+		size_t run = size_t(1) << this->level;
+		size_t runs = this->level == 0 ? this->samples.size() : this->levels[this->level - 1].size();
+
+		// One run past each edge, so the line leaves the view instead of stopping short of it
+		double first = std::floor((this->xMin - this->start) / this->step / run) - 1.0;
+		double last = std::ceil((this->xMax - this->start) / this->step / run) + 1.0;
+		first = std::max(first, 0.0);
+		last = std::min(last, static_cast<double>(runs) - 1.0);
+
+		if (first > last) {
+			return;
+		}
+
+		size_t firstRun = static_cast<size_t>(first);
+		size_t lastRun = static_cast<size_t>(last);
+		size_t needed = (lastRun - firstRun + 1) * (this->level == 0 ? 1 : 2);
+
+		// The ring only grows, to a little over what the widest view so far needed
+		if (this->ring.size() < needed) {
+			std::vector<glm::vec2> empty(needed + needed / 4 + 16, glm::vec2(0.0));
+			if (this->ring.assignPersistent(empty) != 0) {
+				this->ring.assign(empty);
+			}
+		}
+
+		// Without persistent storage, the points go through a copy instead
+		std::vector<glm::vec2> staging;
+		std::span<glm::vec2> out = this->ring.writeSpan(this->frame++);
+		if (out.empty()) {
+			staging.resize(needed);
+			out = staging;
+		}
+
+		for (size_t j = firstRun; j <= lastRun; j++) {
+			if (this->level == 0) {
+				double x = this->start + j * this->step;
+				out[this->points++] = glm::vec2(x - this->pointsOrigin, this->samples[j]);
+				continue;
+			}
+
+			// Strokes alternate up and down, so each one starts where the last one ended
+			double x = this->start + (j * run + (run - 1) * 0.5) * this->step;
+			glm::vec2 extremes = this->levels[this->level - 1][j];
+			float from = j % 2 == 0 ? extremes.x : extremes.y;
+			float to = j % 2 == 0 ? extremes.y : extremes.x;
+
+			out[this->points++] = glm::vec2(x - this->pointsOrigin, from);
+			out[this->points++] = glm::vec2(x - this->pointsOrigin, to);
+		}
+
+		if (!staging.empty()) {
+			this->ring.set(0, staging);
+		}
+	}
+
+	/** @brief Draw the view of the series over the current viewport
+	 * @return A reference to this object
+ 	*/
+	LinePlot& LinePlot::draw() {
+		if (this->samples.size() < 2 || this->xMax <= this->xMin || this->yMax <= this->yMin) {
+			return *this;
+		}
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		if (viewport[2] != this->viewportWidth) {
+			this->viewportWidth = viewport[2];
+			this->dirty = true;
+		}
+
+		if (this->dirty) {
+			this->stream();
+			this->dirty = false;
+		}
+
+		if (this->points < 2) {
+			return *this;
+		}
+
+		// Plot space to normalized device coordinates
+		glm::dvec2 scale(2.0 / (this->xMax - this->xMin), 2.0 / (this->yMax - this->yMin));
+		glm::dvec2 offset((this->pointsOrigin - this->xMin) * scale.x - 1.0, -this->yMin * scale.y - 1.0);
+
+		this->shader->use();
+		this->shader->setVec2("scale", glm::vec2(scale));
+		this->shader->setVec2("offset", glm::vec2(offset));
+		this->shader->setVec2("viewport", glm::vec2(viewport[2], viewport[3]));
+		this->shader->setFloat("halfWidth", this->width * 0.5f);
+		this->shader->setVec4("color", this->color);
+
+		this->ring.bind(POINT_BINDING);
+
+		GLboolean blendWas = glIsEnabled(GL_BLEND);
+		GLboolean depthWas = glIsEnabled(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		glBindVertexArray(this->vao);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(this->points - 1));
+		glBindVertexArray(0);
+
+		if (!blendWas) {
+			glDisable(GL_BLEND);
+		}
+		if (depthWas) {
+			glEnable(GL_DEPTH_TEST);
+		}
+
+		return *this;
+	}
+
+	/** @brief Get the number of samples
+	 * @return The sample count
+ 	*/
+	size_t LinePlot::getSampleCount() const {
+		return this->samples.size();
+	}
+
+	/** @brief Get the number of pyramid levels, counting the samples as level 0
+	 * @return The level count
+ 	*/
+	uint32_t LinePlot::getLevelCount() const {
+		return static_cast<uint32_t>(this->levels.size()) + 1;
+	}
+
+	/** @brief Get the level the last draw() used
+	 * @return The level. 0 is the samples themselves
+ 	*/
+	uint32_t LinePlot::getLevel() const {
+		return this->level;
+	}
+
+	/** @brief Get the number of points the last draw() drew
+	 * @return The point count
+ 	*/
+	size_t LinePlot::getDrawnPoints() const {
+		return this->points;
+	}
+}
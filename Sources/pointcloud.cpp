@@ -0,0 +1,793 @@
+#include "oglopp/pointcloud.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <glm/gtc/packing.hpp>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace oglopp {
+	static constexpr char MAGIC[8] = "OGLOPPC";
+
+	PointCloud::PointCloud() {
+		this->shader = std::make_unique<Shader>(
+		"#version 450 core\n"\
+		// Four scalars pack into 16 bytes like the C++ struct. A vec3 member would be padded to 16 on its own
+		"struct Point {\n"\
+			"float x;\n"\
+			"float y;\n"\
+			"float z;\n"\
+			"uint color;\n"\
+		"};\n"\
+		"layout (std430, binding = 0) readonly buffer PointPool { Point points[]; };\n"\
+		\
+		"uniform mat4 view;\n"\
+		"uniform mat4 projection;\n"\
+		"uniform float pointSize;\n"\
+		\
+		"out vec4 color;\n"\
+		\
+		"void main() {\n"\
+			// glMultiDrawArrays adds each range's first to gl_VertexID, so it indexes the pool directly
+			"Point point = points[gl_VertexID];\n"\
+			"gl_Position = projection * view * vec4(point.x, point.y, point.z, 1.0);\n"\
+			"gl_PointSize = pointSize;\n"\
+			"color = unpackUnorm4x8(point.color);\n"\
+		"}\n",
+		\
+		"#version 450 core\n"\
+		"in vec4 color;\n"\
+		"out vec4 FragColor;\n"\
+		\
+		"void main() {\n"\
+			"vec2 offset = gl_PointCoord * 2.0 - 1.0;\n"\
+			"if (dot(offset, offset) > 1.0) {\n"\
+				"discard;\n"\
+			"}\n"\
+			"FragColor = vec4(color.rgb, 1.0);\n"\
+		"}\n", ShaderType::RAW);
+
+		this->shader->setDrawType(POINTS);
+
+		// Core profiles need a vertex array bound to draw, even with no attributes
+		glGenVertexArrays(1, &this->vao);
+	}
+
+	PointCloud::~PointCloud() {
+		this->close();
+
+		if (this->vao != 0) {
+			glDeleteVertexArrays(1, &this->vao);
+		}
+	}
+
+	/** @brief Map a file written by PointCloudBuilder and start the loader thread
+	 * @param[in] path		The file
+	 * @param[in] budget	The GPU memory for points in bytes. The pool holds this many bytes rounded down to whole chunks
+	 * @return				A status code. 0 on success. -1 if the file can't be mapped or isn't a valid point cloud
+ 	*/
+	int8_t PointCloud::open(std::string const& path, size_t budget) {
+		this->close();
+
+#if defined(_WIN32) || defined(_WIN64)
+		this->fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER fileSize;
+		if (this->fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->fileHandle, &fileSize)) {
+			std::cout << "[Oglopp] Failed to open point cloud " << path << std::endl;
+			this->fileHandle = nullptr;
+			return -1;
+		}
+
+		this->mappingSize = static_cast<size_t>(fileSize.QuadPart);
+		this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (this->mappingHandle != nullptr) {
+			this->mapping = MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		}
+#else
+		this->fileDescriptor = ::open(path.c_str(), O_RDONLY);
+		struct stat status;
+		if (this->fileDescriptor < 0 || fstat(this->fileDescriptor, &status) != 0) {
+			std::cout << "[Oglopp] Failed to open point cloud " << path << std::endl;
+			this->unmap();
+			return -1;
+		}
+
+		this->mappingSize = static_cast<size_t>(status.st_size);
+		void* mapped = mmap(nullptr, this->mappingSize, PROT_READ, MAP_SHARED, this->fileDescriptor, 0);
+		this->mapping = mapped == MAP_FAILED ? nullptr : mapped;
+#endif
+
+		if (this->mapping == nullptr) {
+			std::cout << "[Oglopp] Failed to map point cloud " << path << std::endl;
+			this->unmap();
+			return -1;
+		}
+
+		// Check everything the runtime will read lies inside the file before trusting it
+		char const* bytes = static_cast<char const*>(this->mapping);
+		this->header = reinterpret_cast<Header const*>(bytes);
+
+		bool valid = this->mappingSize >= sizeof(Header)
+			&& std::memcmp(this->header->magic, MAGIC, sizeof(MAGIC)) == 0
+			&& this->header->version == VERSION
+			&& this->header->chunkSize > 0
+			&& this->header->nodeCount > 0
+			&& this->header->nodesOffset % alignof(Node) == 0
+			&& this->header->nodesOffset <= this->mappingSize
+			&& (this->mappingSize - this->header->nodesOffset) / sizeof(Node) >= this->header->nodeCount;
+
+		if (valid) {
+			this->nodes = reinterpret_cast<Node const*>(bytes + this->header->nodesOffset);
+
+			for (uint32_t i = 0; i < this->header->nodeCount && valid; i++) {
+				Node const& node = this->nodes[i];
+				valid = node.count <= this->header->chunkSize
+					&& node.offset <= this->mappingSize
+					&& (this->mappingSize - node.offset) / sizeof(Point) >= node.count;
+
+				for (uint32_t child : node.children) {
+					valid = valid && (child == NONE || (child > i && child < this->header->nodeCount));
+				}
+			}
+		}
+
+		if (!valid) {
+			std::cout << "[Oglopp] " << path << " is not a valid point cloud file" << std::endl;
+			this->unmap();
+			return -1;
+		}
+
+		uint32_t chunkSize = this->header->chunkSize;
+		this->slotCount = static_cast<uint32_t>(std::min<size_t>(budget / (chunkSize * sizeof(Point)), NONE - 1));
+		if (this->slotCount == 0) {
+			std::cout << "[Oglopp] A point cloud budget of " << budget << " bytes can't hold one chunk of " << chunkSize << " points" << std::endl;
+			this->unmap();
+			return -1;
+		}
+
+		this->pool.resize(static_cast<size_t>(this->slotCount) * chunkSize, false);
+		this->slotNodes.assign(this->slotCount, NONE);
+		this->freeSlots.resize(this->slotCount);
+		for (uint32_t i = 0; i < this->slotCount; i++) {
+			this->freeSlots[i] = this->slotCount - 1 - i;
+		}
+
+		this->states.assign(this->header->nodeCount, UNLOADED);
+		this->slots.assign(this->header->nodeCount, NONE);
+		this->lastUsed.assign(this->header->nodeCount, 0);
+		this->frame = 0;
+
+		this->stopping = false;
+		this->loader = std::thread(&PointCloud::loadLoop, this);
+
+		return 0;
+	}
+
+	/** @brief Stop the loader, unmap the file and release the pool. open() can be called again after
+ 	*/
+	void PointCloud::close() {
+		if (this->loader.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+
+			this->wake.notify_all();
+			this->loader.join();
+		}
+
+		this->requests.clear();
+		this->loaded.clear();
+		this->reading = 0;
+
+		this->unmap();
+
+		this->states.clear();
+		this->slots.clear();
+		this->lastUsed.clear();
+		this->slotNodes.clear();
+		this->freeSlots.clear();
+		this->selected.clear();
+		this->firsts.clear();
+		this->counts.clear();
+		this->drawnPoints = 0;
+		this->slotCount = 0;
+
+		this->pool = TypedSSBO<Point>();
+	}
+
+	/** @brief Unmap the file and close its handles
+ 	*/
+	void PointCloud::unmap() {
+#if defined(_WIN32) || defined(_WIN64)
+		if (this->mapping != nullptr) {
+			UnmapViewOfFile(this->mapping);
+		}
+		if (this->mappingHandle != nullptr) {
+			CloseHandle(this->mappingHandle);
+		}
+		if (this->fileHandle != nullptr) {
+			CloseHandle(this->fileHandle);
+		}
+
+		this->mappingHandle = nullptr;
+		this->fileHandle = nullptr;
+#else
+		if (this->mapping != nullptr) {
+			munmap(const_cast<void*>(this->mapping), this->mappingSize);
+		}
+		if (this->fileDescriptor >= 0) {
+			::close(this->fileDescriptor);
+		}
+
+		this->fileDescriptor = -1;
+#endif
+
+		this->mapping = nullptr;
+		this->mappingSize = 0;
+		this->header = nullptr;
+		this->nodes = nullptr;
+	}
+
+	/** @brief Pick the nodes to draw from the camera, queue the missing ones for loading and upload what has been loaded.
+	 * Call after the camera's projection and view are updated for the frame
+	 * @param[in] window	The window whose camera to pick for
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::update(Window& window) {
+		if (!this->isOpen()) {
+			return *this;
+		}
+
+		this->frame++;
+
+		this->select(window);
+		this->upload();
+		this->request();
+
+		// Draw what is resident now, including the nodes just uploaded
+		this->firsts.clear();
+		this->counts.clear();
+		this->drawnPoints = 0;
+
+		for (uint32_t index : this->selected) {
+			if (this->states[index] == RESIDENT) {
+				this->firsts.push_back(static_cast<GLint>(this->slots[index] * this->header->chunkSize));
+				this->counts.push_back(static_cast<GLsizei>(this->nodes[index].count));
+				this->drawnPoints += this->nodes[index].count;
+			}
+		}
+
+		return *this;
+	}
+
+	/** @brief Pick the nodes to draw, largest on screen first
+	 * @param[in] window	The window whose camera to pick for
+ 	*/
+	void PointCloud::select(Window& window) {
+		Camera& camera = window.getCam();
+		glm::dmat4 const& view = camera.getView();
+		glm::dmat4 const& projection = camera.getProjection();
+		glm::dmat4 viewProjection = projection * view;
+		glm::dvec3 eye(glm::inverse(view)[3]);
+
+		// Frustum planes, from the rows of the view projection matrix
+		std::array<glm::dvec4, 6> planes;
+		for (int i = 0; i < 3; i++) {
+			glm::dvec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			glm::dvec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+			planes[i * 2] = w + row;
+			planes[i * 2 + 1] = w - row;
+		}
+
+		auto visible = [&](Node const& node) {
+			glm::dvec3 min(node.min);
+			glm::dvec3 max = min + glm::dvec3(node.size);
+
+			for (glm::dvec4 const& plane : planes) {
+				// The corner furthest along the plane's normal
+				glm::dvec3 corner(plane.x >= 0 ? max.x : min.x, plane.y >= 0 ? max.y : min.y, plane.z >= 0 ? max.z : min.z);
+				if (glm::dot(glm::dvec3(plane), corner) + plane.w < 0) {
+					return false;
+				}
+			}
+
+			return true;
+		};
+
+		// Pixels a world unit covers at distance 1, or anywhere with an orthographic projection
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		double scale = projection[1][1] * viewport[3] * 0.5;
+		bool orthographic = camera.getProjectionType() == Camera::ORTHO;
+
+		auto pixelsPerUnit = [&](Node const& node) {
+			if (orthographic) {
+				return scale;
+			}
+
+			// The nearest the node's bounding sphere gets to the camera
+			glm::dvec3 center = glm::dvec3(node.min) + node.size * 0.5;
+			double radius = node.size * 0.8660254;
+			double distance = std::max(glm::distance(eye, center) - radius, camera.getNear());
+
+			return scale / distance;
+		};
+
+		this->selected.clear();
+
+		std::priority_queue<std::pair<double, uint32_t>> queue;
+		if (visible(this->nodes[0])) {
+			queue.push({this->nodes[0].size * pixelsPerUnit(this->nodes[0]), 0});
+		}
+
+		uint64_t points = 0;
+		while (!queue.empty() && this->selected.size() < this->slotCount) {
+			uint32_t index = queue.top().second;
+			queue.pop();
+
+			Node const& node = this->nodes[index];
+			if (points + node.count > this->pointBudget) {
+				break;
+			}
+
+			points += node.count;
+			this->selected.push_back(index);
+			this->lastUsed[index] = this->frame;
+
+			// Dense enough on screen. Finer nodes would only add points closer together than a pixel spacing
+			if (node.spacing * pixelsPerUnit(node) <= this->pixelSpacing) {
+				continue;
+			}
+
+			for (uint32_t child : node.children) {
+				if (child != NONE && visible(this->nodes[child])) {
+					queue.push({this->nodes[child].size * pixelsPerUnit(this->nodes[child]), child});
+				}
+			}
+		}
+	}
+
+	/** @brief Replace the loader's queue with the wanted nodes which aren't on the GPU
+ 	*/
+	void PointCloud::request() {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			// Requests the loader hasn't started are stale. The ones still wanted are queued again below, in the new order
+			for (uint32_t index : this->requests) {
+				this->states[index] = UNLOADED;
+			}
+			this->requests.clear();
+
+			// Only a few frames of uploads are read ahead, so the loader follows the camera closely
+			size_t limit = static_cast<size_t>(this->uploadsPerFrame) * 4;
+			size_t inFlight = this->reading + this->loaded.size();
+
+			for (uint32_t index : this->selected) {
+				if (inFlight + this->requests.size() >= limit) {
+					break;
+				}
+
+				if (this->states[index] == UNLOADED) {
+					this->states[index] = QUEUED;
+					this->requests.push_back(index);
+				}
+			}
+		}
+
+		this->wake.notify_one();
+	}
+
+	/** @brief Upload loaded nodes into free or evicted slots
+ 	*/
+	void PointCloud::upload() {
+		std::vector<Loaded> ready;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			size_t take = std::min<size_t>(this->loaded.size(), this->uploadsPerFrame);
+			ready.insert(ready.end(), std::make_move_iterator(this->loaded.begin()), std::make_move_iterator(this->loaded.begin() + take));
+			this->loaded.erase(this->loaded.begin(), this->loaded.begin() + take);
+		}
+
+		for (Loaded& result : ready) {
+			// A node the camera has moved away from is only kept if there is room to spare
+			bool wanted = this->lastUsed[result.node] == this->frame;
+			uint32_t slot = wanted || !this->freeSlots.empty() ? this->acquireSlot() : NONE;
+
+			if (slot == NONE) {
+				this->states[result.node] = UNLOADED;
+				continue;
+			}
+
+			this->pool.set(static_cast<size_t>(slot) * this->header->chunkSize, result.points);
+
+			this->states[result.node] = RESIDENT;
+			this->slots[result.node] = slot;
+			this->slotNodes[slot] = result.node;
+		}
+	}
+
+	/** @brief Find a slot for a node, evicting the least recently used node which wasn't picked this frame
+	 * @return The slot, or NONE if every slot is in use this frame
+ 	*/
+	uint32_t PointCloud::acquireSlot() {
+		if (!this->freeSlots.empty()) {
+			uint32_t slot = this->freeSlots.back();
+			this->freeSlots.pop_back();
+			return slot;
+		}
+
+		uint32_t victim = NONE;
+		for (uint32_t slot = 0; slot < this->slotCount; slot++) {
+			uint32_t node = this->slotNodes[slot];
+			if (this->lastUsed[node] < this->frame && (victim == NONE || this->lastUsed[node] < this->lastUsed[this->slotNodes[victim]])) {
+				victim = slot;
+			}
+		}
+
+		if (victim != NONE) {
+			uint32_t node = this->slotNodes[victim];
+			this->states[node] = UNLOADED;
+			this->slots[node] = NONE;
+			this->slotNodes[victim] = NONE;
+		}
+
+		return victim;
+	}
+
+	/** @brief The loader thread. Reads requested nodes out of the mapping until close()
+ 	*/
+	void PointCloud::loadLoop() {
+		char const* bytes = static_cast<char const*>(this->mapping);
+
+		while (true) {
+			uint32_t index;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->wake.wait(lock, [this]() { return this->stopping || !this->requests.empty(); });
+
+				if (this->stopping) {
+					return;
+				}
+
+				index = this->requests.front();
+				this->requests.pop_front();
+				this->reading++;
+			}
+
+			// Touching the mapping faults the pages in from disk here, off the render thread
+			Node const& node = this->nodes[index];
+			Loaded result{index, std::vector<Point>(node.count)};
+			std::memcpy(result.points.data(), bytes + node.offset, node.count * sizeof(Point));
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->reading--;
+				this->loaded.push_back(std::move(result));
+			}
+		}
+	}
+
+	/** @brief Draw the nodes picked by the last update() which are on the GPU
+	 * @param[in] window	The window whose camera to draw from
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::draw(Window& window) {
+		if (this->firsts.empty()) {
+			return *this;
+		}
+
+		this->shader->use();
+		this->shader->setMat4("view", glm::mat4(window.getCam().getView()));
+		this->shader->setMat4("projection", glm::mat4(window.getCam().getProjection()));
+		this->shader->setFloat("pointSize", this->pointSize);
+
+		this->pool.sync(GL_SHADER_STORAGE_BARRIER_BIT).bind(POINT_BINDING);
+
+		GLboolean pointSizeWas = glIsEnabled(GL_PROGRAM_POINT_SIZE);
+		glEnable(GL_PROGRAM_POINT_SIZE);
+
+		glBindVertexArray(this->vao);
+		glMultiDrawArrays(GL_POINTS, this->firsts.data(), this->counts.data(), static_cast<GLsizei>(this->firsts.size()));
+		glBindVertexArray(0);
+
+		if (!pointSizeWas) {
+			glDisable(GL_PROGRAM_POINT_SIZE);
+		}
+
+		return *this;
+	}
+
+	/** @brief Set the spacing between points on screen which is fine enough. Nodes are refined until they are this dense
+	 * @param[in] pixels	The spacing in pixels. Smaller draws more points
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::setPixelSpacing(float pixels) {
+		this->pixelSpacing = pixels;
+
+		return *this;
+	}
+
+	/** @brief Set the size points are drawn at
+	 * @param[in] pixels	The point size in pixels
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::setPointSize(float pixels) {
+		this->pointSize = pixels;
+
+		return *this;
+	}
+
+	/** @brief Set the most points to pick in one update(), whatever the spacing asks for
+	 * @param[in] points	The point budget
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::setPointBudget(uint64_t points) {
+		this->pointBudget = points;
+
+		return *this;
+	}
+
+	/** @brief Set the most nodes uploaded to the GPU in one update(), to bound the time spent copying each frame
+	 * @param[in] nodes		The node count
+	 * @return				A reference to this object
+ 	*/
+	PointCloud& PointCloud::setUploadsPerFrame(uint32_t nodes) {
+		this->uploadsPerFrame = std::max<uint32_t>(nodes, 1);
+
+		return *this;
+	}
+
+	/** @brief Check whether a file is open
+	 * @return True if open() succeeded and close() hasn't been called since
+ 	*/
+	bool PointCloud::isOpen() const {
+		return this->nodes != nullptr;
+	}
+
+	/** @brief Get the header of the open file
+	 * @return A reference to the header
+ 	*/
+	PointCloud::Header const& PointCloud::getHeader() const {
+		return *this->header;
+	}
+
+	/** @brief Get a node of the open file
+	 * @param[in] index		The node index
+	 * @return				A reference to the node
+ 	*/
+	PointCloud::Node const& PointCloud::getNode(uint32_t index) const {
+		return this->nodes[index];
+	}
+
+	/** @brief Get the number of points the last update() picked and are on the GPU, which draw() draws
+	 * @return The point count
+ 	*/
+	uint64_t PointCloud::getDrawnPoints() const {
+		return this->drawnPoints;
+	}
+
+	/** @brief Get the number of nodes the last update() picked, loaded or not
+	 * @return The node count
+ 	*/
+	size_t PointCloud::getSelectedNodes() const {
+		return this->selected.size();
+	}
+
+	/** @brief Get the number of nodes on the GPU
+	 * @return The node count
+ 	*/
+	size_t PointCloud::getResidentNodes() const {
+		return this->slotCount - this->freeSlots.size();
+	}
+
+	/** @brief Get the number of nodes the pool can hold
+	 * @return The slot count
+ 	*/
+	uint32_t PointCloud::getSlotCount() const {
+		return this->slotCount;
+	}
+
+	/** @brief Get the number of nodes queued or being read by the loader
+	 * @return The node count
+ 	*/
+	size_t PointCloud::getPendingLoads() const {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->requests.size() + this->reading;
+	}
+
+	/** @brief Get the point pool, eg. to draw it some other way
+	 * @return The pool. Slot i holds chunkSize points from point i * chunkSize
+ 	*/
+	TypedSSBO<PointCloud::Point>& PointCloud::getPool() {
+		return this->pool;
+	}
+
+	/** @brief Create a builder
+	 * @param[in] chunkSize		The most points in one node
+	 * @param[in] maxDepth		The deepest level. Points past the chunk size in nodes this deep are dropped, which only happens
+	 *							with many points at nearly the same position
+ 	*/
+	PointCloudBuilder::PointCloudBuilder(uint32_t chunkSize, uint32_t maxDepth) : chunkSize(std::max<uint32_t>(chunkSize, 1)), maxDepth(maxDepth) {}
+
+	/** @brief Add a point
+	 * @param[in] position	The position
+	 * @param[in] color		The color, each channel from 0 to 1
+	 * @return				A reference to this object
+ 	*/
+	PointCloudBuilder& PointCloudBuilder::add(glm::vec3 const& position, glm::vec4 const& color) {
+		this->points.push_back(PointCloud::Point{position, glm::packUnorm4x8(color)});
+
+		return *this;
+	}
+
+	/** @brief Add some points
+	 * @param[in] points	The points, colors already packed
+	 * @return				A reference to this object
+ 	*/
+	PointCloudBuilder& PointCloudBuilder::add(std::span<const PointCloud::Point> points) {
+		this->points.insert(this->points.end(), points.begin(), points.end());
+
+		return *this;
+	}
+
+	/** @brief Get the number of points added
+	 * @return The point count
+ 	*/
+	size_t PointCloudBuilder::getPointCount() const {
+		return this->points.size();
+	}
+
+	/** @brief Build the octree and write it to a file. The points added are kept, shuffled
+	 * @param[in] path	The file to write
+	 * @return			A status code. 0 on success. -1 if there are no points or the file can't be written
+ 	*/
+	int8_t PointCloudBuilder::write(std::string const& path) {
+		if (this->points.empty()) {
+			std::cout << "[Oglopp] A point cloud needs at least one point" << std::endl;
+			return -1;
+		}
+
+		this->min = this->max = this->points[0].position;
+		for (PointCloud::Point const& point : this->points) {
+			this->min = glm::min(this->min, point.position);
+			this->max = glm::max(this->max, point.position);
+		}
+
+		// A cube, so children are cubes too
+		glm::vec3 extent = this->max - this->min;
+		float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+		// Any prefix of a shuffled range is a uniform sample of it. Seeded, so the same input builds the same file
+		std::shuffle(this->points.begin(), this->points.end(), std::mt19937(0x0C10D));
+
+		this->nodes.clear();
+		this->starts.clear();
+		this->dropped = 0;
+		this->build(0, this->points.size(), this->min, size, 0, PointCloud::NONE);
+
+		PointCloud::Header header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = PointCloud::VERSION;
+		header.chunkSize = this->chunkSize;
+		header.nodeCount = static_cast<uint32_t>(this->nodes.size());
+		header.nodesOffset = sizeof(PointCloud::Header);
+		header.min = this->min;
+		header.size = size;
+
+		// Every node's points follow the table, in node order
+		uint64_t offset = header.nodesOffset + this->nodes.size() * sizeof(PointCloud::Node);
+		for (PointCloud::Node& node : this->nodes) {
+			node.offset = offset;
+			offset += node.count * sizeof(PointCloud::Point);
+
+			header.pointCount += node.count;
+			header.depth = std::max(header.depth, node.level);
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cout << "[Oglopp] Failed to open " << path << " to write a point cloud" << std::endl;
+			return -1;
+		}
+
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file.write(reinterpret_cast<char const*>(this->nodes.data()), this->nodes.size() * sizeof(PointCloud::Node));
+		for (size_t i = 0; i < this->nodes.size(); i++) {
+			file.write(reinterpret_cast<char const*>(this->points.data() + this->starts[i]), this->nodes[i].count * sizeof(PointCloud::Point));
+		}
+
+		if (!file) {
+			std::cout << "[Oglopp] Failed to write point cloud " << path << std::endl;
+			return -1;
+		}
+
+		if (this->dropped > 0) {
+			std::cout << "[Oglopp] " << this->dropped << " points were dropped from nodes at the maximum depth of " << this->maxDepth << std::endl;
+		}
+
+		return 0;
+	}
+
+	/** @brief Build a node over a range of points, then its children over what it doesn't keep
+	 * @param[in] begin		The first point
+	 * @param[in] end		One past the last point
+	 * @param[in] min		The corner of the node's cube
+	 * @param[in] size		The edge of the node's cube
+	 * @param[in] level		The node's depth
+	 * @param[in] parent	The parent index, or NONE
+	 * @return				The node index
+ 	*/
+	uint32_t PointCloudBuilder::build(size_t begin, size_t end, glm::vec3 const& min, float size, uint32_t level, uint32_t parent) {
+		uint32_t index = static_cast<uint32_t>(this->nodes.size());
+		size_t count = std::min<size_t>(end - begin, this->chunkSize);
+
+		PointCloud::Node node{};
+		node.min = min;
+		node.size = size;
+		node.count = static_cast<uint32_t>(count);
+		node.parent = parent;
+		std::fill(std::begin(node.children), std::end(node.children), PointCloud::NONE);
+		// Scanned surfaces spread a node's points over about size^2
+		node.spacing = size / std::sqrt(static_cast<float>(count));
+		node.level = level;
+
+		this->nodes.push_back(node);
+		this->starts.push_back(begin);
+
+		size_t rest = begin + count;
+		if (rest == end) {
+			return index;
+		}
+
+		if (level >= this->maxDepth) {
+			this->dropped += end - rest;
+			return index;
+		}
+
+		// Split what is left into octants by z, then y, then x. stable_partition keeps each octant shuffled
+		glm::vec3 center = min + glm::vec3(size * 0.5f);
+		auto split = [](auto first, auto last, int axis, float at) {
+			return std::stable_partition(first, last, [axis, at](PointCloud::Point const& point) { return point.position[axis] < at; });
+		};
+
+		std::array<std::vector<PointCloud::Point>::iterator, 9> bounds;
+		bounds[0] = this->points.begin() + rest;
+		bounds[8] = this->points.begin() + end;
+		bounds[4] = split(bounds[0], bounds[8], 2, center.z);
+		bounds[2] = split(bounds[0], bounds[4], 1, center.y);
+		bounds[6] = split(bounds[4], bounds[8], 1, center.y);
+		for (int i = 0; i < 8; i += 2) {
+			bounds[i + 1] = split(bounds[i], bounds[i + 2], 0, center.x);
+		}
+
+		float half = size * 0.5f;
+		for (uint32_t octant = 0; octant < 8; octant++) {
+			if (bounds[octant] == bounds[octant + 1]) {
+				continue;
+			}
+
+			glm::vec3 corner = min + glm::vec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1) * half;
+			uint32_t child = this->build(bounds[octant] - this->points.begin(), bounds[octant + 1] - this->points.begin(), corner, half, level + 1, index);
+			this->nodes[index].children[octant] = child;
+		}
+
+		return index;
+	}
+}
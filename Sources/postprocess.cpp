@@ -0,0 +1,252 @@
+#include "oglopp/postprocess.h"
+#include "oglopp/glad/gl.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace oglopp {
+	/** @brief Create an empty chain
+	 * @param[in] format	The internal format of the intermediate targets
+ 	*/
+	PostProcessChain::PostProcessChain(GLenum format) : format(format) {
+		// Core profile needs a VAO bound to draw, even with no attributes
+		glGenVertexArrays(1, &this->vao);
+	}
+
+	PostProcessChain::~PostProcessChain() {
+		glDeleteVertexArrays(1, &this->vao);
+	}
+
+	/** @brief Add an effect which runs in its own pass
+	 * @param[in] name			A name for debugging
+	 * @param[in] code			GLSL which sets `vec4 color`. `color` starts as the source texel at uv
+	 * @param[in] scale			The pass's resolution relative to the output, eg. 0.5 for half resolution. Ignored for the last pass
+	 * @param[in] uniforms		Optionally set the effect's uniforms. The shader is already in use
+	 * @param[in] declarations	GLSL placed before main(), eg. uniforms and functions
+	 * @return					A reference to this object
+ 	*/
+	PostProcessChain& PostProcessChain::addEffect(std::string const& name, std::string const& code, float scale, UniformFunction uniforms, std::string const& declarations) {
+		this->effects.push_back({name, code, declarations, uniforms, scale, false});
+		this->dirty = true;
+
+		return *this;
+	}
+
+	/** @brief Add a per-pixel color operation. It is fused into the pass before it, so it costs no extra pass.
+	 *  Declarations of fused operations share one shader, so their names must not collide
+	 * @param[in] name			A name for debugging
+	 * @param[in] code			GLSL which modifies `vec4 color`. It must not sample `source` at other coordinates
+	 * @param[in] uniforms		Optionally set the operation's uniforms. The shader is already in use
+	 * @param[in] declarations	GLSL placed before main(), eg. uniforms and functions
+	 * @return					A reference to this object
+ 	*/
+	PostProcessChain& PostProcessChain::addColorOp(std::string const& name, std::string const& code, UniformFunction uniforms, std::string const& declarations) {
+		this->effects.push_back({name, code, declarations, uniforms, 1.f, true});
+		this->dirty = true;
+
+		return *this;
+	}
+
+	/** @brief Run every pass
+	 * @param[in] window	The window, used for the output size when drawing to the default framebuffer
+	 * @param[in] input		The texture to process
+	 * @param[in] output	The framebuffer to draw the result into, or nullptr for the default framebuffer
+	 * @return				A reference to this object
+ 	*/
+	PostProcessChain& PostProcessChain::run(Window& window, Texture& input, FBO* output) {
+		if (this->dirty) {
+			this->build();
+		}
+
+		if (this->passes.empty() || this->failed) {
+			return *this;
+		}
+
+		int outputWidth;
+		int outputHeight;
+		if (output != nullptr) {
+			outputWidth = output->getWidth();
+			outputHeight = output->getHeight();
+		} else {
+			window.getSize(&outputWidth, &outputHeight);
+		}
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_TEST);
+
+		glBindVertexArray(this->vao);
+		input.bind(GL_TEXTURE1);
+
+		Texture* source = &input;
+		for (size_t i = 0; i < this->passes.size(); i++) {
+			Pass& pass = this->passes[i];
+			bool last = i + 1 == this->passes.size();
+
+			FBO* target = nullptr;
+			if (last) {
+				if (output != nullptr) {
+					output->bind(true);
+				} else {
+					FBO::unbind();
+					glViewport(0, 0, outputWidth, outputHeight);
+				}
+			} else {
+				target = &this->getTarget(pass.scale, source, outputWidth, outputHeight);
+				target->bind(true);
+			}
+
+			int sourceWidth;
+			int sourceHeight;
+			source->getSize(&sourceWidth, &sourceHeight);
+
+			Shader& shader = *pass.shader;
+			shader.use();
+			shader.setInt("source", 0);
+			shader.setInt("original", 1);
+			shader.setVec2("texelSize", glm::vec2(1.f / std::max(sourceWidth, 1), 1.f / std::max(sourceHeight, 1)));
+
+			for (size_t index : pass.effects) {
+				if (this->effects[index].uniforms) {
+					this->effects[index].uniforms(shader);
+				}
+			}
+
+			source->bind(GL_TEXTURE0);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+
+			if (target != nullptr) {
+				source = target->getColor();
+			}
+		}
+
+		glBindVertexArray(0);
+		glActiveTexture(GL_TEXTURE0);
+
+		if (depthTest) {
+			glEnable(GL_DEPTH_TEST);
+		}
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+		return *this;
+	}
+
+	/** @brief Remove every effect and color op
+	 * @return A reference to this object
+ 	*/
+	PostProcessChain& PostProcessChain::clear() {
+		this->effects.clear();
+		this->passes.clear();
+		this->dirty = true;
+
+		return *this;
+	}
+
+	/** @brief Get the number of fullscreen passes run() draws, after fusing color ops
+	 * @return The pass count
+ 	*/
+	size_t PostProcessChain::getPassCount() {
+		if (this->dirty) {
+			this->build();
+		}
+
+		return this->passes.size();
+	}
+
+	/** @brief Group the effects into passes and compile a shader for each
+ 	*/
+	void PostProcessChain::build() {
+		this->passes.clear();
+		this->failed = false;
+
+		for (size_t i = 0; i < this->effects.size(); i++) {
+			Effect const& effect = this->effects[i];
+
+			// A color op joins the pass before it. Leading color ops share a full resolution pass of their own
+			if (!effect.colorOp || this->passes.empty()) {
+				Pass pass;
+				pass.name = effect.name;
+				pass.scale = effect.colorOp ? 1.f : effect.scale;
+				this->passes.push_back(std::move(pass));
+			} else {
+				this->passes.back().name += " + " + effect.name;
+			}
+
+			this->passes.back().effects.push_back(i);
+		}
+
+		for (Pass& pass : this->passes) {
+			std::string declarations;
+			std::string body;
+
+			for (size_t index : pass.effects) {
+				Effect const& effect = this->effects[index];
+
+				declarations += effect.declarations + "\n";
+				// Each effect gets its own scope so their locals do not collide
+				body += "\t// " + effect.name + "\n\t{\n" + effect.code + "\n\t}\n";
+			}
+
+			std::string fragment =
+				"#version 330 core\n"\
+				"in vec2 uv;\n"\
+				"out vec4 FragColor;\n"\
+				"uniform sampler2D source;\n"\
+				"uniform sampler2D original;\n"\
+				"uniform vec2 texelSize;\n"
+				+ declarations +
+				"void main() {\n"\
+					"vec4 color = texture(source, uv);\n"
+					+ body +
+					"FragColor = color;\n"\
+				"}\n";
+
+			pass.shader = std::make_unique<Shader>(PostProcessChain::FULLSCREEN_TRIANGLE_VERTEX, fragment.c_str(), ShaderType::RAW);
+			if (!pass.shader->isLinked()) {
+				std::cout << "[Oglopp] Post-processing pass \"" << pass.name << "\" failed to build. The chain is skipped until its effects change" << std::endl;
+				this->failed = true;
+			}
+		}
+
+		this->dirty = false;
+	}
+
+	/** @brief Get a target at a scale which is not the texture being read, sized for the output
+	 * @param[in] scale		The resolution scale
+	 * @param[in] source	The texture the pass reads
+	 * @param[in] width		The output width
+	 * @param[in] height	The output height
+	 * @return				The framebuffer to draw into
+ 	*/
+	FBO& PostProcessChain::getTarget(float scale, Texture* source, int width, int height) {
+		int targetWidth = std::max(1, static_cast<int>(width * scale));
+		int targetHeight = std::max(1, static_cast<int>(height * scale));
+
+		Target* target = nullptr;
+		for (Target& existing : this->targets) {
+			if (existing.scale == scale) {
+				target = &existing;
+				break;
+			}
+		}
+
+		if (target == nullptr) {
+			FBO::Description description = {{{this->format, true, false}}, false, {}, 0};
+
+			this->targets.push_back({scale, {}});
+			target = &this->targets.back();
+			target->framebuffers[0] = std::make_unique<FBO>(targetWidth, targetHeight, description);
+			target->framebuffers[1] = std::make_unique<FBO>(targetWidth, targetHeight, description);
+		}
+
+		// Never draw into the texture being sampled
+		FBO& framebuffer = (target->framebuffers[0]->getColor() == source) ? *target->framebuffers[1] : *target->framebuffers[0];
+
+		if (framebuffer.getWidth() != static_cast<unsigned int>(targetWidth) || framebuffer.getHeight() != static_cast<unsigned int>(targetHeight)) {
+			framebuffer.resize(targetWidth, targetHeight);
+		}
+
+		return framebuffer;
+	}
+}
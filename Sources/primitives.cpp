@@ -0,0 +1,399 @@
+#include "oglopp/primitives.h"
+#include "oglopp/glad/gl.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace oglopp {
+	/** @brief Prefix sum. Output i is the sum of inputs before i (exclusive) or up to and including i (inclusive)
+	 * @param[in] input		The values
+	 * @param[out] output	Receives count values. May be the input
+	 * @param[in] count		The number of values
+	 * @param[in] inclusive	True for an inclusive scan
+	 * @return				A status code. 0 for success. -1 if a buffer is too small
+ 	*/
+	int8_t ComputePrimitives::scan(SSBO& input, SSBO& output, uint32_t count, bool inclusive) {
+		size_t size = static_cast<size_t>(count) * sizeof(GLuint);
+		if (input.getSize() < size || output.getSize() < size) {
+			return -1;
+		}
+
+		if (count > 0) {
+			this->scanLevel(input, output, count, inclusive, 0);
+		}
+
+		return 0;
+	}
+
+	/** @brief Reduce values to one
+	 * @param[in] input		The values
+	 * @param[in] count		The number of values
+	 * @param[out] result	Receives the result as its first uint
+	 * @param[in] op		SUM, MIN or MAX
+	 * @return				A status code. 0 for success. -1 if a buffer is too small
+ 	*/
+	int8_t ComputePrimitives::reduce(SSBO& input, uint32_t count, SSBO& result, ReduceOp op) {
+		if (input.getSize() < static_cast<size_t>(count) * sizeof(GLuint) || result.getSize() < sizeof(GLuint)) {
+			return -1;
+		}
+
+		if (count == 0) {
+			GLuint identity = (op == MIN) ? 0xFFFFFFFFu : 0u;
+			result.update(0, &identity, sizeof(identity));
+			return 0;
+		}
+
+		Compute& kernel = ComputePrimitives::getKernel(this->reduceKernel, REDUCE_SOURCE);
+		kernel.use();
+		kernel.setInt("op", op);
+
+		// Each pass shrinks the values by SCAN_BLOCK, ping-ponging between the partial buffers until one is left
+		SSBO* source = &input;
+		uint32_t remaining = count;
+		size_t pass = 0;
+
+		while (true) {
+			uint32_t groups = (remaining + SCAN_BLOCK - 1) / SCAN_BLOCK;
+			SSBO& target = (groups == 1) ? result : ComputePrimitives::getScratch(this->reducePartials[pass % 2], groups * sizeof(GLuint));
+
+			kernel.setInt("count", remaining);
+			kernel.bindSSBO(0, *source, GL_READ_ONLY).bindSSBO(1, target);
+			ComputePrimitives::dispatchGroups(kernel, groups);
+
+			if (groups == 1) {
+				break;
+			}
+
+			source = &target;
+			remaining = groups;
+			pass++;
+		}
+
+		return 0;
+	}
+
+	/** @brief Stream compaction. Copy the values whose flag is 1 to the front of the output, keeping their order
+	 * @param[in] input			The values
+	 * @param[in] flags			One uint per value. 1 keeps the value, 0 drops it
+	 * @param[out] output		Receives the kept values. Must hold count values
+	 * @param[out] outputCount	Receives the number of kept values as its first uint. An IndirectBuffer works here
+	 * @param[in] count			The number of values
+	 * @return					A status code. 0 for success. -1 if a buffer is too small
+ 	*/
+	int8_t ComputePrimitives::compact(SSBO& input, SSBO& flags, SSBO& output, SSBO& outputCount, uint32_t count) {
+		size_t size = static_cast<size_t>(count) * sizeof(GLuint);
+		if (input.getSize() < size || flags.getSize() < size || output.getSize() < size || outputCount.getSize() < sizeof(GLuint)) {
+			return -1;
+		}
+
+		if (count == 0) {
+			GLuint zero = 0;
+			outputCount.update(0, &zero, sizeof(zero));
+			return 0;
+		}
+
+		// Each kept value's position in the output is the number of kept values before it
+		SSBO& offsets = ComputePrimitives::getScratch(this->compactOffsets, size);
+		this->scanLevel(flags, offsets, count, false, 0);
+
+		Compute& kernel = ComputePrimitives::getKernel(this->scatterKernel, SCATTER_SOURCE);
+		kernel.use();
+		kernel.setInt("count", count);
+		kernel.bindSSBO(0, input, GL_READ_ONLY).bindSSBO(1, flags, GL_READ_ONLY).bindSSBO(2, offsets, GL_READ_ONLY);
+		kernel.bindSSBO(3, output).bindSSBO(4, outputCount);
+		ComputePrimitives::dispatchGroups(kernel, (count + LOCAL_SIZE - 1) / LOCAL_SIZE);
+
+		return 0;
+	}
+
+	/** @brief Count how many values fall in each bin. Values are bin indices, and values of binCount or more are ignored
+	 * @param[in] input		The values
+	 * @param[in] count		The number of values
+	 * @param[out] bins		Receives binCount uints. It is cleared first
+	 * @param[in] binCount	The number of bins
+	 * @return				A status code. 0 for success. -1 if a buffer is too small
+ 	*/
+	int8_t ComputePrimitives::histogram(SSBO& input, uint32_t count, SSBO& bins, uint32_t binCount) {
+		if (input.getSize() < static_cast<size_t>(count) * sizeof(GLuint) || bins.getSize() < static_cast<size_t>(binCount) * sizeof(GLuint)) {
+			return -1;
+		}
+
+		std::vector<GLuint> zeros(binCount, 0);
+		bins.update(0, zeros.data(), zeros.size() * sizeof(GLuint));
+
+		if (count == 0) {
+			return 0;
+		}
+
+		Compute& kernel = ComputePrimitives::getKernel(this->histogramKernel, HISTOGRAM_SOURCE);
+		kernel.use();
+		kernel.setInt("count", count);
+		kernel.setInt("binCount", binCount);
+		kernel.bindSSBO(0, input, GL_READ_ONLY).bindSSBO(1, bins);
+
+		uint32_t perGroup = LOCAL_SIZE * HISTOGRAM_ITEMS;
+		ComputePrimitives::dispatchGroups(kernel, (count + perGroup - 1) / perGroup);
+
+		return 0;
+	}
+
+	/** @brief Sort 32 bit keys in ascending order, and their payloads with them. The sort is stable
+	 * @param[in,out] keys		The keys
+	 * @param[in,out] values	One uint payload per key, or nullptr
+	 * @param[in] count			The number of keys
+	 * @param[in] keyBits		The number of low key bits which can be set. Fewer bits need fewer passes
+	 * @return					A status code. 0 for success. -1 if a buffer is too small
+ 	*/
+	int8_t ComputePrimitives::sort(SSBO& keys, SSBO* values, uint32_t count, uint32_t keyBits) {
+		size_t size = static_cast<size_t>(count) * sizeof(GLuint);
+		if (keys.getSize() < size || (values != nullptr && values->getSize() < size)) {
+			return -1;
+		}
+
+		if (count < 2) {
+			return 0;
+		}
+
+		uint32_t groups = (count + LOCAL_SIZE - 1) / LOCAL_SIZE;
+		uint32_t passes = (std::min(keyBits, 32u) + RADIX_BITS - 1) / RADIX_BITS;
+
+		// An odd number of passes ends in the scratch buffers, so round up. The extra pass only sees zero digits
+		passes += passes % 2;
+
+		SSBO& tempKeys = ComputePrimitives::getScratch(this->sortKeys, size);
+		SSBO& tempValues = ComputePrimitives::getScratch(this->sortValues, values != nullptr ? size : sizeof(GLuint));
+		SSBO& counts = ComputePrimitives::getScratch(this->sortCounts, static_cast<size_t>(groups) * RADIX_DIGITS * sizeof(GLuint));
+
+		Compute& countKernel = ComputePrimitives::getKernel(this->radixCountKernel, RADIX_COUNT_SOURCE);
+		Compute& scatterKernel = ComputePrimitives::getKernel(this->radixScatterKernel, RADIX_SCATTER_SOURCE);
+
+		SSBO* keysIn = &keys;
+		SSBO* keysOut = &tempKeys;
+		SSBO* valuesIn = (values != nullptr) ? values : &tempValues;
+		SSBO* valuesOut = &tempValues;
+
+		for (uint32_t pass = 0; pass < passes; pass++) {
+			int shift = pass * RADIX_BITS;
+
+			// Count each digit per group
+			countKernel.use();
+			countKernel.setInt("count", count);
+			countKernel.setInt("shift", shift);
+			countKernel.bindSSBO(0, *keysIn, GL_READ_ONLY).bindSSBO(1, counts);
+			ComputePrimitives::dispatchGroups(countKernel, groups);
+
+			// Digit major counts scan into each group's first output slot for each digit
+			this->scanLevel(counts, counts, groups * RADIX_DIGITS, false, 0);
+
+			scatterKernel.use();
+			scatterKernel.setInt("count", count);
+			scatterKernel.setInt("shift", shift);
+			scatterKernel.setInt("hasValues", values != nullptr);
+			scatterKernel.bindSSBO(0, *keysIn, GL_READ_ONLY).bindSSBO(1, *valuesIn, GL_READ_ONLY).bindSSBO(2, counts, GL_READ_ONLY);
+			scatterKernel.bindSSBO(3, *keysOut).bindSSBO(4, *valuesOut);
+			ComputePrimitives::dispatchGroups(scatterKernel, groups);
+
+			std::swap(keysIn, keysOut);
+			if (values != nullptr) {
+				std::swap(valuesIn, valuesOut);
+			}
+		}
+
+		return 0;
+	}
+
+	/** @brief CPU reference of scan()
+	 * @param[in] input		The values
+	 * @param[in] inclusive	True for an inclusive scan
+	 * @return				The prefix sums
+ 	*/
+	std::vector<uint32_t> ComputePrimitives::scanReference(std::vector<uint32_t> const& input, bool inclusive) {
+		std::vector<uint32_t> output(input.size());
+
+		uint32_t sum = 0;
+		for (size_t i = 0; i < input.size(); i++) {
+			if (inclusive) {
+				sum += input[i];
+				output[i] = sum;
+			} else {
+				output[i] = sum;
+				sum += input[i];
+			}
+		}
+
+		return output;
+	}
+
+	/** @brief CPU reference of reduce()
+	 * @param[in] input		The values
+	 * @param[in] op		SUM, MIN or MAX
+	 * @return				The result
+ 	*/
+	uint32_t ComputePrimitives::reduceReference(std::vector<uint32_t> const& input, ReduceOp op) {
+		switch (op) {
+			case MIN:
+				return std::accumulate(input.begin(), input.end(), 0xFFFFFFFFu, [](uint32_t a, uint32_t b) { return std::min(a, b); });
+			case MAX:
+				return std::accumulate(input.begin(), input.end(), 0u, [](uint32_t a, uint32_t b) { return std::max(a, b); });
+			default:
+				return std::accumulate(input.begin(), input.end(), 0u);
+		}
+	}
+
+	/** @brief CPU reference of compact()
+	 * @param[in] input		The values
+	 * @param[in] flags		One flag per value, 1 or 0
+	 * @return				The kept values
+ 	*/
+	std::vector<uint32_t> ComputePrimitives::compactReference(std::vector<uint32_t> const& input, std::vector<uint32_t> const& flags) {
+		std::vector<uint32_t> output;
+
+		for (size_t i = 0; i < input.size(); i++) {
+			if (flags[i] == 1) {
+				output.push_back(input[i]);
+			}
+		}
+
+		return output;
+	}
+
+	/** @brief CPU reference of histogram()
+	 * @param[in] input		The values
+	 * @param[in] binCount	The number of bins
+	 * @return				The bins
+ 	*/
+	std::vector<uint32_t> ComputePrimitives::histogramReference(std::vector<uint32_t> const& input, uint32_t binCount) {
+		std::vector<uint32_t> bins(binCount, 0);
+
+		for (uint32_t value : input) {
+			if (value < binCount) {
+				bins[value]++;
+			}
+		}
+
+		return bins;
+	}
+
+	/** @brief CPU reference of sort()
+	 * @param[in,out] keys		The keys
+	 * @param[in,out] values	The payloads, or nullptr
+ 	*/
+	void ComputePrimitives::sortReference(std::vector<uint32_t>& keys, std::vector<uint32_t>* values) {
+		std::vector<size_t> order(keys.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+			return keys[a] < keys[b];
+		});
+
+		std::vector<uint32_t> sortedKeys(keys.size());
+		for (size_t i = 0; i < order.size(); i++) {
+			sortedKeys[i] = keys[order[i]];
+		}
+		keys.swap(sortedKeys);
+
+		if (values != nullptr) {
+			std::vector<uint32_t> sortedValues(values->size());
+			for (size_t i = 0; i < order.size(); i++) {
+				sortedValues[i] = (*values)[order[i]];
+			}
+			values->swap(sortedValues);
+		}
+	}
+
+	/** @brief Scan one level, recursing into the group totals
+	 * @param[in] input		The values
+	 * @param[out] output	Receives the prefix sums
+	 * @param[in] count		The number of values
+	 * @param[in] inclusive	True for an inclusive scan
+	 * @param[in] depth		The recursion depth, selecting the scratch buffer of the group totals
+ 	*/
+	void ComputePrimitives::scanLevel(SSBO& input, SSBO& output, uint32_t count, bool inclusive, size_t depth) {
+		uint32_t groups = (count + SCAN_BLOCK - 1) / SCAN_BLOCK;
+
+		if (this->scanSums.size() <= depth) {
+			this->scanSums.resize(depth + 1);
+		}
+		SSBO& sums = ComputePrimitives::getScratch(this->scanSums[depth], groups * sizeof(GLuint));
+
+		Compute& kernel = ComputePrimitives::getKernel(this->scanKernel, SCAN_SOURCE);
+		kernel.use();
+		kernel.setInt("count", count);
+		kernel.setInt("inclusive", inclusive);
+		kernel.bindSSBO(0, input, GL_READ_ONLY).bindSSBO(1, output).bindSSBO(2, sums);
+		ComputePrimitives::dispatchGroups(kernel, groups);
+
+		if (groups == 1) {
+			return;
+		}
+
+		// Scan the group totals in place, then add each group's offset to its elements
+		this->scanLevel(sums, sums, groups, false, depth + 1);
+
+		Compute& add = ComputePrimitives::getKernel(this->addKernel, ADD_SOURCE);
+		add.use();
+		add.setInt("count", count);
+		add.bindSSBO(1, output).bindSSBO(2, sums, GL_READ_ONLY);
+		ComputePrimitives::dispatchGroups(add, groups);
+	}
+
+	/** @brief Dispatch a number of groups, wrapping those past the device's x limit into y. Kernels skip the extra groups
+	 * @param[in] kernel	The kernel, with a groupCount uniform
+	 * @param[in] groups	The number of groups
+ 	*/
+	void ComputePrimitives::dispatchGroups(Compute& kernel, uint32_t groups) {
+		uint32_t maxGroups = Compute::getLimits().maxGroupCount.x;
+		uint32_t xGroups = std::min(groups, maxGroups);
+		uint32_t yGroups = (groups + xGroups - 1) / xGroups;
+
+		kernel.use();
+		kernel.setInt("groupCount", groups);
+		kernel.dispatch(xGroups, yGroups);
+	}
+
+	/** @brief Get a scratch buffer of at least some size, growing it if needed
+	 * @param[in,out] buffer	The scratch buffer
+	 * @param[in] size			The size needed in bytes
+	 * @return					The buffer
+ 	*/
+	SSBO& ComputePrimitives::getScratch(std::unique_ptr<SSBO>& buffer, size_t size) {
+		if (buffer == nullptr || buffer->getSize() < size) {
+			// Grow by half again, so slowly growing inputs do not reallocate every call
+			size_t capacity = std::max(size, buffer != nullptr ? buffer->getSize() + buffer->getSize() / 2 : size);
+			std::vector<uint8_t> zeros(capacity, 0);
+
+			buffer = std::make_unique<SSBO>();
+			buffer->load(zeros.data(), capacity);
+		}
+
+		return *buffer;
+	}
+
+	/** @brief Get a kernel, compiling it the first time
+	 * @param[in,out] kernel	The kernel
+	 * @param[in] body			The GLSL after the common header
+	 * @return					The kernel
+ 	*/
+	Compute& ComputePrimitives::getKernel(std::unique_ptr<Compute>& kernel, const char* body) {
+		if (kernel == nullptr) {
+			std::string source = std::string("#version 450 core\n") +
+			"#define LOCAL_SIZE " + std::to_string(LOCAL_SIZE) + "u\n"\
+			"#define SCAN_BLOCK " + std::to_string(SCAN_BLOCK) + "u\n"\
+			"#define HISTOGRAM_ITEMS " + std::to_string(HISTOGRAM_ITEMS) + "u\n"\
+			"#define HISTOGRAM_SHARED_BINS " + std::to_string(HISTOGRAM_SHARED_BINS) + "u\n"\
+			"#define RADIX_BITS " + std::to_string(RADIX_BITS) + "u\n"\
+			"#define RADIX_DIGITS " + std::to_string(RADIX_DIGITS) + "u\n"\
+			"layout (local_size_x = " + std::to_string(LOCAL_SIZE) + ") in;\n"\
+			"uniform int groupCount;\n"\
+
+			// Groups past the x limit continue in y
+			"uint groupIndex() {\n"\
+				"return gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;\n"\
+			"}\n" +
+			body;
+
+			kernel = std::make_unique<Compute>(source.c_str(), ShaderType::RAW);
+		}
+
+		return *kernel;
+	}
+}
@@ -0,0 +1,226 @@
+#include "oglopp/readback.h"
+#include "oglopp/glad/gl.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace oglopp {
+	/** @brief Create a pending readback. Only ReadbackRing::request() does this
+	 * @param[in] ring	The ring owning the staging buffer
+	 * @param[in] slot	The staging buffer index
+	 * @param[in] size	The number of bytes copied
+	 * @param[in] fence	The fence after the copy
+ 	*/
+	Readback::Readback(ReadbackRing* ring, size_t slot, size_t size, GLsync fence) : ring(ring), slot(slot), size(size), fence(fence) {}
+
+	Readback::~Readback() {
+		if (this->fence != nullptr) {
+			glDeleteSync(this->fence);
+		}
+	}
+
+	/** @brief Check if the copy has finished, without waiting. Once it has, data() is available
+	 * @return True if the data is ready
+ 	*/
+	bool Readback::ready() {
+		if (this->resolved) {
+			return true;
+		}
+
+		// Flush so the fence reaches the GPU, otherwise polling could wait for a flush which never comes
+		GLenum status = glClientWaitSync(this->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			return false;
+		}
+
+		this->resolve();
+
+		return true;
+	}
+
+	/** @brief Wait for the copy to finish
+	 * @param[in] timeout	The longest wait in nanoseconds
+	 * @return				True if the data is ready
+ 	*/
+	bool Readback::wait(GLuint64 timeout) {
+		if (this->resolved) {
+			return true;
+		}
+
+		GLenum status = glClientWaitSync(this->fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			return false;
+		}
+
+		this->resolve();
+
+		return true;
+	}
+
+	/** @brief Get the data
+	 * @return A pointer to the copied bytes, or nullptr if the copy has not finished
+ 	*/
+	const void* Readback::data() const {
+		return this->resolved ? this->bytes.data() : nullptr;
+	}
+
+	/** @brief Get the number of bytes read back
+	 * @return The size in bytes
+ 	*/
+	size_t Readback::getSize() const {
+		return this->size;
+	}
+
+	/** @brief Copy the data out of the staging buffer and free it. The fence must have signalled
+ 	*/
+	void Readback::resolve() {
+		ReadbackRing::Slot& slot = this->ring->slots[this->slot];
+		this->bytes.resize(this->size);
+
+		if (slot.mapped != nullptr) {
+			// Coherent, and the copy has finished
+			std::memcpy(this->bytes.data(), slot.mapped, this->size);
+		} else {
+			glBindBuffer(GL_COPY_READ_BUFFER, slot.buffer);
+			void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, this->size, GL_MAP_READ_BIT);
+			if (mapped != nullptr) {
+				std::memcpy(this->bytes.data(), mapped, this->size);
+				glUnmapBuffer(GL_COPY_READ_BUFFER);
+			}
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+
+		glDeleteSync(this->fence);
+		this->fence = nullptr;
+		this->resolved = true;
+
+		// Last, since this may drop the ring's reference to this object
+		std::shared_ptr<Readback> self = std::move(slot.pending);
+	}
+
+	/** @brief Create a ring of staging buffers. They are allocated by the first request using them
+	 * @param[in] slots		The number of readbacks which can be in flight at once
+ 	*/
+	ReadbackRing::ReadbackRing(size_t slots) : slots(slots > 0 ? slots : 1) {}
+
+	/** @brief Wait for every pending readback and delete the staging buffers
+ 	*/
+	ReadbackRing::~ReadbackRing() {
+		for (Slot& slot : this->slots) {
+			if (slot.pending != nullptr) {
+				slot.pending->wait();
+			}
+
+			if (slot.buffer != 0) {
+				if (slot.mapped != nullptr) {
+					glBindBuffer(GL_COPY_READ_BUFFER, slot.buffer);
+					glUnmapBuffer(GL_COPY_READ_BUFFER);
+					glBindBuffer(GL_COPY_READ_BUFFER, 0);
+				}
+				glDeleteBuffers(1, &slot.buffer);
+			}
+		}
+	}
+
+	/** @brief Start copying a range of a buffer back to the CPU
+	 * @param[in] source	The buffer
+	 * @param[in] offset	The start of the range in bytes
+	 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+	 * @return				The pending readback, or nullptr if the range is out of bounds
+ 	*/
+	std::shared_ptr<Readback> ReadbackRing::request(SSBO& source, size_t offset, size_t size) {
+		if (size == 0 && offset < source.getSize()) {
+			size = source.getSize() - offset;
+		}
+
+		if (size == 0 || offset + size > source.getSize()) {
+			std::cout << "[Oglopp] Readback of " << size << " bytes at " << offset << " is out of range of a buffer of " << source.getSize() << std::endl;
+			return nullptr;
+		}
+
+		size_t index = this->next;
+		this->next = (this->next + 1) % this->slots.size();
+		Slot& slot = this->slots[index];
+
+		// The ring wrapped onto a copy which is still in flight. Only this waits
+		if (slot.pending != nullptr) {
+			slot.pending->wait();
+		}
+
+		ReadbackRing::reserve(slot, size);
+
+		// glCopyBufferSubData reads the source as a buffer update, so it must see earlier shader writes
+		source.sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, source.getBuffer());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source.getRegionOffset() + offset, 0, size);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		slot.pending = std::shared_ptr<Readback>(new Readback(this, index, size, fence));
+
+		return slot.pending;
+	}
+
+	/** @brief Get the number of staging buffers
+	 * @return The number of slots
+ 	*/
+	size_t ReadbackRing::getSlotCount() const {
+		return this->slots.size();
+	}
+
+	/** @brief Get the ring SSBO::readbackAsync() uses by default. It is never deleted, since it may outlive the context
+	 * @return The shared ring
+ 	*/
+	ReadbackRing& ReadbackRing::getShared() {
+		static ReadbackRing* shared = new ReadbackRing();
+
+		return *shared;
+	}
+
+	/** @brief Check if staging buffers can be persistently mapped (GL 4.4 or ARB_buffer_storage)
+	 * @return True if persistent mapping is available
+ 	*/
+	bool ReadbackRing::hasPersistentMapping() {
+		return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+	}
+
+	/** @brief Make sure a staging buffer can hold some number of bytes, reallocating it if needed
+	 * @param[in,out] slot	The staging buffer
+	 * @param[in] size		The size needed in bytes
+ 	*/
+	void ReadbackRing::reserve(Slot& slot, size_t size) {
+		if (slot.buffer != 0 && slot.capacity >= size) {
+			return;
+		}
+
+		// Grow geometrically so a slowly growing readback does not reallocate every time
+		size_t capacity = slot.capacity * 2 > size ? slot.capacity * 2 : size;
+
+		if (slot.buffer != 0) {
+			if (slot.mapped != nullptr) {
+				glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+				glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			}
+			glDeleteBuffers(1, &slot.buffer);
+			slot.mapped = nullptr;
+		}
+
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+
+		if (ReadbackRing::hasPersistentMapping()) {
+			GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_COPY_WRITE_BUFFER, capacity, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+			slot.mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, flags);
+		} else {
+			glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_READ);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		slot.capacity = capacity;
+	}
+}
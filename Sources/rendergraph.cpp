@@ -0,0 +1,495 @@
+#include "oglopp/rendergraph.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+namespace oglopp {
+	/** @brief Get the GL texture behind a texture handle for this frame
+	 * @param[in] handle	The texture handle
+	 * @return				A reference to the texture
+ 	*/
+	Texture& RenderGraph::Context::texture(Handle handle) {
+		Resource& resource = this->graph.resources[handle];
+
+		if (resource.type == TRANSIENT_TEXTURE) {
+			return *this->graph.physicalTextures[resource.physical].texture;
+		}
+
+		return *resource.texture;
+	}
+
+	/** @brief Get the buffer behind a buffer handle
+	 * @param[in] handle	The buffer handle
+	 * @return				A reference to the buffer
+ 	*/
+	SSBO& RenderGraph::Context::buffer(Handle handle) {
+		return *this->graph.resources[handle].buffer;
+	}
+
+	/** @brief Declare a read of a resource
+	 * @param[in] handle	The resource
+	 * @param[in] access	How the resource is read
+	 * @return				A reference to this pass
+ 	*/
+	RenderGraph::Pass& RenderGraph::Pass::read(Handle handle, Access access) {
+		this->reads.push_back({handle, access});
+		this->graph->compileState = STALE;
+
+		return *this;
+	}
+
+	/** @brief Declare a write of a resource
+	 * @param[in] handle	The resource
+	 * @param[in] access	How the resource is written
+	 * @return				A reference to this pass
+ 	*/
+	RenderGraph::Pass& RenderGraph::Pass::write(Handle handle, Access access) {
+		this->writes.push_back({handle, access});
+		this->graph->compileState = STALE;
+
+		return *this;
+	}
+
+	/** @brief Keep this pass even if nothing reads what it writes
+	 * @return A reference to this pass
+ 	*/
+	RenderGraph::Pass& RenderGraph::Pass::keep() {
+		this->sideEffects = true;
+		this->graph->compileState = STALE;
+
+		return *this;
+	}
+
+	/** @brief Create a transient texture. Its GL texture may be shared with other transient textures
+	 * @param[in] name	A name for debugging
+	 * @param[in] desc	The format and size
+	 * @return			The handle of the new texture
+ 	*/
+	RenderGraph::Handle RenderGraph::createTexture(std::string const& name, TextureDesc const& desc) {
+		this->resources.push_back({name, TRANSIENT_TEXTURE, desc, nullptr, nullptr, -1, -1, -1});
+		this->compileState = STALE;
+
+		return this->resources.size() - 1;
+	}
+
+	/** @brief Use a texture owned by the caller. It is never aliased, and passes writing it are never culled
+	 * @param[in] name		A name for debugging
+	 * @param[in] texture	The texture
+	 * @return				The handle of the texture
+ 	*/
+	RenderGraph::Handle RenderGraph::importTexture(std::string const& name, Texture* texture) {
+		this->resources.push_back({name, IMPORTED_TEXTURE, {}, texture, nullptr, -1, -1, -1});
+		this->compileState = STALE;
+
+		return this->resources.size() - 1;
+	}
+
+	/** @brief Use a buffer owned by the caller. Passes writing it are never culled
+	 * @param[in] name		A name for debugging
+	 * @param[in] buffer	The buffer
+	 * @return				The handle of the buffer
+ 	*/
+	RenderGraph::Handle RenderGraph::importBuffer(std::string const& name, SSBO* buffer) {
+		this->resources.push_back({name, IMPORTED_BUFFER, {}, nullptr, buffer, -1, -1, -1});
+		this->compileState = STALE;
+
+		return this->resources.size() - 1;
+	}
+
+	/** @brief Get the handle of the window's default framebuffer. Write it as a COLOR_ATTACHMENT to draw to the screen
+	 * @return The backbuffer handle
+ 	*/
+	RenderGraph::Handle RenderGraph::getBackbuffer() {
+		if (this->backbuffer == UINT32_MAX) {
+			this->resources.push_back({"backbuffer", BACKBUFFER, {}, nullptr, nullptr, -1, -1, -1});
+			this->backbuffer = this->resources.size() - 1;
+		}
+
+		return this->backbuffer;
+	}
+
+	/** @brief Add a pass. Passes run in the order they are added
+	 * @param[in] name		A name for debugging
+	 * @param[in] execute	The function recording the pass's GL commands
+	 * @return				A reference to the pass, to declare its reads and writes
+ 	*/
+	RenderGraph::Pass& RenderGraph::addPass(std::string const& name, ExecuteFunction execute) {
+		std::unique_ptr<Pass> pass = std::make_unique<Pass>();
+		pass->graph = this;
+		pass->name = name;
+		pass->execute = execute;
+
+		this->passes.push_back(std::move(pass));
+		this->compileState = STALE;
+
+		return *this->passes.back();
+	}
+
+	/** @brief Cull, compute lifetimes and allocate textures and framebuffers. Called by execute() when needed
+	 * @param[in] window	The window which sizes are relative to
+	 * @return				A status code. 0 for success. -1 if a resource is written as an attachment with the wrong kind
+ 	*/
+	int8_t RenderGraph::compile(Window& window) {
+		int width, height;
+		window.getSize(&width, &height);
+
+		// Cull. Walk backwards from everything visible outside the graph, keeping the passes that produce what is needed
+		std::vector<bool> needed(this->resources.size(), false);
+		for (size_t i = 0; i < this->resources.size(); i++) {
+			needed[i] = this->resources[i].type != TRANSIENT_TEXTURE;
+		}
+
+		for (size_t i = this->passes.size(); i-- > 0;) {
+			Pass& pass = *this->passes[i];
+
+			bool keep = pass.sideEffects;
+			for (Pass::Use const& use : pass.writes) {
+				keep = keep || needed[use.handle];
+			}
+
+			pass.culled = !keep;
+			if (keep) {
+				for (Pass::Use const& use : pass.reads) {
+					needed[use.handle] = true;
+				}
+			}
+		}
+
+		// Lifetimes, in pass indices
+		for (Resource& resource : this->resources) {
+			resource.firstUse = -1;
+			resource.lastUse = -1;
+			resource.physical = -1;
+		}
+
+		for (size_t i = 0; i < this->passes.size(); i++) {
+			Pass& pass = *this->passes[i];
+			if (pass.culled) {
+				continue;
+			}
+
+			for (std::vector<Pass::Use> const* uses : {&pass.reads, &pass.writes}) {
+				for (Pass::Use const& use : *uses) {
+					Resource& resource = this->resources[use.handle];
+					bool isBuffer = resource.type == IMPORTED_BUFFER;
+					bool bufferAccess = use.access == STORAGE || use.access == VERTEX || use.access == INDIRECT;
+
+					if (isBuffer != bufferAccess || (resource.type == BACKBUFFER && use.access != COLOR_ATTACHMENT)) {
+						std::cout << "[Oglopp] Render graph pass '" << pass.name << "' uses '" << resource.name << "' with an access it does not support" << std::endl;
+						this->compileState = FAILED;
+						return -1;
+					}
+
+					if (resource.firstUse < 0) {
+						resource.firstUse = i;
+					}
+					resource.lastUse = i;
+				}
+			}
+		}
+
+		// Alias transient textures. Each takes the first free GL texture of the same format and size, in order of first use
+		this->physicalTextures.clear();
+
+		std::vector<Handle> order;
+		for (Handle i = 0; i < this->resources.size(); i++) {
+			if (this->resources[i].type == TRANSIENT_TEXTURE && this->resources[i].firstUse >= 0) {
+				order.push_back(i);
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [this](Handle a, Handle b) {
+			return this->resources[a].firstUse < this->resources[b].firstUse;
+		});
+
+		for (Handle handle : order) {
+			Resource& resource = this->resources[handle];
+
+			int texWidth, texHeight;
+			RenderGraph::getTextureSize(resource.desc, width, height, &texWidth, &texHeight);
+
+			for (size_t p = 0; p < this->physicalTextures.size(); p++) {
+				PhysicalTexture& physical = this->physicalTextures[p];
+				if (physical.freeAfter < resource.firstUse && physical.format == resource.desc.format &&
+					physical.width == texWidth && physical.height == texHeight && physical.nearest == resource.desc.nearest) {
+					resource.physical = p;
+					physical.freeAfter = resource.lastUse;
+					break;
+				}
+			}
+
+			if (resource.physical < 0) {
+				this->physicalTextures.push_back({
+					std::make_unique<Texture>(texWidth, texHeight, resource.desc.format, resource.desc.nearest),
+					resource.desc.format, texWidth, texHeight, resource.desc.nearest, resource.lastUse
+				});
+				resource.physical = this->physicalTextures.size() - 1;
+			}
+		}
+
+		// Framebuffers
+		for (std::unique_ptr<Pass>& passPtr : this->passes) {
+			Pass& pass = *passPtr;
+			pass.framebuffer.reset();
+			pass.toBackbuffer = false;
+
+			if (pass.culled) {
+				continue;
+			}
+
+			std::vector<Handle> colors;
+			Handle depth = UINT32_MAX;
+			for (std::vector<Pass::Use> const* uses : {&pass.writes, &pass.reads}) {
+				for (Pass::Use const& use : *uses) {
+					if (use.access == COLOR_ATTACHMENT && std::find(colors.begin(), colors.end(), use.handle) == colors.end()) {
+						colors.push_back(use.handle);
+					} else if (use.access == DEPTH_ATTACHMENT) {
+						depth = use.handle;
+					}
+				}
+			}
+
+			if (std::find(colors.begin(), colors.end(), this->backbuffer) != colors.end()) {
+				pass.toBackbuffer = true;
+				continue;
+			}
+
+			if (colors.empty() && depth == UINT32_MAX) {
+				continue;
+			}
+
+			// Size the framebuffer from its first attachment
+			Context context{*this, window, nullptr, width, height};
+			Texture& first = context.texture(colors.empty() ? depth : colors[0]);
+			int fbWidth, fbHeight;
+			first.getSize(&fbWidth, &fbHeight);
+
+			pass.framebuffer = std::make_unique<FBO>(fbWidth, fbHeight, FBO::Description{{}, false, {}, 0});
+			for (size_t c = 0; c < colors.size(); c++) {
+				pass.framebuffer->attachTexture(context.texture(colors[c]), GL_COLOR_ATTACHMENT0 + c);
+			}
+			if (depth != UINT32_MAX) {
+				Texture& depthTexture = context.texture(depth);
+				pass.framebuffer->attachTexture(depthTexture, FBO::getDepthAttachment(depthTexture.getInternalFormat()));
+			}
+		}
+
+		// Barriers. Track which barrier bits each resource still needs after an incoherent write.
+		// Walk the frame twice so writes at the end of one frame are covered at the start of the next
+		std::vector<GLbitfield> pending(this->resources.size(), 0);
+		GLbitfield allBits = 0;
+		for (Access access : {SAMPLED, IMAGE, STORAGE, VERTEX, INDIRECT, COLOR_ATTACHMENT}) {
+			allBits |= RenderGraph::getBarrierBit(access);
+		}
+
+		for (int frame = 0; frame < 2; frame++) {
+			for (std::unique_ptr<Pass>& passPtr : this->passes) {
+				Pass& pass = *passPtr;
+				if (pass.culled) {
+					continue;
+				}
+
+				GLbitfield bits = 0;
+				for (std::vector<Pass::Use> const* uses : {&pass.reads, &pass.writes}) {
+					for (Pass::Use const& use : *uses) {
+						bits |= pending[use.handle] & RenderGraph::getBarrierBit(use.access);
+					}
+				}
+
+				// A barrier covers every resource
+				for (GLbitfield& bit : pending) {
+					bit &= ~bits;
+				}
+
+				for (Pass::Use const& use : pass.writes) {
+					if (RenderGraph::isIncoherent(use.access)) {
+						pending[use.handle] = allBits;
+					}
+				}
+
+				pass.barriers = bits;
+			}
+		}
+
+		this->compileState = COMPILED;
+		this->compiledWidth = width;
+		this->compiledHeight = height;
+
+		return 0;
+	}
+
+	/** @brief Run every pass which was not culled
+	 * @param[in] window	The window being drawn to
+	 * @return				A reference to this object
+ 	*/
+	RenderGraph& RenderGraph::execute(Window& window) {
+		int width, height;
+		window.getSize(&width, &height);
+
+		// Minimized
+		if (width <= 0 || height <= 0) {
+			return *this;
+		}
+
+		// The error was printed when it failed. Resizing won't fix it, changing the graph might
+		if (this->compileState == FAILED) {
+			return *this;
+		}
+
+		if (this->compileState != COMPILED || width != this->compiledWidth || height != this->compiledHeight) {
+			if (this->compile(window) != 0) {
+				return *this;
+			}
+		}
+
+		for (std::unique_ptr<Pass>& passPtr : this->passes) {
+			Pass& pass = *passPtr;
+			if (pass.culled) {
+				continue;
+			}
+
+			// Skipped if something else already issued the bits since the write
+			if (pass.barriers != 0) {
+				Hazards::requireAll(pass.barriers);
+			}
+
+			Context context{*this, window, pass.framebuffer.get(), width, height};
+			if (pass.framebuffer != nullptr) {
+				pass.framebuffer->bind(true);
+				context.width = pass.framebuffer->getWidth();
+				context.height = pass.framebuffer->getHeight();
+			} else if (pass.toBackbuffer) {
+				FBO::unbind();
+				glViewport(0, 0, width, height);
+			}
+
+			pass.execute(context);
+
+			// Recorded so the barriers above, and uses outside the graph, see the write
+			for (Pass::Use const& use : pass.writes) {
+				if (!RenderGraph::isIncoherent(use.access)) {
+					continue;
+				}
+
+				if (this->resources[use.handle].type == IMPORTED_BUFFER) {
+					context.buffer(use.handle).markWritten();
+				} else {
+					context.texture(use.handle).markWritten();
+				}
+			}
+		}
+
+		FBO::unbind();
+		glViewport(0, 0, width, height);
+
+		return *this;
+	}
+
+	/** @brief Remove every pass and resource
+	 * @return A reference to this object
+ 	*/
+	RenderGraph& RenderGraph::clear() {
+		this->passes.clear();
+		this->resources.clear();
+		this->physicalTextures.clear();
+		this->backbuffer = UINT32_MAX;
+		this->compileState = STALE;
+
+		return *this;
+	}
+
+	/** @brief Get the number of GL textures allocated for the transient textures
+	 * @return The physical texture count
+ 	*/
+	size_t RenderGraph::getPhysicalTextureCount() const {
+		return this->physicalTextures.size();
+	}
+
+	/** @brief Get the number of passes which will run
+	 * @return The active pass count
+ 	*/
+	size_t RenderGraph::getActivePassCount() const {
+		size_t count = 0;
+		for (std::unique_ptr<Pass> const& pass : this->passes) {
+			count += pass->culled ? 0 : 1;
+		}
+
+		return count;
+	}
+
+	/** @brief Print the passes, culling and texture assignment to stdout
+	 * @return A reference to this object
+ 	*/
+	RenderGraph& RenderGraph::print() {
+		std::cout << "[Oglopp] Render graph: " << this->getActivePassCount() << "/" << this->passes.size() << " passes, "
+			<< this->physicalTextures.size() << " textures" << std::endl;
+
+		for (std::unique_ptr<Pass> const& pass : this->passes) {
+			std::cout << "\t" << (pass->culled ? "(culled) " : "") << pass->name;
+			if (pass->barriers != 0) {
+				std::cout << " [barrier 0x" << std::hex << pass->barriers << std::dec << "]";
+			}
+			std::cout << std::endl;
+		}
+
+		for (Resource const& resource : this->resources) {
+			if (resource.type == TRANSIENT_TEXTURE) {
+				std::cout << "\t" << resource.name << " -> texture " << resource.physical
+					<< " (passes " << resource.firstUse << " to " << resource.lastUse << ")" << std::endl;
+			}
+		}
+
+		return *this;
+	}
+
+	/** @brief Get the size of a transient texture for a window size
+	 * @param[in] desc		The texture description
+	 * @param[in] width		The window width
+	 * @param[in] height	The window height
+	 * @param[out] outWidth		The texture width
+	 * @param[out] outHeight	The texture height
+ 	*/
+	void RenderGraph::getTextureSize(TextureDesc const& desc, int width, int height, int* outWidth, int* outHeight) {
+		if (desc.width > 0 && desc.height > 0) {
+			*outWidth = desc.width;
+			*outHeight = desc.height;
+			return;
+		}
+
+		float scale = desc.scale > 0.f ? desc.scale : 1.f;
+		*outWidth = std::max(1, static_cast<int>(width * scale));
+		*outHeight = std::max(1, static_cast<int>(height * scale));
+	}
+
+	/** @brief Get the barrier bit making incoherent writes visible to an access
+	 * @param[in] access	The access
+	 * @return				The glMemoryBarrier bit
+ 	*/
+	GLbitfield RenderGraph::getBarrierBit(Access access) {
+		switch (access) {
+			case SAMPLED:
+				return GL_TEXTURE_FETCH_BARRIER_BIT;
+			case IMAGE:
+				return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+			case STORAGE:
+				return GL_SHADER_STORAGE_BARRIER_BIT;
+			case VERTEX:
+				return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+			case INDIRECT:
+				return GL_COMMAND_BARRIER_BIT;
+			case COLOR_ATTACHMENT:
+			case DEPTH_ATTACHMENT:
+				return GL_FRAMEBUFFER_BARRIER_BIT;
+		}
+
+		return 0;
+	}
+
+	/** @brief Check if an access writes incoherently (needs a glMemoryBarrier before it is read)
+	 * @param[in] access	The access
+	 * @return				True for image and storage writes
+ 	*/
+	bool RenderGraph::isIncoherent(Access access) {
+		return access == IMAGE || access == STORAGE;
+	}
+}
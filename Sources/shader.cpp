@@ -114,6 +114,8 @@ namespace oglopp {
 			std::cout << "[Oglopp] Shader linking failed!\n" << infoLog << std::endl;
 		}
 
+		this->positionOnly = this->reflectPositionOnly();
+
 		// delete the shaders as they're linked into our program now and no longer necessary
 		if (vertexShader != nullptr) {
 			glDeleteShader(vertexIndex);
@@ -126,6 +128,24 @@ namespace oglopp {
 		}
 	}
 
+	/** @brief Check the active attributes of the linked program to see if it only reads the position attribute
+	 * @return True if location 0 is the only active vertex attribute
+ 	*/
+	bool Shader::reflectPositionOnly() const {
+		GLint attributes = 0;
+		glGetProgramiv(this->ID, GL_ACTIVE_ATTRIBUTES, &attributes);
+		if (attributes != 1) {
+			return false;
+		}
+
+		char name[128];
+		GLint size;
+		GLenum type;
+		glGetActiveAttrib(this->ID, 0, sizeof(name), nullptr, &size, &type, name);
+
+		return glGetAttribLocation(this->ID, name) == 0;
+	}
+
 	/** @brief Get the texture uniform string for use in fragment shaders
 	 * @param[in] textureId	The texture number from 0 to 32
 	*/
@@ -225,4 +245,32 @@ namespace oglopp {
 
 		return *this;
 	}
+
+	/** @brief Check if this shader only reads the position attribute. Detected automatically when the program is linked.
+	 * 	Shapes with a separate position stream draw with their position-only VAO for these shaders.
+	 * @return True if the shader is position-only
+ 	*/
+	bool Shader::isPositionOnly() const {
+		return this->positionOnly;
+	}
+
+	/** @brief Check if the program linked. A stage which failed to compile also fails the link
+	 * @return True if the program is usable
+ 	*/
+	bool Shader::isLinked() const {
+		GLint success = GL_FALSE;
+		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+
+		return success == GL_TRUE;
+	}
+
+	/** @brief Override the position-only detection
+	 * @param[in] value	True to treat this shader as position-only
+	 * @return			A reference to this shader object
+ 	*/
+	Shader& Shader::setPositionOnly(bool value) {
+		this->positionOnly = value;
+
+		return *this;
+	}
 }
@@ -1,8 +1,10 @@
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <glm/ext/vector_float2.hpp>
 #include <iostream>
 #include <iterator>
+#include <algorithm>
 
 #include "oglopp/defines.h"
 #include "oglopp/glad/gl.h"
@@ -84,7 +86,9 @@ namespace oglopp {
 
 	Shape& Shape::updateEBO() {
 		// Create the element buffer object
-		glGenBuffers(1, &this->EBO);
+		if (this->EBO == 0) {
+			glGenBuffers(1, &this->EBO);
+		}
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indexCount * HLGL_EBO_COMPONENTS * sizeof(unsigned int), this->indices.data(), GL_STATIC_DRAW);
 
@@ -93,7 +97,9 @@ namespace oglopp {
 
 	Shape& Shape::updateVBO() {
 		// Create an empty vertex buffer object
-		glGenBuffers(1, &this->VBO);
+		if (this->VBO == 0) {
+			glGenBuffers(1, &this->VBO);
+		}
 
 		// Bind the newly created buffer to the array buffer
 		glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
@@ -104,72 +110,201 @@ namespace oglopp {
 		return *this;
 	}
 
-	/** @brief Update the vertex, index, and texture coordinate list. Expected to be called when the texture list is modified.
-	 * @param[in] color		Include the color/normal vec3
-	 * @param[in] texture	Include the texture coord vec2
-	 * @param[in] option	Include the option uint16_t
-	 * @return	A reference to this shape object
+	/** @brief Upload the vertex streams and set the attribute pointers for every attribute in this->attributes
+	 * @return A reference to this shape object
 	*/
-	Shape& Shape::updateVAO(bool color, bool texture, bool option) {
-		// Calculate the stride bytes
-		this->strideElements = HLGL_VEC_COMPONENTS + (color ? HLGL_COL_COMPONENTS : 0) + (texture ? HLGL_TEX_COMPONENTS : 0) + (option ? HLGL_OPT_COMPONENTS : 0);
-		this->strideBytes = this->strideElements * sizeof(float);
-			//HLGL_VEC_COMPONENTS * sizeof(float) + (color ? HLGL_COL_COMPONENTS * sizeof(float) : 0) + (texture ? HLGL_TEX_COMPONENTS * sizeof(float) : 0) + (option ? HLGL_OPT_COMPONENTS * sizeof(float) : 0);
+	Shape& Shape::buildVAO() {
+		// Start from scratch so attributes from a previous layout are not left enabled
+		this->deleteBuffers();
+
+		// Group the attributes into streams. A new stream begins at every attribute index listed in streamStarts
+		std::vector<std::vector<Attribute const*>> streams;
+		for (Attribute const& attribute : this->attributes) {
+			bool newStream = streams.empty();
+			for (uint8_t start : this->streamStarts) {
+				newStream |= (start == attribute.index);
+			}
 
-		glGenVertexArrays(1, &this->VAO);
-		// Initialization code (done once (unless your object frequently changes))
+			if (newStream) {
+				streams.emplace_back();
+			}
+			streams.back().push_back(&attribute);
+		}
 
 		// 1. bind Vertex Array Object
+		glGenVertexArrays(1, &this->VAO);
 		glBindVertexArray(this->VAO);
 
-		// Update Vertex Buffer Object
-		this->updateVBO();
-
 		// Update Enitty Buffer Object
 		if (this->indexCount > 0) {
 			this->updateEBO();
 		}
 
-		unsigned long int offset = 0;
-		int index = 0;
+		if (streams.size() <= 1) {
+			// Single interleaved stream, upload the vertices as they are
+			this->updateVBO();
 
-		// 3. then set our vertex attributes pointers
-		glVertexAttribPointer(index, HLGL_VEC_COMPONENTS, GL_FLOAT, GL_FALSE, this->strideBytes, (void*)offset);
-		glEnableVertexAttribArray(index);
-		offset += HLGL_VEC_COMPONENTS * sizeof(float);
-		index++;
+			for (Attribute const& attribute : this->attributes) {
+				Shape::setAttribPointer(attribute, this->strideBytes, attribute.offset);
+			}
+		} else {
+			this->streamVBOs.resize(streams.size() - 1, 0);
+			glGenBuffers(this->streamVBOs.size(), this->streamVBOs.data());
+			glGenBuffers(1, &this->VBO);
+
+			std::vector<uint8_t> streamData;
+			for (size_t s = 0; s < streams.size(); s++) {
+				// Calculate the stride of this stream alone
+				uint32_t streamStride = 0;
+				for (Attribute const* attribute : streams[s]) {
+					streamStride += attribute->bytes;
+				}
+
+				// De-interleave this stream's attributes out of the vertex list
+				streamData.resize(static_cast<size_t>(this->vertCount) * streamStride);
+				for (size_t v = 0; v < this->vertCount; v++) {
+					uint8_t const* src = this->vertices.data() + v * this->strideBytes;
+					uint8_t* dst = streamData.data() + v * streamStride;
+
+					for (Attribute const* attribute : streams[s]) {
+						std::memcpy(dst, src + attribute->offset, attribute->bytes);
+						dst += attribute->bytes;
+					}
+				}
+
+				glBindBuffer(GL_ARRAY_BUFFER, (s == 0) ? this->VBO : this->streamVBOs[s - 1]);
+				glBufferData(GL_ARRAY_BUFFER, streamData.size(), streamData.data(), GL_STATIC_DRAW);
+
+				uint64_t offset = 0;
+				for (Attribute const* attribute : streams[s]) {
+					Shape::setAttribPointer(*attribute, streamStride, offset);
+					offset += attribute->bytes;
+				}
+			}
+
+			// Position-only variant. Depth-only passes fetch just the position stream
+			if (streams[0].size() == 1 && streams[0][0]->index == 0) {
+				glGenVertexArrays(1, &this->depthVAO);
+				glBindVertexArray(this->depthVAO);
+
+				if (this->indexCount > 0) {
+					glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+				}
+
+				glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+				Shape::setAttribPointer(*streams[0][0], streams[0][0]->bytes, 0);
+			}
+		}
+
+		// Unbind the vertex array
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		return *this;
+	}
+
+	/** @brief Delete the vertex array objects and all stream buffers
+	 * @return A reference to this shape object
+	*/
+	Shape& Shape::deleteBuffers() {
+		glDeleteBuffers(1, &this->VBO);
+		glDeleteBuffers(1, &this->EBO);
+		glDeleteVertexArrays(1, &this->VAO);
+		glDeleteVertexArrays(1, &this->depthVAO);
+		if (!this->streamVBOs.empty()) {
+			glDeleteBuffers(this->streamVBOs.size(), this->streamVBOs.data());
+		}
+
+		this->VBO = this->EBO = this->VAO = this->depthVAO = 0;
+		this->streamVBOs.clear();
+
+		return *this;
+	}
+
+	/** @brief Set the attribute pointer for the currently bound array buffer
+	 * @param[in] attribute	The attribute to describe
+	 * @param[in] stride	The stride in bytes of the stream containing the attribute
+	 * @param[in] offset	The offset in bytes of the attribute within the stream
+	*/
+	void Shape::setAttribPointer(Attribute const& attribute, uint32_t stride, uint64_t offset) {
+		switch(attribute.type) {
+			case FLOAT:
+			case VEC2:
+			case VEC3:
+			case VEC4:
+				glVertexAttribPointer(attribute.index, attribute.elements, Shape::getStructComponentRegister(attribute.type), GL_FALSE, stride, (void*)offset);
+				break;
+
+			case DVEC4:
+			case DVEC3:
+			case DVEC2:
+			case DOUBLE:
+				glVertexAttribLPointer(attribute.index, attribute.elements, Shape::getStructComponentRegister(attribute.type), stride, (void*)offset);
+				break;
+
+			case UINT8:
+			case UINT16:
+			case UINT32:
+			case INT8:
+			case INT16:
+			case INT32:
+			case IVEC2:
+			case I64VEC2:
+			case UVEC2:
+			case U64VEC2:
+			case IVEC3:
+			case I64VEC3:
+			case UVEC3:
+			case U64VEC3:
+			case IVEC4:
+			case I64VEC4:
+			case UVEC4:
+			case U64VEC4:
+				glVertexAttribIPointer(attribute.index, attribute.elements, Shape::getStructComponentRegister(attribute.type), stride, (void*)offset);
+				break;
+
+			default:
+				return;
+		}
+
+		glEnableVertexAttribArray(attribute.index);
+	}
+
+	/** @brief Update the vertex, index, and texture coordinate list. Expected to be called when the texture list is modified.
+	 * @param[in] color		Include the color/normal vec3
+	 * @param[in] texture	Include the texture coord vec2
+	 * @param[in] option	Include the option uint16_t
+	 * @return	A reference to this shape object
+	*/
+	Shape& Shape::updateVAO(bool color, bool texture, bool option) {
+		// Calculate the stride bytes
+		this->strideElements = HLGL_VEC_COMPONENTS + (color ? HLGL_COL_COMPONENTS : 0) + (texture ? HLGL_TEX_COMPONENTS : 0) + (option ? HLGL_OPT_COMPONENTS : 0);
+		this->strideBytes = this->strideElements * sizeof(float);
+
+		// Describe the attributes. The locations stay fixed even if an attribute is excluded
+		uint32_t offset = 0;
+		this->attributes.clear();
 
+		this->attributes.push_back({0, VEC3, HLGL_VEC_COMPONENTS, HLGL_VEC_COMPONENTS * sizeof(float), offset});
+		offset += HLGL_VEC_COMPONENTS * sizeof(float);
 
 		// Color (Used for Normals now uhhh idk man how this stuff is supposed to be generalized now.. I Need like a billion templates and stuff I don't wanna)
 		if (color) {
-			// 4. Set the colour attribute
-			glVertexAttribPointer(index, HLGL_COL_COMPONENTS, GL_FLOAT, GL_FALSE, this->strideBytes, (void*)offset);
-			glEnableVertexAttribArray(index);
+			this->attributes.push_back({1, VEC3, HLGL_COL_COMPONENTS, HLGL_COL_COMPONENTS * sizeof(float), offset});
 			offset += HLGL_COL_COMPONENTS * sizeof(float);
 		}
-		index++;
 
 		if (texture) {
-			// 5. Set the texture attribute
-			glVertexAttribPointer(index, HLGL_TEX_COMPONENTS, GL_FLOAT, GL_FALSE, this->strideBytes, (void*)offset);
-			glEnableVertexAttribArray(index);
+			this->attributes.push_back({2, VEC2, HLGL_TEX_COMPONENTS, HLGL_TEX_COMPONENTS * sizeof(float), offset});
 			offset += HLGL_TEX_COMPONENTS * sizeof(float);
 		}
-		index++;
 
 		if (option) {
-			// 5. Set the texture attribute
-			glVertexAttribPointer(index, HLGL_OPT_COMPONENTS, GL_FLOAT, GL_FALSE, this->strideBytes, (void*)offset);
-			glEnableVertexAttribArray(index);
+			this->attributes.push_back({3, FLOAT, HLGL_OPT_COMPONENTS, HLGL_OPT_COMPONENTS * sizeof(float), offset});
 			offset += HLGL_OPT_COMPONENTS * sizeof(float);
 		}
-		index++;
 
-		// Unbind the vertex array
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-
-		return *this;
+		return this->buildVAO();
 	}
 
 	/** @brief Replacement for updateVAO. Allows dynamically specifying the type of value. Termination case
@@ -177,19 +312,7 @@ namespace oglopp {
 	 * @return 	A reference to this shape object
  	*/
 	Shape& Shape::finalizePoints(const int totalIndices) {
-		glGenVertexArrays(1, &this->VAO);
-		// Initialization code (done once (unless your object frequently changes))
-
-		// 1. bind Vertex Array Object
-		glBindVertexArray(this->VAO);
-
-		// Update Vertex Buffer Object
-		this->updateVBO();
-
-		// Update Enitty Buffer Object
-		if (this->indexCount > 0) {
-			this->updateEBO();
-		}
+		this->buildVAO();
 
 		std::cout << "FIN Index count " << this->indexCount << std::endl;
 		std::cout << "FIN Stride bytes " << this->strideBytes << std::endl;
@@ -198,6 +321,23 @@ namespace oglopp {
 		return *this;
 	}
 
+	/** @brief Split the vertex data into multiple streams (buffers). Each value is the attribute index that begins a new stream.
+	 * 	For example, {1} places the position (attribute 0) in its own buffer and everything else in a second buffer.
+	 * 	When the position is alone in the first stream, a position-only VAO is also built and used automatically for position-only shaders (depth prepass, shadow maps).
+	 * 	If the shape was already uploaded, the buffers are rebuilt with the new layout.
+	 * @param[in] firstAttributes	The attribute indices which begin a new stream. Empty for a single interleaved stream
+	 * @return						A reference to this shape object
+ 	*/
+	Shape& Shape::setStreams(std::vector<uint8_t> const& firstAttributes) {
+		this->streamStarts = firstAttributes;
+
+		if (this->VAO != 0) {
+			this->buildVAO();
+		}
+
+		return *this;
+	}
+
 	/** @brief Convert a shape DataType to a stride element count
 	 * @param[in] dataType	The data type
 	 * @return				The number of associated stride elements/components
@@ -385,9 +525,7 @@ namespace oglopp {
 	}
 
 	Shape::~Shape() {
-		glDeleteBuffers(1, &this->VBO);
-		glDeleteBuffers(1, &this->EBO);
-		glDeleteVertexArrays(1, &this->VAO);
+		this->deleteBuffers();
 	}
 
 	/** @brief Push a single point to the shape.
@@ -559,6 +697,21 @@ namespace oglopp {
 		return this->VBO;
 	}
 
+	unsigned int Shape::getDepthVAO() {
+		return this->depthVAO;
+	}
+
+	unsigned int Shape::getVertCount() {
+		return this->vertCount;
+	}
+
+	/** @brief Get the number of indices (three per triangle), as an indexed draw command's count
+	 * @return The number of indices
+	*/
+	unsigned int Shape::getElementCount() {
+		return this->indexCount * HLGL_EBO_COMPONENTS;
+	}
+
 	std::vector<uint8_t>& Shape::getVertices() {
 		return this->vertices;
 	}
@@ -567,12 +720,12 @@ namespace oglopp {
 		return this->textures;
 	}
 
-	/** @brief Draw this shape to the specified window using an optional shader
-	* @param[in] window		A reference to the window object
-	* @param[in] pShader	An optional pointer to the shader object
-	* @return 				A reference to this shape
+	/** @brief Use the shader, set its MVP and textures, and bind the vertex array, ready for a draw call
+	 * @param[in] window	A reference to the window object
+	 * @param[in] pShader	An optional pointer to the shader object
+	 * @return				The draw type of the shader, or TRIANGLES without one
 	*/
-	Shape& Shape::draw(Window& window, Shader* pShader) {
+	DrawType Shape::prepareDraw(Window& window, Shader* pShader) {
 		DrawType drawType = TRIANGLES;
 
 		this->size = this->textures.size();
@@ -600,8 +753,23 @@ namespace oglopp {
 			}
 		}
 
-		// Bind vertex array
-		glBindVertexArray(this->VAO);
+		// Bind vertex array. Position-only shaders use the position stream alone when the shape has one
+		if (pShader != nullptr && this->depthVAO != 0 && pShader->isPositionOnly()) {
+			glBindVertexArray(this->depthVAO);
+		} else {
+			glBindVertexArray(this->VAO);
+		}
+
+		return drawType;
+	}
+
+	/** @brief Draw this shape to the specified window using an optional shader
+	* @param[in] window		A reference to the window object
+	* @param[in] pShader	An optional pointer to the shader object
+	* @return 				A reference to this shape
+	*/
+	Shape& Shape::draw(Window& window, Shader* pShader) {
+		DrawType drawType = this->prepareDraw(window, pShader);
 
 		// Draw
 		switch (drawType) {
@@ -637,6 +805,82 @@ namespace oglopp {
 		return *this;
 	}
 
+	/** @brief Draw this shape once per command in an indirect buffer, eg. written by a culling compute shader.
+	 *  Shapes with indices need a DrawElementsIndirectBuffer, shapes without a DrawArraysIndirectBuffer
+	 * @param[in] window	A reference to the window object
+	 * @param[in] pShader	A pointer to the shader object
+	 * @param[in] commands	The draw commands
+	 * @param[in] maxDraws	The most commands drawn. 0 for the buffer's capacity. The count in the buffer is used when
+	 *						GL 4.6 or ARB_indirect_parameters is available, otherwise exactly maxDraws are drawn
+	 * @return 				A reference to this shape
+	*/
+	Shape& Shape::drawIndirect(Window& window, Shader* pShader, IndirectBuffer& commands, uint32_t maxDraws) {
+		bool indexed = this->indexCount > 0;
+		GLsizei expectedStride = indexed ? sizeof(DrawElementsIndirectBuffer::Command) : sizeof(DrawArraysIndirectBuffer::Command);
+
+		if (commands.getStride() != expectedStride) {
+			std::cout << "[Oglopp] Indirect draw of a shape " << (indexed ? "with" : "without") << " indices needs a " << (indexed ? "DrawElementsIndirectBuffer" : "DrawArraysIndirectBuffer") << std::endl;
+			return *this;
+		}
+
+		GLsizei drawCount = (maxDraws == 0) ? commands.getCapacity() : std::min(maxDraws, commands.getCapacity());
+
+		DrawType drawType = this->prepareDraw(window, pShader);
+
+		GLenum mode;
+		switch (drawType) {
+			default:
+			case TRIANGLES:
+				mode = GL_TRIANGLES;
+				break;
+			case LINE_LOOP:
+			case LINE:
+				mode = indexed ? GL_LINES : ((drawType == LINE) ? GL_LINE_STRIP : GL_LINE_LOOP);
+				break;
+			case POINTS:
+				mode = GL_POINTS;
+				break;
+		}
+
+		// Waits for the shader which wrote the commands, if any. The count is read from the same buffer
+		commands.bindIndirect(GL_DRAW_INDIRECT_BUFFER);
+		const void* firstCommand = reinterpret_cast<const void*>(commands.getOffset(0));
+
+		if (IndirectBuffer::hasIndirectCount()) {
+			commands.bindIndirect(GL_PARAMETER_BUFFER);
+
+			if (indexed) {
+				if (GLAD_GL_VERSION_4_6) {
+					glMultiDrawElementsIndirectCount(mode, GL_UNSIGNED_INT, firstCommand, 0, drawCount, 0);
+				} else {
+					glMultiDrawElementsIndirectCountARB(mode, GL_UNSIGNED_INT, firstCommand, 0, drawCount, 0);
+				}
+			} else {
+				if (GLAD_GL_VERSION_4_6) {
+					glMultiDrawArraysIndirectCount(mode, firstCommand, 0, drawCount, 0);
+				} else {
+					glMultiDrawArraysIndirectCountARB(mode, firstCommand, 0, drawCount, 0);
+				}
+			}
+
+			glBindBuffer(GL_PARAMETER_BUFFER, 0);
+		} else {
+			// Without the count every command is drawn. Commands past it must keep an instanceCount of 0, as reset() leaves them
+			if (indexed) {
+				glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, firstCommand, drawCount, 0);
+			} else {
+				glMultiDrawArraysIndirect(mode, firstCommand, drawCount, 0);
+			}
+		}
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		// Unbind vertex array
+		glBindVertexArray(0);
+
+		return *this;
+	}
+
 	/** @brief Get the position of this shape
 	* @return The position of this shape
 	*/
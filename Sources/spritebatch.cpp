@@ -0,0 +1,301 @@
+#include "oglopp/spritebatch.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace oglopp {
+
+	SpriteBatch::SpriteBatch() {
+		this->shader = std::make_unique<Shader>(
+		"#version 450 core\n"\
+		// The Rectangle's corners and texture coordinates
+		"layout (location = 0) in vec3 aPos;\n"\
+		"layout (location = 2) in vec2 aTexCoord;\n"\
+		\
+		"struct Sprite {\n"\
+			"vec4 rect;\n"\
+			"vec4 region;\n"\
+			"vec4 color;\n"\
+			"vec4 extra;\n"\
+		"};\n"\
+		"layout (std430, binding = 0) readonly buffer Sprites { Sprite sprites[]; };\n"\
+		\
+		"uniform mat4 projection;\n"\
+		"uniform uint firstSprite;\n"\
+		\
+		"out vec2 texCoord;\n"\
+		"out vec4 color;\n"\
+		"flat out float layer;\n"\
+		\
+		"void main() {\n"\
+			"Sprite sprite = sprites[firstSprite + gl_InstanceID];\n"\
+			\
+			"float c = cos(sprite.extra.x);\n"\
+			"float s = sin(sprite.extra.x);\n"\
+			"vec2 offset = mat2(c, s, -s, c) * (aPos.xy * sprite.rect.zw);\n"\
+			"gl_Position = projection * vec4(sprite.rect.xy + offset, 0.0, 1.0);\n"\
+			\
+			// The region is measured from the top of the image, which was loaded bottom up
+			"vec2 fromTop = mix(sprite.region.xy, sprite.region.zw, aTexCoord);\n"\
+			"texCoord = vec2(fromTop.x, 1.0 - fromTop.y);\n"\
+			"color = sprite.color;\n"\
+			"layer = sprite.extra.y;\n"\
+		"}\n",
+		\
+		"#version 450 core\n"\
+		"in vec2 texCoord;\n"\
+		"in vec4 color;\n"\
+		"flat in float layer;\n"\
+		"out vec4 FragColor;\n"\
+		\
+		// 0 for no texture, 1 for a texture, 2 for a texture array. Each sampler type has its own unit
+		"uniform int source;\n"\
+		"uniform sampler2D sprite;\n"\
+		"uniform sampler2DArray spriteArray;\n"\
+		\
+		"void main() {\n"\
+			"vec4 result = color;\n"\
+			"if (source == 1) {\n"\
+				"result *= texture(sprite, texCoord);\n"\
+			"} else if (source == 2) {\n"\
+				"result *= texture(spriteArray, vec3(texCoord, layer));\n"\
+			"}\n"\
+			\
+			"if (result.a <= 0.0) {\n"\
+				"discard;\n"\
+			"}\n"\
+			"FragColor = result;\n"\
+		"}\n", ShaderType::RAW);
+	}
+
+	/** @brief Start a batch in pixels over the current viewport, origin at the top left, y down
+	 * @return A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::begin() {
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		return this->begin(glm::ortho(0.0f, static_cast<float>(viewport[2]), static_cast<float>(viewport[3]), 0.0f, -1.0f, 1.0f));
+	}
+
+	/** @brief Start a batch with a projection
+	 * @param[in] projection	Transforms sprite positions to clip space
+	 * @return					A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::begin(glm::mat4 const& projection) {
+		this->projection = projection;
+
+		this->sprites.clear();
+		this->spriteGroups.clear();
+		this->groups.clear();
+		this->groupIndices.clear();
+		this->lastKey = ~uint64_t(0);
+
+		return *this;
+	}
+
+	/** @brief Add a sprite
+	 * @param[in] texture	The texture, or nullptr for a plain colored quad. It must live until end()
+	 * @param[in] center	The center
+	 * @param[in] size		The width and height
+	 * @param[in] color		The color, multiplied with the texture
+	 * @param[in] region	The part of the texture to show: left, top, right, bottom, from 0 to 1 from the top left
+	 * @param[in] rotation	The rotation in radians about the center
+	 * @return				A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::draw(Texture* texture, glm::vec2 const& center, glm::vec2 const& size, glm::vec4 const& color, glm::vec4 const& region, float rotation) {
+		this->sprites.push_back(Sprite{glm::vec4(center, size), region, color, glm::vec4(rotation, 0.0, 0.0, 0.0)});
+		this->spriteGroups.push_back(this->getGroup(texture, 0));
+
+		return *this;
+	}
+
+	/** @brief Add a sprite from a layer of a texture array
+	 * @param[in] textureArray	The GL name of a GL_TEXTURE_2D_ARRAY, its rows uploaded bottom up like Texture does
+	 * @param[in] layer			The layer
+	 * @param[in] center		The center
+	 * @param[in] size			The width and height
+	 * @param[in] color			The color, multiplied with the texture
+	 * @param[in] region		The part of the layer to show: left, top, right, bottom, from 0 to 1 from the top left
+	 * @param[in] rotation		The rotation in radians about the center
+	 * @return					A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::drawLayer(GLuint textureArray, uint32_t layer, glm::vec2 const& center, glm::vec2 const& size, glm::vec4 const& color, glm::vec4 const& region, float rotation) {
+		this->sprites.push_back(Sprite{glm::vec4(center, size), region, color, glm::vec4(rotation, static_cast<float>(layer), 0.0, 0.0)});
+		this->spriteGroups.push_back(this->getGroup(nullptr, textureArray));
+
+		return *this;
+	}
+
+	/** @brief Find or add the group of a texture
+	 * @param[in] texture	The texture, or nullptr
+	 * @param[in] array		The texture array, or 0
+	 * @return				The group index
+ 	*/
+	uint32_t SpriteBatch::getGroup(Texture* texture, GLuint array) {
+		// Texture pointers and array names can't collide: arrays set the top bit
+		uint64_t key = texture != nullptr ? reinterpret_cast<uintptr_t>(texture) : (array != 0 ? (uint64_t(1) << 63) | array : 0);
+
+		// Sprites mostly come in runs of one texture, which skip the hash lookup
+		if (key == this->lastKey) {
+			return this->lastGroup;
+		}
+
+		auto [found, added] = this->groupIndices.try_emplace(key, static_cast<uint32_t>(this->groups.size()));
+		if (added) {
+			this->groups.push_back(Group{texture, array});
+		}
+
+		this->lastKey = key;
+		this->lastGroup = found->second;
+
+		return this->lastGroup;
+	}
+
+	/** @brief Upload the batch and draw it, one draw per group
+	 * @return A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::end() {
+		this->drawn = this->sprites.size();
+		this->draws = 0;
+
+		if (this->sprites.empty()) {
+			return *this;
+		}
+
+		size_t count = this->sprites.size();
+
+		// The ring only grows, with room to spare so a few more sprites don't make it grow every frame
+		if (this->ring.size() < count) {
+			std::vector<Sprite> empty(count + count / 2, Sprite{});
+			if (this->ring.assignPersistent(empty) != 0) {
+				this->ring.assign(empty);
+			}
+		}
+
+		// Without persistent storage, the sprites go through a copy instead
+		std::vector<Sprite> staging;
+		std::span<Sprite> out = this->ring.writeSpan(this->frame++);
+		if (out.empty()) {
+			staging.resize(count);
+			out = staging;
+		}
+
+		// Each run is one draw: a group, and a range of the ring
+		struct Run {
+			uint32_t group;
+			uint32_t first;
+			uint32_t count;
+		};
+		std::vector<Run> runs;
+
+		if (this->sortMode == TEXTURE) {
+			// Counting sort by group. Stable, and O(sprites + groups)
+			this->groupStarts.assign(this->groups.size() + 1, 0);
+			for (uint32_t group : this->spriteGroups) {
+				this->groupStarts[group + 1]++;
+			}
+
+			for (uint32_t group = 0; group < this->groups.size(); group++) {
+				runs.push_back(Run{group, this->groupStarts[group], this->groupStarts[group + 1]});
+				this->groupStarts[group + 1] += this->groupStarts[group];
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				out[this->groupStarts[this->spriteGroups[i]]++] = this->sprites[i];
+			}
+		} else {
+			std::copy(this->sprites.begin(), this->sprites.end(), out.begin());
+
+			for (size_t i = 0; i < count; i++) {
+				if (runs.empty() || runs.back().group != this->spriteGroups[i]) {
+					runs.push_back(Run{this->spriteGroups[i], static_cast<uint32_t>(i), 0});
+				}
+				runs.back().count++;
+			}
+		}
+
+		if (!staging.empty()) {
+			this->ring.set(0, staging);
+		}
+
+		this->shader->use();
+		this->shader->setMat4("projection", this->projection);
+		this->shader->setInt("sprite", 0);
+		this->shader->setInt("spriteArray", 1);
+
+		this->ring.bind(SPRITE_BINDING);
+
+		GLboolean blendWas = glIsEnabled(GL_BLEND);
+		GLboolean depthWas = glIsEnabled(GL_DEPTH_TEST);
+		GLint blendFuncWas[4];
+		glGetIntegerv(GL_BLEND_SRC_RGB, &blendFuncWas[0]);
+		glGetIntegerv(GL_BLEND_DST_RGB, &blendFuncWas[1]);
+		glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendFuncWas[2]);
+		glGetIntegerv(GL_BLEND_DST_ALPHA, &blendFuncWas[3]);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		glBindVertexArray(this->quad.getVAO());
+
+		// The shader adds the first sprite itself. gl_BaseInstance would need GLSL 4.60
+		for (Run const& run : runs) {
+			this->bindGroup(this->groups[run.group]);
+			this->shader->setUInt("firstSprite", run.first);
+			glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, run.count);
+			this->draws++;
+		}
+
+		glBindVertexArray(0);
+
+		glBlendFuncSeparate(blendFuncWas[0], blendFuncWas[1], blendFuncWas[2], blendFuncWas[3]);
+		if (!blendWas) {
+			glDisable(GL_BLEND);
+		}
+		if (depthWas) {
+			glEnable(GL_DEPTH_TEST);
+		}
+
+		return *this;
+	}
+
+	/** @brief Bind a group's texture for the next draw
+	 * @param[in] group		The group
+ 	*/
+	void SpriteBatch::bindGroup(Group const& group) {
+		if (group.texture != nullptr) {
+			this->shader->setInt("source", 1);
+			group.texture->bind(GL_TEXTURE0);
+		} else if (group.array != 0) {
+			this->shader->setInt("source", 2);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, group.array);
+		} else {
+			this->shader->setInt("source", 0);
+		}
+	}
+
+	/** @brief Set how sprites are grouped into draws
+	 * @param[in] mode	The sort mode
+	 * @return			A reference to this object
+ 	*/
+	SpriteBatch& SpriteBatch::setSortMode(SortMode mode) {
+		this->sortMode = mode;
+
+		return *this;
+	}
+
+	/** @brief Get the number of sprites the last end() drew
+	 * @return The sprite count
+ 	*/
+	size_t SpriteBatch::getSpriteCount() const {
+		return this->drawn;
+	}
+
+	/** @brief Get the number of draws the last end() made
+	 * @return The draw count
+ 	*/
+	size_t SpriteBatch::getDrawCount() const {
+		return this->draws;
+	}
+}
@@ -1,8 +1,47 @@
 #include "oglopp/ssbo.h"
+#include "oglopp/readback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
 
 namespace oglopp {
 
-	/** @brief Copy the data in a pointer into the ssbo to be sent to the GPU on dispatch
+	/** @brief Delete the GL buffer
+ 	*/
+	SSBO::~SSBO() {
+		for (GLsync fence : this->fences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+			}
+		}
+
+		if (this->ssbo != 0) {
+			glDeleteBuffers(1, &this->ssbo);
+		}
+	}
+
+	SSBO::SSBO(SSBO&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	// Swapping leaves the other SSBO with whatever this one held, which it deletes in turn
+	SSBO& SSBO::operator=(SSBO&& other) noexcept {
+		std::swap(this->ssbo, other.ssbo);
+		std::swap(this->bufferSize, other.bufferSize);
+		std::swap(this->capacityBytes, other.capacityBytes);
+		std::swap(this->lastWrite, other.lastWrite);
+		std::swap(this->regions, other.regions);
+		std::swap(this->region, other.region);
+		std::swap(this->regionStride, other.regionStride);
+		std::swap(this->persistent, other.persistent);
+		std::swap(this->fences, other.fences);
+
+		return *this;
+	}
+
+	/** @brief Copy the data in a pointer into the ssbo to be sent to the GPU on dispatch. Loading again reuses the GL buffer
 	 * @param[in] buffer	A pointer to some buffer
 	 * @param[in] size		The number of bytes to be read from the buffer
 	 * @return				A status code. 0 for success. -1 for failure.
@@ -12,11 +51,21 @@ namespace oglopp {
 			return -1;
 		}
 
+		// Immutable storage can't be respecified
+		if (this->isPersistent()) {
+			this->releasePersistent();
+		}
+
 		// Update the size
 		this->bufferSize = size;
+		this->capacityBytes = size;
 
-		// Prepare ssbo
-		glGenBuffers(1, &this->ssbo);
+		// Prepare ssbo. Earlier shader writes must land before the store is replaced
+		if (this->ssbo == 0) {
+			glGenBuffers(1, &this->ssbo);
+		} else {
+			this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+		}
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
 
 		// Copy buffer into ssbo
@@ -44,8 +93,16 @@ namespace oglopp {
 			return -2;
 		}
 
+		// Coherent memory needs no copy and no flush, only for the GPU to be done reading the region
+		if (this->isPersistent()) {
+			this->waitForRegion();
+			std::memcpy(this->persistent + this->getRegionOffset() + offset, buffer, size);
+			return 0;
+		}
+
 		//glBindBufferBase(GL_SHADER_STORAGE_BUFFER, this->binding, ssbo);
 		//this->use();
+		this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
 
 		// Bind the ssbo
@@ -62,7 +119,11 @@ namespace oglopp {
 	 * @return				A reference to the SSBO 0
  	*/
 	SSBO& SSBO::bind(int binding) {
-		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo);
+		if (this->isPersistent()) {
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, this->ssbo, this->getRegionOffset(), this->bufferSize);
+		} else {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, this->ssbo);
+		}
 		return *this;
 	}
 
@@ -79,11 +140,49 @@ namespace oglopp {
 		return this->bufferSize;
 	}
 
+	/** @brief Get the GL buffer object name
+	 * @return	The buffer name, for binding it to other targets (uniform, atomic counter, indirect)
+ 	*/
+	GLuint SSBO::getBuffer() const {
+		return this->ssbo;
+	}
+
+	/** @brief Record that a shader wrote to this buffer (storage or atomic counter writes). Compute::dispatch() does this for its buffers
+	 * @return	A reference to this SSBO object
+ 	*/
+	SSBO& SSBO::markWritten() {
+		Hazards::written(this->lastWrite);
+
+		return *this;
+	}
+
+	/** @brief Issue the barrier bits needed before this buffer is used in some way, if a shader wrote to it since they were last issued
+	 * @param[in] barriers	The bits for the kind of use, eg. GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT to draw from it
+	 * @return				A reference to this SSBO object
+ 	*/
+	SSBO& SSBO::sync(GLbitfield barriers) {
+		Hazards::require(this->lastWrite, barriers);
+
+		return *this;
+	}
+
 	/** @brief Map the SSBO to a buffer
 	 * @param[in] method	The method of mapping. READ, WRITE, or BOTH
 	 * @return 				A pointer to the mapped buffer
  	*/
 	void* SSBO::map(MapMethod method) {
+		if (this->isPersistent()) {
+			if (method != WRITE) {
+				std::cout << "[Oglopp] Persistent SSBOs are mapped for writing only. Use readbackAsync() to read one" << std::endl;
+				return nullptr;
+			}
+
+			this->waitForRegion();
+			return this->persistent + this->getRegionOffset();
+		}
+
+		this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
 		void* mapped = glMapBuffer(GL_SHADER_STORAGE_BUFFER, method);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
@@ -94,10 +193,244 @@ namespace oglopp {
 	/** @brief Unmap the mapped buffer
  	*/
 	SSBO& SSBO::unmap() {
+		// Persistent storage stays mapped until it is released
+		if (this->isPersistent()) {
+			return *this;
+		}
+
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
 		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
 		return *this;
 	}
+
+	/** @brief Start copying a range of the SSBO back to the CPU without waiting for the GPU. Poll the result with
+	 *  ready() on a later frame, rather than stalling in map() until every write to the buffer has finished
+	 * @param[in] offset	The start of the range in bytes
+	 * @param[in] size		The size of the range in bytes. 0 for the rest of the buffer
+	 * @param[in] ring		The staging buffers to copy into, or nullptr for the shared ring
+	 * @return				The pending readback, or nullptr if the range is out of bounds
+ 	*/
+	std::shared_ptr<Readback> SSBO::readbackAsync(size_t offset, size_t size, ReadbackRing* ring) {
+		if (ring == nullptr) {
+			ring = &ReadbackRing::getShared();
+		}
+
+		return ring->request(*this, offset, size);
+	}
+
+	/** @brief Move the contents to a new GL buffer of another capacity. The copy stays on the GPU
+	 * @param[in] capacity	The new capacity in bytes
+	 * @param[in] keep		The number of leading bytes to copy over
+	 * @return				A status code. 0 for success
+ 	*/
+	int8_t SSBO::reallocate(size_t capacity, size_t keep) {
+		size_t from = this->getRegionOffset();
+
+		// The copy below is the last use of the persistent storage. Deleting the buffer after it unmaps it
+		if (this->isPersistent()) {
+			for (GLsync& fence : this->fences) {
+				if (fence != nullptr) {
+					glDeleteSync(fence);
+					fence = nullptr;
+				}
+			}
+
+			this->fences.clear();
+			this->persistent = nullptr;
+			this->regions = 0;
+			this->region = 0;
+			this->regionStride = 0;
+		}
+
+		GLuint grown = 0;
+		glGenBuffers(1, &grown);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+
+		keep = keep < capacity ? keep : capacity;
+		if (this->ssbo != 0) {
+			if (keep > 0) {
+				// The copy reads the old buffer as a buffer update
+				this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+				glBindBuffer(GL_COPY_READ_BUFFER, this->ssbo);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, 0, keep);
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			}
+
+			glDeleteBuffers(1, &this->ssbo);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		this->ssbo = grown;
+		this->capacityBytes = capacity;
+
+		return 0;
+	}
+
+	/** @brief Create immutable, persistently mapped storage holding some number of regions of the same size.
+	 * Requires GL 4.4 or ARB_buffer_storage
+	 * @param[in] buffer	The initial contents of every region, or nullptr to zero them
+	 * @param[in] size		The size of a region in bytes
+	 * @param[in] regions	The number of regions. One per frame the CPU may run ahead of the GPU, plus one
+	 * @return				A status code. 0 for success. -1 if the size is 0. -2 if buffer storage is unavailable
+ 	*/
+	int8_t SSBO::loadPersistent(void* buffer, size_t size, uint32_t regions) {
+		if (size == 0) {
+			return -1;
+		}
+
+		if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage) {
+			std::cout << "[Oglopp] Persistent SSBOs need GL 4.4 or ARB_buffer_storage" << std::endl;
+			return -2;
+		}
+
+		if (regions == 0) {
+			regions = 1;
+		}
+
+		// Storage is immutable, so any previous buffer goes
+		if (this->isPersistent()) {
+			this->releasePersistent();
+		} else if (this->ssbo != 0) {
+			this->sync(GL_BUFFER_UPDATE_BARRIER_BIT);
+			glDeleteBuffers(1, &this->ssbo);
+			this->ssbo = 0;
+		}
+
+		// Each region starts on an offset glBindBufferRange accepts, as a storage or a uniform buffer
+		GLint storageAlignment = 1, uniformAlignment = 1;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		size_t alignment = static_cast<size_t>(std::max(std::max(storageAlignment, uniformAlignment), 1));
+
+		this->bufferSize = size;
+		this->regionStride = (size + alignment - 1) / alignment * alignment;
+		this->capacityBytes = size;
+		this->regions = regions;
+		this->region = 0;
+		this->fences.assign(regions, nullptr);
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glGenBuffers(1, &this->ssbo);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ssbo);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, this->regionStride * regions, nullptr, flags);
+		this->persistent = static_cast<uint8_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, this->regionStride * regions, flags));
+		SSBO::unbind();
+
+		if (this->persistent == nullptr) {
+			std::cout << "[Oglopp] Failed to map persistent SSBO storage" << std::endl;
+			this->releasePersistent();
+			return -2;
+		}
+
+		for (uint32_t i = 0; i < regions; i++) {
+			if (buffer != nullptr) {
+				std::memcpy(this->persistent + i * this->regionStride, buffer, size);
+			} else {
+				std::memset(this->persistent + i * this->regionStride, 0, size);
+			}
+		}
+
+		return 0;
+	}
+
+	/** @brief Select the region for a frame and get a pointer the CPU can write it through. Waits only if the GPU
+	 *  is still reading that region from regions frames ago. Only valid after loadPersistent()
+	 * @param[in] frame		A number increasing by one every frame
+	 * @return				A pointer to getSize() writable bytes, or nullptr if the buffer is not persistent
+ 	*/
+	void* SSBO::writePtr(uint64_t frame) {
+		if (!this->isPersistent()) {
+			std::cout << "[Oglopp] SSBO::writePtr needs a buffer made by loadPersistent()" << std::endl;
+			return nullptr;
+		}
+
+		uint32_t target = frame % this->regions;
+
+		// Every command reading the current region has been submitted, so fence it before moving on.
+		// A single region is fenced and waited on every time
+		if (target != this->region || this->regions == 1) {
+			if (this->fences[this->region] != nullptr) {
+				glDeleteSync(this->fences[this->region]);
+			}
+			this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			this->region = target;
+		}
+
+		GLsync& fence = this->fences[target];
+		if (fence != nullptr) {
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		return this->persistent + this->getRegionOffset();
+	}
+
+	/** @brief Check if the buffer was made by loadPersistent()
+	 * @return True if the buffer is persistently mapped
+ 	*/
+	bool SSBO::isPersistent() const {
+		return this->regions > 0;
+	}
+
+	/** @brief Get the number of regions in persistent storage
+	 * @return The region count, or 1 for a regular buffer
+ 	*/
+	uint32_t SSBO::getRegionCount() const {
+		return this->isPersistent() ? this->regions : 1;
+	}
+
+	/** @brief Get the byte offset of the region writePtr() last selected
+	 * @return The offset in the GL buffer. Always 0 for a regular buffer
+ 	*/
+	size_t SSBO::getRegionOffset() const {
+		return this->region * this->regionStride;
+	}
+
+	/** @brief Wait for the commands submitted so far to finish, since any of them may read the selected region
+ 	*/
+	void SSBO::waitForRegion() {
+		// writePtr() waited on the region's own fence when it selected it, but the commands since then may read it too
+		GLsync& fence = this->fences[this->region];
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+		}
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	/** @brief Wait for the GPU to finish with every region and go back to a regular buffer. The GL buffer is deleted
+ 	*/
+	void SSBO::releasePersistent() {
+		for (GLsync& fence : this->fences) {
+			if (fence != nullptr) {
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		// Deleting the buffer unmaps it
+		if (this->ssbo != 0) {
+			glDeleteBuffers(1, &this->ssbo);
+			this->ssbo = 0;
+		}
+
+		this->fences.clear();
+		this->persistent = nullptr;
+		this->regions = 0;
+		this->region = 0;
+		this->regionStride = 0;
+		this->bufferSize = 0;
+		this->capacityBytes = 0;
+	}
 }
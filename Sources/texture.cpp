@@ -44,6 +44,46 @@ namespace oglopp {
 		glGenerateMipmap(GL_TEXTURE_2D);
 	}
 
+	/** @brief Get the pixel format and type to pass alongside an internal format when allocating empty storage
+	 * @param[in]	format			The internal format
+	 * @param[out]	pixelFormat		The matching pixel format
+	 * @param[out]	pixelType		The matching pixel type
+	*/
+	void Texture::getPixelFormat(GLenum format, GLenum* pixelFormat, GLenum* pixelType) {
+		switch (format) {
+			case GL_DEPTH24_STENCIL8:
+				*pixelFormat = GL_DEPTH_STENCIL;
+				*pixelType = GL_UNSIGNED_INT_24_8;
+				return;
+
+			case GL_DEPTH32F_STENCIL8:
+				*pixelFormat = GL_DEPTH_STENCIL;
+				*pixelType = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+				return;
+
+			case GL_DEPTH_COMPONENT16:
+			case GL_DEPTH_COMPONENT24:
+			case GL_DEPTH_COMPONENT32F:
+				*pixelFormat = GL_DEPTH_COMPONENT;
+				*pixelType = GL_FLOAT;
+				return;
+
+			case GL_R8UI: case GL_R16UI: case GL_R32UI: case GL_RG32UI: case GL_RGBA8UI: case GL_RGBA16UI: case GL_RGBA32UI:
+				*pixelFormat = GL_RGBA_INTEGER;
+				*pixelType = GL_UNSIGNED_INT;
+				return;
+
+			case GL_R8I: case GL_R16I: case GL_R32I: case GL_RG32I: case GL_RGBA8I: case GL_RGBA16I: case GL_RGBA32I:
+				*pixelFormat = GL_RGBA_INTEGER;
+				*pixelType = GL_INT;
+				return;
+		}
+
+		// Normalized and float formats. No data is uploaded so any compatible type works
+		*pixelFormat = GL_RGBA;
+		*pixelType = GL_FLOAT;
+	}
+
 	/** @brief Texture constructor. Load texture
 	*/
 	Texture::Texture(const char* path, FileType type, bool nearest) {
@@ -54,22 +94,34 @@ namespace oglopp {
 	 * @brief Texture from FBO
 	 * @param[in] fbo	The FBO object to map. Automatically bound and unbound
 	 */
-	Texture::Texture(FBO& fbo, int newWidth, int newHeight, bool nearest) : width(newWidth), height(newHeight), channels(4) {
-		fbo.bind();
+	Texture::Texture(FBO& fbo, int newWidth, int newHeight, bool nearest) : Texture(newWidth, newHeight, GL_RGBA8, nearest) {
+		fbo.attachTexture(*this, GL_COLOR_ATTACHMENT0);
+
+		// Render targets clamp, but textures made from an FBO have always kept GL's default repeat wrapping
+		glBindTexture(GL_TEXTURE_2D, this->TID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		if (!fbo.isComplete())
+			throw new std::runtime_error("Failed to complete fbo prep before unbinding in texture.");
+	}
 
+	/**
+	 * @brief Create an empty texture with a given storage format. Used for render targets, eg. with FBO::attachTexture()
+	 * @param[in] width				The width of the texture
+	 * @param[in] height			The height of the texture
+	 * @param[in] internalFormat	The storage format, eg. GL_RGBA8, GL_RGB10_A2, GL_RGBA16F or GL_DEPTH24_STENCIL8
+	 * @param[in] nearest			Use nearest-neighbour texture filtering
+	 */
+	Texture::Texture(int newWidth, int newHeight, GLenum internalFormat, bool nearest) : width(newWidth), height(newHeight), channels(4), internalFormat(internalFormat) {
 		glGenTextures(1, &this->TID);
 		glBindTexture(GL_TEXTURE_2D, this->TID);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, newWidth, newHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
-
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->TID, 0);
-
-		if (fbo.isComplete())
-			fbo.unbind();
-		else
-			throw new std::runtime_error("Failed to complete fbo prep before unbinding in texture.");
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		this->resize(newWidth, newHeight);
 	}
 
 	/** @brief Texture destructor
@@ -88,15 +140,95 @@ namespace oglopp {
 		fbo.resize(rboWidth, rboHeight);
 
 		// Now resize this texture
+		return this->resize(rboWidth, rboHeight);
+	}
+
+	/**
+	 * @brief Reallocate the storage of a render target texture. The contents are lost
+	 * @param[in] newWidth	The new width
+	 * @param[in] newHeight	The new height
+	 * @return				A reference to this texture object
+	 */
+	Texture& Texture::resize(int newWidth, int newHeight) {
+		GLenum pixelFormat, pixelType;
+		Texture::getPixelFormat(this->internalFormat, &pixelFormat, &pixelType);
+
 		this->bind();
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rboWidth, rboHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-		this->width = rboWidth;
-		this->height = rboHeight;
+		glTexImage2D(GL_TEXTURE_2D, 0, this->internalFormat, newWidth, newHeight, 0, pixelFormat, pixelType, NULL);
+		this->width = newWidth;
+		this->height = newHeight;
 		this->channels = 4; // RGBA
 
 		return *this;
 	}
 
+	/** @brief Get the internal storage format of a render target texture
+	 * @return The internal format
+	*/
+	GLenum Texture::getInternalFormat() const {
+		return this->internalFormat;
+	}
+
+	/** @brief Get the GLSL image format qualifier of an internal format, for image2D declarations
+	 * @param[in] format	The internal format
+	 * @return				The qualifier, eg. "rgba16f". nullptr if the format cannot be used as an image
+	*/
+	const char* Texture::getImageFormat(GLenum format) {
+		switch (format) {
+			case GL_RGBA32F:
+				return "rgba32f";
+			case GL_RGBA16F:
+				return "rgba16f";
+			case GL_RG32F:
+				return "rg32f";
+			case GL_RG16F:
+				return "rg16f";
+			case GL_R32F:
+				return "r32f";
+			case GL_R16F:
+				return "r16f";
+			case GL_R11F_G11F_B10F:
+				return "r11f_g11f_b10f";
+			case GL_RGBA8:
+				return "rgba8";
+			case GL_RG8:
+				return "rg8";
+			case GL_R8:
+				return "r8";
+			case GL_RGB10_A2:
+				return "rgb10_a2";
+			case GL_RGBA32UI:
+				return "rgba32ui";
+			case GL_R32UI:
+				return "r32ui";
+			case GL_RGBA32I:
+				return "rgba32i";
+			case GL_R32I:
+				return "r32i";
+		}
+
+		return nullptr;
+	}
+
+	/** @brief Record that a shader wrote to this texture with imageStore. Compute::dispatch() does this for its images
+	 * @return A reference to this texture object
+	*/
+	Texture& Texture::markWritten() {
+		Hazards::written(this->lastWrite);
+
+		return *this;
+	}
+
+	/** @brief Issue the barrier bits needed before this texture is used in some way, if a shader stored to it since they were last issued
+	 * @param[in] barriers	The bits for the kind of use, eg. GL_FRAMEBUFFER_BARRIER_BIT to blit from it
+	 * @return				A reference to this texture object
+	*/
+	Texture& Texture::sync(GLbitfield barriers) {
+		Hazards::require(this->lastWrite, barriers);
+
+		return *this;
+	}
+
 	/** @brief Load an image path into the texture
 	*  @param[in]	path	The filepath to load
 	*  @param[in]	type	The type of the texture file
@@ -169,7 +301,10 @@ namespace oglopp {
 	Texture& Texture::getSize(int* getWidth, int* getHeight, int* getChannels) {
 		*getWidth = this->width;
 		*getHeight = this->height;
-		*getChannels = this->channels;
+
+		if (getChannels != nullptr) {
+			*getChannels = this->channels;
+		}
 
 		return *this;
 	}
@@ -181,10 +316,12 @@ namespace oglopp {
 		return this->TID;
 	}
 
-	/** @brief Bind this texture to some texture ID. Called before drawing each shape
+	/** @brief Bind this texture to some texture ID. Called before drawing each shape. Waits for image stores to it first
 	 * @param[in] id	The texture ID to bind to.
  	*/
 	Texture& Texture::bind(uint16_t id) {
+		this->sync(GL_TEXTURE_FETCH_BARRIER_BIT);
+
 		// Set the id (used within the shader) to bind the texture to
 		glActiveTexture(id);
 
@@ -0,0 +1,222 @@
+#include "oglopp/tuner.h"
+#include "oglopp/glad/gl.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace oglopp {
+	/** @brief Create a tuner and load its cache file, if there is one
+	 * @param[in] cachePath		The file the winning sizes are stored in
+ 	*/
+	ComputeTuner::ComputeTuner(std::string const& cachePath) : cachePath(cachePath) {
+		this->load();
+	}
+
+	/** @brief Set the local sizes to try. Sizes the device does not allow are skipped
+	 * @param[in] sizes		The candidate local_size_x values
+	 * @return				A reference to this object
+ 	*/
+	ComputeTuner& ComputeTuner::setCandidates(std::vector<GLint> const& sizes) {
+		this->candidates = sizes;
+
+		return *this;
+	}
+
+	/** @brief Set how many times each candidate runs
+	 * @param[in] warmup	Untimed runs first, so compilation and caches settle
+	 * @param[in] timed		Timed runs. The fastest one counts
+	 * @return				A reference to this object
+ 	*/
+	ComputeTuner& ComputeTuner::setRuns(uint32_t warmup, uint32_t timed) {
+		this->warmupRuns = warmup;
+		this->timedRuns = std::max(timed, 1u);
+
+		return *this;
+	}
+
+	/** @brief Compile a kernel with its best local size, tuning it first if the cache has no entry for it on this device
+	 * @param[in] source	The compute shader source, using LOCAL_SIZE_X
+	 * @param[in] run		Dispatches the kernel over representative inputs
+	 * @param[in] binding	The SSBO binding passed to the Compute constructor
+	 * @return				The compiled kernel
+ 	*/
+	std::unique_ptr<Compute> ComputeTuner::tune(std::string const& source, RunFunction run, GLuint binding) {
+		GLint cached = this->getCachedSize(source);
+		if (cached > 0) {
+			return std::make_unique<Compute>(ComputeTuner::injectDefine(source, LOCAL_SIZE_DEFINE, std::to_string(cached)).c_str(), ShaderType::RAW, binding);
+		}
+
+		std::unique_ptr<Compute> best;
+		GLint bestSize = 0;
+		uint64_t bestTime = UINT64_MAX;
+
+		for (GLint size : this->candidates) {
+			if (!Compute::groupSizeIsValid(glm::ivec3(size, 1, 1))) {
+				continue;
+			}
+
+			std::unique_ptr<Compute> kernel = std::make_unique<Compute>(ComputeTuner::injectDefine(source, LOCAL_SIZE_DEFINE, std::to_string(size)).c_str(), ShaderType::RAW, binding);
+
+			// A candidate which failed to compile or link (eg. too much shared memory) reflects no local size
+			if (kernel->getLocalSize().x != size) {
+				continue;
+			}
+
+			uint64_t elapsed = this->time(*kernel, run);
+			std::cout << "[Oglopp] Compute tuner: local_size_x = " << size << " took " << elapsed / 1000.0 << "us" << std::endl;
+
+			if (elapsed < bestTime) {
+				bestTime = elapsed;
+				bestSize = size;
+				best = std::move(kernel);
+			}
+		}
+
+		if (best == nullptr) {
+			std::cout << "[Oglopp] Compute tuner: no candidate local size compiled" << std::endl;
+			return nullptr;
+		}
+
+		const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		this->cache[ComputeTuner::getKey(source)] = {bestSize, renderer != nullptr ? renderer : ""};
+		this->save();
+
+		return best;
+	}
+
+	/** @brief Get the cached local size of a kernel on this device
+	 * @param[in] source	The compute shader source
+	 * @return				The local size, or 0 if the kernel has not been tuned on this device
+ 	*/
+	GLint ComputeTuner::getCachedSize(std::string const& source) const {
+		auto found = this->cache.find(ComputeTuner::getKey(source));
+
+		return found == this->cache.end() ? 0 : found->second.size;
+	}
+
+	/** @brief Insert a #define after the #version line of a shader
+	 * @param[in] source	The shader source
+	 * @param[in] name		The macro name
+	 * @param[in] value		The macro value
+	 * @return				The new source
+ 	*/
+	std::string ComputeTuner::injectDefine(std::string const& source, std::string const& name, std::string const& value) {
+		std::string define = "#define " + name + " " + value + "\n";
+
+		// #version must stay the first line
+		size_t version = source.find("#version");
+		if (version == std::string::npos) {
+			return define + source;
+		}
+
+		size_t lineEnd = source.find('\n', version);
+		if (lineEnd == std::string::npos) {
+			return source + "\n" + define;
+		}
+
+		return source.substr(0, lineEnd + 1) + define + source.substr(lineEnd + 1);
+	}
+
+	/** @brief Get the cache key of a kernel on the current device
+	 * @param[in] source	The compute shader source
+	 * @return				The key
+ 	*/
+	std::string ComputeTuner::getKey(std::string const& source) {
+		const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+		std::string text = source + '\n' + (renderer != nullptr ? renderer : "") + '\n' + (version != nullptr ? version : "");
+
+		// 64 bit FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : text) {
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+
+		char key[17];
+		std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+
+		return key;
+	}
+
+	/** @brief Time one candidate
+	 * @param[in] kernel	The kernel compiled with the candidate size
+	 * @param[in] run		The dispatch function
+	 * @return				The fastest run in nanoseconds
+ 	*/
+	uint64_t ComputeTuner::time(Compute& kernel, RunFunction const& run) const {
+		for (uint32_t i = 0; i < this->warmupRuns; i++) {
+			run(kernel);
+		}
+
+		GLuint query;
+		glGenQueries(1, &query);
+
+		uint64_t fastest = UINT64_MAX;
+		for (uint32_t i = 0; i < this->timedRuns; i++) {
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			run(kernel);
+			glEndQuery(GL_TIME_ELAPSED);
+
+			// Waits for the GPU to finish the run
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			fastest = std::min<uint64_t>(fastest, elapsed);
+		}
+
+		glDeleteQueries(1, &query);
+
+		return fastest;
+	}
+
+	/** @brief Read the cache file
+	 * @return A status code. 0 for success. -1 if the file could not be opened
+ 	*/
+	int8_t ComputeTuner::load() {
+		std::ifstream file(this->cachePath);
+		if (!file.is_open()) {
+			return -1;
+		}
+
+		// Each line is "<key> <local size> <renderer>". The renderer is only there for people reading the file
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+
+			std::istringstream fields(line);
+			std::string key;
+			GLint size = 0;
+			if (fields >> key >> size && size > 0) {
+				std::string renderer;
+				std::getline(fields >> std::ws, renderer);
+				this->cache[key] = {size, renderer};
+			}
+		}
+
+		return 0;
+	}
+
+	/** @brief Write the cache file
+	 * @return A status code. 0 for success. -1 if the file could not be opened
+ 	*/
+	int8_t ComputeTuner::save() const {
+		std::ofstream file(this->cachePath, std::ios::trunc);
+		if (!file.is_open()) {
+			std::cout << "[Oglopp] Compute tuner could not write " << this->cachePath << std::endl;
+			return -1;
+		}
+
+		file << "# oglopp compute tuner cache: <source, renderer and version hash> <local_size_x> <renderer>" << std::endl;
+		for (auto const& entry : this->cache) {
+			file << entry.first << " " << entry.second.size << " " << entry.second.renderer << std::endl;
+		}
+
+		return 0;
+	}
+}
@@ -2,6 +2,7 @@
 
 #include "oglopp/window.h"
 #include "oglopp/init.h"
+#include "oglopp/shape.h"
 
 namespace oglopp {
 	// Callback function to automatically change viewport when window is resized
@@ -101,6 +102,12 @@ namespace oglopp {
 			}
 		} else {
 			glDisable(GL_DEPTH_TEST);
+			this->startSettings.depthPrepass = false; // Nothing to prepass without a depth buffer
+		}
+
+		// Depth prepass shader
+		if (this->startSettings.depthPrepass) {
+			this->prepassShader = Shader(Shader::DEPTH_PREPASS_VERTEX, Shader::DEPTH_PREPASS_FRAGMENT, ShaderType::RAW);
 		}
 
 		// Modifying point size
@@ -361,4 +368,81 @@ namespace oglopp {
 
 		return *this;
 	}
+
+	/** @brief Check if the depth prepass is enabled in the window settings
+	 * @return True if the depth prepass is enabled
+ 	*/
+	bool Window::hasDepthPrepass() const {
+		return this->startSettings.depthPrepass;
+	}
+
+	/** @brief Get the position-only shader used for the depth prepass. Only valid if the depth prepass is enabled
+	 * @return A pointer to the prepass shader, or nullptr if the depth prepass is disabled
+ 	*/
+	Shader* Window::getPrepassShader() {
+		return this->startSettings.depthPrepass ? &this->prepassShader : nullptr;
+	}
+
+	/** @brief Disable color writes and enable depth writes for the depth prepass. Does nothing if the depth prepass is disabled
+	 * @return A reference to this window object
+ 	*/
+	Window& Window::beginDepthPrepass() {
+		if (!this->startSettings.depthPrepass) {
+			return *this;
+		}
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(this->startSettings.depthPass);
+
+		return *this;
+	}
+
+	/** @brief Enable color writes, disable depth writes and test depth with EQUAL for the main pass. Does nothing if the depth prepass is disabled
+	 * @return A reference to this window object
+ 	*/
+	Window& Window::beginShadingPass() {
+		if (!this->startSettings.depthPrepass) {
+			return *this;
+		}
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthMask(GL_FALSE);
+		glDepthFunc(DepthPass::EQUAL);
+
+		return *this;
+	}
+
+	/** @brief Restore the depth state from the window settings after the main pass. Does nothing if the depth prepass is disabled
+	 * @return A reference to this window object
+ 	*/
+	Window& Window::endShadingPass() {
+		if (!this->startSettings.depthPrepass) {
+			return *this;
+		}
+
+		glDepthMask(this->startSettings.depthReadonly ? GL_FALSE : GL_TRUE);
+		glDepthFunc(this->startSettings.depthPass);
+
+		return *this;
+	}
+
+	/** @brief Draw a list of opaque shapes depth-only with the prepass shader, then switch to the shading pass state.
+	 * 	Draw the same shapes with their real shaders afterwards, then call endShadingPass(). Does nothing if the depth prepass is disabled
+	 * @param[in] shapes	The opaque shapes to write into the depth buffer
+	 * @return				A reference to this window object
+ 	*/
+	Window& Window::depthPrepass(std::vector<Shape*> const& shapes) {
+		if (!this->startSettings.depthPrepass) {
+			return *this;
+		}
+
+		this->beginDepthPrepass();
+
+		for (Shape* shape : shapes) {
+			shape->draw(*this, &this->prepassShader);
+		}
+
+		return this->beginShadingPass();
+	}
 }